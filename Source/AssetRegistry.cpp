@@ -0,0 +1,242 @@
+///////////////////////////////////////////////////////////////////////////////
+// assetregistry.cpp
+// ============
+// small integer handles for the scene's textures, materials and meshes, with
+// generation counters that catch handles kept past their asset's release
+///////////////////////////////////////////////////////////////////////////////
+
+#include "AssetRegistry.h"
+
+#include <iostream>
+
+/***********************************************************
+ *  AssetRegistry()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+AssetRegistry::AssetRegistry()
+{
+}
+
+/***********************************************************
+ *  ~AssetRegistry()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+AssetRegistry::~AssetRegistry()
+{
+	for (int type = 0; type < ASSET_TYPE_COUNT; type++)
+	{
+		m_pools[type].slots.clear();
+		m_pools[type].freeSlots.clear();
+		m_pools[type].handles.clear();
+	}
+}
+
+/***********************************************************
+ *  MakeHandle()
+ *
+ *  This method is used for packing the slot index, the
+ *  generation and the type of an asset into a handle.  The
+ *  generation is never 0, so no handle equals
+ *  INVALID_ASSET_HANDLE.
+ ***********************************************************/
+ASSET_HANDLE AssetRegistry::MakeHandle(ASSET_TYPE type, uint32_t index, uint32_t generation)
+{
+	return(((uint32_t)type << (INDEX_BITS + GENERATION_BITS)) |
+		(generation << INDEX_BITS) |
+		index);
+}
+
+/***********************************************************
+ *  FindSlot()
+ *
+ *  This method is used for getting the slot the passed in
+ *  handle refers to, as long as the handle is of the passed
+ *  in type and its asset has not been released since.
+ ***********************************************************/
+const AssetRegistry::ASSET_SLOT* AssetRegistry::FindSlot(ASSET_HANDLE handle, ASSET_TYPE type) const
+{
+	uint32_t index = handle & INDEX_MASK;
+	uint32_t generation = (handle >> INDEX_BITS) & GENERATION_MASK;
+	const ASSET_POOL& pool = m_pools[type];
+
+	if ((handle >> (INDEX_BITS + GENERATION_BITS)) != (uint32_t)type)
+	{
+		return(NULL);
+	}
+	if (index >= pool.slots.size())
+	{
+		return(NULL);
+	}
+
+	const ASSET_SLOT& slot = pool.slots[index];
+	if ((slot.bLive == false) || (slot.generation != generation))
+	{
+		return(NULL);
+	}
+	return(&slot);
+}
+
+/***********************************************************
+ *  Register()
+ *
+ *  This method is used for adding an asset under the passed
+ *  in tag and returning its handle.  A released slot is
+ *  reused before the slot array grows.  Registering a tag
+ *  again releases the asset it named, so that handles to
+ *  the old asset go stale.
+ ***********************************************************/
+ASSET_HANDLE AssetRegistry::Register(ASSET_TYPE type, const std::string& tag, int value)
+{
+	ASSET_POOL& pool = m_pools[type];
+	uint32_t index = 0;
+
+	ASSET_HANDLE previous = Find(type, tag);
+	if (previous != INVALID_ASSET_HANDLE)
+	{
+		Release(previous);
+	}
+
+	if (pool.freeSlots.empty() == false)
+	{
+		index = pool.freeSlots.back();
+		pool.freeSlots.pop_back();
+	}
+	else
+	{
+		if (pool.slots.size() > INDEX_MASK)
+		{
+			std::cout << "ERROR: Too many assets to register " << tag << std::endl;
+			return(INVALID_ASSET_HANDLE);
+		}
+
+		ASSET_SLOT slot;
+		slot.value = -1;
+		slot.generation = 1;
+		slot.bLive = false;
+		index = (uint32_t)pool.slots.size();
+		pool.slots.push_back(slot);
+	}
+
+	ASSET_SLOT& slot = pool.slots[index];
+	slot.value = value;
+	slot.bLive = true;
+
+	ASSET_HANDLE handle = MakeHandle(type, index, slot.generation);
+	pool.handles[tag] = handle;
+	return(handle);
+}
+
+/***********************************************************
+ *  Find()
+ *
+ *  This method is used for getting the handle of the asset
+ *  registered under the passed in tag, or
+ *  INVALID_ASSET_HANDLE when there is none.  Tags are meant
+ *  to be looked up once while loading, with the handle kept
+ *  for drawing.
+ ***********************************************************/
+ASSET_HANDLE AssetRegistry::Find(ASSET_TYPE type, const std::string& tag) const
+{
+	const ASSET_POOL& pool = m_pools[type];
+	std::unordered_map<std::string, ASSET_HANDLE>::const_iterator found = pool.handles.find(tag);
+
+	if (found == pool.handles.end())
+	{
+		return(INVALID_ASSET_HANDLE);
+	}
+	return(found->second);
+}
+
+/***********************************************************
+ *  Resolve()
+ *
+ *  This method is used for getting the value of the asset
+ *  the passed in handle refers to.  It only indexes the
+ *  slot array and compares the generation, so it is cheap
+ *  enough to call for every draw.
+ ***********************************************************/
+bool AssetRegistry::Resolve(ASSET_HANDLE handle, ASSET_TYPE type, int& value) const
+{
+	const ASSET_SLOT* pSlot = FindSlot(handle, type);
+
+	if (NULL == pSlot)
+	{
+		return(false);
+	}
+	value = pSlot->value;
+	return(true);
+}
+
+/***********************************************************
+ *  Release()
+ *
+ *  This method is used for releasing the asset the passed
+ *  in handle refers to.  Its slot's generation is raised,
+ *  skipping 0 when it wraps, and the slot is kept for the
+ *  next registered asset.
+ ***********************************************************/
+void AssetRegistry::Release(ASSET_HANDLE handle)
+{
+	uint32_t type = handle >> (INDEX_BITS + GENERATION_BITS);
+
+	if ((type >= ASSET_TYPE_COUNT) ||
+		(NULL == FindSlot(handle, (ASSET_TYPE)type)))
+	{
+		return;
+	}
+
+	ASSET_POOL& pool = m_pools[type];
+	uint32_t index = handle & INDEX_MASK;
+	ASSET_SLOT& slot = pool.slots[index];
+
+	slot.bLive = false;
+	slot.value = -1;
+	slot.generation = (slot.generation + 1) & GENERATION_MASK;
+	if (0 == slot.generation)
+	{
+		slot.generation = 1;
+	}
+	pool.freeSlots.push_back(index);
+
+	std::unordered_map<std::string, ASSET_HANDLE>::iterator entry = pool.handles.begin();
+	while (entry != pool.handles.end())
+	{
+		if (entry->second == handle)
+		{
+			pool.handles.erase(entry);
+			break;
+		}
+		++entry;
+	}
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for releasing every asset of the
+ *  passed in type, leaving all of their handles stale.
+ ***********************************************************/
+void AssetRegistry::Clear(ASSET_TYPE type)
+{
+	ASSET_POOL& pool = m_pools[type];
+
+	pool.handles.clear();
+	pool.freeSlots.clear();
+	for (size_t i = 0; i < pool.slots.size(); i++)
+	{
+		ASSET_SLOT& slot = pool.slots[i];
+		if (slot.bLive == true)
+		{
+			slot.bLive = false;
+			slot.value = -1;
+			slot.generation = (slot.generation + 1) & GENERATION_MASK;
+			if (0 == slot.generation)
+			{
+				slot.generation = 1;
+			}
+		}
+		pool.freeSlots.push_back((uint32_t)i);
+	}
+}
@@ -0,0 +1,99 @@
+///////////////////////////////////////////////////////////////////////////////
+// assetregistry.h
+// ============
+// small integer handles for the scene's textures, materials and meshes, with
+// generation counters that catch handles kept past their asset's release
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// kinds of asset that handles are handed out for
+enum ASSET_TYPE
+{
+	ASSET_TEXTURE = 0,
+	ASSET_MATERIAL,
+	ASSET_MESH,
+	ASSET_VIRTUAL_TEXTURE,
+	ASSET_TYPE_COUNT
+};
+
+// handle of a registered asset, packing its slot index, the
+// generation of the slot and the asset type
+typedef uint32_t ASSET_HANDLE;
+
+// handle that never resolves, returned when a tag is not found
+const ASSET_HANDLE INVALID_ASSET_HANDLE = 0;
+
+/***********************************************************
+ *  AssetRegistry
+ *
+ *  This class hands out a handle for every registered
+ *  asset, in place of its tag.  Tags are only looked up
+ *  through a hash map while the scene loads, and a draw
+ *  resolves its handles by indexing a slot array, with no
+ *  hashing or allocation.  A released slot is reused with
+ *  its generation counter raised, so a handle kept past its
+ *  asset's release fails to resolve instead of reaching the
+ *  asset that took its place.
+ ***********************************************************/
+class AssetRegistry
+{
+public:
+	// constructor
+	AssetRegistry();
+	// destructor
+	~AssetRegistry();
+
+private:
+	// bits of a handle holding each part, the type on top
+	static const int INDEX_BITS = 20;
+	static const int GENERATION_BITS = 10;
+	static const uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
+	static const uint32_t GENERATION_MASK = (1u << GENERATION_BITS) - 1;
+
+	struct ASSET_SLOT
+	{
+		// texture index, material ID, mesh type or virtual
+		// texture ID of the asset
+		int value;
+		// raised every time the slot is released, never 0
+		uint32_t generation;
+		bool bLive;
+	};
+
+	// slots, released slots and tags of every asset type
+	struct ASSET_POOL
+	{
+		std::vector<ASSET_SLOT> slots;
+		std::vector<uint32_t> freeSlots;
+		std::unordered_map<std::string, ASSET_HANDLE> handles;
+	};
+
+	ASSET_POOL m_pools[ASSET_TYPE_COUNT];
+
+	// pack the parts of a handle
+	static ASSET_HANDLE MakeHandle(ASSET_TYPE type, uint32_t index, uint32_t generation);
+	// find the live slot a handle refers to, or NULL
+	const ASSET_SLOT* FindSlot(ASSET_HANDLE handle, ASSET_TYPE type) const;
+
+public:
+	// register an asset under a tag and return its handle
+	ASSET_HANDLE Register(ASSET_TYPE type, const std::string& tag, int value);
+	// find the handle of an asset by tag, while loading only
+	ASSET_HANDLE Find(ASSET_TYPE type, const std::string& tag) const;
+	// get the value of the asset a handle refers to, returning
+	// false when the handle is stale or of another type
+	bool Resolve(ASSET_HANDLE handle, ASSET_TYPE type, int& value) const;
+	// release an asset, making its handles stale
+	void Release(ASSET_HANDLE handle);
+	// release every asset of a type
+	void Clear(ASSET_TYPE type);
+
+	// get the number of live assets of a type
+	int GetAssetCount(ASSET_TYPE type) const { return((int)m_pools[type].handles.size()); }
+};
@@ -0,0 +1,764 @@
+///////////////////////////////////////////////////////////////////////////////
+// batchedmeshes.cpp
+// ============
+// basic shape meshes packed into shared vertex and index buffers so that
+// many copies of a shape can be drawn with a single instanced draw call
+///////////////////////////////////////////////////////////////////////////////
+
+#include "BatchedMeshes.h"
+
+#include <cstddef>
+#include <cstring>
+
+// declaration of global variables
+namespace
+{
+	// number of floats in each vertex - position, normal, texture coordinate
+	const int g_FloatsPerVertex = 8;
+	// number of slices around the cylinder meshes
+	const int g_CylinderSectors = 36;
+	const float g_Pi = 3.14159265f;
+
+	// vertex attribute locations used by the vertex shader
+	const GLuint g_PositionLocation = 0;
+	const GLuint g_NormalLocation = 1;
+	const GLuint g_TextureLocation = 2;
+	const GLuint g_InstanceModelLocation = 3;
+	const GLuint g_InstanceColorLocation = 7;
+	const GLuint g_InstanceMaterialLocation = 8;
+	const GLuint g_InstanceNormalLocation = 9;
+	const GLuint g_InstanceTextureLayerLocation = 12;
+	const GLuint g_InstanceUVScaleLocation = 13;
+
+	// bytes of the ring buffer used by each frame, doubled
+	// automatically when a frame needs more
+	const size_t g_RingFrameSize = 256 * 1024;
+}
+
+// the per-draw storage buffer holds the instance data as it is
+SHADER_LAYOUT_ASSERT(BatchedMeshes::INSTANCE_DATA, DRAW_DATA_LAYOUT, LAYOUT_STD430);
+
+/***********************************************************
+ *  BatchedMeshes()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+BatchedMeshes::BatchedMeshes()
+{
+	m_vao = 0;
+	m_vertexBuffer = 0;
+	m_indexBuffer = 0;
+	m_instanceBuffer = 0;
+	m_instanceBufferSize = 0;
+	m_bBuffersDirty = false;
+	m_currentBaseVertex = 0;
+	m_drawDataBuffer = 0;
+	m_indirectBuffer = 0;
+	m_drawDataBufferSize = 0;
+	m_indirectBufferSize = 0;
+	m_ringBuffer = NULL;
+	m_storageAlignment = 1;
+	m_instanceSource = 0;
+	m_instanceSourceOffset = 0;
+	m_ringGeneration = 0;
+	m_indirectSource = 0;
+	m_indirectSourceOffset = 0;
+
+	for (int i = 0; i < RenderQueue::MESH_COUNT; i++)
+	{
+		m_meshRanges[i].nIndices = 0;
+		m_meshRanges[i].firstIndex = 0;
+		m_meshRanges[i].baseVertex = 0;
+	}
+}
+
+/***********************************************************
+ *  ~BatchedMeshes()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+BatchedMeshes::~BatchedMeshes()
+{
+	if (0 != m_vao)
+	{
+		glDeleteVertexArrays(1, &m_vao);
+		glDeleteBuffers(1, &m_vertexBuffer);
+		glDeleteBuffers(1, &m_indexBuffer);
+		glDeleteBuffers(1, &m_instanceBuffer);
+	}
+	if (0 != m_indirectBuffer)
+	{
+		glDeleteBuffers(1, &m_drawDataBuffer);
+		glDeleteBuffers(1, &m_indirectBuffer);
+	}
+	if (NULL != m_ringBuffer)
+	{
+		delete m_ringBuffer;
+		m_ringBuffer = NULL;
+	}
+	m_drawDataBuffer = 0;
+	m_indirectBuffer = 0;
+	m_vao = 0;
+	m_vertexBuffer = 0;
+	m_indexBuffer = 0;
+	m_instanceBuffer = 0;
+}
+
+/***********************************************************
+ *  BeginMesh()
+ *
+ *  This method is used for recording where the data of the
+ *  passed in mesh starts in the shared buffers.
+ ***********************************************************/
+void BatchedMeshes::BeginMesh(RenderQueue::MESH_TYPE mesh)
+{
+	m_meshRanges[mesh].firstIndex = (GLuint)m_indices.size();
+	m_meshRanges[mesh].baseVertex = (GLint)(m_vertices.size() / g_FloatsPerVertex);
+	m_meshRanges[mesh].nIndices = 0;
+	m_currentBaseVertex = m_meshRanges[mesh].baseVertex;
+}
+
+/***********************************************************
+ *  EndMesh()
+ *
+ *  This method is used for recording how many indices were
+ *  added for the passed in mesh.
+ ***********************************************************/
+void BatchedMeshes::EndMesh(RenderQueue::MESH_TYPE mesh)
+{
+	m_meshRanges[mesh].nIndices = (GLsizei)(m_indices.size() - m_meshRanges[mesh].firstIndex);
+	m_bBuffersDirty = true;
+}
+
+/***********************************************************
+ *  AddVertex()
+ *
+ *  This method is used for adding a vertex to the mesh that
+ *  is being collected.  The returned index is relative to
+ *  the first vertex of the mesh.
+ ***********************************************************/
+GLuint BatchedMeshes::AddVertex(glm::vec3 position, glm::vec3 normal, glm::vec2 uv)
+{
+	GLuint index = 0;
+
+	index = (GLuint)(m_vertices.size() / g_FloatsPerVertex) - m_currentBaseVertex;
+
+	m_vertices.push_back(position.x);
+	m_vertices.push_back(position.y);
+	m_vertices.push_back(position.z);
+	m_vertices.push_back(normal.x);
+	m_vertices.push_back(normal.y);
+	m_vertices.push_back(normal.z);
+	m_vertices.push_back(uv.x);
+	m_vertices.push_back(uv.y);
+
+	return(index);
+}
+
+/***********************************************************
+ *  AddTriangle()
+ *
+ *  This method is used for adding a triangle to the mesh
+ *  that is being collected.
+ ***********************************************************/
+void BatchedMeshes::AddTriangle(GLuint a, GLuint b, GLuint c)
+{
+	m_indices.push_back(a);
+	m_indices.push_back(b);
+	m_indices.push_back(c);
+}
+
+/***********************************************************
+ *  AddCylinder()
+ *
+ *  This method is used for adding a cylinder with a bottom
+ *  radius of 1 and the passed in top radius, standing on the
+ *  XZ plane with a height of 1 - the same as ShapeMeshes.
+ ***********************************************************/
+void BatchedMeshes::AddCylinder(float topRadius)
+{
+	GLuint bottomCenter = 0;
+	GLuint topCenter = 0;
+	GLuint bottomStart = 0;
+	GLuint topStart = 0;
+	GLuint sideStart = 0;
+	// the side normals lean inwards when the top is narrower
+	float slope = 1.0f - topRadius;
+
+	// bottom cap
+	bottomCenter = AddVertex(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec2(0.5f, 0.5f));
+	bottomStart = bottomCenter + 1;
+	for (int i = 0; i <= g_CylinderSectors; i++)
+	{
+		float angle = 2.0f * g_Pi * i / g_CylinderSectors;
+		float x = cos(angle);
+		float z = sin(angle);
+		AddVertex(glm::vec3(x, 0.0f, z), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec2(0.5f + x * 0.5f, 0.5f + z * 0.5f));
+	}
+
+	// top cap
+	topCenter = AddVertex(glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2(0.5f, 0.5f));
+	topStart = topCenter + 1;
+	for (int i = 0; i <= g_CylinderSectors; i++)
+	{
+		float angle = 2.0f * g_Pi * i / g_CylinderSectors;
+		float x = cos(angle);
+		float z = sin(angle);
+		AddVertex(glm::vec3(x * topRadius, 1.0f, z * topRadius), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2(0.5f + x * 0.5f, 0.5f + z * 0.5f));
+	}
+
+	// sides - the first and last columns are duplicated so the
+	// texture wraps around once without a seam
+	sideStart = topStart + g_CylinderSectors + 1;
+	for (int i = 0; i <= g_CylinderSectors; i++)
+	{
+		float angle = 2.0f * g_Pi * i / g_CylinderSectors;
+		float x = cos(angle);
+		float z = sin(angle);
+		float u = (float)i / g_CylinderSectors;
+		glm::vec3 normal = glm::normalize(glm::vec3(x, slope, z));
+		AddVertex(glm::vec3(x, 0.0f, z), normal, glm::vec2(u, 0.0f));
+		AddVertex(glm::vec3(x * topRadius, 1.0f, z * topRadius), normal, glm::vec2(u, 1.0f));
+	}
+
+	for (GLuint i = 0; i < (GLuint)g_CylinderSectors; i++)
+	{
+		GLuint bottom = sideStart + i * 2;
+
+		AddTriangle(bottomCenter, bottomStart + i, bottomStart + i + 1);
+		AddTriangle(topCenter, topStart + i + 1, topStart + i);
+		AddTriangle(bottom, bottom + 1, bottom + 3);
+		AddTriangle(bottom, bottom + 3, bottom + 2);
+	}
+}
+
+/***********************************************************
+ *  BuildBuffers()
+ *
+ *  This method is used for sending the collected vertex and
+ *  index data to the GPU and configuring the vertex array
+ *  object, including the per-instance attributes.
+ ***********************************************************/
+void BatchedMeshes::BuildBuffers()
+{
+	GLsizei stride = sizeof(GLfloat) * g_FloatsPerVertex;
+
+	if (0 == m_vao)
+	{
+		glGenVertexArrays(1, &m_vao);
+		glGenBuffers(1, &m_vertexBuffer);
+		glGenBuffers(1, &m_indexBuffer);
+		glGenBuffers(1, &m_instanceBuffer);
+
+		// per-draw data goes through the ring buffer when the
+		// driver supports persistent mapping
+		if (RingBuffer::IsSupported() == true)
+		{
+			m_ringBuffer = new RingBuffer();
+			if (m_ringBuffer->Create(g_RingFrameSize) == false)
+			{
+				delete m_ringBuffer;
+				m_ringBuffer = NULL;
+			}
+		}
+		if (IsIndirectSupported() == true)
+		{
+			glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &m_storageAlignment);
+		}
+	}
+	glBindVertexArray(m_vao);
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, m_vertices.size() * sizeof(GLfloat), m_vertices.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indices.size() * sizeof(GLuint), m_indices.data(), GL_STATIC_DRAW);
+
+	// per-vertex attributes
+	glVertexAttribPointer(g_PositionLocation, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+	glEnableVertexAttribArray(g_PositionLocation);
+	glVertexAttribPointer(g_NormalLocation, 3, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(GLfloat) * 3));
+	glEnableVertexAttribArray(g_NormalLocation);
+	glVertexAttribPointer(g_TextureLocation, 2, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(GLfloat) * 6));
+	glEnableVertexAttribArray(g_TextureLocation);
+
+	// per-instance attributes - the model matrix takes four
+	// consecutive locations, one for each column.  The buffer
+	// always holds at least one instance so that the indirect
+	// path, which ignores these attributes, never reads past it
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+	if (m_instanceBufferSize == 0)
+	{
+		m_instanceBufferSize = sizeof(INSTANCE_DATA);
+		glBufferData(GL_ARRAY_BUFFER, m_instanceBufferSize, NULL, GL_STREAM_DRAW);
+	}
+	for (GLuint i = 0; i < 4; i++)
+	{
+		glEnableVertexAttribArray(g_InstanceModelLocation + i);
+		glVertexAttribDivisor(g_InstanceModelLocation + i, 1);
+	}
+	for (GLuint i = 0; i < 3; i++)
+	{
+		glEnableVertexAttribArray(g_InstanceNormalLocation + i);
+		glVertexAttribDivisor(g_InstanceNormalLocation + i, 1);
+	}
+	glEnableVertexAttribArray(g_InstanceColorLocation);
+	glVertexAttribDivisor(g_InstanceColorLocation, 1);
+	glEnableVertexAttribArray(g_InstanceMaterialLocation);
+	glVertexAttribDivisor(g_InstanceMaterialLocation, 1);
+	glEnableVertexAttribArray(g_InstanceTextureLayerLocation);
+	glVertexAttribDivisor(g_InstanceTextureLayerLocation, 1);
+	glEnableVertexAttribArray(g_InstanceUVScaleLocation);
+	glVertexAttribDivisor(g_InstanceUVScaleLocation, 1);
+	m_instanceSource = 0;
+	BindInstanceAttributes(m_instanceBuffer, 0);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	m_bBuffersDirty = false;
+}
+
+/***********************************************************
+ *  BindInstanceAttributes()
+ *
+ *  This method is used for pointing the per-instance
+ *  attributes of the bound vertex array object at the
+ *  instance data stored in the passed in buffer, starting
+ *  at the passed in offset.
+ ***********************************************************/
+void BatchedMeshes::BindInstanceAttributes(GLuint buffer, GLintptr offset)
+{
+	GLsizei instanceStride = sizeof(INSTANCE_DATA);
+
+	if ((buffer == m_instanceSource) && (offset == m_instanceSourceOffset))
+	{
+		return;
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	for (GLuint i = 0; i < 4; i++)
+	{
+		glVertexAttribPointer(g_InstanceModelLocation + i, 4, GL_FLOAT, GL_FALSE, instanceStride,
+			(void*)(offset + offsetof(INSTANCE_DATA, model) + sizeof(glm::vec4) * i));
+	}
+	for (GLuint i = 0; i < 3; i++)
+	{
+		glVertexAttribPointer(g_InstanceNormalLocation + i, 3, GL_FLOAT, GL_FALSE, instanceStride,
+			(void*)(offset + offsetof(INSTANCE_DATA, normalMatrix) + sizeof(glm::vec4) * i));
+	}
+	glVertexAttribPointer(g_InstanceColorLocation, 4, GL_FLOAT, GL_FALSE, instanceStride,
+		(void*)(offset + offsetof(INSTANCE_DATA, color)));
+	glVertexAttribIPointer(g_InstanceMaterialLocation, 1, GL_INT, instanceStride,
+		(void*)(offset + offsetof(INSTANCE_DATA, materialIndex)));
+	glVertexAttribIPointer(g_InstanceTextureLayerLocation, 1, GL_INT, instanceStride,
+		(void*)(offset + offsetof(INSTANCE_DATA, textureLayer)));
+	glVertexAttribPointer(g_InstanceUVScaleLocation, 2, GL_FLOAT, GL_FALSE, instanceStride,
+		(void*)(offset + offsetof(INSTANCE_DATA, uvScale)));
+
+	m_instanceSource = buffer;
+	m_instanceSourceOffset = offset;
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for starting the per-draw data of a
+ *  new frame.  It waits only if the GPU is still reading the
+ *  ring buffer region that this frame will write.
+ ***********************************************************/
+void BatchedMeshes::BeginFrame()
+{
+	if (NULL != m_ringBuffer)
+	{
+		m_ringBuffer->BeginFrame();
+	}
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for fencing the per-draw data of the
+ *  frame once all of its draws have been issued.
+ ***********************************************************/
+void BatchedMeshes::EndFrame()
+{
+	if (NULL != m_ringBuffer)
+	{
+		m_ringBuffer->EndFrame();
+	}
+}
+
+/***********************************************************
+ *  LoadBoxMesh()
+ *
+ *  This method is used for adding a unit box centered on
+ *  the origin to the shared buffers.
+ ***********************************************************/
+void BatchedMeshes::LoadBoxMesh()
+{
+	// outward normal, right and up axes of each face
+	const glm::vec3 faces[6][3] =
+	{
+		{ glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f) },
+		{ glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f) },
+		{ glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f) },
+		{ glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f) },
+		{ glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f) },
+		{ glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f) }
+	};
+
+	BeginMesh(RenderQueue::MESH_BOX);
+	for (int i = 0; i < 6; i++)
+	{
+		glm::vec3 normal = faces[i][0];
+		glm::vec3 right = faces[i][1] * 0.5f;
+		glm::vec3 up = faces[i][2] * 0.5f;
+		glm::vec3 center = normal * 0.5f;
+
+		GLuint first = AddVertex(center - right - up, normal, glm::vec2(0.0f, 0.0f));
+		AddVertex(center + right - up, normal, glm::vec2(1.0f, 0.0f));
+		AddVertex(center + right + up, normal, glm::vec2(1.0f, 1.0f));
+		AddVertex(center - right + up, normal, glm::vec2(0.0f, 1.0f));
+
+		AddTriangle(first, first + 1, first + 2);
+		AddTriangle(first, first + 2, first + 3);
+	}
+	EndMesh(RenderQueue::MESH_BOX);
+}
+
+/***********************************************************
+ *  LoadCylinderMesh()
+ *
+ *  This method is used for adding a cylinder to the shared
+ *  buffers.
+ ***********************************************************/
+void BatchedMeshes::LoadCylinderMesh()
+{
+	BeginMesh(RenderQueue::MESH_CYLINDER);
+	AddCylinder(1.0f);
+	EndMesh(RenderQueue::MESH_CYLINDER);
+}
+
+/***********************************************************
+ *  LoadTaperedCylinderMesh()
+ *
+ *  This method is used for adding a cylinder whose top is
+ *  half the width of its bottom to the shared buffers.
+ ***********************************************************/
+void BatchedMeshes::LoadTaperedCylinderMesh()
+{
+	BeginMesh(RenderQueue::MESH_TAPERED_CYLINDER);
+	AddCylinder(0.5f);
+	EndMesh(RenderQueue::MESH_TAPERED_CYLINDER);
+}
+
+/***********************************************************
+ *  LoadPlaneMesh()
+ *
+ *  This method is used for adding a 2x2 plane lying on the
+ *  XZ plane to the shared buffers.
+ ***********************************************************/
+void BatchedMeshes::LoadPlaneMesh()
+{
+	glm::vec3 normal = glm::vec3(0.0f, 1.0f, 0.0f);
+
+	BeginMesh(RenderQueue::MESH_PLANE);
+	GLuint first = AddVertex(glm::vec3(-1.0f, 0.0f, 1.0f), normal, glm::vec2(0.0f, 0.0f));
+	AddVertex(glm::vec3(1.0f, 0.0f, 1.0f), normal, glm::vec2(1.0f, 0.0f));
+	AddVertex(glm::vec3(1.0f, 0.0f, -1.0f), normal, glm::vec2(1.0f, 1.0f));
+	AddVertex(glm::vec3(-1.0f, 0.0f, -1.0f), normal, glm::vec2(0.0f, 1.0f));
+	AddTriangle(first, first + 1, first + 2);
+	AddTriangle(first, first + 2, first + 3);
+	EndMesh(RenderQueue::MESH_PLANE);
+}
+
+/***********************************************************
+ *  DrawMeshInstanced()
+ *
+ *  This method is used for drawing the passed in number of
+ *  copies of a mesh with one draw call.  The instance data
+ *  is written into the ring buffer, or when that is not
+ *  available or full, streamed into the instance buffer,
+ *  which is orphaned first so the driver does not wait on
+ *  the previous draw.
+ ***********************************************************/
+void BatchedMeshes::DrawMeshInstanced(
+	RenderQueue::MESH_TYPE mesh,
+	const INSTANCE_DATA* instances,
+	int count)
+{
+	GLsizeiptr dataSize = sizeof(INSTANCE_DATA) * count;
+	const MESH_RANGE& range = m_meshRanges[mesh];
+	void* pMapped = NULL;
+	GLintptr offset = 0;
+
+	if ((count <= 0) || (range.nIndices == 0))
+	{
+		return;
+	}
+
+	if (m_bBuffersDirty == true)
+	{
+		BuildBuffers();
+	}
+
+	glBindVertexArray(m_vao);
+
+	if (NULL != m_ringBuffer)
+	{
+		pMapped = m_ringBuffer->Allocate(dataSize, sizeof(GLfloat), offset);
+	}
+	if (NULL != pMapped)
+	{
+		memcpy(pMapped, instances, dataSize);
+		// a grown ring buffer may reuse the name of the one it
+		// replaced, so the attributes are pointed at it again
+		if (m_ringBuffer->GetGeneration() != m_ringGeneration)
+		{
+			m_ringGeneration = m_ringBuffer->GetGeneration();
+			m_instanceSource = 0;
+		}
+		BindInstanceAttributes(m_ringBuffer->GetBuffer(), offset);
+	}
+	else
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+		if (dataSize > m_instanceBufferSize)
+		{
+			m_instanceBufferSize = dataSize;
+		}
+		glBufferData(GL_ARRAY_BUFFER, m_instanceBufferSize, NULL, GL_STREAM_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, dataSize, instances);
+		BindInstanceAttributes(m_instanceBuffer, 0);
+	}
+
+	glDrawElementsInstancedBaseVertex(
+		GL_TRIANGLES,
+		range.nIndices,
+		GL_UNSIGNED_INT,
+		(void*)(sizeof(GLuint) * range.firstIndex),
+		count,
+		range.baseVertex);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/***********************************************************
+ *  DrawBoxMeshInstanced()
+ *
+ *  This method is used for drawing copies of the box mesh.
+ ***********************************************************/
+void BatchedMeshes::DrawBoxMeshInstanced(const INSTANCE_DATA* instances, int count)
+{
+	DrawMeshInstanced(RenderQueue::MESH_BOX, instances, count);
+}
+
+/***********************************************************
+ *  DrawCylinderMeshInstanced()
+ *
+ *  This method is used for drawing copies of the cylinder
+ *  mesh.
+ ***********************************************************/
+void BatchedMeshes::DrawCylinderMeshInstanced(const INSTANCE_DATA* instances, int count)
+{
+	DrawMeshInstanced(RenderQueue::MESH_CYLINDER, instances, count);
+}
+
+/***********************************************************
+ *  DrawTaperedCylinderMeshInstanced()
+ *
+ *  This method is used for drawing copies of the tapered
+ *  cylinder mesh.
+ ***********************************************************/
+void BatchedMeshes::DrawTaperedCylinderMeshInstanced(const INSTANCE_DATA* instances, int count)
+{
+	DrawMeshInstanced(RenderQueue::MESH_TAPERED_CYLINDER, instances, count);
+}
+
+/***********************************************************
+ *  DrawPlaneMeshInstanced()
+ *
+ *  This method is used for drawing copies of the plane mesh.
+ ***********************************************************/
+void BatchedMeshes::DrawPlaneMeshInstanced(const INSTANCE_DATA* instances, int count)
+{
+	DrawMeshInstanced(RenderQueue::MESH_PLANE, instances, count);
+}
+
+/***********************************************************
+ *  IsIndirectSupported()
+ *
+ *  This method is used for checking whether the driver has
+ *  multi-draw-indirect, shader storage buffers and the
+ *  gl_DrawID shader input needed for indirect drawing.
+ ***********************************************************/
+bool BatchedMeshes::IsIndirectSupported()
+{
+	return((GLEW_VERSION_4_3 || GLEW_ARB_multi_draw_indirect) &&
+		(GLEW_VERSION_4_3 || GLEW_ARB_shader_storage_buffer_object) &&
+		(GLEW_VERSION_4_6 || GLEW_ARB_shader_draw_parameters));
+}
+
+/***********************************************************
+ *  BeginIndirectDraws()
+ *
+ *  This method is used for clearing the draws collected
+ *  for the previous frame.  The allocated memory is kept.
+ ***********************************************************/
+void BatchedMeshes::BeginIndirectDraws()
+{
+	m_indirectDrawData.clear();
+	m_indirectCommands.clear();
+}
+
+/***********************************************************
+ *  AddIndirectDraw()
+ *
+ *  This method is used for collecting one draw of the passed
+ *  in mesh.  The draw reads its model matrix, color and
+ *  material from the storage buffer entry with the same
+ *  index as its indirect command.
+ ***********************************************************/
+void BatchedMeshes::AddIndirectDraw(
+	RenderQueue::MESH_TYPE mesh,
+	const INSTANCE_DATA& data)
+{
+	INDIRECT_COMMAND command;
+	const MESH_RANGE& range = m_meshRanges[mesh];
+
+	command.count = range.nIndices;
+	command.instanceCount = 1;
+	command.firstIndex = range.firstIndex;
+	command.baseVertex = range.baseVertex;
+	command.baseInstance = 0;
+
+	m_indirectCommands.push_back(command);
+	m_indirectDrawData.push_back(data);
+}
+
+/***********************************************************
+ *  UploadIndirectDraws()
+ *
+ *  This method is used for sending all of the collected
+ *  draws to the GPU.  The per-draw data is bound to the
+ *  passed in shader storage binding point.  The ring buffer
+ *  is used when it has room, otherwise the draws are
+ *  uploaded into buffers of their own.  Static draws always
+ *  go into their own buffers, since ring buffer memory is
+ *  only valid for the frame that wrote it.
+ ***********************************************************/
+void BatchedMeshes::UploadIndirectDraws(GLuint storageBinding, bool bStatic)
+{
+	GLenum usage = bStatic ? GL_STATIC_DRAW : GL_STREAM_DRAW;
+	GLsizeiptr drawDataSize = sizeof(INSTANCE_DATA) * m_indirectDrawData.size();
+	GLsizeiptr commandSize = sizeof(INDIRECT_COMMAND) * m_indirectCommands.size();
+	void* pDrawData = NULL;
+	void* pCommands = NULL;
+	GLintptr drawDataOffset = 0;
+	GLintptr commandOffset = 0;
+
+	if (m_indirectCommands.size() == 0)
+	{
+		return;
+	}
+
+	if (m_bBuffersDirty == true)
+	{
+		BuildBuffers();
+	}
+
+	if ((NULL != m_ringBuffer) && (bStatic == false))
+	{
+		pDrawData = m_ringBuffer->Allocate(drawDataSize, m_storageAlignment, drawDataOffset);
+		if (NULL != pDrawData)
+		{
+			pCommands = m_ringBuffer->Allocate(commandSize, sizeof(GLuint), commandOffset);
+		}
+	}
+	if ((NULL != pDrawData) && (NULL != pCommands))
+	{
+		memcpy(pDrawData, m_indirectDrawData.data(), drawDataSize);
+		memcpy(pCommands, m_indirectCommands.data(), commandSize);
+		glBindBufferRange(GL_SHADER_STORAGE_BUFFER, storageBinding, m_ringBuffer->GetBuffer(), drawDataOffset, drawDataSize);
+		m_indirectSource = m_ringBuffer->GetBuffer();
+		m_indirectSourceOffset = commandOffset;
+		return;
+	}
+
+	if (0 == m_indirectBuffer)
+	{
+		glGenBuffers(1, &m_drawDataBuffer);
+		glGenBuffers(1, &m_indirectBuffer);
+	}
+
+	// the buffers only grow, and are orphaned every frame so
+	// the driver does not wait on the previous frame's draws
+	if (drawDataSize > m_drawDataBufferSize)
+	{
+		m_drawDataBufferSize = drawDataSize;
+	}
+	if (commandSize > m_indirectBufferSize)
+	{
+		m_indirectBufferSize = commandSize;
+	}
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_drawDataBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, m_drawDataBufferSize, NULL, usage);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, drawDataSize, m_indirectDrawData.data());
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, storageBinding, m_drawDataBuffer);
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirectBuffer);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, m_indirectBufferSize, NULL, usage);
+	glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, commandSize, m_indirectCommands.data());
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	m_indirectSource = m_indirectBuffer;
+	m_indirectSourceOffset = 0;
+}
+
+/***********************************************************
+ *  BindIndirectDraws()
+ *
+ *  This method is used for drawing the draws of the last
+ *  static upload again without sending them to the GPU.
+ ***********************************************************/
+void BatchedMeshes::BindIndirectDraws(GLuint storageBinding)
+{
+	if (0 == m_indirectBuffer)
+	{
+		return;
+	}
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, storageBinding, m_drawDataBuffer);
+	m_indirectSource = m_indirectBuffer;
+	m_indirectSourceOffset = 0;
+}
+
+/***********************************************************
+ *  DrawIndirect()
+ *
+ *  This method is used for drawing a range of the uploaded
+ *  draws with one glMultiDrawElementsIndirect call.  The
+ *  shader adds the first draw index to gl_DrawID to find
+ *  the per-draw data.
+ ***********************************************************/
+void BatchedMeshes::DrawIndirect(int firstDraw, int drawCount)
+{
+	if ((drawCount <= 0) || (0 == m_indirectSource))
+	{
+		return;
+	}
+
+	glBindVertexArray(m_vao);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirectSource);
+
+	glMultiDrawElementsIndirect(
+		GL_TRIANGLES,
+		GL_UNSIGNED_INT,
+		(void*)(m_indirectSourceOffset + sizeof(INDIRECT_COMMAND) * firstDraw),
+		drawCount,
+		sizeof(INDIRECT_COMMAND));
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	glBindVertexArray(0);
+}
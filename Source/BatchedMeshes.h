@@ -0,0 +1,163 @@
+///////////////////////////////////////////////////////////////////////////////
+// batchedmeshes.h
+// ============
+// basic shape meshes packed into shared vertex and index buffers so that
+// many copies of a shape can be drawn with a single instanced draw call,
+// or a whole scene with a few multi-draw-indirect calls
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "RenderQueue.h"
+#include "RingBuffer.h"
+#include "ShaderLayouts.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  BatchedMeshes
+ *
+ *  This class builds the same basic shapes as ShapeMeshes,
+ *  with the same dimensions, but stores all of them in one
+ *  vertex buffer and one index buffer behind a single VAO.
+ *  Per-instance model matrices, colors, material indices,
+ *  texture layers and UV scales are read from an instance
+ *  buffer by the vertex shader.
+ *
+ *  For indirect drawing, the same per-draw data is stored in
+ *  a shader storage buffer indexed by gl_DrawID, and one
+ *  indirect command per draw references the shared buffers.
+ *
+ *  When the driver supports persistent mapping, the per-draw
+ *  data and indirect commands are written into a fenced ring
+ *  buffer instead of being uploaded through the driver.
+ ***********************************************************/
+class BatchedMeshes
+{
+public:
+	// constructor
+	BatchedMeshes();
+	// destructor
+	~BatchedMeshes();
+
+	// per-instance data read by the vertex shader, either as
+	// instanced attributes or as DrawData under std430 rules
+	struct INSTANCE_DATA
+	{
+		DRAW_DATA_LAYOUT(SHADER_LAYOUT_MEMBER, SHADER_LAYOUT_MEMBER_PAD)
+	};
+
+	// layout of the commands read by glMultiDrawElementsIndirect
+	struct INDIRECT_COMMAND
+	{
+		GLuint count;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance;
+	};
+
+private:
+	// range of the shared buffers used by one mesh
+	struct MESH_RANGE
+	{
+		GLsizei nIndices;
+		GLuint firstIndex;
+		GLint baseVertex;
+	};
+
+	// vertex array object that references all of the buffers
+	GLuint m_vao;
+	// shared position, normal and texture coordinate buffer
+	GLuint m_vertexBuffer;
+	// shared index buffer
+	GLuint m_indexBuffer;
+	// per-instance data buffer
+	GLuint m_instanceBuffer;
+	// allocated size of the instance buffer in bytes
+	GLsizeiptr m_instanceBufferSize;
+	// true when loaded meshes have not been sent to the GPU yet
+	bool m_bBuffersDirty;
+	// per-draw data storage buffer for indirect drawing
+	GLuint m_drawDataBuffer;
+	// indirect command buffer for indirect drawing
+	GLuint m_indirectBuffer;
+	// allocated sizes of the indirect drawing buffers in bytes
+	GLsizeiptr m_drawDataBufferSize;
+	GLsizeiptr m_indirectBufferSize;
+	// per-draw data and commands collected for indirect drawing
+	std::vector<INSTANCE_DATA> m_indirectDrawData;
+	std::vector<INDIRECT_COMMAND> m_indirectCommands;
+	// persistently mapped memory for the per-draw data, NULL
+	// when the driver cannot map buffers persistently
+	RingBuffer* m_ringBuffer;
+	// required offset alignment of storage buffer bindings
+	GLint m_storageAlignment;
+	// buffer and offset the instance attributes read from
+	GLuint m_instanceSource;
+	GLintptr m_instanceSourceOffset;
+	// generation of the ring buffer the attributes were last
+	// pointed at
+	uint32_t m_ringGeneration;
+	// buffer and offset holding the uploaded indirect commands
+	GLuint m_indirectSource;
+	GLintptr m_indirectSourceOffset;
+
+	// vertex and index data collected while loading the meshes
+	std::vector<GLfloat> m_vertices;
+	std::vector<GLuint> m_indices;
+	// location of each mesh in the shared buffers
+	MESH_RANGE m_meshRanges[RenderQueue::MESH_COUNT];
+	// first vertex of the mesh being collected
+	GLint m_currentBaseVertex;
+
+	// start collecting the data of a new mesh
+	void BeginMesh(RenderQueue::MESH_TYPE mesh);
+	// finish collecting the data of a mesh
+	void EndMesh(RenderQueue::MESH_TYPE mesh);
+	// add a vertex to the mesh being collected
+	GLuint AddVertex(glm::vec3 position, glm::vec3 normal, glm::vec2 uv);
+	// add a triangle to the mesh being collected
+	void AddTriangle(GLuint a, GLuint b, GLuint c);
+	// add a cylinder with the passed in top radius
+	void AddCylinder(float topRadius);
+	// send the collected mesh data to the GPU
+	void BuildBuffers();
+	// point the per-instance attributes at a buffer and offset
+	void BindInstanceAttributes(GLuint buffer, GLintptr offset);
+
+public:
+	// start and finish the per-draw data of a frame
+	void BeginFrame();
+	void EndFrame();
+
+	// load the basic shapes into the shared buffers
+	void LoadBoxMesh();
+	void LoadCylinderMesh();
+	void LoadTaperedCylinderMesh();
+	void LoadPlaneMesh();
+
+	// draw many copies of a basic shape with one draw call
+	void DrawBoxMeshInstanced(const INSTANCE_DATA* instances, int count);
+	void DrawCylinderMeshInstanced(const INSTANCE_DATA* instances, int count);
+	void DrawTaperedCylinderMeshInstanced(const INSTANCE_DATA* instances, int count);
+	void DrawPlaneMeshInstanced(const INSTANCE_DATA* instances, int count);
+	void DrawMeshInstanced(RenderQueue::MESH_TYPE mesh, const INSTANCE_DATA* instances, int count);
+
+	// check whether the driver supports indirect drawing
+	static bool IsIndirectSupported();
+	// clear the draws collected for indirect drawing
+	void BeginIndirectDraws();
+	// collect one draw for indirect drawing
+	void AddIndirectDraw(RenderQueue::MESH_TYPE mesh, const INSTANCE_DATA& data);
+	// send the collected draws to the GPU in one upload per buffer,
+	// keeping static draws out of the ring buffer so they can be reused
+	void UploadIndirectDraws(GLuint storageBinding, bool bStatic = false);
+	// bind the draws of the last static upload again
+	void BindIndirectDraws(GLuint storageBinding);
+	// draw a range of the collected draws with one call
+	void DrawIndirect(int firstDraw, int drawCount);
+};
@@ -0,0 +1,200 @@
+///////////////////////////////////////////////////////////////////////////////
+// commandlist.cpp
+// ============
+// retained list of recorded draw commands, grouped by scene object so that
+// only the objects which changed are recorded again
+///////////////////////////////////////////////////////////////////////////////
+
+#include "CommandList.h"
+
+// declaration of global variables
+namespace
+{
+	// object that receives the draws recorded before any
+	// object has been started
+	const char* g_RootObjectName = "";
+}
+
+/***********************************************************
+ *  CommandList()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+CommandList::CommandList()
+{
+	m_currentObject = -1;
+	m_dirtyCount = 0;
+	m_bRecording = false;
+	m_bChanged = false;
+}
+
+/***********************************************************
+ *  ~CommandList()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+CommandList::~CommandList()
+{
+	Clear();
+}
+
+/***********************************************************
+ *  BeginRecording()
+ *
+ *  This method is used for starting a recording pass.  The
+ *  draws made before the first object is started belong to
+ *  an unnamed root object.
+ ***********************************************************/
+void CommandList::BeginRecording(RenderQueue::DRAW_COMMAND& state)
+{
+	m_bRecording = true;
+	BeginObject(g_RootObjectName, state);
+}
+
+/***********************************************************
+ *  EndRecording()
+ *
+ *  This method is used for finishing a recording pass.
+ *  Every object that was recorded is now up to date.
+ ***********************************************************/
+void CommandList::EndRecording()
+{
+	for (size_t i = 0; (i < m_objects.size()) && (m_dirtyCount > 0); i++)
+	{
+		if (m_objects[i].bDirty == true)
+		{
+			m_objects[i].bDirty = false;
+			m_dirtyCount--;
+			m_bChanged = true;
+		}
+	}
+
+	m_bRecording = false;
+	m_currentObject = -1;
+}
+
+/***********************************************************
+ *  BeginObject()
+ *
+ *  This method is used for starting the commands of the
+ *  named object.  A new or invalidated object is recorded,
+ *  in which case the passed in draw state is set to what it
+ *  was when the object was first recorded, so the object
+ *  draws the same whether or not the objects before it were
+ *  recorded in this pass.  Otherwise false is returned and
+ *  the object's draws are skipped.
+ ***********************************************************/
+bool CommandList::BeginObject(const std::string& name, RenderQueue::DRAW_COMMAND& state)
+{
+	std::unordered_map<std::string, int>::iterator found = m_objectIndices.find(name);
+
+	m_currentObject = -1;
+	if (m_bRecording == false)
+	{
+		return(false);
+	}
+
+	if (found == m_objectIndices.end())
+	{
+		OBJECT_ENTRY entry;
+		entry.name = name;
+		entry.bDirty = true;
+		entry.startState = state;
+		m_objects.push_back(entry);
+		m_objectIndices[name] = (int)m_objects.size() - 1;
+		m_dirtyCount++;
+		m_currentObject = (int)m_objects.size() - 1;
+		return(true);
+	}
+
+	if (m_objects[found->second].bDirty == false)
+	{
+		return(false);
+	}
+
+	m_currentObject = found->second;
+	m_objects[m_currentObject].commands.clear();
+	state = m_objects[m_currentObject].startState;
+	return(true);
+}
+
+/***********************************************************
+ *  Record()
+ *
+ *  This method is used for storing a draw command for the
+ *  object being recorded.  Draws of skipped objects are
+ *  ignored.
+ ***********************************************************/
+void CommandList::Record(const RenderQueue::DRAW_COMMAND& command)
+{
+	if (IsRecordingObject() == true)
+	{
+		m_objects[m_currentObject].commands.push_back(command);
+	}
+}
+
+/***********************************************************
+ *  Invalidate()
+ *
+ *  This method is used for marking the named object so that
+ *  its draws are recorded again on the next pass.
+ ***********************************************************/
+void CommandList::Invalidate(const std::string& name)
+{
+	std::unordered_map<std::string, int>::iterator found = m_objectIndices.find(name);
+
+	if ((found != m_objectIndices.end()) && (m_objects[found->second].bDirty == false))
+	{
+		m_objects[found->second].bDirty = true;
+		m_dirtyCount++;
+	}
+}
+
+/***********************************************************
+ *  InvalidateAll()
+ *
+ *  This method is used for marking every object so that the
+ *  whole scene is recorded again on the next pass.
+ ***********************************************************/
+void CommandList::InvalidateAll()
+{
+	for (size_t i = 0; i < m_objects.size(); i++)
+	{
+		m_objects[i].bDirty = true;
+	}
+	m_dirtyCount = (int)m_objects.size();
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing every object, so that
+ *  the next pass records the scene from scratch.
+ ***********************************************************/
+void CommandList::Clear()
+{
+	m_objects.clear();
+	m_objectIndices.clear();
+	m_currentObject = -1;
+	m_dirtyCount = 0;
+	m_bChanged = true;
+}
+
+/***********************************************************
+ *  Replay()
+ *
+ *  This method is used for passing every stored command to
+ *  the submit function in recorded order.
+ ***********************************************************/
+void CommandList::Replay(const SUBMIT_CALLBACK& submit)
+{
+	for (size_t i = 0; i < m_objects.size(); i++)
+	{
+		const std::vector<RenderQueue::DRAW_COMMAND>& commands = m_objects[i].commands;
+		for (size_t j = 0; j < commands.size(); j++)
+		{
+			submit(commands[j]);
+		}
+	}
+	m_bChanged = false;
+}
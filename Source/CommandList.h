@@ -0,0 +1,89 @@
+///////////////////////////////////////////////////////////////////////////////
+// commandlist.h
+// ============
+// retained list of recorded draw commands, grouped by scene object so that
+// only the objects which changed are recorded again
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "RenderQueue.h"
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/***********************************************************
+ *  CommandList
+ *
+ *  This class keeps the draw commands of a scene between
+ *  frames.  The commands are grouped by named scene object.
+ *  On the first recording pass every object is stored, and
+ *  on later passes only the objects that were invalidated
+ *  take new commands, so the work of recording is limited
+ *  to what changed.  Replaying hands the stored commands to
+ *  a submit function without running any scene code.
+ ***********************************************************/
+class CommandList
+{
+public:
+	// constructor
+	CommandList();
+	// destructor
+	~CommandList();
+
+	// called with each stored command when replaying
+	typedef std::function<void(const RenderQueue::DRAW_COMMAND& command)> SUBMIT_CALLBACK;
+
+private:
+	struct OBJECT_ENTRY
+	{
+		std::string name;
+		// true when the commands must be recorded again
+		bool bDirty;
+		// draw state in effect when the object was first recorded
+		RenderQueue::DRAW_COMMAND startState;
+		// commands recorded for the object
+		std::vector<RenderQueue::DRAW_COMMAND> commands;
+	};
+
+	// scene objects in recorded order
+	std::vector<OBJECT_ENTRY> m_objects;
+	// index of each object keyed by name
+	std::unordered_map<std::string, int> m_objectIndices;
+	// object receiving recorded commands, -1 when skipping
+	int m_currentObject;
+	// number of objects that need to be recorded again
+	int m_dirtyCount;
+	// true while a recording pass is running
+	bool m_bRecording;
+	// true when the commands changed since the last replay
+	bool m_bChanged;
+
+public:
+	// check whether any object needs to be recorded
+	bool NeedsRecording() const { return((m_objects.size() == 0) || (m_dirtyCount > 0)); }
+	// check whether the commands changed since the last replay
+	bool HasChanged() const { return(m_bChanged); }
+	// check whether draws are being stored for the current object
+	bool IsRecordingObject() const { return((m_bRecording == true) && (m_currentObject >= 0)); }
+
+	// start and finish a recording pass
+	void BeginRecording(RenderQueue::DRAW_COMMAND& state);
+	void EndRecording();
+	// start the commands of a named object, returning true
+	// when its draws must be recorded during this pass
+	bool BeginObject(const std::string& name, RenderQueue::DRAW_COMMAND& state);
+	// store a draw command for the current object
+	void Record(const RenderQueue::DRAW_COMMAND& command);
+
+	// mark an object, or every object, to be recorded again
+	void Invalidate(const std::string& name);
+	void InvalidateAll();
+	// remove every object
+	void Clear();
+
+	// pass every stored command to the submit function
+	void Replay(const SUBMIT_CALLBACK& submit);
+};
@@ -0,0 +1,106 @@
+///////////////////////////////////////////////////////////////////////////////
+// frameuniformbuffer.cpp
+// ============
+// per-frame camera and timing values kept in one std140 uniform buffer that
+// is shared by every shader program
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrameUniformBuffer.h"
+
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	const char* g_FrameDataBlockName = "FrameData";
+
+	// uniform buffer binding point of the frame data
+	const GLuint g_FrameDataBinding = LAYOUT_FRAME_DATA_BINDING;
+}
+
+// the frame data is written to the FrameData block as it is
+SHADER_LAYOUT_ASSERT(FrameUniformBuffer::FRAME_DATA, FRAME_DATA_LAYOUT, LAYOUT_STD140);
+
+/***********************************************************
+ *  FrameUniformBuffer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FrameUniformBuffer::FrameUniformBuffer()
+{
+	m_buffer = 0;
+}
+
+/***********************************************************
+ *  ~FrameUniformBuffer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FrameUniformBuffer::~FrameUniformBuffer()
+{
+	if (0 != m_buffer)
+	{
+		glDeleteBuffers(1, &m_buffer);
+	}
+	m_buffer = 0;
+}
+
+/***********************************************************
+ *  CreateBuffer()
+ *
+ *  This method is used for creating the uniform buffer and
+ *  attaching it to the frame data binding point, where it
+ *  stays for the life of the application.
+ ***********************************************************/
+void FrameUniformBuffer::CreateBuffer()
+{
+	glGenBuffers(1, &m_buffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(FRAME_DATA), NULL, GL_DYNAMIC_DRAW);
+	glBindBufferBase(GL_UNIFORM_BUFFER, g_FrameDataBinding, m_buffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+/***********************************************************
+ *  AttachProgram()
+ *
+ *  This method is used for connecting the FrameData block of
+ *  the passed in linked program to the frame data binding
+ *  point.  It must be called for every program that reads
+ *  the block, and again whenever the program is relinked.
+ ***********************************************************/
+void FrameUniformBuffer::AttachProgram(GLuint programID)
+{
+	GLuint blockIndex = GL_INVALID_INDEX;
+
+	if (0 == m_buffer)
+	{
+		CreateBuffer();
+	}
+
+	blockIndex = glGetUniformBlockIndex(programID, g_FrameDataBlockName);
+	if (GL_INVALID_INDEX == blockIndex)
+	{
+		std::cout << "ERROR: Program " << programID << " has no " << g_FrameDataBlockName << " block" << std::endl;
+		return;
+	}
+	glUniformBlockBinding(programID, blockIndex, g_FrameDataBinding);
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used for writing the values for the
+ *  current frame into the uniform buffer with one call.
+ ***********************************************************/
+void FrameUniformBuffer::Update(const FRAME_DATA& frameData)
+{
+	if (0 == m_buffer)
+	{
+		CreateBuffer();
+	}
+
+	glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FRAME_DATA), &frameData);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
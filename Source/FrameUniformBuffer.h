@@ -0,0 +1,51 @@
+///////////////////////////////////////////////////////////////////////////////
+// frameuniformbuffer.h
+// ============
+// per-frame camera and timing values kept in one std140 uniform buffer that
+// is shared by every shader program
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderLayouts.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  FrameUniformBuffer
+ *
+ *  This class owns the uniform buffer that holds the values
+ *  which are the same for every draw of a frame.  Each
+ *  program connects its FrameData block to the buffer's
+ *  binding point once, after which the whole block is
+ *  updated with a single buffer write per frame.
+ ***********************************************************/
+class FrameUniformBuffer
+{
+public:
+	// constructor
+	FrameUniformBuffer();
+	// destructor
+	~FrameUniformBuffer();
+
+	// per-frame values, read through the FrameData block in
+	// the shaders under std140 packing rules
+	struct FRAME_DATA
+	{
+		FRAME_DATA_LAYOUT(SHADER_LAYOUT_MEMBER, SHADER_LAYOUT_MEMBER_PAD)
+	};
+
+private:
+	// uniform buffer holding the frame data
+	GLuint m_buffer;
+
+	// create the buffer and attach it to its binding point
+	void CreateBuffer();
+
+public:
+	// connect the FrameData block of a linked program to the buffer
+	void AttachProgram(GLuint programID);
+	// write the values for the current frame
+	void Update(const FRAME_DATA& frameData);
+};
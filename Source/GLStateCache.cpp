@@ -0,0 +1,590 @@
+///////////////////////////////////////////////////////////////////////////////
+// glstatecache.cpp
+// ============
+// shadow copy of the OpenGL and shader state that drops calls which would
+// set a value that is already in place
+///////////////////////////////////////////////////////////////////////////////
+
+#include "GLStateCache.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <cstring>
+#include <iostream>
+
+/***********************************************************
+ *  GLStateCache()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+GLStateCache::GLStateCache()
+{
+	memset(&m_reportedStats, 0, sizeof(m_reportedStats));
+	Invalidate();
+}
+
+/***********************************************************
+ *  ~GLStateCache()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+GLStateCache::~GLStateCache()
+{
+	m_pBoundProgram = NULL;
+	m_programs.clear();
+	m_enableBits.clear();
+}
+
+/***********************************************************
+ *  Invalidate()
+ *
+ *  This method is used for forgetting all of the cached
+ *  state, so that the next call of every kind is passed on.
+ *  It must be called after any code changes GL state
+ *  without going through the cache.  The uniform tables of
+ *  the registered programs are kept.
+ ***********************************************************/
+void GLStateCache::Invalidate()
+{
+	std::unordered_map<GLuint, PROGRAM_STATE>::iterator program;
+
+	m_boundProgramID = 0;
+	m_pBoundProgram = NULL;
+	for (program = m_programs.begin(); program != m_programs.end(); program++)
+	{
+		program->second.slotValues.assign(program->second.slotValues.size(), UNIFORM_VALUE());
+		program->second.namedValues.clear();
+	}
+	m_enableBits.clear();
+	for (int i = 0; i < MAX_TEXTURE_UNITS; i++)
+	{
+		m_boundTextures[i] = 0;
+		m_boundTargets[i] = GL_TEXTURE_2D;
+	}
+	m_activeTexture = 0;
+	m_clearColor = glm::vec4(0.0f);
+	m_bClearColorSet = false;
+	m_blendSource = 0;
+	m_blendDestination = 0;
+	memset(&m_frameStats, 0, sizeof(m_frameStats));
+}
+
+/***********************************************************
+ *  CountCall()
+ *
+ *  This method is used for counting a call that was either
+ *  passed on to OpenGL or dropped as redundant.
+ ***********************************************************/
+void GLStateCache::CountCall(bool bIssued)
+{
+	if (bIssued == true)
+	{
+		m_frameStats.issuedCalls++;
+	}
+	else
+	{
+		m_frameStats.elidedCalls++;
+	}
+}
+
+/***********************************************************
+ *  GetBoundProgram()
+ *
+ *  This method is used for getting the uniform state of the
+ *  program that receives the uniform values, which must not
+ *  be zero.
+ ***********************************************************/
+GLStateCache::PROGRAM_STATE& GLStateCache::GetBoundProgram()
+{
+	if (NULL == m_pBoundProgram)
+	{
+		GetUniformTable(m_boundProgramID);
+		m_pBoundProgram = &m_programs[m_boundProgramID];
+	}
+	return(*m_pBoundProgram);
+}
+
+/***********************************************************
+ *  GetUniformLocation()
+ *
+ *  This method is used for looking up the location of a
+ *  named uniform of the bound program.
+ ***********************************************************/
+GLint GLStateCache::GetUniformLocation(const std::string& name)
+{
+	return(glGetUniformLocation(m_boundProgramID, name.c_str()));
+}
+
+/***********************************************************
+ *  UpdateValue()
+ *
+ *  This method is used for comparing the passed in value
+ *  with a stored uniform value.  The new value is stored and
+ *  true is returned when it differs.
+ ***********************************************************/
+bool GLStateCache::UpdateValue(UNIFORM_VALUE& stored, const void* data, int size)
+{
+	bool bChanged = false;
+
+	if ((stored.size != size) ||
+		(memcmp(stored.data, data, sizeof(float) * size) != 0))
+	{
+		stored.size = size;
+		memcpy(stored.data, data, sizeof(float) * size);
+		bChanged = true;
+	}
+
+	CountCall(bChanged);
+	return(bChanged);
+}
+
+/***********************************************************
+ *  UpdateUniform()
+ *
+ *  This method is used for comparing the passed in value
+ *  with the last value sent to the named uniform of the
+ *  bound program.  Without a bound program there is nothing
+ *  to set, so false is returned.
+ ***********************************************************/
+bool GLStateCache::UpdateUniform(const std::string& name, const void* data, int size)
+{
+	if (0 == m_boundProgramID)
+	{
+		return(false);
+	}
+	return(UpdateValue(GetBoundProgram().namedValues[name], data, size));
+}
+
+/***********************************************************
+ *  UpdateUniformSlot()
+ *
+ *  This method is used for comparing the passed in value
+ *  with the last value sent through a uniform handle.  The
+ *  slot indexes straight into the program's stored values.
+ ***********************************************************/
+bool GLStateCache::UpdateUniformSlot(int slot, const void* data, int size)
+{
+	if (0 == m_boundProgramID)
+	{
+		return(false);
+	}
+
+	PROGRAM_STATE& program = GetBoundProgram();
+	if ((slot < 0) || (slot >= (int)program.slotValues.size()))
+	{
+		return(false);
+	}
+	return(UpdateValue(program.slotValues[slot], data, size));
+}
+
+/***********************************************************
+ *  RegisterProgram()
+ *
+ *  This method is used for building the uniform table of the
+ *  passed in program.  It must be called again whenever the
+ *  program is relinked.
+ ***********************************************************/
+void GLStateCache::RegisterProgram(GLuint programID)
+{
+	PROGRAM_STATE& program = m_programs[programID];
+
+	program.uniformTable.Build(programID);
+	program.slotValues.assign(program.uniformTable.GetSlotCount(), UNIFORM_VALUE());
+	program.namedValues.clear();
+}
+
+/***********************************************************
+ *  GetUniformTable()
+ *
+ *  This method is used for getting the uniform table of a
+ *  program, registering the program first if needed.
+ ***********************************************************/
+const UniformTable* GLStateCache::GetUniformTable(GLuint programID)
+{
+	std::unordered_map<GLuint, PROGRAM_STATE>::iterator found = m_programs.find(programID);
+
+	if ((found == m_programs.end()) || (found->second.uniformTable.GetProgramID() == 0))
+	{
+		RegisterProgram(programID);
+		found = m_programs.find(programID);
+	}
+	return(&found->second.uniformTable);
+}
+
+/***********************************************************
+ *  ForgetProgram()
+ *
+ *  This method is used for dropping the uniform table and
+ *  values of a program that is about to be deleted, since
+ *  OpenGL may hand its name out again for a new program.
+ ***********************************************************/
+void GLStateCache::ForgetProgram(GLuint programID)
+{
+	if (programID == m_boundProgramID)
+	{
+		m_boundProgramID = 0;
+		m_pBoundProgram = NULL;
+	}
+	m_programs.erase(programID);
+}
+
+/***********************************************************
+ *  ForgetTexture()
+ *
+ *  This method is used for dropping a texture that is about
+ *  to be deleted from the units it is bound to.  Deleting a
+ *  texture unbinds it, and a new texture given the same
+ *  name must not be taken as already bound.
+ ***********************************************************/
+void GLStateCache::ForgetTexture(GLuint textureID)
+{
+	for (int i = 0; i < MAX_TEXTURE_UNITS; i++)
+	{
+		if (m_boundTextures[i] == textureID)
+		{
+			m_boundTextures[i] = 0;
+		}
+	}
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for writing the number of issued and
+ *  elided calls to the console when they differ from the
+ *  previously written values, then resetting them.
+ ***********************************************************/
+void GLStateCache::EndFrame()
+{
+	if (memcmp(&m_frameStats, &m_reportedStats, sizeof(CACHE_STATS)) != 0)
+	{
+		std::cout << "INFO: GLStateCache - calls issued:" << m_frameStats.issuedCalls
+			<< ", elided:" << m_frameStats.elidedCalls << std::endl;
+		m_reportedStats = m_frameStats;
+	}
+	memset(&m_frameStats, 0, sizeof(m_frameStats));
+}
+
+/***********************************************************
+ *  UseProgram()
+ *
+ *  This method is used for binding the passed in program
+ *  when it is not already bound.
+ ***********************************************************/
+void GLStateCache::UseProgram(GLuint programID)
+{
+	bool bChanged = (programID != m_boundProgramID) || (NULL == m_pBoundProgram);
+
+	if ((bChanged == true) && (programID != 0))
+	{
+		// the first bind of a program builds its uniform table
+		GetUniformTable(programID);
+		glUseProgram(programID);
+		m_boundProgramID = programID;
+		m_pBoundProgram = &m_programs[programID];
+	}
+	CountCall(bChanged);
+}
+
+/***********************************************************
+ *  Enable()
+ *
+ *  This method is used for enabling an OpenGL capability
+ *  when it is not already enabled.
+ ***********************************************************/
+void GLStateCache::Enable(GLenum capability)
+{
+	std::unordered_map<GLenum, bool>::iterator found = m_enableBits.find(capability);
+	bool bChanged = (found == m_enableBits.end()) || (found->second == false);
+
+	if (bChanged == true)
+	{
+		glEnable(capability);
+		m_enableBits[capability] = true;
+	}
+	CountCall(bChanged);
+}
+
+/***********************************************************
+ *  Disable()
+ *
+ *  This method is used for disabling an OpenGL capability
+ *  when it is not already disabled.
+ ***********************************************************/
+void GLStateCache::Disable(GLenum capability)
+{
+	std::unordered_map<GLenum, bool>::iterator found = m_enableBits.find(capability);
+	bool bChanged = (found == m_enableBits.end()) || (found->second == true);
+
+	if (bChanged == true)
+	{
+		glDisable(capability);
+		m_enableBits[capability] = false;
+	}
+	CountCall(bChanged);
+}
+
+/***********************************************************
+ *  ClearColor()
+ *
+ *  This method is used for setting the clear color when it
+ *  differs from the current one.
+ ***********************************************************/
+void GLStateCache::ClearColor(float red, float green, float blue, float alpha)
+{
+	glm::vec4 color = glm::vec4(red, green, blue, alpha);
+	bool bChanged = (m_bClearColorSet == false) || (color != m_clearColor);
+
+	if (bChanged == true)
+	{
+		glClearColor(red, green, blue, alpha);
+		m_clearColor = color;
+		m_bClearColorSet = true;
+	}
+	CountCall(bChanged);
+}
+
+/***********************************************************
+ *  BlendFunc()
+ *
+ *  This method is used for setting the blend factors when
+ *  they differ from the current ones.
+ ***********************************************************/
+void GLStateCache::BlendFunc(GLenum source, GLenum destination)
+{
+	bool bChanged = (source != m_blendSource) || (destination != m_blendDestination);
+
+	if (bChanged == true)
+	{
+		glBlendFunc(source, destination);
+		m_blendSource = source;
+		m_blendDestination = destination;
+	}
+	CountCall(bChanged);
+}
+
+/***********************************************************
+ *  BindTexture()
+ *
+ *  This method is used for binding a texture to a texture
+ *  unit, as a 2D texture unless another target is passed.
+ *  The active unit is only switched when the binding on
+ *  that unit has to change.
+ ***********************************************************/
+void GLStateCache::BindTexture(int unit, GLuint textureID, GLenum target)
+{
+	bool bChanged = true;
+
+	if ((unit >= 0) && (unit < MAX_TEXTURE_UNITS))
+	{
+		bChanged = (m_boundTextures[unit] != textureID) || (m_boundTargets[unit] != target);
+	}
+
+	if (bChanged == true)
+	{
+		if (m_activeTexture != (GLenum)(GL_TEXTURE0 + unit))
+		{
+			glActiveTexture(GL_TEXTURE0 + unit);
+			m_activeTexture = GL_TEXTURE0 + unit;
+		}
+		glBindTexture(target, textureID);
+		if ((unit >= 0) && (unit < MAX_TEXTURE_UNITS))
+		{
+			m_boundTextures[unit] = textureID;
+			m_boundTargets[unit] = target;
+		}
+	}
+	CountCall(bChanged);
+}
+
+/***********************************************************
+ *  setBoolValue()
+ *
+ *  This method is used for setting a bool uniform when the
+ *  value has changed.
+ ***********************************************************/
+void GLStateCache::setBoolValue(const std::string& name, bool value)
+{
+	int data = value ? 1 : 0;
+
+	if (UpdateUniform(name, &data, 1) == true)
+	{
+		glUniform1i(GetUniformLocation(name), data);
+	}
+}
+
+/***********************************************************
+ *  setIntValue()
+ *
+ *  This method is used for setting an int uniform when the
+ *  value has changed.
+ ***********************************************************/
+void GLStateCache::setIntValue(const std::string& name, int value)
+{
+	if (UpdateUniform(name, &value, 1) == true)
+	{
+		glUniform1i(GetUniformLocation(name), value);
+	}
+}
+
+/***********************************************************
+ *  setFloatValue()
+ *
+ *  This method is used for setting a float uniform when the
+ *  value has changed.
+ ***********************************************************/
+void GLStateCache::setFloatValue(const std::string& name, float value)
+{
+	if (UpdateUniform(name, &value, 1) == true)
+	{
+		glUniform1f(GetUniformLocation(name), value);
+	}
+}
+
+/***********************************************************
+ *  setSampler2DValue()
+ *
+ *  This method is used for setting a sampler uniform when
+ *  the texture unit has changed.
+ ***********************************************************/
+void GLStateCache::setSampler2DValue(const std::string& name, int value)
+{
+	if (UpdateUniform(name, &value, 1) == true)
+	{
+		glUniform1i(GetUniformLocation(name), value);
+	}
+}
+
+/***********************************************************
+ *  setVec2Value()
+ *
+ *  This method is used for setting a vec2 uniform when the
+ *  value has changed.
+ ***********************************************************/
+void GLStateCache::setVec2Value(const std::string& name, glm::vec2 value)
+{
+	if (UpdateUniform(name, glm::value_ptr(value), 2) == true)
+	{
+		glUniform2fv(GetUniformLocation(name), 1, glm::value_ptr(value));
+	}
+}
+
+/***********************************************************
+ *  setVec3Value()
+ *
+ *  This method is used for setting a vec3 uniform when the
+ *  value has changed.
+ ***********************************************************/
+void GLStateCache::setVec3Value(const std::string& name, glm::vec3 value)
+{
+	if (UpdateUniform(name, glm::value_ptr(value), 3) == true)
+	{
+		glUniform3fv(GetUniformLocation(name), 1, glm::value_ptr(value));
+	}
+}
+
+void GLStateCache::setVec3Value(const std::string& name, float x, float y, float z)
+{
+	setVec3Value(name, glm::vec3(x, y, z));
+}
+
+/***********************************************************
+ *  setVec4Value()
+ *
+ *  This method is used for setting a vec4 uniform when the
+ *  value has changed.
+ ***********************************************************/
+void GLStateCache::setVec4Value(const std::string& name, glm::vec4 value)
+{
+	if (UpdateUniform(name, glm::value_ptr(value), 4) == true)
+	{
+		glUniform4fv(GetUniformLocation(name), 1, glm::value_ptr(value));
+	}
+}
+
+/***********************************************************
+ *  setMat4Value()
+ *
+ *  This method is used for setting a mat4 uniform when the
+ *  value has changed.
+ ***********************************************************/
+void GLStateCache::setMat4Value(const std::string& name, const glm::mat4& value)
+{
+	if (UpdateUniform(name, glm::value_ptr(value), 16) == true)
+	{
+		glUniformMatrix4fv(GetUniformLocation(name), 1, GL_FALSE, glm::value_ptr(value));
+	}
+}
+
+/***********************************************************
+ *  SetUniform()
+ *
+ *  These methods are used for setting a uniform of the bound
+ *  program through a resolved handle when the value has
+ *  changed.
+ ***********************************************************/
+void GLStateCache::SetUniform(const UniformHandle<bool>& handle, bool value)
+{
+	int data = value ? 1 : 0;
+
+	if (UpdateUniformSlot(handle.slot, &data, 1) == true)
+	{
+		::SetUniform(handle, value);
+	}
+}
+
+void GLStateCache::SetUniform(const UniformHandle<int>& handle, int value)
+{
+	if (UpdateUniformSlot(handle.slot, &value, 1) == true)
+	{
+		::SetUniform(handle, value);
+	}
+}
+
+void GLStateCache::SetUniform(const UniformHandle<float>& handle, float value)
+{
+	if (UpdateUniformSlot(handle.slot, &value, 1) == true)
+	{
+		::SetUniform(handle, value);
+	}
+}
+
+void GLStateCache::SetUniform(const UniformHandle<glm::vec2>& handle, const glm::vec2& value)
+{
+	if (UpdateUniformSlot(handle.slot, glm::value_ptr(value), 2) == true)
+	{
+		::SetUniform(handle, value);
+	}
+}
+
+void GLStateCache::SetUniform(const UniformHandle<glm::vec3>& handle, const glm::vec3& value)
+{
+	if (UpdateUniformSlot(handle.slot, glm::value_ptr(value), 3) == true)
+	{
+		::SetUniform(handle, value);
+	}
+}
+
+void GLStateCache::SetUniform(const UniformHandle<glm::vec4>& handle, const glm::vec4& value)
+{
+	if (UpdateUniformSlot(handle.slot, glm::value_ptr(value), 4) == true)
+	{
+		::SetUniform(handle, value);
+	}
+}
+
+void GLStateCache::SetUniform(const UniformHandle<glm::mat3>& handle, const glm::mat3& value)
+{
+	if (UpdateUniformSlot(handle.slot, glm::value_ptr(value), 9) == true)
+	{
+		::SetUniform(handle, value);
+	}
+}
+
+void GLStateCache::SetUniform(const UniformHandle<glm::mat4>& handle, const glm::mat4& value)
+{
+	if (UpdateUniformSlot(handle.slot, glm::value_ptr(value), 16) == true)
+	{
+		::SetUniform(handle, value);
+	}
+}
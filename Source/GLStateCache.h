@@ -0,0 +1,150 @@
+///////////////////////////////////////////////////////////////////////////////
+// glstatecache.h
+// ============
+// shadow copy of the OpenGL and shader state that drops calls which would
+// set a value that is already in place
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "UniformTable.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/***********************************************************
+ *  GLStateCache
+ *
+ *  This class sits between the scene and view managers and
+ *  OpenGL.  It remembers the bound program, the texture
+ *  bound to each unit, the enable bits, the clear color and
+ *  the last value sent to every uniform, and only passes a
+ *  call on when it would change something.
+ *
+ *  Uniforms can be set by name, or by a handle from the
+ *  program's uniform table, in which case the last value is
+ *  found by the handle's slot without any string hashing.
+ *  Programs are tracked by their OpenGL object, and values
+ *  set before any program is bound are dropped.
+ ***********************************************************/
+class GLStateCache
+{
+public:
+	// constructor
+	GLStateCache();
+	// destructor
+	~GLStateCache();
+
+	struct CACHE_STATS
+	{
+		int issuedCalls;
+		int elidedCalls;
+	};
+
+private:
+	// largest uniform that can be cached, a 4x4 matrix
+	static const int MAX_UNIFORM_FLOATS = 16;
+	// number of texture units that are tracked
+	static const int MAX_TEXTURE_UNITS = 32;
+
+	struct UNIFORM_VALUE
+	{
+		int size;
+		float data[MAX_UNIFORM_FLOATS];
+	};
+
+	// uniform table and last sent values of one program
+	struct PROGRAM_STATE
+	{
+		UniformTable uniformTable;
+		std::vector<UNIFORM_VALUE> slotValues;
+		std::unordered_map<std::string, UNIFORM_VALUE> namedValues;
+	};
+
+	// program that is currently bound, zero when unknown
+	GLuint m_boundProgramID;
+	// uniform tables and last sent values of each program
+	std::unordered_map<GLuint, PROGRAM_STATE> m_programs;
+	// state of the bound program
+	PROGRAM_STATE* m_pBoundProgram;
+	// last state of each enable bit
+	std::unordered_map<GLenum, bool> m_enableBits;
+	// texture bound to each texture unit, zero when unknown
+	GLuint m_boundTextures[MAX_TEXTURE_UNITS];
+	// target the texture of each unit was bound to
+	GLenum m_boundTargets[MAX_TEXTURE_UNITS];
+	// currently active texture unit
+	GLenum m_activeTexture;
+	// current clear color
+	glm::vec4 m_clearColor;
+	bool m_bClearColorSet;
+	// current blend factors
+	GLenum m_blendSource;
+	GLenum m_blendDestination;
+	// statistics for the current frame
+	CACHE_STATS m_frameStats;
+	// statistics that were last written to the console
+	CACHE_STATS m_reportedStats;
+
+	// get the state of the bound program
+	PROGRAM_STATE& GetBoundProgram();
+	// get the location of a named uniform of the bound program
+	GLint GetUniformLocation(const std::string& name);
+	// store a uniform value, returning true when it changed
+	bool UpdateUniform(const std::string& name, const void* data, int size);
+	bool UpdateUniformSlot(int slot, const void* data, int size);
+	// compare and store a uniform value
+	bool UpdateValue(UNIFORM_VALUE& stored, const void* data, int size);
+	// count a call that was passed on or dropped
+	void CountCall(bool bIssued);
+
+public:
+	// forget all of the cached state
+	void Invalidate();
+	// report the statistics when they have changed and reset them
+	void EndFrame();
+	// get the statistics for the current frame
+	const CACHE_STATS& GetFrameStats() const { return(m_frameStats); }
+
+	// build the uniform table of a newly linked program
+	void RegisterProgram(GLuint programID);
+	// get the uniform table of a registered program
+	const UniformTable* GetUniformTable(GLuint programID);
+	// drop the state of a program that is about to be deleted
+	void ForgetProgram(GLuint programID);
+	// drop the bindings of a texture that is about to be deleted
+	void ForgetTexture(GLuint textureID);
+
+	// fixed function state
+	void UseProgram(GLuint programID);
+	void Enable(GLenum capability);
+	void Disable(GLenum capability);
+	void ClearColor(float red, float green, float blue, float alpha);
+	void BlendFunc(GLenum source, GLenum destination);
+	void BindTexture(int unit, GLuint textureID, GLenum target = GL_TEXTURE_2D);
+
+	// uniform values of the bound program
+	void setBoolValue(const std::string& name, bool value);
+	void setIntValue(const std::string& name, int value);
+	void setFloatValue(const std::string& name, float value);
+	void setSampler2DValue(const std::string& name, int value);
+	void setVec2Value(const std::string& name, glm::vec2 value);
+	void setVec3Value(const std::string& name, glm::vec3 value);
+	void setVec3Value(const std::string& name, float x, float y, float z);
+	void setVec4Value(const std::string& name, glm::vec4 value);
+	void setMat4Value(const std::string& name, const glm::mat4& value);
+
+	// uniform values of the bound program, set through handles
+	void SetUniform(const UniformHandle<bool>& handle, bool value);
+	void SetUniform(const UniformHandle<int>& handle, int value);
+	void SetUniform(const UniformHandle<float>& handle, float value);
+	void SetUniform(const UniformHandle<glm::vec2>& handle, const glm::vec2& value);
+	void SetUniform(const UniformHandle<glm::vec3>& handle, const glm::vec3& value);
+	void SetUniform(const UniformHandle<glm::vec4>& handle, const glm::vec4& value);
+	void SetUniform(const UniformHandle<glm::mat3>& handle, const glm::mat3& value);
+	void SetUniform(const UniformHandle<glm::mat4>& handle, const glm::mat4& value);
+};
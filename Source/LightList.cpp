@@ -0,0 +1,331 @@
+///////////////////////////////////////////////////////////////////////////////
+// lightlist.cpp
+// ============
+// registry of the scene's light sources, uploaded to the shaders as one
+// buffer holding any number of lights
+///////////////////////////////////////////////////////////////////////////////
+
+#include "LightList.h"
+
+#include <cstring>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	const char* g_LightBlockName = "LightBuffer";
+
+	// storage or uniform buffer binding point of the lights
+	const GLuint g_LightBinding = LAYOUT_LIGHT_BINDING;
+}
+
+// the lights are copied into either kind of buffer as they are
+SHADER_LAYOUT_ASSERT(LightList::LIGHT_DATA, LIGHT_DATA_LAYOUT, LAYOUT_STD140);
+SHADER_LAYOUT_ASSERT(LightList::LIGHT_DATA, LIGHT_DATA_LAYOUT, LAYOUT_STD430);
+
+/***********************************************************
+ *  LightList()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+LightList::LightList()
+{
+	m_buffer = 0;
+	m_bufferSize = 0;
+	m_uploadedCount = 0;
+	// the shaders enable the storage buffer extension, so they
+	// declare the block as a storage buffer whenever it exists
+	m_bUseStorageBuffer = (GLEW_ARB_shader_storage_buffer_object == GL_TRUE);
+}
+
+/***********************************************************
+ *  ~LightList()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+LightList::~LightList()
+{
+	if (0 != m_buffer)
+	{
+		glDeleteBuffers(1, &m_buffer);
+	}
+	m_buffer = 0;
+	m_bufferSize = 0;
+	m_lights.clear();
+	m_uploadData.clear();
+}
+
+/***********************************************************
+ *  AddLight()
+ *
+ *  This method is used for adding an active light to the
+ *  registry and returning its index.
+ ***********************************************************/
+int LightList::AddLight(const LIGHT_DATA& data)
+{
+	LIGHT_ENTRY entry;
+
+	entry.data = data;
+	entry.bActive = true;
+	m_lights.push_back(entry);
+
+	return((int)m_lights.size() - 1);
+}
+
+/***********************************************************
+ *  AddDirectionalLight()
+ *
+ *  This method is used for adding a light that shines in
+ *  one direction over the whole scene.
+ ***********************************************************/
+int LightList::AddDirectionalLight(
+	glm::vec3 direction,
+	glm::vec3 ambient,
+	glm::vec3 diffuse,
+	glm::vec3 specular)
+{
+	LIGHT_DATA data;
+
+	data.position = glm::vec4(0.0f, 0.0f, 0.0f, (float)LIGHT_DIRECTIONAL);
+	data.direction = glm::vec4(direction, 0.0f);
+	data.ambient = glm::vec4(ambient, 0.0f);
+	data.diffuse = glm::vec4(diffuse, 0.0f);
+	data.specular = glm::vec4(specular, 0.0f);
+	data.attenuation = glm::vec4(1.0f, 0.0f, 0.0f, 0.0f);
+	data.cone = glm::vec4(0.0f);
+
+	return(AddLight(data));
+}
+
+/***********************************************************
+ *  AddPointLight()
+ *
+ *  This method is used for adding a light that shines in
+ *  every direction from one position.
+ ***********************************************************/
+int LightList::AddPointLight(
+	glm::vec3 position,
+	glm::vec3 ambient,
+	glm::vec3 diffuse,
+	glm::vec3 specular,
+	float constant,
+	float linear,
+	float quadratic)
+{
+	LIGHT_DATA data;
+
+	data.position = glm::vec4(position, (float)LIGHT_POINT);
+	data.direction = glm::vec4(0.0f);
+	data.ambient = glm::vec4(ambient, 0.0f);
+	data.diffuse = glm::vec4(diffuse, 0.0f);
+	data.specular = glm::vec4(specular, 0.0f);
+	data.attenuation = glm::vec4(constant, linear, quadratic, 0.0f);
+	data.cone = glm::vec4(0.0f);
+
+	return(AddLight(data));
+}
+
+/***********************************************************
+ *  AddSpotLight()
+ *
+ *  This method is used for adding a light that shines in a
+ *  cone from one position.  The edge of the cone fades out
+ *  between the inner and outer angles.
+ ***********************************************************/
+int LightList::AddSpotLight(
+	glm::vec3 position,
+	glm::vec3 direction,
+	glm::vec3 ambient,
+	glm::vec3 diffuse,
+	glm::vec3 specular,
+	float constant,
+	float linear,
+	float quadratic,
+	float cutOffDegrees,
+	float outerCutOffDegrees)
+{
+	LIGHT_DATA data;
+
+	data.position = glm::vec4(position, (float)LIGHT_SPOT);
+	data.direction = glm::vec4(direction, 0.0f);
+	data.ambient = glm::vec4(ambient, 0.0f);
+	data.diffuse = glm::vec4(diffuse, 0.0f);
+	data.specular = glm::vec4(specular, 0.0f);
+	data.attenuation = glm::vec4(constant, linear, quadratic, 0.0f);
+	data.cone = glm::vec4(
+		glm::cos(glm::radians(cutOffDegrees)),
+		glm::cos(glm::radians(outerCutOffDegrees)),
+		0.0f, 0.0f);
+
+	return(AddLight(data));
+}
+
+/***********************************************************
+ *  SetFollowCamera()
+ *
+ *  This method is used for making a light take its position
+ *  and direction from the camera, like a flashlight.
+ ***********************************************************/
+void LightList::SetFollowCamera(int index, bool bFollowCamera)
+{
+	if ((index >= 0) && (index < (int)m_lights.size()))
+	{
+		m_lights[index].data.direction.w = bFollowCamera ? 1.0f : 0.0f;
+	}
+}
+
+/***********************************************************
+ *  SetActive()
+ *
+ *  This method is used for switching a light on or off.
+ *  Lights that are off are left out of the next upload.
+ ***********************************************************/
+void LightList::SetActive(int index, bool bActive)
+{
+	if ((index >= 0) && (index < (int)m_lights.size()))
+	{
+		m_lights[index].bActive = bActive;
+	}
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing all of the lights.
+ ***********************************************************/
+void LightList::Clear()
+{
+	m_lights.clear();
+}
+
+/***********************************************************
+ *  AttachProgram()
+ *
+ *  This method is used for connecting the light buffer
+ *  block of the passed in linked program to the light
+ *  binding point, as the storage or uniform block the
+ *  shader declares on this driver.
+ ***********************************************************/
+void LightList::AttachProgram(GLuint programID)
+{
+	GLuint blockIndex = GL_INVALID_INDEX;
+
+	if (m_bUseStorageBuffer == true)
+	{
+		blockIndex = glGetProgramResourceIndex(programID, GL_SHADER_STORAGE_BLOCK, g_LightBlockName);
+		if (GL_INVALID_INDEX != blockIndex)
+		{
+			glShaderStorageBlockBinding(programID, blockIndex, g_LightBinding);
+		}
+	}
+	else
+	{
+		blockIndex = glGetUniformBlockIndex(programID, g_LightBlockName);
+		if (GL_INVALID_INDEX != blockIndex)
+		{
+			glUniformBlockBinding(programID, blockIndex, g_LightBinding);
+		}
+	}
+
+	if (GL_INVALID_INDEX == blockIndex)
+	{
+		std::cout << "ERROR: Program " << programID << " has no " << g_LightBlockName << " block" << std::endl;
+	}
+}
+
+/***********************************************************
+ *  PackLight()
+ *
+ *  This method is used for copying one light into the
+ *  upload behind the lights packed so far.  False is
+ *  returned when a uniform buffer has no room for it.
+ ***********************************************************/
+bool LightList::PackLight(const LIGHT_DATA& data, LIGHT_HEADER& header)
+{
+	if ((m_bUseStorageBuffer == false) && (header.lightCount >= MAX_UNIFORM_LIGHTS))
+	{
+		std::cout << "ERROR: Only " << MAX_UNIFORM_LIGHTS << " lights are supported without storage buffers" << std::endl;
+		return(false);
+	}
+	memcpy(&m_uploadData[sizeof(LIGHT_HEADER) + (header.lightCount * sizeof(LIGHT_DATA))],
+		&data, sizeof(LIGHT_DATA));
+	header.lightCount++;
+	return(true);
+}
+
+/***********************************************************
+ *  Upload()
+ *
+ *  This method is used for packing the active lights behind
+ *  a count and sending them to the GPU with one call.  The
+ *  directional lights are packed before the others.  The
+ *  baked light, which far objects are shaded with instead
+ *  of the lights, is the ambient of every light plus half
+ *  the diffuse of the directional lights, as an average
+ *  over the surfaces facing towards and away from them.
+ *  The buffer only grows, so an upload with fewer lights
+ *  reuses the existing data store.
+ ***********************************************************/
+void LightList::Upload()
+{
+	GLenum target = m_bUseStorageBuffer ? GL_SHADER_STORAGE_BUFFER : GL_UNIFORM_BUFFER;
+	LIGHT_HEADER header;
+	size_t dataSize = 0;
+	size_t bufferSize = 0;
+	bool bRoom = true;
+
+	header.lightCount = 0;
+	header.padding[0] = header.padding[1] = header.padding[2] = 0;
+	header.bakedAmbient = glm::vec4(0.0f);
+	header.bakedDiffuse = glm::vec4(0.0f);
+	m_uploadData.resize(sizeof(LIGHT_HEADER) + (m_lights.size() * sizeof(LIGHT_DATA)));
+
+	// the first pass packs the directional lights, the second
+	// pass every other light
+	for (int pass = 0; (pass < 2) && (bRoom == true); pass++)
+	{
+		for (size_t i = 0; (i < m_lights.size()) && (bRoom == true); i++)
+		{
+			const LIGHT_DATA& data = m_lights[i].data;
+			bool bDirectional = ((int)data.position.w == LIGHT_DIRECTIONAL);
+
+			if ((m_lights[i].bActive == false) || (bDirectional != (pass == 0)))
+			{
+				continue;
+			}
+			bRoom = PackLight(data, header);
+			if (bRoom == true)
+			{
+				header.bakedAmbient += glm::vec4(glm::vec3(data.ambient), 0.0f);
+				if (bDirectional == true)
+				{
+					header.bakedDiffuse += glm::vec4(glm::vec3(data.diffuse) * 0.5f, 0.0f);
+				}
+			}
+		}
+	}
+	memcpy(&m_uploadData[0], &header, sizeof(LIGHT_HEADER));
+	m_uploadedCount = header.lightCount;
+	dataSize = sizeof(LIGHT_HEADER) + (header.lightCount * sizeof(LIGHT_DATA));
+
+	// the uniform block always has room for the full array
+	bufferSize = dataSize;
+	if (m_bUseStorageBuffer == false)
+	{
+		bufferSize = sizeof(LIGHT_HEADER) + (MAX_UNIFORM_LIGHTS * sizeof(LIGHT_DATA));
+	}
+
+	if (0 == m_buffer)
+	{
+		glGenBuffers(1, &m_buffer);
+	}
+	glBindBuffer(target, m_buffer);
+	if (bufferSize > m_bufferSize)
+	{
+		m_bufferSize = bufferSize;
+		glBufferData(target, m_bufferSize, NULL, GL_DYNAMIC_DRAW);
+	}
+	glBufferSubData(target, 0, dataSize, m_uploadData.data());
+	glBindBufferBase(target, g_LightBinding, m_buffer);
+	glBindBuffer(target, 0);
+}
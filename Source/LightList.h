@@ -0,0 +1,133 @@
+///////////////////////////////////////////////////////////////////////////////
+// lightlist.h
+// ============
+// registry of the scene's light sources, uploaded to the shaders as one
+// buffer holding any number of lights
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderLayouts.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  LightList
+ *
+ *  This class collects the light sources of the scene and
+ *  packs the active ones into a single GPU buffer, so that
+ *  the fragment shader loops over exactly the lights that
+ *  are switched on.  A shader storage buffer is used when
+ *  the driver has one, otherwise a uniform buffer limited to
+ *  MAX_UNIFORM_LIGHTS lights.  Directional lights are packed
+ *  first, so a shader that only loops over the first lights
+ *  keeps the ones that reach the whole scene.
+ ***********************************************************/
+class LightList
+{
+public:
+	// constructor
+	LightList();
+	// destructor
+	~LightList();
+
+	// the LIGHT_ values in the shaders
+	enum LIGHT_TYPE
+	{
+		LIGHT_DIRECTIONAL = LAYOUT_LIGHT_DIRECTIONAL,
+		LIGHT_POINT = LAYOUT_LIGHT_POINT,
+		LIGHT_SPOT = LAYOUT_LIGHT_SPOT
+	};
+
+	// one light as read by the shader, laid out the same way
+	// under std140 and std430 packing rules
+	struct LIGHT_DATA
+	{
+		LIGHT_DATA_LAYOUT(SHADER_LAYOUT_MEMBER, SHADER_LAYOUT_MEMBER_PAD)
+	};
+
+	// lights a uniform buffer holds when there is no storage buffer
+	static const int MAX_UNIFORM_LIGHTS = LAYOUT_MAX_UNIFORM_LIGHTS;
+
+private:
+	struct LIGHT_ENTRY
+	{
+		LIGHT_DATA data;
+		bool bActive;
+	};
+
+	// the values that precede the light array in the buffer,
+	// the members before lights[] in the LightBuffer block
+	struct LIGHT_HEADER
+	{
+		GLint lightCount;
+		GLint padding[3];
+		// light given to far objects that are not lit per light
+		glm::vec4 bakedAmbient;
+		glm::vec4 bakedDiffuse;
+	};
+
+	// every light that has been added, active or not
+	std::vector<LIGHT_ENTRY> m_lights;
+	// staging memory for the packed buffer contents
+	std::vector<unsigned char> m_uploadData;
+	// buffer holding the active lights
+	GLuint m_buffer;
+	// size of the buffer's data store in bytes
+	size_t m_bufferSize;
+	// number of lights in the last upload
+	int m_uploadedCount;
+	// true when the shaders read the lights from a storage buffer
+	bool m_bUseStorageBuffer;
+
+	// add a light to the registry and return its index
+	int AddLight(const LIGHT_DATA& data);
+	// pack one light behind the lights already in the upload
+	bool PackLight(const LIGHT_DATA& data, LIGHT_HEADER& header);
+
+public:
+	// add the different kinds of light sources
+	int AddDirectionalLight(
+		glm::vec3 direction,
+		glm::vec3 ambient,
+		glm::vec3 diffuse,
+		glm::vec3 specular);
+	int AddPointLight(
+		glm::vec3 position,
+		glm::vec3 ambient,
+		glm::vec3 diffuse,
+		glm::vec3 specular,
+		float constant = 1.0f,
+		float linear = 0.0f,
+		float quadratic = 0.0f);
+	int AddSpotLight(
+		glm::vec3 position,
+		glm::vec3 direction,
+		glm::vec3 ambient,
+		glm::vec3 diffuse,
+		glm::vec3 specular,
+		float constant,
+		float linear,
+		float quadratic,
+		float cutOffDegrees,
+		float outerCutOffDegrees);
+
+	// make a spot light follow the camera position and direction
+	void SetFollowCamera(int index, bool bFollowCamera);
+	// switch a light on or off
+	void SetActive(int index, bool bActive);
+	// remove all of the lights
+	void Clear();
+	// get the number of lights that have been added
+	int GetLightCount() const { return((int)m_lights.size()); }
+	// get the number of lights the shaders see after the last upload
+	int GetUploadedLightCount() const { return(m_uploadedCount); }
+
+	// connect the light buffer block of a linked program
+	void AttachProgram(GLuint programID);
+	// send the active lights to the GPU with a single upload
+	void Upload();
+};
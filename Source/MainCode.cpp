@@ -1,186 +1,250 @@
-///////////////////////////////////////////////////////////////////////////////
-// maincode.cpp
-// ============
-// gets called when application is launched - initializes GLEW, GLFW
-//
-//  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
-//	Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
-///////////////////////////////////////////////////////////////////////////////
-
-#include <iostream>         // error handling and output
-#include <cstdlib>          // EXIT_FAILURE
-
-#include <GL/glew.h>        // GLEW library
-#include "GLFW/glfw3.h"     // GLFW library
-
-// GLM Math Header inclusions
-#include <glm/glm.hpp>
-#include <glm/gtx/transform.hpp>
-#include <glm/gtc/type_ptr.hpp>
-
-#include "SceneManager.h"
-#include "ViewManager.h"
-#include "ShapeMeshes.h"
-#include "ShaderManager.h"
-
-// Namespace for declaring global variables
-namespace
-{
-	// Macro for window title
-	const char* const WINDOW_TITLE = "7-1 FinalProject and Milestones"; 
-
-	// Main GLFW window
-	GLFWwindow* g_Window = nullptr;
-
-	// scene manager object for managing the 3D scene prepare and render
-	SceneManager* g_SceneManager = nullptr;
-	// shader manager object for dynamic interaction with the shader code
-	ShaderManager* g_ShaderManager = nullptr;
-	// view manager object for managing the 3D view setup and projection to 2D
-	ViewManager* g_ViewManager = nullptr;
-}
-
-// Function declarations - all functions that are called manually
-// need to be pre-declared at the beginning of the source code.
-bool InitializeGLFW();
-bool InitializeGLEW();
-
-
-/***********************************************************
- *  main(int, char*)
- *
- *  This function gets called after the application has been
- *  launched.
- ***********************************************************/
-int main(int argc, char* argv[])
-{
-	// if GLFW fails initialization, then terminate the application
-	if (InitializeGLFW() == false)
-	{
-		return(EXIT_FAILURE);
-	}
-
-	// try to create a new shader manager object
-	g_ShaderManager = new ShaderManager();
-	// try to create a new view manager object
-	g_ViewManager = new ViewManager(
-		g_ShaderManager);
-
-	// try to create the main display window
-	g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE);
-
-	// if GLEW fails initialization, then terminate the application
-	if (InitializeGLEW() == false)
-	{
-		return(EXIT_FAILURE);
-	}
-
-	// load the shader code from the external GLSL files
-	g_ShaderManager->LoadShaders(
-		"shaders/vertexShader.glsl",
-		"shaders/fragmentShader.glsl");
-	g_ShaderManager->use();
-
-	// try to create a new scene manager object and prepare the 3D scene
-	g_SceneManager = new SceneManager(g_ShaderManager);
-	g_SceneManager->PrepareScene();
-
-	// loop will keep running until the application is closed 
-	// or until an error has occurred
-	while (!glfwWindowShouldClose(g_Window))
-	{
-		// Enable z-depth
-		glEnable(GL_DEPTH_TEST);
-
-		// Clear the frame and z buffers
-		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-		// convert from 3D object space to 2D view
-		g_ViewManager->PrepareSceneView();
-
-		// refresh the 3D scene
-		g_SceneManager->RenderScene();
-
-
-		// Flips the the back buffer with the front buffer every frame.
-		glfwSwapBuffers(g_Window);
-
-		// query the latest GLFW events
-		glfwPollEvents();
-	}
-
-	// clear the allocated manager objects from memory
-	if (NULL != g_SceneManager)
-	{
-		delete g_SceneManager;
-		g_SceneManager = NULL;
-	}
-	if (NULL != g_ViewManager)
-	{
-		delete g_ViewManager;
-		g_ViewManager = NULL;
-	}
-	if (NULL != g_ShaderManager)
-	{
-		delete g_ShaderManager;
-		g_ShaderManager = NULL;
-	}
-
-	// Terminates the program successfully
-	exit(EXIT_SUCCESS); 
-}
-
-/***********************************************************
- *	InitializeGLFW()
- * 
- *  This function is used to initialize the GLFW library.   
- ***********************************************************/
-bool InitializeGLFW()
-{
-	// GLFW: initialize and configure library
-	// --------------------------------------
-	glfwInit();
-
-#ifdef __APPLE__
-	// set the version of OpenGL and profile to use
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
-#else
-	// set the version of OpenGL and profile to use
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
-	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-#endif
-	// GLFW: end -------------------------------
-
-	return(true);
-}
-
-/***********************************************************
- *	InitializeGLEW()
- *
- *  This function is used to initialize the GLEW library.
- ***********************************************************/
-bool InitializeGLEW()
-{
-	// GLEW: initialize
-	// -----------------------------------------
-	GLenum GLEWInitResult = GLEW_OK;
-
-	// try to initialize the GLEW library
-	GLEWInitResult = glewInit();
-	if (GLEW_OK != GLEWInitResult)
-	{
-		std::cerr << glewGetErrorString(GLEWInitResult) << std::endl;
-		return false;
-	}
-	// GLEW: end -------------------------------
-
-	// Displays a successful OpenGL initialization message
-	std::cout << "INFO: OpenGL Successfully Initialized\n";
-	std::cout << "INFO: OpenGL Version: " << glGetString(GL_VERSION) << "\n" << std::endl;
-
-	return(true);
+///////////////////////////////////////////////////////////////////////////////
+// maincode.cpp
+// ============
+// gets called when application is launched - initializes GLEW, GLFW
+//
+//  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
+//	Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
+///////////////////////////////////////////////////////////////////////////////
+
+#include <iostream>         // error handling and output
+#include <cstdlib>          // EXIT_FAILURE
+#include <cstring>          // strcmp
+
+#include <GL/glew.h>        // GLEW library
+#include "GLFW/glfw3.h"     // GLFW library
+
+// GLM Math Header inclusions
+#include <glm/glm.hpp>
+#include <glm/gtx/transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "SceneManager.h"
+#include "ViewManager.h"
+#include "ShapeMeshes.h"
+#include "GLStateCache.h"
+#include "ShaderVariants.h"
+#include "ShaderWatcher.h"
+
+// Namespace for declaring global variables
+namespace
+{
+	// Macro for window title
+	const char* const WINDOW_TITLE = "7-1 FinalProject and Milestones"; 
+
+	// Main GLFW window
+	GLFWwindow* g_Window = nullptr;
+
+	// scene manager object for managing the 3D scene prepare and render
+	SceneManager* g_SceneManager = nullptr;
+	// view manager object for managing the 3D view setup and projection to 2D
+	ViewManager* g_ViewManager = nullptr;
+	// state cache object for dropping redundant OpenGL and uniform calls
+	GLStateCache* g_StateCache = nullptr;
+	// programs compiled from the shader code for each scene feature combination
+	ShaderVariants* g_ShaderVariants = nullptr;
+	// watcher that picks up edits to the shader files while running
+	ShaderWatcher* g_ShaderWatcher = nullptr;
+
+	// shader files of the scene, in the order the watcher returns them
+	const char* const VERTEX_SHADER_PATH = "shaders/vertexShader.glsl";
+	const char* const FRAGMENT_SHADER_PATH = "shaders/fragmentShader.glsl";
+}
+
+// Function declarations - all functions that are called manually
+// need to be pre-declared at the beginning of the source code.
+bool InitializeGLFW();
+bool InitializeGLEW();
+
+
+/***********************************************************
+ *  main(int, char*)
+ *
+ *  This function gets called after the application has been
+ *  launched.
+ ***********************************************************/
+int main(int argc, char* argv[])
+{
+	// if GLFW fails initialization, then terminate the application
+	if (InitializeGLFW() == false)
+	{
+		return(EXIT_FAILURE);
+	}
+
+	// try to create a new state cache object
+	g_StateCache = new GLStateCache();
+	// try to create a new view manager object
+	g_ViewManager = new ViewManager(
+		g_StateCache);
+
+	// try to create the main display window
+	g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE);
+
+	// if GLEW fails initialization, then terminate the application
+	if (InitializeGLEW() == false)
+	{
+		return(EXIT_FAILURE);
+	}
+
+	// the scene is drawn with variants of the same shader code that
+	// are compiled in the background when first used, so no shader
+	// is built before the first frame
+	g_ShaderVariants = new ShaderVariants();
+	g_ShaderVariants->AddProgramCallback([](int /*variant*/, GLuint programID)
+	{
+		// SPIR-V modules already bind their FrameData block
+		if (g_ShaderVariants->UsesSpirv() == false)
+		{
+			g_ViewManager->AttachProgram(programID);
+		}
+	});
+	g_ShaderVariants->AddReleaseCallback([](GLuint programID) { g_StateCache->ForgetProgram(programID); });
+	// the SPIR-V modules of Tools/CompileSpirv.cpp are only used
+	// when asked for on the command line with --spirv
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--spirv") == 0)
+		{
+			g_ShaderVariants->AllowSpirv(true);
+		}
+	}
+	g_ShaderVariants->Load(VERTEX_SHADER_PATH, FRAGMENT_SHADER_PATH);
+
+	// saved shader files are rebuilt without restarting
+	g_ShaderWatcher = new ShaderWatcher();
+	g_ShaderWatcher->AddFile(VERTEX_SHADER_PATH);
+	g_ShaderWatcher->AddFile(FRAGMENT_SHADER_PATH);
+	g_ShaderWatcher->Start();
+	std::vector<std::string> shaderSources;
+
+	// try to create a new scene manager object and prepare the 3D scene
+	g_SceneManager = new SceneManager(g_StateCache, g_ShaderVariants);
+	g_SceneManager->PrepareScene();
+
+	// loop will keep running until the application is closed 
+	// or until an error has occurred
+	while (!glfwWindowShouldClose(g_Window))
+	{
+		// edited shaders are built in the background, and the
+		// previous programs stay in use until all of them link,
+		// or for good when they fail to build
+		if (g_ShaderWatcher->TakeSources(shaderSources) == true)
+		{
+			g_ShaderVariants->Reload(shaderSources[0], shaderSources[1]);
+		}
+
+		// start drawing with the variants that finished compiling
+		// in the background, the rest stay out of the frame, and
+		// swap in a finished reload between frames
+		g_ShaderVariants->Update();
+
+		// Enable z-depth
+		g_StateCache->Enable(GL_DEPTH_TEST);
+
+		// Clear the frame and z buffers
+		g_StateCache->ClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		// convert from 3D object space to 2D view
+		g_ViewManager->PrepareSceneView();
+
+		// refresh the 3D scene, sorting draws from the camera position
+		g_SceneManager->SetViewPosition(g_ViewManager->g_pCamera->Position);
+		g_SceneManager->SetProjection(g_ViewManager->GetProjection());
+		g_SceneManager->RenderScene();
+
+		// report how many state changes were dropped this frame
+		g_StateCache->EndFrame();
+
+
+		// Flips the the back buffer with the front buffer every frame.
+		glfwSwapBuffers(g_Window);
+
+		// query the latest GLFW events
+		glfwPollEvents();
+	}
+
+	// clear the allocated manager objects from memory
+	if (NULL != g_SceneManager)
+	{
+		delete g_SceneManager;
+		g_SceneManager = NULL;
+	}
+	if (NULL != g_ViewManager)
+	{
+		delete g_ViewManager;
+		g_ViewManager = NULL;
+	}
+	if (NULL != g_ShaderWatcher)
+	{
+		delete g_ShaderWatcher;
+		g_ShaderWatcher = NULL;
+	}
+	if (NULL != g_ShaderVariants)
+	{
+		delete g_ShaderVariants;
+		g_ShaderVariants = NULL;
+	}
+	if (NULL != g_StateCache)
+	{
+		delete g_StateCache;
+		g_StateCache = NULL;
+	}
+
+	// Terminates the program successfully
+	exit(EXIT_SUCCESS); 
+}
+
+/***********************************************************
+ *	InitializeGLFW()
+ * 
+ *  This function is used to initialize the GLFW library.   
+ ***********************************************************/
+bool InitializeGLFW()
+{
+	// GLFW: initialize and configure library
+	// --------------------------------------
+	glfwInit();
+
+#ifdef __APPLE__
+	// set the version of OpenGL and profile to use
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#else
+	// set the version of OpenGL and profile to use
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#endif
+	// GLFW: end -------------------------------
+
+	return(true);
+}
+
+/***********************************************************
+ *	InitializeGLEW()
+ *
+ *  This function is used to initialize the GLEW library.
+ ***********************************************************/
+bool InitializeGLEW()
+{
+	// GLEW: initialize
+	// -----------------------------------------
+	GLenum GLEWInitResult = GLEW_OK;
+
+	// try to initialize the GLEW library
+	GLEWInitResult = glewInit();
+	if (GLEW_OK != GLEWInitResult)
+	{
+		std::cerr << glewGetErrorString(GLEWInitResult) << std::endl;
+		return false;
+	}
+	// GLEW: end -------------------------------
+
+	// Displays a successful OpenGL initialization message
+	std::cout << "INFO: OpenGL Successfully Initialized\n";
+	std::cout << "INFO: OpenGL Version: " << glGetString(GL_VERSION) << "\n" << std::endl;
+
+	return(true);
 }
\ No newline at end of file
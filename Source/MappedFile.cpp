@@ -0,0 +1,144 @@
+///////////////////////////////////////////////////////////////////////////////
+// mappedfile.cpp
+// ============
+// map a whole file into memory read-only, so its contents can be handed to
+// OpenGL without reading them into a buffer first
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/***********************************************************
+ *  MappedFile()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+MappedFile::MappedFile()
+{
+	m_pData = NULL;
+	m_size = 0;
+#ifdef _WIN32
+	m_fileHandle = INVALID_HANDLE_VALUE;
+	m_mappingHandle = NULL;
+#endif
+}
+
+/***********************************************************
+ *  ~MappedFile()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+/***********************************************************
+ *  Open()
+ *
+ *  This method is used for mapping the whole of a file
+ *  read-only.  Empty files are not mapped, since neither
+ *  system maps zero bytes.
+ ***********************************************************/
+bool MappedFile::Open(const std::string& filePath)
+{
+	Close();
+
+#ifdef _WIN32
+	LARGE_INTEGER fileSize;
+
+	m_fileHandle = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (m_fileHandle == INVALID_HANDLE_VALUE)
+	{
+		return(false);
+	}
+	if ((GetFileSizeEx(m_fileHandle, &fileSize) == FALSE) || (fileSize.QuadPart == 0))
+	{
+		Close();
+		return(false);
+	}
+	m_mappingHandle = CreateFileMappingA(m_fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (NULL == m_mappingHandle)
+	{
+		Close();
+		return(false);
+	}
+	m_pData = (const unsigned char*)MapViewOfFile(m_mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	m_size = (size_t)fileSize.QuadPart;
+#else
+	struct stat fileStatus;
+	int fileDescriptor = open(filePath.c_str(), O_RDONLY);
+	void* pMapping = MAP_FAILED;
+
+	if (fileDescriptor < 0)
+	{
+		return(false);
+	}
+	if ((fstat(fileDescriptor, &fileStatus) == 0) && (fileStatus.st_size > 0))
+	{
+		pMapping = mmap(NULL, (size_t)fileStatus.st_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+	}
+	// the mapping stays valid after the descriptor is closed
+	close(fileDescriptor);
+	if (pMapping != MAP_FAILED)
+	{
+		m_pData = (const unsigned char*)pMapping;
+		m_size = (size_t)fileStatus.st_size;
+	}
+#endif
+
+	if (NULL == m_pData)
+	{
+		Close();
+		return(false);
+	}
+	return(true);
+}
+
+/***********************************************************
+ *  Close()
+ *
+ *  This method is used for releasing the mapping and the
+ *  handles of the open file.
+ ***********************************************************/
+void MappedFile::Close()
+{
+#ifdef _WIN32
+	if (NULL != m_pData)
+	{
+		UnmapViewOfFile(m_pData);
+	}
+	if (NULL != m_mappingHandle)
+	{
+		CloseHandle(m_mappingHandle);
+		m_mappingHandle = NULL;
+	}
+	if (m_fileHandle != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_fileHandle);
+		m_fileHandle = INVALID_HANDLE_VALUE;
+	}
+#else
+	if (NULL != m_pData)
+	{
+		munmap((void*)m_pData, m_size);
+	}
+#endif
+	m_pData = NULL;
+	m_size = 0;
+}
@@ -0,0 +1,53 @@
+///////////////////////////////////////////////////////////////////////////////
+// mappedfile.h
+// ============
+// map a whole file into memory read-only, so its contents can be handed to
+// OpenGL without reading them into a buffer first
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/***********************************************************
+ *  MappedFile
+ *
+ *  This class maps a file with MapViewOfFile on Windows and
+ *  mmap elsewhere.  The pages are only read from disk when
+ *  they are first touched, and the mapping is released when
+ *  the object is closed or destroyed.
+ ***********************************************************/
+class MappedFile
+{
+public:
+	// constructor
+	MappedFile();
+	// destructor
+	~MappedFile();
+
+private:
+	// start of the mapped contents, NULL when nothing is open
+	const unsigned char* m_pData;
+	// number of mapped bytes
+	size_t m_size;
+#ifdef _WIN32
+	// file and mapping handles
+	void* m_fileHandle;
+	void* m_mappingHandle;
+#endif
+
+	// not copyable, the mapping has one owner
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+
+public:
+	// map a file, closing any file mapped before
+	bool Open(const std::string& filePath);
+	// release the mapping
+	void Close();
+	// get the mapped contents
+	const unsigned char* GetData() const { return(m_pData); }
+	// get the number of mapped bytes
+	size_t GetSize() const { return(m_size); }
+};
@@ -0,0 +1,192 @@
+///////////////////////////////////////////////////////////////////////////////
+// materialtable.cpp
+// ============
+// object materials packed into one GPU table that the shaders index by a
+// small integer material ID
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MaterialTable.h"
+
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	const char* g_MaterialBlockName = "MaterialBuffer";
+
+	// storage or uniform buffer binding point of the materials
+	const GLuint g_MaterialBinding = LAYOUT_MATERIAL_BINDING;
+}
+
+// the table is copied into either kind of buffer as it is
+SHADER_LAYOUT_ASSERT(MaterialTable::MATERIAL_DATA, MATERIAL_DATA_LAYOUT, LAYOUT_STD140);
+SHADER_LAYOUT_ASSERT(MaterialTable::MATERIAL_DATA, MATERIAL_DATA_LAYOUT, LAYOUT_STD430);
+
+/***********************************************************
+ *  MaterialTable()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+MaterialTable::MaterialTable()
+{
+	m_buffer = 0;
+	// the shaders enable the storage buffer extension, so they
+	// declare the block as a storage buffer whenever it exists
+	m_bUseStorageBuffer = (GLEW_ARB_shader_storage_buffer_object == GL_TRUE);
+}
+
+/***********************************************************
+ *  ~MaterialTable()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+MaterialTable::~MaterialTable()
+{
+	if (0 != m_buffer)
+	{
+		glDeleteBuffers(1, &m_buffer);
+	}
+	m_buffer = 0;
+	m_materials.clear();
+	m_materialIDs.clear();
+}
+
+/***********************************************************
+ *  AddMaterial()
+ *
+ *  This method is used for adding a material to the end of
+ *  the table and returning its ID.  A tag that is already
+ *  defined keeps its first material.
+ ***********************************************************/
+int MaterialTable::AddMaterial(
+	const std::string& tag,
+	glm::vec3 diffuseColor,
+	glm::vec3 specularColor,
+	float shininess)
+{
+	MATERIAL_DATA material;
+	int materialID = FindMaterial(tag);
+
+	if (materialID >= 0)
+	{
+		std::cout << "ERROR: Material " << tag << " is already defined" << std::endl;
+		return(materialID);
+	}
+
+	material.diffuseColor = glm::vec4(diffuseColor, 0.0f);
+	material.specularColor = glm::vec4(specularColor, shininess);
+	m_materials.push_back(material);
+
+	materialID = (int)m_materials.size() - 1;
+	m_materialIDs[tag] = materialID;
+
+	return(materialID);
+}
+
+/***********************************************************
+ *  FindMaterial()
+ *
+ *  This method is used for getting the ID of the material
+ *  with the passed in tag.
+ ***********************************************************/
+int MaterialTable::FindMaterial(const std::string& tag) const
+{
+	std::unordered_map<std::string, int>::const_iterator found = m_materialIDs.find(tag);
+
+	if (found == m_materialIDs.end())
+	{
+		return(-1);
+	}
+	return(found->second);
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing all of the materials.
+ ***********************************************************/
+void MaterialTable::Clear()
+{
+	m_materials.clear();
+	m_materialIDs.clear();
+}
+
+/***********************************************************
+ *  AttachProgram()
+ *
+ *  This method is used for connecting the material buffer
+ *  block of the passed in linked program to the material
+ *  binding point, as the storage or uniform block the
+ *  shader declares on this driver.
+ ***********************************************************/
+void MaterialTable::AttachProgram(GLuint programID)
+{
+	GLuint blockIndex = GL_INVALID_INDEX;
+
+	if (m_bUseStorageBuffer == true)
+	{
+		blockIndex = glGetProgramResourceIndex(programID, GL_SHADER_STORAGE_BLOCK, g_MaterialBlockName);
+		if (GL_INVALID_INDEX != blockIndex)
+		{
+			glShaderStorageBlockBinding(programID, blockIndex, g_MaterialBinding);
+		}
+	}
+	else
+	{
+		blockIndex = glGetUniformBlockIndex(programID, g_MaterialBlockName);
+		if (GL_INVALID_INDEX != blockIndex)
+		{
+			glUniformBlockBinding(programID, blockIndex, g_MaterialBinding);
+		}
+	}
+
+	if (GL_INVALID_INDEX == blockIndex)
+	{
+		std::cout << "ERROR: Program " << programID << " has no " << g_MaterialBlockName << " block" << std::endl;
+	}
+}
+
+/***********************************************************
+ *  Upload()
+ *
+ *  This method is used for sending the whole material table
+ *  to the GPU.  It is called once after the materials are
+ *  defined, and again only if the table changes.
+ ***********************************************************/
+void MaterialTable::Upload()
+{
+	GLenum target = m_bUseStorageBuffer ? GL_SHADER_STORAGE_BUFFER : GL_UNIFORM_BUFFER;
+	size_t materialCount = m_materials.size();
+	size_t bufferSize = 0;
+
+	if ((m_bUseStorageBuffer == false) && (materialCount > MAX_UNIFORM_MATERIALS))
+	{
+		std::cout << "ERROR: Only " << MAX_UNIFORM_MATERIALS << " materials are supported without storage buffers" << std::endl;
+		materialCount = MAX_UNIFORM_MATERIALS;
+	}
+
+	// the uniform block always has room for the full array,
+	// and a storage buffer is never created empty
+	bufferSize = materialCount * sizeof(MATERIAL_DATA);
+	if (m_bUseStorageBuffer == false)
+	{
+		bufferSize = MAX_UNIFORM_MATERIALS * sizeof(MATERIAL_DATA);
+	}
+	else if (0 == bufferSize)
+	{
+		bufferSize = sizeof(MATERIAL_DATA);
+	}
+
+	if (0 == m_buffer)
+	{
+		glGenBuffers(1, &m_buffer);
+	}
+	glBindBuffer(target, m_buffer);
+	glBufferData(target, bufferSize, NULL, GL_STATIC_DRAW);
+	if (materialCount > 0)
+	{
+		glBufferSubData(target, 0, materialCount * sizeof(MATERIAL_DATA), m_materials.data());
+	}
+	glBindBufferBase(target, g_MaterialBinding, m_buffer);
+	glBindBuffer(target, 0);
+}
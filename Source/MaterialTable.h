@@ -0,0 +1,76 @@
+///////////////////////////////////////////////////////////////////////////////
+// materialtable.h
+// ============
+// object materials packed into one GPU table that the shaders index by a
+// small integer material ID
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderLayouts.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/***********************************************************
+ *  MaterialTable
+ *
+ *  This class holds every defined material in the order it
+ *  was added, so that a material's index in the table is
+ *  its ID in the shaders.  Tags are only looked up while
+ *  recording draws, through a hash map, and the whole table
+ *  is uploaded once.  A shader storage buffer is used when
+ *  the driver has one, otherwise a uniform buffer limited to
+ *  MAX_UNIFORM_MATERIALS materials.
+ ***********************************************************/
+class MaterialTable
+{
+public:
+	// constructor
+	MaterialTable();
+	// destructor
+	~MaterialTable();
+
+	// one material as read by the shader, laid out the same
+	// way under std140 and std430 packing rules
+	struct MATERIAL_DATA
+	{
+		MATERIAL_DATA_LAYOUT(SHADER_LAYOUT_MEMBER, SHADER_LAYOUT_MEMBER_PAD)
+	};
+
+	// materials a uniform buffer holds when there is no storage buffer
+	static const int MAX_UNIFORM_MATERIALS = LAYOUT_MAX_UNIFORM_MATERIALS;
+
+private:
+	// materials in ID order
+	std::vector<MATERIAL_DATA> m_materials;
+	// material IDs keyed by tag
+	std::unordered_map<std::string, int> m_materialIDs;
+	// buffer holding the table
+	GLuint m_buffer;
+	// true when the shaders read the table from a storage buffer
+	bool m_bUseStorageBuffer;
+
+public:
+	// add a material and return its ID
+	int AddMaterial(
+		const std::string& tag,
+		glm::vec3 diffuseColor,
+		glm::vec3 specularColor,
+		float shininess);
+	// find the ID of a material by tag, or -1 when not defined
+	int FindMaterial(const std::string& tag) const;
+	// remove all of the materials
+	void Clear();
+	// get the number of materials in the table
+	int GetMaterialCount() const { return((int)m_materials.size()); }
+
+	// connect the material buffer block of a linked program
+	void AttachProgram(GLuint programID);
+	// send the whole table to the GPU with a single upload
+	void Upload();
+};
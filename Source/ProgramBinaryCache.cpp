@@ -0,0 +1,276 @@
+///////////////////////////////////////////////////////////////////////////////
+// programbinarycache.cpp
+// ============
+// keep linked shader programs on disk as driver binaries, so that later
+// launches load them instead of compiling the GLSL sources again
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ProgramBinaryCache.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+// declaration of global variables
+namespace
+{
+	// "PBIN" in the first four bytes of a cache file
+	const uint32_t g_BinaryMagic = 0x4E494250;
+	// changed whenever the file layout changes
+	const uint32_t g_BinaryVersion = 1;
+
+	/***********************************************************
+	 *  HashBytes()
+	 *
+	 *  This function is used for adding bytes to a 64-bit
+	 *  FNV-1a hash.
+	 ***********************************************************/
+	uint64_t HashBytes(uint64_t hash, const std::string& bytes)
+	{
+		for (size_t i = 0; i < bytes.size(); i++)
+		{
+			hash = (hash ^ (uint8_t)bytes[i]) * 1099511628211ull;
+		}
+		// separate the strings so that moving text between
+		// them changes the hash
+		return((hash ^ 0xFF) * 1099511628211ull);
+	}
+}
+
+/***********************************************************
+ *  ProgramBinaryCache()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ProgramBinaryCache::ProgramBinaryCache(const std::string& directory)
+{
+	m_directory = directory;
+	if ((m_directory.empty() == false) &&
+		(m_directory.back() != '/') && (m_directory.back() != '\\'))
+	{
+		m_directory += '/';
+	}
+	m_bChecked = false;
+	m_bSupported = false;
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+/***********************************************************
+ *  ~ProgramBinaryCache()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ProgramBinaryCache::~ProgramBinaryCache()
+{
+}
+
+/***********************************************************
+ *  CheckSupport()
+ *
+ *  This method is used for checking once whether the driver
+ *  has program binaries and at least one binary format, and
+ *  for reading the strings that name the driver.
+ ***********************************************************/
+bool ProgramBinaryCache::CheckSupport()
+{
+	GLint formatCount = 0;
+	const GLubyte* renderer = NULL;
+	const GLubyte* version = NULL;
+
+	if (m_bChecked == true)
+	{
+		return(m_bSupported);
+	}
+	m_bChecked = true;
+
+	if ((GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary) == false)
+	{
+		std::cout << "INFO: Program binaries are not supported, shaders are compiled at every launch" << std::endl;
+		return(false);
+	}
+
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+	if (formatCount <= 0)
+	{
+		std::cout << "INFO: The driver has no program binary formats, shaders are compiled at every launch" << std::endl;
+		return(false);
+	}
+
+	renderer = glGetString(GL_RENDERER);
+	version = glGetString(GL_VERSION);
+	m_driverName = std::string((NULL != renderer) ? (const char*)renderer : "") +
+		"|" + std::string((NULL != version) ? (const char*)version : "");
+	m_bSupported = true;
+	return(true);
+}
+
+/***********************************************************
+ *  GetFilePath()
+ *
+ *  This method is used for getting the name of the cache
+ *  file that holds the binary of a key.
+ ***********************************************************/
+std::string ProgramBinaryCache::GetFilePath(uint64_t key) const
+{
+	std::stringstream path;
+
+	path << m_directory << std::hex << key << ".programbin";
+	return(path.str());
+}
+
+/***********************************************************
+ *  MakeKey()
+ *
+ *  This method is used for hashing the passed in sources,
+ *  which already hold any variant defines, together with
+ *  the renderer and driver version.
+ ***********************************************************/
+uint64_t ProgramBinaryCache::MakeKey(const std::string& vertexSource, const std::string& fragmentSource)
+{
+	uint64_t hash = 14695981039346656037ull;
+
+	CheckSupport();
+	hash = HashBytes(hash, m_driverName);
+	hash = HashBytes(hash, vertexSource);
+	hash = HashBytes(hash, fragmentSource);
+	return(hash);
+}
+
+/***********************************************************
+ *  Load()
+ *
+ *  This method is used for creating a program from the
+ *  cached binary of a key.  Zero is returned when there is
+ *  no usable binary, and a binary the driver rejects is
+ *  deleted so that the rebuilt program replaces it.
+ ***********************************************************/
+GLuint ProgramBinaryCache::Load(uint64_t key)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::string filePath;
+	BINARY_HEADER header;
+	std::vector<char> binary;
+	GLuint programID = 0;
+	GLint status = GL_FALSE;
+	double loadMilliseconds = 0.0;
+
+	if (CheckSupport() == false)
+	{
+		return(0);
+	}
+
+	filePath = GetFilePath(key);
+	std::ifstream file(filePath, std::ios::binary);
+	if (!file.is_open())
+	{
+		return(0);
+	}
+
+	file.read((char*)&header, sizeof(header));
+	if ((!file) || (header.magic != g_BinaryMagic) ||
+		(header.version != g_BinaryVersion) || (header.key != key))
+	{
+		file.close();
+		std::remove(filePath.c_str());
+		return(0);
+	}
+
+	binary.resize(header.length);
+	file.read(binary.data(), header.length);
+	file.close();
+
+	programID = glCreateProgram();
+	if (file)
+	{
+		glProgramBinary(programID, header.format, binary.data(), (GLsizei)header.length);
+		glGetProgramiv(programID, GL_LINK_STATUS, &status);
+	}
+
+	if (status != GL_TRUE)
+	{
+		std::cout << "INFO: Cached program binary " << filePath << " was rejected, compiling the shaders" << std::endl;
+		glDeleteProgram(programID);
+		std::remove(filePath.c_str());
+		return(0);
+	}
+
+	loadMilliseconds = std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - start).count();
+	m_stats.loadedPrograms++;
+	if (header.buildMilliseconds > loadMilliseconds)
+	{
+		m_stats.savedMilliseconds += header.buildMilliseconds - loadMilliseconds;
+	}
+	return(programID);
+}
+
+/***********************************************************
+ *  PrepareProgram()
+ *
+ *  This method is used for asking the driver to keep the
+ *  binary of a program it is about to link.
+ ***********************************************************/
+void ProgramBinaryCache::PrepareProgram(GLuint programID)
+{
+	if (CheckSupport() == true)
+	{
+		glProgramParameteri(programID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+}
+
+/***********************************************************
+ *  Save()
+ *
+ *  This method is used for writing the binary of a linked
+ *  program to the cache file of a key, along with the time
+ *  the program took to build so that a later load can
+ *  report the time it saved.
+ ***********************************************************/
+void ProgramBinaryCache::Save(uint64_t key, GLuint programID, double buildMilliseconds)
+{
+	std::string filePath;
+	BINARY_HEADER header;
+	std::vector<char> binary;
+	GLint length = 0;
+	GLsizei written = 0;
+
+	m_stats.builtPrograms++;
+	if (CheckSupport() == false)
+	{
+		return;
+	}
+
+	glGetProgramiv(programID, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+	{
+		return;
+	}
+
+	memset(&header, 0, sizeof(header));
+	binary.resize(length);
+	glGetProgramBinary(programID, length, &written, &header.format, binary.data());
+	if (written <= 0)
+	{
+		return;
+	}
+
+	header.magic = g_BinaryMagic;
+	header.version = g_BinaryVersion;
+	header.key = key;
+	header.length = (uint32_t)written;
+	header.buildMilliseconds = (float)buildMilliseconds;
+
+	filePath = GetFilePath(key);
+	std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		std::cout << "ERROR: Could not write program binary " << filePath << std::endl;
+		return;
+	}
+	file.write((const char*)&header, sizeof(header));
+	file.write(binary.data(), written);
+}
@@ -0,0 +1,81 @@
+///////////////////////////////////////////////////////////////////////////////
+// programbinarycache.h
+// ============
+// keep linked shader programs on disk as driver binaries, so that later
+// launches load them instead of compiling the GLSL sources again
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <string>
+
+/***********************************************************
+ *  ProgramBinaryCache
+ *
+ *  This class saves the binary of a linked program to a
+ *  file named by a hash of its sources and of the renderer
+ *  and driver version strings, so that a driver update or a
+ *  different GPU never loads a stale binary.  A binary the
+ *  driver rejects is deleted, and the caller compiles the
+ *  sources again as if there had been no cache entry.
+ ***********************************************************/
+class ProgramBinaryCache
+{
+public:
+	// constructor
+	ProgramBinaryCache(const std::string& directory);
+	// destructor
+	~ProgramBinaryCache();
+
+	struct CACHE_STATS
+	{
+		int loadedPrograms;
+		int builtPrograms;
+		double savedMilliseconds;
+	};
+
+private:
+	// start of every cache file
+	struct BINARY_HEADER
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t key;
+		GLenum format;
+		uint32_t length;
+		// time the program took to compile and link
+		float buildMilliseconds;
+	};
+
+	// directory holding the cache files, ending in a separator
+	std::string m_directory;
+	// renderer and driver version strings, read on first use
+	std::string m_driverName;
+	// true once support has been checked
+	bool m_bChecked;
+	// true when the driver can return program binaries
+	bool m_bSupported;
+	// totals since the cache was created
+	CACHE_STATS m_stats;
+
+	// check whether the driver can return program binaries
+	bool CheckSupport();
+	// get the cache file name of a key
+	std::string GetFilePath(uint64_t key) const;
+
+public:
+	// hash the sources of a program, including their defines,
+	// together with the renderer and driver version
+	uint64_t MakeKey(const std::string& vertexSource, const std::string& fragmentSource);
+	// create a program from a cached binary, or return zero
+	GLuint Load(uint64_t key);
+	// mark a program as retrievable, before it is linked
+	void PrepareProgram(GLuint programID);
+	// save the binary of a linked program
+	void Save(uint64_t key, GLuint programID, double buildMilliseconds);
+	// get the totals since the cache was created
+	const CACHE_STATS& GetStats() const { return(m_stats); }
+};
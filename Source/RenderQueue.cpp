@@ -0,0 +1,393 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderqueue.cpp
+// ============
+// record draw commands with packed sort keys so they can be submitted in an
+// order that keeps shader state changes to a minimum
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RenderQueue.h"
+#include "ShaderLayouts.h"
+
+#include <glm/gtc/matrix_inverse.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+// four normal matrices are computed at once where SSE is available
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 1))
+#define NORMAL_MATRIX_SSE
+#include <xmmintrin.h>
+#endif
+
+// declaration of global variables
+namespace
+{
+	// width of each field of the 64-bit sort key, the most
+	// significant field changes least often
+	const int g_ProgramBits = 12;
+	const int g_TextureBits = 16;
+	const int g_MaterialBits = 16;
+	const int g_MeshBits = 4;
+	const int g_DepthBits = 16;
+
+	// bit positions of each field within the sort key
+	const int g_MeshShift = g_DepthBits;
+	const int g_MaterialShift = g_MeshShift + g_MeshBits;
+	const int g_TextureShift = g_MaterialShift + g_MaterialBits;
+	const int g_ProgramShift = g_TextureShift + g_TextureBits;
+
+	static_assert(g_ProgramShift + g_ProgramBits == 64, "the sort key fields must fill 64 bits");
+	static_assert(RenderQueue::MESH_COUNT <= (1 << g_MeshBits), "every mesh must fit the mesh field");
+	static_assert(LAYOUT_MAX_UNIFORM_MATERIALS + 1 < (1 << g_MaterialBits),
+		"every uniform buffer material must fit the material field");
+
+	// names used when reporting the state change counts
+	const char* g_StateNames[RenderQueue::STATE_COUNT] =
+	{
+		"program", "texture", "material", "mesh", "color", "uvscale"
+	};
+
+#ifdef NORMAL_MATRIX_SSE
+	/***********************************************************
+	 *  CrossLanes()
+	 *
+	 *  This function is used for the cross products of four
+	 *  pairs of vectors, with x, y and z each held in one
+	 *  register and one vector per lane.
+	 ***********************************************************/
+	void CrossLanes(const __m128 a[3], const __m128 b[3], __m128 result[3])
+	{
+		result[0] = _mm_sub_ps(_mm_mul_ps(a[1], b[2]), _mm_mul_ps(a[2], b[1]));
+		result[1] = _mm_sub_ps(_mm_mul_ps(a[2], b[0]), _mm_mul_ps(a[0], b[2]));
+		result[2] = _mm_sub_ps(_mm_mul_ps(a[0], b[1]), _mm_mul_ps(a[1], b[0]));
+	}
+#endif
+
+	/***********************************************************
+	 *  PackField()
+	 *
+	 *  This function is used for placing a value in a field of
+	 *  the sort key.  Values too large for the field are kept
+	 *  at its largest value, so they sort after the others
+	 *  instead of wrapping onto the smallest ones.
+	 ***********************************************************/
+	uint64_t PackField(int value, int bits, int shift)
+	{
+		uint64_t largest = (1ull << bits) - 1;
+		uint64_t field = (value > 0) ? std::min((uint64_t)value, largest) : 0;
+
+		return(field << shift);
+	}
+}
+
+/***********************************************************
+ *  RenderQueue()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+RenderQueue::RenderQueue()
+{
+	m_viewPosition = glm::vec3(0.0f);
+	m_bPerInstanceState = false;
+	m_bSorted = false;
+	m_generation = 0;
+	memset(&m_frameStats, 0, sizeof(m_frameStats));
+	memset(&m_reportedStats, 0, sizeof(m_reportedStats));
+}
+
+/***********************************************************
+ *  ~RenderQueue()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+RenderQueue::~RenderQueue()
+{
+	m_commands.clear();
+	m_sortEntries.clear();
+}
+
+/***********************************************************
+ *  BuildSortKey()
+ *
+ *  This method is used for packing the state of the passed
+ *  in draw command into a single sortable integer.  Texture
+ *  array and material are stored offset by one so that the
+ *  untextured and unmaterialed draws sort first, and the
+ *  view depth fills the low 16 bits so that draws sharing
+ *  the same state are submitted front to back.  Materials
+ *  are left out when they are passed as per-instance data.
+ ***********************************************************/
+uint64_t RenderQueue::BuildSortKey(const DRAW_COMMAND& command) const
+{
+	uint64_t key = 0;
+	uint32_t depthBits = 0;
+	float depth = 0.0f;
+
+	key |= PackField(command.program, g_ProgramBits, g_ProgramShift);
+	key |= PackField(command.textureSlot + 1, g_TextureBits, g_TextureShift);
+	if (m_bPerInstanceState == false)
+	{
+		key |= PackField(command.materialIndex + 1, g_MaterialBits, g_MaterialShift);
+	}
+	key |= PackField(command.mesh, g_MeshBits, g_MeshShift);
+
+	// the bit pattern of a non-negative float increases
+	// along with its value, so it can be sorted as an integer,
+	// and its top bits keep the exponent and the leading
+	// mantissa bits, about one percent of the distance
+	depth = glm::length(glm::vec3(command.model[3]) - m_viewPosition);
+	memcpy(&depthBits, &depth, sizeof(depthBits));
+	key |= (uint64_t)(depthBits >> (32 - g_DepthBits));
+
+	return(key);
+}
+
+/***********************************************************
+ *  CountStateChanges()
+ *
+ *  This method is used for counting how many pieces of
+ *  shader state differ between two draw commands.  Texture
+ *  layers and UV scales only count when they are set as
+ *  uniforms.
+ ***********************************************************/
+int RenderQueue::CountStateChanges(
+	const DRAW_COMMAND& previous,
+	const DRAW_COMMAND& next) const
+{
+	int changes = 0;
+
+	if (previous.program != next.program) changes++;
+	if (previous.textureSlot != next.textureSlot) changes++;
+	if (previous.materialIndex != next.materialIndex) changes++;
+	if (previous.mesh != next.mesh) changes++;
+	if ((next.textureSlot < 0) && (previous.color != next.color)) changes++;
+	if ((m_bPerInstanceState == false) && (next.textureSlot >= 0))
+	{
+		if (previous.textureLayer != next.textureLayer) changes++;
+		if (previous.uvScale != next.uvScale) changes++;
+	}
+
+	return(changes);
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for clearing the previously recorded
+ *  commands and statistics before a new frame is recorded.
+ ***********************************************************/
+void RenderQueue::BeginFrame(glm::vec3 viewPosition)
+{
+	m_viewPosition = viewPosition;
+	m_commands.clear();
+	m_sortEntries.clear();
+	m_bSorted = false;
+	m_generation++;
+	memset(&m_frameStats, 0, sizeof(m_frameStats));
+}
+
+/***********************************************************
+ *  BeginReplay()
+ *
+ *  This method is used for starting a new frame that draws
+ *  exactly the commands of the previous frame.  The commands
+ *  and their sorted order are kept, and only the statistics
+ *  gathered while submitting them are cleared.
+ ***********************************************************/
+void RenderQueue::BeginReplay()
+{
+	m_frameStats.drawCalls = 0;
+	m_frameStats.totalStateChanges = 0;
+	for (int i = 0; i < STATE_COUNT; i++)
+	{
+		m_frameStats.stateChanges[i] = 0;
+	}
+}
+
+/***********************************************************
+ *  Submit()
+ *
+ *  This method is used for recording a draw command into
+ *  the queue.  The state changes the command would cause in
+ *  recorded order are counted so the saving from sorting
+ *  can be reported.
+ ***********************************************************/
+void RenderQueue::Submit(const DRAW_COMMAND& command)
+{
+	SORT_ENTRY entry;
+
+	if (m_commands.size() > 0)
+	{
+		m_frameStats.unsortedStateChanges += CountStateChanges(m_commands.back(), command);
+	}
+
+	entry.sortKey = BuildSortKey(command);
+	entry.index = (uint32_t)m_commands.size();
+
+	m_commands.push_back(command);
+	m_commands.back().sortKey = entry.sortKey;
+	m_sortEntries.push_back(entry);
+	m_frameStats.drawCommands++;
+	m_bSorted = false;
+}
+
+/***********************************************************
+ *  UpdateNormalMatrices()
+ *
+ *  This method is used for computing the normal matrix of
+ *  every recorded command, so that normals stay at right
+ *  angles to rotated and unevenly scaled surfaces.  The
+ *  inverse transpose of the upper 3x3 has the cross products
+ *  of its column pairs as columns, divided by the
+ *  determinant, which is worked out for four commands at a
+ *  time with SSE.
+ ***********************************************************/
+void RenderQueue::UpdateNormalMatrices()
+{
+	size_t count = m_commands.size();
+	size_t first = 0;
+
+#ifdef NORMAL_MATRIX_SSE
+	for (; first + 4 <= count; first += 4)
+	{
+		const DRAW_COMMAND* commands = &m_commands[first];
+		__m128 columns[3][3];
+		__m128 normals[3][3];
+		__m128 determinant;
+		__m128 inverse;
+		float lanes[4];
+
+		// component r of column c of four models, one per lane
+		for (int c = 0; c < 3; c++)
+		{
+			for (int r = 0; r < 3; r++)
+			{
+				columns[c][r] = _mm_setr_ps(
+					commands[0].model[c][r], commands[1].model[c][r],
+					commands[2].model[c][r], commands[3].model[c][r]);
+			}
+		}
+
+		CrossLanes(columns[1], columns[2], normals[0]);
+		CrossLanes(columns[2], columns[0], normals[1]);
+		CrossLanes(columns[0], columns[1], normals[2]);
+
+		determinant = _mm_add_ps(_mm_add_ps(
+			_mm_mul_ps(columns[0][0], normals[0][0]),
+			_mm_mul_ps(columns[0][1], normals[0][1])),
+			_mm_mul_ps(columns[0][2], normals[0][2]));
+		inverse = _mm_div_ps(_mm_set1_ps(1.0f), determinant);
+
+		for (int c = 0; c < 3; c++)
+		{
+			for (int r = 0; r < 3; r++)
+			{
+				_mm_storeu_ps(lanes, _mm_mul_ps(normals[c][r], inverse));
+				for (int lane = 0; lane < 4; lane++)
+				{
+					m_commands[first + lane].normalMatrix[c][r] = lanes[lane];
+				}
+			}
+		}
+	}
+#endif
+
+	for (; first < count; first++)
+	{
+		m_commands[first].normalMatrix = glm::inverseTranspose(glm::mat3(m_commands[first].model));
+	}
+}
+
+/***********************************************************
+ *  Sort()
+ *
+ *  This method is used for sorting the recorded commands.
+ *  Only the compact key and index pairs are moved around,
+ *  the draw commands themselves stay where they were recorded.
+ *  Commands that are already sorted are left alone, so the
+ *  normal matrices are only computed for new commands.
+ ***********************************************************/
+void RenderQueue::Sort()
+{
+	if (m_bSorted == true)
+	{
+		return;
+	}
+	m_bSorted = true;
+
+	UpdateNormalMatrices();
+
+	std::sort(
+		m_sortEntries.begin(),
+		m_sortEntries.end(),
+		[](const SORT_ENTRY& a, const SORT_ENTRY& b)
+		{
+			return(a.sortKey < b.sortKey);
+		});
+}
+
+/***********************************************************
+ *  SetPerInstanceState()
+ *
+ *  This method is used for choosing whether the material is
+ *  part of the sort key.  When materials, texture layers
+ *  and UV scales are read from the instance data, draws
+ *  that only differ by them can be grouped into the same
+ *  instanced draw call.
+ ***********************************************************/
+void RenderQueue::SetPerInstanceState(bool bPerInstance)
+{
+	m_bPerInstanceState = bPerInstance;
+}
+
+/***********************************************************
+ *  RecordStateChange()
+ *
+ *  This method is used for counting a shader state change
+ *  made while submitting the sorted commands.
+ ***********************************************************/
+void RenderQueue::RecordStateChange(STATE_TYPE state)
+{
+	m_frameStats.stateChanges[state]++;
+	m_frameStats.totalStateChanges++;
+}
+
+/***********************************************************
+ *  RecordDrawCall()
+ *
+ *  This method is used for counting a draw call issued
+ *  while submitting the sorted commands.
+ ***********************************************************/
+void RenderQueue::RecordDrawCall()
+{
+	m_frameStats.drawCalls++;
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for writing the frame statistics to
+ *  the console.  They are only written when they differ from
+ *  the previously written values so a static scene does not
+ *  flood the output every frame.
+ ***********************************************************/
+void RenderQueue::EndFrame()
+{
+	if (memcmp(&m_frameStats, &m_reportedStats, sizeof(FRAME_STATS)) == 0)
+	{
+		return;
+	}
+
+	std::cout << "INFO: RenderQueue - commands:" << m_frameStats.drawCommands
+		<< ", draw calls:" << m_frameStats.drawCalls
+		<< ", state changes:" << m_frameStats.totalStateChanges
+		<< " (unsorted:" << m_frameStats.unsortedStateChanges << ")";
+	for (int i = 0; i < STATE_COUNT; i++)
+	{
+		std::cout << ", " << g_StateNames[i] << ":" << m_frameStats.stateChanges[i];
+	}
+	std::cout << std::endl;
+
+	m_reportedStats = m_frameStats;
+}
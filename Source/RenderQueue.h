@@ -0,0 +1,147 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderqueue.h
+// ============
+// record draw commands with packed sort keys so they can be submitted in an
+// order that keeps shader state changes to a minimum
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  RenderQueue
+ *
+ *  This class collects the draw commands for one frame.
+ *  Each command carries a 64-bit sort key packed from the
+ *  program, texture array, material, mesh and view depth so
+ *  that sorting the keys groups draws sharing the same
+ *  shader state together.
+ ***********************************************************/
+class RenderQueue
+{
+public:
+	// constructor
+	RenderQueue();
+	// destructor
+	~RenderQueue();
+
+	// basic meshes that can be referenced by a draw command
+	enum MESH_TYPE
+	{
+		MESH_BOX = 0,
+		MESH_CYLINDER,
+		MESH_TAPERED_CYLINDER,
+		MESH_PLANE,
+		MESH_COUNT
+	};
+
+	// kinds of shader state that are tracked during submission
+	enum STATE_TYPE
+	{
+		STATE_PROGRAM = 0,
+		STATE_TEXTURE,
+		STATE_MATERIAL,
+		STATE_MESH,
+		STATE_COLOR,
+		STATE_UVSCALE,
+		STATE_COUNT
+	};
+
+	struct DRAW_COMMAND
+	{
+		uint64_t sortKey;
+		glm::mat4 model;
+		// inverse transpose of the model's upper 3x3, filled in
+		// by the queue before the commands are sorted
+		glm::mat3 normalMatrix;
+		glm::vec4 color;
+		glm::vec2 uvScale;
+		int program;
+		// texture index the draw was recorded with, -1 for none
+		int texture;
+		// virtual texture ID the draw samples instead, -1 for none
+		int virtualTexture;
+		// texture array and layer holding that texture, looked
+		// up when the draw is submitted to the queue, or the
+		// virtual texture ID for a virtual texture draw
+		int textureSlot;
+		int textureLayer;
+		int materialIndex;
+		int mesh;
+	};
+
+	struct FRAME_STATS
+	{
+		int drawCommands;
+		int drawCalls;
+		int stateChanges[STATE_COUNT];
+		int totalStateChanges;
+		int unsortedStateChanges;
+	};
+
+	struct SORT_ENTRY
+	{
+		uint64_t sortKey;
+		uint32_t index;
+	};
+
+private:
+	// draw commands recorded for the current frame
+	std::vector<DRAW_COMMAND> m_commands;
+	// sort keys and command indices in submission order
+	std::vector<SORT_ENTRY> m_sortEntries;
+	// statistics for the frame being recorded and submitted
+	FRAME_STATS m_frameStats;
+	// statistics that were last written to the console
+	FRAME_STATS m_reportedStats;
+	// position the depth portion of the sort key is measured from
+	glm::vec3 m_viewPosition;
+	// true when materials, texture layers and UV scales are
+	// per-instance data instead of shader state
+	bool m_bPerInstanceState;
+	// true when the commands have not changed since they were sorted
+	bool m_bSorted;
+	// incremented every time the recorded commands are cleared
+	uint32_t m_generation;
+
+	// pack the state of a draw command into a sort key
+	uint64_t BuildSortKey(const DRAW_COMMAND& command) const;
+	// count the state that differs between two draw commands
+	int CountStateChanges(const DRAW_COMMAND& previous, const DRAW_COMMAND& next) const;
+	// compute the normal matrix of every recorded command
+	void UpdateNormalMatrices();
+
+public:
+	// clear the recorded commands and statistics for a new frame
+	void BeginFrame(glm::vec3 viewPosition);
+	// keep the sorted commands of the previous frame for a new frame
+	void BeginReplay();
+	// record a draw command into the queue
+	void Submit(const DRAW_COMMAND& command);
+	// compute the normal matrices and sort the recorded
+	// commands by their sort keys
+	void Sort();
+	// report the frame statistics when they have changed
+	void EndFrame();
+	// leave the material out of the sort key when it does not
+	// need to be set between draws
+	void SetPerInstanceState(bool bPerInstance);
+
+	// record that a piece of shader state was changed
+	void RecordStateChange(STATE_TYPE state);
+	// record that a draw call was issued
+	void RecordDrawCall();
+
+	// get the number of recorded draw commands
+	size_t GetCommandCount() const { return(m_sortEntries.size()); }
+	// get a recorded draw command in sorted submission order
+	const DRAW_COMMAND& GetSortedCommand(size_t index) const { return(m_commands[m_sortEntries[index].index]); }
+	// get the statistics for the current frame
+	const FRAME_STATS& GetFrameStats() const { return(m_frameStats); }
+	// get a number that changes whenever the recorded commands do
+	uint32_t GetGeneration() const { return(m_generation); }
+};
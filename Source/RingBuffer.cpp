@@ -0,0 +1,291 @@
+///////////////////////////////////////////////////////////////////////////////
+// ringbuffer.cpp
+// ============
+// persistently mapped buffer split into per-frame regions, so that per-draw
+// data is written straight into GPU visible memory once per frame
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RingBuffer.h"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// the mapping stays valid while the GPU reads the buffer, and
+	// writes are visible to the GPU without explicit flushes
+	const GLbitfield g_MapFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	// longest single wait on a fence, one second in nanoseconds
+	const GLuint64 g_FenceTimeout = 1000000000;
+}
+
+/***********************************************************
+ *  RingBuffer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+RingBuffer::RingBuffer()
+{
+	m_buffer = 0;
+	m_pMapped = NULL;
+	m_frameSize = 0;
+	m_frameIndex = 0;
+	m_frameOffset = 0;
+	m_bGrow = false;
+	m_generation = 0;
+	for (int i = 0; i < FRAME_COUNT; i++)
+	{
+		m_fences[i] = NULL;
+	}
+	memset(&m_frameStats, 0, sizeof(m_frameStats));
+	memset(&m_reportedStats, 0, sizeof(m_reportedStats));
+}
+
+/***********************************************************
+ *  ~RingBuffer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+RingBuffer::~RingBuffer()
+{
+	DestroyBuffer();
+}
+
+/***********************************************************
+ *  IsSupported()
+ *
+ *  This method is used for checking whether the driver has
+ *  immutable buffer storage, which persistent mapping needs.
+ ***********************************************************/
+bool RingBuffer::IsSupported()
+{
+	return(GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage);
+}
+
+/***********************************************************
+ *  CreateBuffer()
+ *
+ *  This method is used for creating the buffer with room for
+ *  every region and mapping it once.
+ ***********************************************************/
+bool RingBuffer::CreateBuffer(size_t frameSize)
+{
+	GLsizeiptr bufferSize = (GLsizeiptr)(frameSize * FRAME_COUNT);
+
+	glGenBuffers(1, &m_buffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+	glBufferStorage(GL_COPY_WRITE_BUFFER, bufferSize, NULL, g_MapFlags);
+	m_pMapped = (unsigned char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, bufferSize, g_MapFlags);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	if (NULL == m_pMapped)
+	{
+		std::cout << "ERROR: Could not map the ring buffer" << std::endl;
+		glDeleteBuffers(1, &m_buffer);
+		m_buffer = 0;
+		return(false);
+	}
+
+	m_frameSize = frameSize;
+	m_frameIndex = 0;
+	m_frameOffset = 0;
+	m_generation++;
+	return(true);
+}
+
+/***********************************************************
+ *  DestroyBuffer()
+ *
+ *  This method is used for unmapping and deleting the buffer
+ *  along with any fences that are still waiting.
+ ***********************************************************/
+void RingBuffer::DestroyBuffer()
+{
+	for (int i = 0; i < FRAME_COUNT; i++)
+	{
+		if (NULL != m_fences[i])
+		{
+			glDeleteSync(m_fences[i]);
+			m_fences[i] = NULL;
+		}
+	}
+
+	if (0 != m_buffer)
+	{
+		glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+		glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		glDeleteBuffers(1, &m_buffer);
+	}
+	m_buffer = 0;
+	m_pMapped = NULL;
+	m_frameSize = 0;
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for creating the buffer with the
+ *  passed in number of bytes for each frame.
+ ***********************************************************/
+bool RingBuffer::Create(size_t frameSize)
+{
+	DestroyBuffer();
+	if (IsSupported() == false)
+	{
+		return(false);
+	}
+	return(CreateBuffer(frameSize));
+}
+
+/***********************************************************
+ *  WaitForRegion()
+ *
+ *  This method is used for blocking until the GPU has
+ *  finished the last frame that used the passed in region.
+ *  A wait that is needed at all is counted as a stall.
+ ***********************************************************/
+void RingBuffer::WaitForRegion(int frameIndex)
+{
+	GLenum result = GL_TIMEOUT_EXPIRED;
+	GLsync fence = m_fences[frameIndex];
+
+	if (NULL == fence)
+	{
+		return;
+	}
+
+	result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+	if (GL_TIMEOUT_EXPIRED == result)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		while (GL_TIMEOUT_EXPIRED == result)
+		{
+			result = glClientWaitSync(fence, 0, g_FenceTimeout);
+		}
+
+		m_frameStats.stalls++;
+		m_frameStats.stallMilliseconds += std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - start).count();
+	}
+
+	glDeleteSync(fence);
+	m_fences[frameIndex] = NULL;
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for moving to the next region and
+ *  waiting for the GPU to release it.  When the previous
+ *  frame ran out of room, the buffer is recreated at twice
+ *  the size after every region has been released.
+ ***********************************************************/
+void RingBuffer::BeginFrame()
+{
+	if (NULL == m_pMapped)
+	{
+		return;
+	}
+
+	if (m_bGrow == true)
+	{
+		size_t frameSize = m_frameSize * 2;
+
+		for (int i = 0; i < FRAME_COUNT; i++)
+		{
+			WaitForRegion(i);
+		}
+		DestroyBuffer();
+		if (CreateBuffer(frameSize) == false)
+		{
+			return;
+		}
+		std::cout << "INFO: RingBuffer - grown to " << frameSize << " bytes per frame" << std::endl;
+		m_bGrow = false;
+	}
+	else
+	{
+		m_frameIndex = (m_frameIndex + 1) % FRAME_COUNT;
+		WaitForRegion(m_frameIndex);
+	}
+	m_frameOffset = 0;
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for placing a fence after the draws
+ *  that read the current region, and writing the statistics
+ *  to the console when they differ from the last frame.
+ ***********************************************************/
+void RingBuffer::EndFrame()
+{
+	if (NULL == m_pMapped)
+	{
+		return;
+	}
+
+	m_fences[m_frameIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	if (m_frameStats.failedAllocations > 0)
+	{
+		m_bGrow = true;
+	}
+
+	if ((m_frameStats.bytesWritten != m_reportedStats.bytesWritten) ||
+		(m_frameStats.stalls != m_reportedStats.stalls) ||
+		(m_frameStats.failedAllocations != m_reportedStats.failedAllocations))
+	{
+		std::cout << "INFO: RingBuffer - bytes written: " << m_frameStats.bytesWritten
+			<< ", stalls: " << m_frameStats.stalls
+			<< " (" << m_frameStats.stallMilliseconds << " ms)"
+			<< ", failed allocations: " << m_frameStats.failedAllocations << std::endl;
+	}
+	m_reportedStats = m_frameStats;
+	memset(&m_frameStats, 0, sizeof(m_frameStats));
+}
+
+/***********************************************************
+ *  Allocate()
+ *
+ *  This method is used for reserving the passed in number of
+ *  bytes in the current region.  The returned pointer is
+ *  written directly by the caller, and the offset is where
+ *  the memory starts in the buffer.  NULL is returned when
+ *  the region is full, in which case the caller must upload
+ *  the data some other way for this frame.
+ ***********************************************************/
+void* RingBuffer::Allocate(size_t size, size_t alignment, GLintptr& offset)
+{
+	size_t regionStart = m_frameSize * m_frameIndex;
+	size_t start = 0;
+
+	if (NULL == m_pMapped)
+	{
+		return(NULL);
+	}
+
+	// offsets are aligned within the whole buffer, since that
+	// is what the GL binding rules check
+	start = regionStart + m_frameOffset;
+	if (alignment > 1)
+	{
+		start = ((start + alignment - 1) / alignment) * alignment;
+	}
+
+	if (start + size > regionStart + m_frameSize)
+	{
+		m_frameStats.failedAllocations++;
+		return(NULL);
+	}
+
+	m_frameStats.bytesWritten += (start + size) - (regionStart + m_frameOffset);
+	m_frameOffset = (start + size) - regionStart;
+	offset = (GLintptr)start;
+
+	return(m_pMapped + start);
+}
@@ -0,0 +1,98 @@
+///////////////////////////////////////////////////////////////////////////////
+// ringbuffer.h
+// ============
+// persistently mapped buffer split into per-frame regions, so that per-draw
+// data is written straight into GPU visible memory once per frame
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <cstdint>
+
+/***********************************************************
+ *  RingBuffer
+ *
+ *  This class owns one buffer that is mapped for the life of
+ *  the application.  The buffer is split into FRAME_COUNT
+ *  regions, and each frame writes only into its own region.
+ *  A fence is placed after the draws of every frame, and a
+ *  region is only reused once the fence of the frame that
+ *  last wrote it has signaled, so the CPU never overwrites
+ *  data the GPU is still reading.
+ ***********************************************************/
+class RingBuffer
+{
+public:
+	// constructor
+	RingBuffer();
+	// destructor
+	~RingBuffer();
+
+	// number of frames that can be in flight at once
+	static const int FRAME_COUNT = 3;
+
+	struct RING_STATS
+	{
+		// bytes handed out by Allocate, including alignment
+		size_t bytesWritten;
+		// times BeginFrame had to wait for the GPU
+		int stalls;
+		// total time spent waiting in milliseconds
+		double stallMilliseconds;
+		// allocations that did not fit in the frame's region
+		int failedAllocations;
+	};
+
+private:
+	// the persistently mapped buffer
+	GLuint m_buffer;
+	// CPU address of the start of the buffer
+	unsigned char* m_pMapped;
+	// size of each per-frame region in bytes
+	size_t m_frameSize;
+	// region written by the current frame
+	int m_frameIndex;
+	// bytes used in the current region
+	size_t m_frameOffset;
+	// true when the last frame ran out of room
+	bool m_bGrow;
+	// fence placed after the last frame that wrote each region
+	GLsync m_fences[FRAME_COUNT];
+	// statistics for the current frame
+	RING_STATS m_frameStats;
+	// statistics that were last written to the console
+	RING_STATS m_reportedStats;
+	// incremented every time the buffer is created, since a
+	// new buffer can be given the name of the deleted one
+	uint32_t m_generation;
+
+	// create and map the buffer with the passed in region size
+	bool CreateBuffer(size_t frameSize);
+	// unmap and delete the buffer and fences
+	void DestroyBuffer();
+	// wait for the fence of one region
+	void WaitForRegion(int frameIndex);
+
+public:
+	// check whether the driver supports persistent mapping
+	static bool IsSupported();
+	// create the buffer with the passed in region size
+	bool Create(size_t frameSize);
+	// wait until the next region is free and start writing to it
+	void BeginFrame();
+	// fence the current region and report the statistics
+	void EndFrame();
+	// reserve memory in the current region, returning NULL when full
+	void* Allocate(size_t size, size_t alignment, GLintptr& offset);
+
+	// get the buffer to bind for the allocated memory
+	GLuint GetBuffer() const { return(m_buffer); }
+	// get the number of times the buffer has been created, to
+	// tell a recreated buffer from the one it replaced
+	uint32_t GetGeneration() const { return(m_generation); }
+	// get the statistics for the current frame
+	const RING_STATS& GetFrameStats() const { return(m_frameStats); }
+};
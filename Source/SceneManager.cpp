@@ -1,654 +1,1752 @@
-///////////////////////////////////////////////////////////////////////////////
-// scenemanager.cpp
-// ============
-// manage the preparing and rendering of 3D scenes - textures, materials, lighting
-//
-//  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
-//	Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
-///////////////////////////////////////////////////////////////////////////////
-
-#include "SceneManager.h"
-
-#ifndef STB_IMAGE_IMPLEMENTATION
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
-#endif
-
-#include <glm/gtx/transform.hpp>
-
-// declaration of global variables
-namespace
-{
-	const char* g_ModelName = "model";
-	const char* g_ColorValueName = "objectColor";
-	const char* g_TextureValueName = "objectTexture";
-	const char* g_UseTextureName = "bUseTexture";
-	const char* g_UseLightingName = "bUseLighting";
-}
-
-/***********************************************************
- *  SceneManager()
- *
- *  The constructor for the class
- ***********************************************************/
-SceneManager::SceneManager(ShaderManager *pShaderManager)
-{
-	m_pShaderManager = pShaderManager;
-	m_basicMeshes = new ShapeMeshes();
-}
-
-/***********************************************************
- *  ~SceneManager()
- *
- *  The destructor for the class
- ***********************************************************/
-SceneManager::~SceneManager()
-{
-	m_pShaderManager = NULL;
-	delete m_basicMeshes;
-	m_basicMeshes = NULL;
-}
-
-/***********************************************************
- *  CreateGLTexture()
- *
- *  This method is used for loading textures from image files,
- *  configuring the texture mapping parameters in OpenGL,
- *  generating the mipmaps, and loading the read texture into
- *  the next available texture slot in memory.
- ***********************************************************/
-bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
-{
-	int width = 0;
-	int height = 0;
-	int colorChannels = 0;
-	GLuint textureID = 0;
-
-	// indicate to always flip images vertically when loaded
-	stbi_set_flip_vertically_on_load(true);
-
-	// try to parse the image data from the specified image file
-	unsigned char* image = stbi_load(
-		filename,
-		&width,
-		&height,
-		&colorChannels,
-		0);
-
-	// if the image was successfully read from the image file
-	if (image)
-	{
-		std::cout << "Successfully loaded image:" << filename << ", width:" << width << ", height:" << height << ", channels:" << colorChannels << std::endl;
-
-		glGenTextures(1, &textureID);
-		glBindTexture(GL_TEXTURE_2D, textureID);
-
-		// set the texture wrapping parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		// set texture filtering parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		// if the loaded image is in RGB format
-		if (colorChannels == 3)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-		// if the loaded image is in RGBA format - it supports transparency
-		else if (colorChannels == 4)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
-		else
-		{
-			std::cout << "Not implemented to handle image with " << colorChannels << " channels" << std::endl;
-			return false;
-		}
-
-		// generate the texture mipmaps for mapping textures to lower resolutions
-		glGenerateMipmap(GL_TEXTURE_2D);
-
-		// free the image data from local memory
-		stbi_image_free(image);
-		glBindTexture(GL_TEXTURE_2D, 0); // Unbind the texture
-
-		// register the loaded texture and associate it with the special tag string
-		m_textureIDs[m_loadedTextures].ID = textureID;
-		m_textureIDs[m_loadedTextures].tag = tag;
-		m_loadedTextures++;
-
-		return true;
-	}
-
-	std::cout << "Could not load image:" << filename << std::endl;
-
-	// Error loading the image
-	return false;
-}
-
-/***********************************************************
- *  BindGLTextures()
- *
- *  This method is used for binding the loaded textures to
- *  OpenGL texture memory slots.  There are up to 16 slots.
- ***********************************************************/
-void SceneManager::BindGLTextures()
-{
-	for (int i = 0; i < m_loadedTextures; i++)
-	{
-		// bind textures on corresponding texture units
-		glActiveTexture(GL_TEXTURE0 + i);
-		glBindTexture(GL_TEXTURE_2D, m_textureIDs[i].ID);
-	}
-}
-
-/***********************************************************
- *  DestroyGLTextures()
- *
- *  This method is used for freeing the memory in all the
- *  used texture memory slots.
- ***********************************************************/
-void SceneManager::DestroyGLTextures()
-{
-	for (int i = 0; i < m_loadedTextures; i++)
-	{
-		glGenTextures(1, &m_textureIDs[i].ID);
-	}
-}
-
-/***********************************************************
- *  FindTextureID()
- *
- *  This method is used for getting an ID for the previously
- *  loaded texture bitmap associated with the passed in tag.
- ***********************************************************/
-int SceneManager::FindTextureID(std::string tag)
-{
-	int textureID = -1;
-	int index = 0;
-	bool bFound = false;
-
-	while ((index < m_loadedTextures) && (bFound == false))
-	{
-		if (m_textureIDs[index].tag.compare(tag) == 0)
-		{
-			textureID = m_textureIDs[index].ID;
-			bFound = true;
-		}
-		else
-			index++;
-	}
-
-	return(textureID);
-}
-
-/***********************************************************
- *  FindTextureSlot()
- *
- *  This method is used for getting a slot index for the previously
- *  loaded texture bitmap associated with the passed in tag.
- ***********************************************************/
-int SceneManager::FindTextureSlot(std::string tag)
-{
-	int textureSlot = -1;
-	int index = 0;
-	bool bFound = false;
-
-	while ((index < m_loadedTextures) && (bFound == false))
-	{
-		if (m_textureIDs[index].tag.compare(tag) == 0)
-		{
-			textureSlot = index;
-			bFound = true;
-		}
-		else
-			index++;
-	}
-
-	return(textureSlot);
-}
-
-/***********************************************************
- *  FindMaterial()
- *
- *  This method is used for getting a material from the previously
- *  defined materials list that is associated with the passed in tag.
- ***********************************************************/
-bool SceneManager::FindMaterial(std::string tag, OBJECT_MATERIAL& material)
-{
-	if (m_objectMaterials.size() == 0)
-	{
-		return(false);
-	}
-
-	int index = 0;
-	bool bFound = false;
-	while ((index < m_objectMaterials.size()) && (bFound == false))
-	{
-		if (m_objectMaterials[index].tag.compare(tag) == 0)
-		{
-			bFound = true;
-			material.diffuseColor = m_objectMaterials[index].diffuseColor;
-			material.specularColor = m_objectMaterials[index].specularColor;
-			material.shininess = m_objectMaterials[index].shininess;
-		}
-		else
-		{
-			index++;
-		}
-	}
-
-	return(true);
-}
-
-/***********************************************************
- *  SetTransformations()
- *
- *  This method is used for setting the transform buffer
- *  using the passed in transformation values.
- ***********************************************************/
-void SceneManager::SetTransformations(
-	glm::vec3 scaleXYZ,
-	float XrotationDegrees,
-	float YrotationDegrees,
-	float ZrotationDegrees,
-	glm::vec3 positionXYZ)
-{
-	// variables for this method
-	glm::mat4 modelView;
-	glm::mat4 scale;
-	glm::mat4 rotationX;
-	glm::mat4 rotationY;
-	glm::mat4 rotationZ;
-	glm::mat4 translation;
-
-	// set the scale value in the transform buffer
-	scale = glm::scale(scaleXYZ);
-	// set the rotation values in the transform buffer
-	rotationX = glm::rotate(glm::radians(XrotationDegrees), glm::vec3(1.0f, 0.0f, 0.0f));
-	rotationY = glm::rotate(glm::radians(YrotationDegrees), glm::vec3(0.0f, 1.0f, 0.0f));
-	rotationZ = glm::rotate(glm::radians(ZrotationDegrees), glm::vec3(0.0f, 0.0f, 1.0f));
-	// set the translation value in the transform buffer
-	translation = glm::translate(positionXYZ);
-
-	modelView = translation * rotationZ * rotationY * rotationX * scale;
-
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setMat4Value(g_ModelName, modelView);
-	}
-}
-
-/***********************************************************
- *  SetShaderColor()
- *
- *  This method is used for setting the passed in color
- *  into the shader for the next draw command
- ***********************************************************/
-void SceneManager::SetShaderColor(
-	float redColorValue,
-	float greenColorValue,
-	float blueColorValue,
-	float alphaValue)
-{
-	// variables for this method
-	glm::vec4 currentColor;
-
-	currentColor.r = redColorValue;
-	currentColor.g = greenColorValue;
-	currentColor.b = blueColorValue;
-	currentColor.a = alphaValue;
-
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setIntValue(g_UseTextureName, false);
-		m_pShaderManager->setVec4Value(g_ColorValueName, currentColor);
-	}
-}
-
-/***********************************************************
- *  SetShaderTexture()
- *
- *  This method is used for setting the texture data
- *  associated with the passed in ID into the shader.
- ***********************************************************/
-void SceneManager::SetShaderTexture(
-	std::string textureTag)
-{
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setIntValue(g_UseTextureName, true);
-
-		int textureID = -1;
-		textureID = FindTextureSlot(textureTag);
-		m_pShaderManager->setSampler2DValue(g_TextureValueName, textureID);
-	}
-}
-
-/***********************************************************
- *  SetTextureUVScale()
- *
- *  This method is used for setting the texture UV scale
- *  values into the shader.
- ***********************************************************/
-void SceneManager::SetTextureUVScale(float u, float v)
-{
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setVec2Value("UVscale", glm::vec2(u, v));
-	}
-}
-
-/***********************************************************
- *  SetShaderMaterial()
- *
- *  This method is used for passing the material values
- *  into the shader.
- ***********************************************************/
-void SceneManager::SetShaderMaterial(
-	std::string materialTag)
-{
-	if (m_objectMaterials.size() > 0)
-	{
-		OBJECT_MATERIAL material;
-		bool bReturn = false;
-
-		bReturn = FindMaterial(materialTag, material);
-		if (bReturn == true)
-		{
-			m_pShaderManager->setVec3Value("material.diffuseColor", material.diffuseColor);
-			m_pShaderManager->setVec3Value("material.specularColor", material.specularColor);
-			m_pShaderManager->setFloatValue("material.shininess", material.shininess);
-		}
-	}
-}
-
-/***********************************************************
- * DefineObjectMaterials()
- *
- * This method is used for configuring the various material
- * settings for all of the objects within the 3D scene.
- ***********************************************************/
-void SceneManager::DefineObjectMaterials()
-{
-	/*** STUDENTS - add the code BELOW for defining object materials. ***/
-	/*** There is no limit to the number of object materials that can ***/
-	/*** be defined. Refer to the code in the OpenGL Sample for help ***/
-	OBJECT_MATERIAL plasticMaterial;
-	plasticMaterial.diffuseColor = glm::vec3(0.5f, 0.5f, 0.5f);
-	plasticMaterial.specularColor = glm::vec3(0.7f, 0.7f, 0.7f);
-	plasticMaterial.shininess = 5.0;
-	plasticMaterial.tag = "plastic";
-	m_objectMaterials.push_back(plasticMaterial);
-
-	OBJECT_MATERIAL woodMaterial;
-	woodMaterial.diffuseColor = glm::vec3(0.6f, 0.5f, 0.2f);
-	woodMaterial.specularColor = glm::vec3(0.5f, 0.2f, 0.5f);
-	woodMaterial.shininess = 1.0;
-	woodMaterial.tag = "wood";
-	m_objectMaterials.push_back(woodMaterial);
-
-	OBJECT_MATERIAL stoneMaterial;
-	stoneMaterial.diffuseColor = glm::vec3(0.5f, 0.5f, 0.5f);
-	stoneMaterial.specularColor = glm::vec3(0.73f, 0.3f, 0.3f);
-	stoneMaterial.shininess = 6.0;
-	stoneMaterial.tag = "stone";
-	m_objectMaterials.push_back(stoneMaterial);
-
-}
-
-void SceneManager::SetupSceneLights()
-{
-	// this line of code is NEEDED for telling the shaders to render 
-	// the 3D scene with custom lighting, if no light sources have
-	// been added then the display window will be black - to use the 
-	// default OpenGL lighting then comment out the following line
-	m_pShaderManager->setBoolValue(g_UseLightingName, true);
-
-	/*** STUDENTS - add the code BELOW for setting up light sources ***/
-	/*** Up to four light sources can be defined. Refer to the code ***/
-	/*** in the OpenGL Sample for help                              ***/
-
-	// point light 1
-	m_pShaderManager->setVec3Value("pointLights[0].position", 4.0f, 6.0f, 2.0f);
-	m_pShaderManager->setVec3Value("pointLights[0].ambient", 0.05f, 0.05f, 0.05f);
-	m_pShaderManager->setVec3Value("pointLights[0].diffuse", 1.0f, 1.0f, 1.0f);
-	m_pShaderManager->setVec3Value("pointLights[0].specular", 0.2f, 0.2f, 0.2f);
-	m_pShaderManager->setBoolValue("pointLights[0].bActive", true);
-
-	// point light 2
-	m_pShaderManager->setVec3Value("pointLights[1].position", -4.0f, -4.0f, -4.0f);
-	m_pShaderManager->setVec3Value("pointLights[1].ambient", 0.05f, 0.05f, 0.05f);
-	m_pShaderManager->setVec3Value("pointLights[1].diffuse", 0.8f, 0.8f, 0.8f);
-	m_pShaderManager->setVec3Value("pointLights[1].specular", 0.2f, 0.2f, 0.2f);
-	m_pShaderManager->setBoolValue("pointLights[1].bActive", true);
-
-	// directional light 3
-	m_pShaderManager->setVec3Value("directionalLight.direction", 7.2f, 7.2f, 1.5f);
-	m_pShaderManager->setVec3Value("directionalLight.ambient", 0.05f, 0.05f, 0.01f);
-	m_pShaderManager->setVec3Value("directionalLight.diffuse", 0.8f, 0.8f, 0.8f);
-	m_pShaderManager->setVec3Value("directionalLight.specular", 0.2f, 0.2f, 0.2f);
-	m_pShaderManager->setBoolValue("directionalLight.bActive", true);
-
-	
-	// spotlight 4
-	m_pShaderManager->setVec3Value("spotLight.ambient", 0.0f, 0.0f, 0.0f);
-	m_pShaderManager->setVec3Value("spotLight.diffuse", 1.0f, 1.0f, 1.0f);
-	m_pShaderManager->setVec3Value("spotLight.specular", 1.0f, 1.0f, 1.0f);
-	m_pShaderManager->setFloatValue("spotLight.constant", 1.0f);
-	m_pShaderManager->setFloatValue("spotLight.linear", 0.014f);
-	m_pShaderManager->setFloatValue("spotLight.quadratic", 0.0007f);
-	m_pShaderManager->setFloatValue("spotLight.cutOff", glm::cos(glm::radians(22.5f)));
-	m_pShaderManager->setFloatValue("spotLight.outerCutOff",
-		glm::cos(glm::radians(28.0f)));
-	m_pShaderManager->setBoolValue("spotLight.bActive", true);
-
-
-}
-
-void SceneManager::LoadSceneTextures()
-{
-	/*** STUDENTS - add the code BELOW for loading the textures that ***/
-	/*** will be used for mapping to objects in the 3D scene. Up to  ***/
-	/*** 16 textures can be loaded per scene. Refer to the code in   ***/
-	/*** the OpenGL Sample for help.                                 ***/
-	CreateGLTexture("textures/marbletexture.jpg", "marble");
-	CreateGLTexture("textures/woodtexture.jpg", "wood");
-
-
-
-	// after the texture image data is loaded into memory, the
-	// loaded textures need to be bound to texture slots - there
-	// are a total of 16 available slots for scene textures
-	BindGLTextures();
-}
-
-
-/**************************************************************/
-/*** STUDENTS CAN MODIFY the code in the methods BELOW for  ***/
-/*** preparing and rendering their own 3D replicated scenes.***/
-/*** Please refer to the code in the OpenGL sample project  ***/
-/*** for assistance.                                        ***/
-/**************************************************************/
-
-
-/***********************************************************
- *  PrepareScene()
- *
- *  This method is used for preparing the 3D scene by loading
- *  the shapes, textures in memory to support the 3D scene 
- *  rendering
- ***********************************************************/
-void SceneManager::PrepareScene()
-{
-	// only one instance of a particular mesh needs to be
-	// loaded in memory no matter how many times it is drawn
-	// in the rendered 3D scene
-	LoadSceneTextures();
-	DefineObjectMaterials();
-	SetupSceneLights();
-	m_basicMeshes->LoadPlaneMesh();
-	m_basicMeshes->LoadCylinderMesh();
-	m_basicMeshes->LoadTaperedCylinderMesh();
-	m_basicMeshes->LoadBoxMesh();
-}
-
-/***********************************************************
- *  RenderScene()
- *
- *  This method is used for rendering the 3D scene by 
- *  transforming and drawing the basic 3D shapes
- ***********************************************************/
-void SceneManager::RenderScene()
-{
-	// declare the variables for the transformations
-	glm::vec3 scaleXYZ;
-	float XrotationDegrees = 0.0f;
-	float YrotationDegrees = 0.0f;
-	float ZrotationDegrees = 0.0f;
-	glm::vec3 positionXYZ;
-
-	glm::vec3 scaleCylinderBody;
-	glm::vec3 scaleTaperedCylinder;
-	glm::vec3 positionCylinderBody;
-	glm::vec3 positionTaperedCylinder;
-
-	/*** Set needed transformations before drawing the basic mesh.  ***/
-	/*** This same ordering of code should be used for transforming ***/
-	/*** and drawing all the basic 3D shapes.						***/
-	/******************************************************************/
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(40.0f, 0.5f, 20.0f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(0.0f, 0.0f, 0.0f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	//SetShaderColor(0.8f, 0.6f, 0.4f, 1.0f);
-	SetShaderMaterial("wood");
-	SetShaderTexture("marble");
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
-	// Table Legs 
-	float tableHeight = 3.0f; 
-	glm::vec3 scaleLeg = glm::vec3(0.3f, tableHeight, 0.3f);  
-
-	// Tabletop dimensions
-	float tableWidth = 40.0f;   
-	float tableDepth = 20.0f;   
-	float legOffsetX = scaleLeg.x * 2.0f; 
-	float legOffsetZ = scaleLeg.z * 1.5f; 
-
-	// Table leg positions
-	glm::vec3 legPositions[4] = {
-		glm::vec3(-tableWidth / 2.0f + legOffsetX, -tableHeight / 1.0f, -tableDepth / 2.0f + legOffsetZ), // Rear-left corner
-		glm::vec3(tableWidth / 2.0f - legOffsetX, -tableHeight / 1.0f, -tableDepth / 2.0f + legOffsetZ),  // Rear-right corner
-		glm::vec3(-tableWidth / 2.0f + legOffsetX, -tableHeight / 1.0f, tableDepth / 2.0f - legOffsetZ),  // Front-left corner
-		glm::vec3(tableWidth / 2.0f - legOffsetX, -tableHeight / 1.0f, tableDepth / 2.0f - legOffsetZ)    // Front-right corner
-	};
-	
-	// Render the four legs
-	for (int i = 0; i < 4; i++) {
-		SetTransformations(scaleLeg, 0.0f, 0.0f, 0.0f, legPositions[i]);
-		//SetShaderColor(0.5f, 0.5f, 0.5f, 1.0f);
-		SetShaderTexture("wood");
-		m_basicMeshes->DrawCylinderMesh();
-	}
-
-
-	/****************************************************************/
-	//Main Cylinder (body of the bowl)
-	scaleCylinderBody = glm::vec3(1.5f, 0.9f, 1.5f); 
-	positionCylinderBody = glm::vec3(0.0f, 0.0f, 0.0f);  
-
-	SetTransformations(scaleCylinderBody, 0.0f, 0.0f, 0.0f, positionCylinderBody);
-	SetShaderColor(1,1,1,1); 
-	SetShaderMaterial("plastic");
-	//SetShaderTexture("marble");
-	m_basicMeshes->DrawCylinderMesh();
-
-	//Tapered Cylinder (upper slope of the bowl)
-	scaleTaperedCylinder = glm::vec3(2.0f, 0.3f, 2.0f);  
-	positionTaperedCylinder = glm::vec3(0.0f, 1.0f, 0.0f);
-	float rotationDegrees = 180.0f;
-
-	SetTransformations(scaleTaperedCylinder, rotationDegrees, 0.0f, 0.0f, positionTaperedCylinder);
-	//SetShaderColor(1,1,1,1);  
-	SetShaderMaterial("stone");
-	SetShaderTexture("marble");
-	m_basicMeshes->DrawTaperedCylinderMesh();
-
-	//Microwave
-	// Set transformations for microwave body 
-	glm::vec3 scaleMicrowaveBody = glm::vec3(9.5f, 5.2f, 5.5f); 
-	glm::vec3 positionMicrowaveBody = glm::vec3(10.0f, 3.0f, 0.0f);
-
-	SetTransformations(scaleMicrowaveBody, 0.0f, 0.0f, 0.0f, positionMicrowaveBody);
-	SetShaderMaterial("plastic");
-	SetShaderColor(0.5f, 0.5f, 0.5f, 1.0f);
-	m_basicMeshes->DrawBoxMesh();
-
-	// Microwave front panel
-	glm::vec3 scaleMicrowaveFront = glm::vec3(9.5f, 5.2f, 0.1f); 
-	glm::vec3 positionMicrowaveFront = glm::vec3(10.0f, 3.0f, 2.8f); 
-
-	SetTransformations(scaleMicrowaveFront, 0.0f, 0.0f, 0.0f, positionMicrowaveFront);
-	SetShaderMaterial("plastic");
-	SetShaderTexture("marble"); 
-	m_basicMeshes->DrawBoxMesh();
-
-	// Microwave control panel 
-	glm::vec3 scaleMicrowavePanel = glm::vec3(0.3f, 0.7f, 1.5f); 
-	glm::vec3 positionMicrowavePanel = glm::vec3(13.2f, 1.3f, 2.85f); 
-
-	SetTransformations(scaleMicrowavePanel, 0.0f, 90.0f, 0.0f, positionMicrowavePanel);
-	SetShaderMaterial("plastic");
-	SetShaderTexture("wood"); 
-	m_basicMeshes->DrawBoxMesh(); 
-
-	// Ice maker 
-	glm::vec3 scaleIceMakerBody = glm::vec3(4.5f, 5.0f, 4.2f); 
-	glm::vec3 positionIceMakerBody = glm::vec3(-5.0f, 2.7f, 0.0f); 
-
-	SetTransformations(scaleIceMakerBody, 0.0f, 0.0f, 0.0f, positionIceMakerBody);
-	SetShaderMaterial("plastic");
-	SetShaderColor(0.8f, 0.1f, 0.1f, 1.0f); 
-	m_basicMeshes->DrawBoxMesh();
-
-	// Ice maker front 
-	glm::vec3 scaleIceMakerFrontCylinder = glm::vec3(2.27f, 5.0f, 1.8f); 
-	glm::vec3 positionIceMakerFrontCylinder = glm::vec3(-5.0f, 0.2f, 1.96f);
-
-	SetTransformations(scaleIceMakerFrontCylinder, 0.0f, 0.0f, 0.0f, positionIceMakerFrontCylinder); 
-	SetShaderMaterial("plastic");
-	SetShaderColor(0.8f, 0.1f, 0.1f, 1.0f); 
-	m_basicMeshes->DrawCylinderMesh(); 
-
-	// Pitcher
-	// Main body of the pitcher 
-	glm::vec3 scalePitcherBody = glm::vec3(1.0f, 2.5f, 1.0f); 
-	glm::vec3 positionPitcherBody = glm::vec3(1.5f, 0.0f, -4.0f);
-
-	SetTransformations(scalePitcherBody, 0.0f, 0.0f, 0.0f, positionPitcherBody);
-	SetShaderMaterial("plastic"); 
-	SetShaderColor(0.4f, 0.9f, 0.9f, 4.0f); 
-	m_basicMeshes->DrawCylinderMesh(); 
-
-	// Pitcher spout 
-	glm::vec3 scalePitcherSpout = glm::vec3(0.2f, 0.3f, 0.3f); 
-	glm::vec3 positionPitcherSpout = glm::vec3(1.5f, 1.9f, -3.2f); 
-
-	SetTransformations(scalePitcherSpout, 45.0f, 0.0f, 0.0f, positionPitcherSpout); 
-	SetShaderMaterial("plastic");
-	SetShaderColor(0.4f, 0.9f, 0.9f, 4.0f);
-	m_basicMeshes->DrawCylinderMesh(); 
-}
+///////////////////////////////////////////////////////////////////////////////
+// scenemanager.cpp
+// ============
+// manage the preparing and rendering of 3D scenes - textures, materials, lighting
+//
+//  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
+//	Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneManager.h"
+
+#include <glm/gtx/transform.hpp>
+
+#include <algorithm>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	const char* g_DrawDataBlockName = "DrawDataBuffer";
+
+	// names of the uniforms set for every draw, hashed at compile time
+	constexpr uint32_t g_ModelName = UniformHash("model");
+	constexpr uint32_t g_NormalMatrixName = UniformHash("normalMatrix");
+	constexpr uint32_t g_ColorValueName = UniformHash("objectColor");
+	constexpr uint32_t g_TextureValueName = UniformHash("objectTexture");
+	constexpr uint32_t g_UVScaleName = UniformHash("UVscale");
+	constexpr uint32_t g_TextureLayerName = UniformHash("textureLayer");
+	constexpr uint32_t g_MaterialIndexName = UniformHash("materialIndex");
+	constexpr uint32_t g_UseInstancingName = UniformHash("bUseInstancing");
+	constexpr uint32_t g_UseIndirectName = UniformHash("bUseIndirect");
+	constexpr uint32_t g_DrawIndexBaseName = UniformHash("drawIndexBase");
+	constexpr uint32_t g_VirtualPageTableName = UniformHash("virtualPageTable");
+	constexpr uint32_t g_VirtualPageCacheName = UniformHash("virtualPageCache");
+	constexpr uint32_t g_VirtualTextureInfoName = UniformHash("virtualTextureInfo");
+	constexpr uint32_t g_VirtualCacheInfoName = UniformHash("virtualCacheInfo");
+
+	// shader storage binding point of the per-draw data
+	const GLuint g_DrawDataBinding = LAYOUT_DRAW_DATA_BINDING;
+	// texture unit every texture array is sampled from
+	const int g_TextureUnit = 0;
+	// texture units of a virtual texture's page table and of
+	// the page cache
+	const int g_PageTableUnit = 1;
+	const int g_PageCacheUnit = 2;
+
+	// texture levels kept on the GPU, and uploaded in one frame
+	const size_t g_TextureBudgetBytes = 128 * 1024 * 1024;
+	const size_t g_TextureUploadBytesPerFrame = 4 * 1024 * 1024;
+
+	// radius of a sphere around the origin of each basic mesh
+	// that holds the whole mesh, for measuring it on screen.
+	// The box spans -0.5 to 0.5, the plane -1 to 1 across,
+	// and the cylinders a radius of 1 from 0 to 1 high.
+	const float g_MeshRadius[RenderQueue::MESH_COUNT] =
+	{
+		0.87f, 1.42f, 1.42f, 1.42f
+	};
+
+	/***********************************************************
+	 *  FillInstanceData()
+	 *
+	 *  This function is used for copying the per-draw values
+	 *  of a draw command into the layout the vertex shader
+	 *  reads for instanced and indirect draws.
+	 ***********************************************************/
+	void FillInstanceData(const RenderQueue::DRAW_COMMAND& command, BatchedMeshes::INSTANCE_DATA& data)
+	{
+		data.model = command.model;
+		for (int i = 0; i < 3; i++)
+		{
+			data.normalMatrix[i] = glm::vec4(command.normalMatrix[i], 0.0f);
+		}
+		data.color = command.color;
+		data.materialIndex = (command.materialIndex >= 0) ? command.materialIndex : 0;
+		data.textureLayer = command.textureLayer;
+		data.uvScale = command.uvScale;
+	}
+}
+
+/***********************************************************
+ *  SceneManager()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneManager::SceneManager(GLStateCache* pStateCache, ShaderVariants* pShaderVariants)
+{
+	m_pStateCache = pStateCache;
+	m_pShaderVariants = pShaderVariants;
+	m_bUseLighting = false;
+	m_basicMeshes = new ShapeMeshes();
+	m_batchedMeshes = new BatchedMeshes();
+	m_lightList = new LightList();
+	m_materialTable = new MaterialTable();
+	m_commandList = new CommandList();
+	m_bRetainedMode = false;
+	m_bReplayNeeded = true;
+	m_replayViewPosition = glm::vec3(0.0f);
+	m_uploadedGeneration = 0;
+	m_renderQueue = new RenderQueue();
+	m_viewPosition = glm::vec3(0.0f);
+	m_shadingLod = new ShadingLod();
+	m_textureArrays = new TextureArrays(pStateCache);
+	m_textureStreamer = new TextureStreamer(m_textureArrays);
+	m_textureLoader = new TextureLoader(m_textureArrays, m_textureStreamer);
+	m_virtualTextures = new VirtualTextures(pStateCache);
+	m_assets = new AssetRegistry();
+	m_sceneAssets = SCENE_ASSETS();
+	SetSubmitMode(SUBMIT_INSTANCED);
+
+	// every shader variant reads the same scene buffers
+	if (NULL != m_pShaderVariants)
+	{
+		m_pShaderVariants->AddProgramCallback([this](int variant, GLuint programID) { AttachProgram(variant, programID); });
+	}
+}
+
+/***********************************************************
+ *  ~SceneManager()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+SceneManager::~SceneManager()
+{
+	// stop the texture decodes before their textures are freed
+	delete m_textureLoader;
+	m_textureLoader = NULL;
+	DestroyGLTextures();
+	delete m_textureStreamer;
+	m_textureStreamer = NULL;
+	delete m_virtualTextures;
+	m_virtualTextures = NULL;
+	delete m_textureArrays;
+	m_textureArrays = NULL;
+	delete m_assets;
+	m_assets = NULL;
+	m_pStateCache = NULL;
+	m_pShaderVariants = NULL;
+	delete m_basicMeshes;
+	m_basicMeshes = NULL;
+	delete m_batchedMeshes;
+	m_batchedMeshes = NULL;
+	delete m_lightList;
+	m_lightList = NULL;
+	delete m_materialTable;
+	m_materialTable = NULL;
+	delete m_commandList;
+	m_commandList = NULL;
+	delete m_renderQueue;
+	m_renderQueue = NULL;
+	delete m_shadingLod;
+	m_shadingLod = NULL;
+}
+
+/***********************************************************
+ *  CreateGLTexture()
+ *
+ *  This method is used for creating a texture for an image
+ *  file in the texture arrays, with no limit on how many
+ *  are loaded.  The image is decoded on a worker thread
+ *  and uploaded, along with its mipmaps, between frames, so
+ *  the texture shows a placeholder until then.  A file that
+ *  cannot be decoded is reported when the worker gets to it.
+ ***********************************************************/
+bool SceneManager::CreateGLTexture(const char* filename, const std::string& tag)
+{
+	int texture = m_textureLoader->Load(filename);
+
+	if (texture < 0)
+	{
+		std::cout << "ERROR: Could not create a texture for " << filename << std::endl;
+		return(false);
+	}
+
+	// register the texture and associate it with the special tag string
+	m_assets->Register(ASSET_TEXTURE, tag, texture);
+	return(true);
+}
+
+/***********************************************************
+ *  CreateGLVirtualTexture()
+ *
+ *  This method is used for mapping the virtual texture
+ *  baked from an image file, whose pages are loaded as the
+ *  frame samples them, and registering it under the passed
+ *  in tag.  SetShaderTexture() takes the tag the same as a
+ *  regular texture's.  Nothing is registered when the file
+ *  has not been baked with BakeTextures --virtual.
+ ***********************************************************/
+bool SceneManager::CreateGLVirtualTexture(const char* filename, const std::string& tag)
+{
+	int virtualTexture = m_virtualTextures->Load(filename);
+
+	if (virtualTexture < 0)
+	{
+		return(false);
+	}
+
+	m_assets->Register(ASSET_VIRTUAL_TEXTURE, tag, virtualTexture);
+	return(true);
+}
+
+/***********************************************************
+ *  DestroyGLTextures()
+ *
+ *  This method is used for freeing the texture arrays that
+ *  hold all of the loaded textures, and every virtual
+ *  texture, leaving any handle to one of them stale.
+ ***********************************************************/
+void SceneManager::DestroyGLTextures()
+{
+	m_textureStreamer->Clear();
+	m_textureArrays->Clear();
+	m_assets->Clear(ASSET_TEXTURE);
+	m_virtualTextures->Clear();
+	m_assets->Clear(ASSET_VIRTUAL_TEXTURE);
+}
+
+/***********************************************************
+ *  RegisterMeshes()
+ *
+ *  This method is used for registering each basic mesh
+ *  under a tag, so that draws refer to meshes by handle the
+ *  same way as to textures and materials.
+ ***********************************************************/
+void SceneManager::RegisterMeshes()
+{
+	m_assets->Clear(ASSET_MESH);
+	m_assets->Register(ASSET_MESH, "box", RenderQueue::MESH_BOX);
+	m_assets->Register(ASSET_MESH, "cylinder", RenderQueue::MESH_CYLINDER);
+	m_assets->Register(ASSET_MESH, "taperedCylinder", RenderQueue::MESH_TAPERED_CYLINDER);
+	m_assets->Register(ASSET_MESH, "plane", RenderQueue::MESH_PLANE);
+}
+
+/***********************************************************
+ *  ResolveSceneAssets()
+ *
+ *  This method is used for looking up the handles of every
+ *  asset the scene draws with, once all of them have been
+ *  registered, so that a missing tag is reported while the
+ *  scene loads rather than dropped while it draws.
+ ***********************************************************/
+void SceneManager::ResolveSceneAssets()
+{
+	struct ASSET_LOOKUP
+	{
+		ASSET_HANDLE* pHandle;
+		ASSET_TYPE type;
+		const char* tag;
+	};
+
+	const ASSET_LOOKUP lookups[] =
+	{
+		{ &m_sceneAssets.marbleTexture, ASSET_TEXTURE, "marble" },
+		{ &m_sceneAssets.woodTexture, ASSET_TEXTURE, "wood" },
+		{ &m_sceneAssets.plasticMaterial, ASSET_MATERIAL, "plastic" },
+		{ &m_sceneAssets.woodMaterial, ASSET_MATERIAL, "wood" },
+		{ &m_sceneAssets.stoneMaterial, ASSET_MATERIAL, "stone" },
+		{ &m_sceneAssets.boxMesh, ASSET_MESH, "box" },
+		{ &m_sceneAssets.cylinderMesh, ASSET_MESH, "cylinder" },
+		{ &m_sceneAssets.taperedCylinderMesh, ASSET_MESH, "taperedCylinder" },
+		{ &m_sceneAssets.planeMesh, ASSET_MESH, "plane" }
+	};
+
+	for (size_t i = 0; i < sizeof(lookups) / sizeof(lookups[0]); i++)
+	{
+		*lookups[i].pHandle = m_assets->Find(lookups[i].type, lookups[i].tag);
+		if (*lookups[i].pHandle == INVALID_ASSET_HANDLE)
+		{
+			std::cout << "ERROR: Scene asset " << lookups[i].tag << " is not defined" << std::endl;
+		}
+	}
+
+	// the table top is only virtually textured once its file
+	// has been baked
+	m_sceneAssets.tabletopTexture = m_assets->Find(ASSET_VIRTUAL_TEXTURE, "tabletop");
+	if (m_sceneAssets.tabletopTexture == INVALID_ASSET_HANDLE)
+	{
+		m_sceneAssets.tabletopTexture = m_sceneAssets.marbleTexture;
+	}
+}
+
+/***********************************************************
+ *  SetTransformations()
+ *
+ *  This method is used for setting the model matrix of the
+ *  next recorded draw using the passed in transformation
+ *  values.
+ ***********************************************************/
+void SceneManager::SetTransformations(
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	// variables for this method
+	glm::mat4 modelView;
+	glm::mat4 scale;
+	glm::mat4 rotationX;
+	glm::mat4 rotationY;
+	glm::mat4 rotationZ;
+	glm::mat4 translation;
+
+	// nothing is computed for objects that are not recorded
+	if (IsRecordingDraws() == false)
+	{
+		return;
+	}
+
+	// set the scale value in the transform buffer
+	scale = glm::scale(scaleXYZ);
+	// set the rotation values in the transform buffer
+	rotationX = glm::rotate(glm::radians(XrotationDegrees), glm::vec3(1.0f, 0.0f, 0.0f));
+	rotationY = glm::rotate(glm::radians(YrotationDegrees), glm::vec3(0.0f, 1.0f, 0.0f));
+	rotationZ = glm::rotate(glm::radians(ZrotationDegrees), glm::vec3(0.0f, 0.0f, 1.0f));
+	// set the translation value in the transform buffer
+	translation = glm::translate(positionXYZ);
+
+	modelView = translation * rotationZ * rotationY * rotationX * scale;
+
+	m_pendingDraw.model = modelView;
+}
+
+/***********************************************************
+ *  SetShaderColor()
+ *
+ *  This method is used for setting the passed in color
+ *  for the next recorded draw command
+ ***********************************************************/
+void SceneManager::SetShaderColor(
+	float redColorValue,
+	float greenColorValue,
+	float blueColorValue,
+	float alphaValue)
+{
+	// variables for this method
+	glm::vec4 currentColor;
+
+	if (IsRecordingDraws() == false)
+	{
+		return;
+	}
+
+	currentColor.r = redColorValue;
+	currentColor.g = greenColorValue;
+	currentColor.b = blueColorValue;
+	currentColor.a = alphaValue;
+
+	// a solid color replaces any previously set texture
+	m_pendingDraw.color = currentColor;
+	m_pendingDraw.texture = -1;
+	m_pendingDraw.virtualTexture = -1;
+}
+
+/***********************************************************
+ *  SetShaderTexture()
+ *
+ *  This method is used for setting the texture associated
+ *  with the passed in tag for the next recorded draw
+ *  command, looking among the virtual textures when no
+ *  regular texture has the tag.  The tag is hashed on every
+ *  call, so draws recorded every frame should pass a handle
+ *  instead.
+ ***********************************************************/
+void SceneManager::SetShaderTexture(
+	const std::string& textureTag)
+{
+	ASSET_HANDLE texture = INVALID_ASSET_HANDLE;
+
+	if (IsRecordingDraws() == false)
+	{
+		return;
+	}
+
+	texture = m_assets->Find(ASSET_TEXTURE, textureTag);
+	if (texture == INVALID_ASSET_HANDLE)
+	{
+		texture = m_assets->Find(ASSET_VIRTUAL_TEXTURE, textureTag);
+	}
+	SetShaderTexture(texture);
+}
+
+/***********************************************************
+ *  SetShaderTexture()
+ *
+ *  This method is used for setting the texture or virtual
+ *  texture the passed in handle refers to for the next
+ *  recorded draw command, or no texture when the handle is
+ *  stale.
+ ***********************************************************/
+void SceneManager::SetShaderTexture(
+	ASSET_HANDLE texture)
+{
+	int textureIndex = -1;
+	int virtualTexture = -1;
+
+	if (IsRecordingDraws() == false)
+	{
+		return;
+	}
+
+	if (m_assets->Resolve(texture, ASSET_VIRTUAL_TEXTURE, virtualTexture) == false)
+	{
+		m_assets->Resolve(texture, ASSET_TEXTURE, textureIndex);
+	}
+	m_pendingDraw.texture = textureIndex;
+	m_pendingDraw.virtualTexture = virtualTexture;
+}
+
+/***********************************************************
+ *  SetTextureUVScale()
+ *
+ *  This method is used for setting the texture UV scale
+ *  values for the next recorded draw command.
+ ***********************************************************/
+void SceneManager::SetTextureUVScale(float u, float v)
+{
+	if (IsRecordingDraws() == false)
+	{
+		return;
+	}
+	m_pendingDraw.uvScale = glm::vec2(u, v);
+}
+
+/***********************************************************
+ *  SetShaderMaterial()
+ *
+ *  This method is used for setting the material associated
+ *  with the passed in tag for the next recorded draw command.
+ ***********************************************************/
+void SceneManager::SetShaderMaterial(
+	const std::string& materialTag)
+{
+	if (IsRecordingDraws() == false)
+	{
+		return;
+	}
+	SetShaderMaterial(m_assets->Find(ASSET_MATERIAL, materialTag));
+}
+
+/***********************************************************
+ *  SetShaderMaterial()
+ *
+ *  This method is used for setting the material the passed
+ *  in handle refers to for the next recorded draw command.
+ *  A stale handle keeps the current material.
+ ***********************************************************/
+void SceneManager::SetShaderMaterial(
+	ASSET_HANDLE material)
+{
+	int materialIndex = -1;
+
+	if (IsRecordingDraws() == false)
+	{
+		return;
+	}
+
+	if (m_assets->Resolve(material, ASSET_MATERIAL, materialIndex) == true)
+	{
+		m_pendingDraw.materialIndex = materialIndex;
+	}
+}
+
+/***********************************************************
+ *  DrawMesh()
+ *
+ *  This method is used for recording a draw of the passed
+ *  in basic mesh into the render queue, or into the command
+ *  list in retained mode, using the state that was set by
+ *  the preceding Set*() calls.  The state is kept for the
+ *  following draws, the same as immediate drawing.
+ ***********************************************************/
+void SceneManager::DrawMesh(RenderQueue::MESH_TYPE mesh)
+{
+	if (IsRecordingDraws() == false)
+	{
+		return;
+	}
+
+	m_pendingDraw.mesh = mesh;
+	m_pendingDraw.program = GetSceneVariant(
+		(m_pendingDraw.texture >= 0) || (m_pendingDraw.virtualTexture >= 0),
+		m_pendingDraw.virtualTexture >= 0,
+		ShadingLod::SHADING_LOD_FULL);
+	if (m_pendingDraw.program < 0)
+	{
+		return;
+	}
+
+	if (m_bRetainedMode == true)
+	{
+		m_commandList->Record(m_pendingDraw);
+	}
+	else
+	{
+		SubmitDraw(m_pendingDraw);
+	}
+}
+
+/***********************************************************
+ *  DrawMesh()
+ *
+ *  This method is used for recording a draw of the basic
+ *  mesh the passed in handle refers to, or nothing when the
+ *  handle is stale.
+ ***********************************************************/
+void SceneManager::DrawMesh(ASSET_HANDLE mesh)
+{
+	int meshType = -1;
+
+	if (m_assets->Resolve(mesh, ASSET_MESH, meshType) == false)
+	{
+		return;
+	}
+	DrawMesh((RenderQueue::MESH_TYPE)meshType);
+}
+
+/***********************************************************
+ *  SubmitDraw()
+ *
+ *  This method is used for passing a recorded draw to the
+ *  render queue.  Draws are recorded with the full shading
+ *  variant, and one that is small on screen is switched to
+ *  the variant of its shading level here, as long as that
+ *  variant is built.  The texture array and layer are looked
+ *  up here too, since a texture moves out of the
+ *  placeholder array once its image has been uploaded, and
+ *  to another array whenever its levels are streamed in or
+ *  out.  The draw's size on screen, measured once, chooses
+ *  its shading level and the streamed levels of its
+ *  texture.  A virtual texture draw takes the virtual
+ *  texture ID as its slot, since its pages are chosen by
+ *  the feedback pass.  The draw is counted at the shading
+ *  level it is submitted with.
+ ***********************************************************/
+void SceneManager::SubmitDraw(const RenderQueue::DRAW_COMMAND& command)
+{
+	RenderQueue::DRAW_COMMAND lodCommand = command;
+	ShadingLod::SHADING_LOD lod = ShadingLod::SHADING_LOD_FULL;
+	int variant = -1;
+	float screenSize = m_shadingLod->GetDrawSize(command.model, g_MeshRadius[command.mesh], m_viewPosition);
+
+	if (command.texture >= 0)
+	{
+		m_textureStreamer->Request(command.texture, screenSize, command.uvScale);
+	}
+
+	if (command.virtualTexture >= 0)
+	{
+		lodCommand.textureSlot = command.virtualTexture;
+		lodCommand.textureLayer = 0;
+	}
+	else
+	{
+		lodCommand.textureSlot = m_textureArrays->GetArray(command.texture);
+		lodCommand.textureLayer = m_textureArrays->GetLayer(command.texture);
+	}
+
+	lod = m_shadingLod->Select(screenSize);
+	if (lod != ShadingLod::SHADING_LOD_FULL)
+	{
+		variant = GetSceneVariant((command.texture >= 0) || (command.virtualTexture >= 0),
+			command.virtualTexture >= 0, lod);
+		if ((variant >= 0) && (m_pShaderVariants->IsReady(variant) == true))
+		{
+			lodCommand.program = variant;
+		}
+		else
+		{
+			// drawn at full detail until the cheaper program links
+			lod = ShadingLod::SHADING_LOD_FULL;
+		}
+	}
+	m_shadingLod->Count(lod);
+	m_renderQueue->Submit(lodCommand);
+}
+
+/***********************************************************
+ *  ResetPendingDraw()
+ *
+ *  This method is used for setting the state used by the
+ *  next recorded draw back to its defaults.
+ ***********************************************************/
+void SceneManager::ResetPendingDraw()
+{
+	m_pendingDraw.model = glm::mat4(1.0f);
+	m_pendingDraw.color = glm::vec4(1.0f);
+	m_pendingDraw.uvScale = glm::vec2(1.0f, 1.0f);
+	m_pendingDraw.program = 0;
+	m_pendingDraw.texture = -1;
+	m_pendingDraw.virtualTexture = -1;
+	m_pendingDraw.textureSlot = -1;
+	m_pendingDraw.textureLayer = 0;
+	m_pendingDraw.materialIndex = -1;
+	m_pendingDraw.mesh = RenderQueue::MESH_BOX;
+}
+
+/***********************************************************
+ *  BeginSceneObject()
+ *
+ *  This method is used for marking the start of the draws
+ *  of a named scene object.  In retained mode the object's
+ *  draws are only recorded when it is new or invalidated,
+ *  so an object should set all of the state it draws with.
+ ***********************************************************/
+void SceneManager::BeginSceneObject(const std::string& name)
+{
+	if (m_bRetainedMode == true)
+	{
+		m_commandList->BeginObject(name, m_pendingDraw);
+	}
+}
+
+/***********************************************************
+ *  IsRecordingDraws()
+ *
+ *  This method is used for checking whether the Set*() and
+ *  DrawMesh() calls of the current scene object are being
+ *  recorded, which is always the case outside retained mode.
+ ***********************************************************/
+bool SceneManager::IsRecordingDraws() const
+{
+	return((m_bRetainedMode == false) || (m_commandList->IsRecordingObject() == true));
+}
+
+/***********************************************************
+ *  SubmitRenderQueue()
+ *
+ *  This method is used for sorting the recorded draw
+ *  commands and passing them to the shader using the
+ *  current submit mode.  Draws whose shader variant is
+ *  still compiling are left out of the frame.
+ ***********************************************************/
+void SceneManager::SubmitRenderQueue()
+{
+	if (NULL == m_pShaderVariants)
+	{
+		return;
+	}
+
+	m_renderQueue->Sort();
+
+	if (m_submitMode == SUBMIT_INDIRECT)
+	{
+		SubmitIndirect();
+	}
+	else if (m_submitMode == SUBMIT_INSTANCED)
+	{
+		SubmitInstanced();
+	}
+	else
+	{
+		SubmitImmediate();
+	}
+}
+
+/***********************************************************
+ *  ApplyTexture()
+ *
+ *  This method is used for binding the texture array of a
+ *  draw to the unit the shader samples, or the page table
+ *  of its virtual texture and the page cache, along with
+ *  the values the shader finds the pages with.  Whether a
+ *  draw is textured is compiled into its shader variant, so
+ *  untextured draws bind nothing.
+ ***********************************************************/
+void SceneManager::ApplyTexture(const RenderQueue::DRAW_COMMAND& command, bool bFeedback)
+{
+	if (command.virtualTexture >= 0)
+	{
+		m_pStateCache->SetUniform(m_uniforms.virtualPageTable, g_PageTableUnit);
+		m_pStateCache->SetUniform(m_uniforms.virtualPageCache, g_PageCacheUnit);
+		m_pStateCache->SetUniform(m_uniforms.virtualTextureInfo, m_virtualTextures->GetTextureInfo(command.virtualTexture));
+		m_pStateCache->SetUniform(m_uniforms.virtualCacheInfo, m_virtualTextures->GetCacheInfo(bFeedback));
+		m_virtualTextures->Bind(command.virtualTexture, g_PageTableUnit, g_PageCacheUnit);
+	}
+	else if (command.textureSlot >= 0)
+	{
+		m_pStateCache->SetUniform(m_uniforms.objectTexture, g_TextureUnit);
+		m_textureArrays->BindArray(command.textureSlot, g_TextureUnit);
+	}
+}
+
+/***********************************************************
+ *  ApplyProgram()
+ *
+ *  This method is used for binding the program of a shader
+ *  variant and switching to its uniform handles.  Uniforms
+ *  belong to a program, so the submit mode flags are sent
+ *  to each variant as it is bound.
+ ***********************************************************/
+void SceneManager::ApplyProgram(int variant)
+{
+	m_pStateCache->UseProgram(m_pShaderVariants->GetProgram(variant));
+	m_uniforms = m_variantUniforms[variant];
+
+	// the indirect path reads the same per-draw values as the
+	// instanced path, so the fragment shader treats them alike
+	m_pStateCache->SetUniform(m_uniforms.useInstancing, m_submitMode != SUBMIT_IMMEDIATE);
+	m_pStateCache->SetUniform(m_uniforms.useIndirect, m_submitMode == SUBMIT_INDIRECT);
+}
+
+/***********************************************************
+ *  GetSceneVariant()
+ *
+ *  This method is used for getting the shader variant that
+ *  draws with the passed in texturing and the scene's
+ *  lighting and light count.  The reduced shading level
+ *  loops over fewer lights, and the baked level is not lit
+ *  per light at all.  A virtual texture is sampled through
+ *  its page table instead of a texture array.
+ ***********************************************************/
+int SceneManager::GetSceneVariant(bool bTextured, bool bVirtual, ShadingLod::SHADING_LOD lod)
+{
+	uint32_t flags = 0;
+	int lightCount = m_lightList->GetUploadedLightCount();
+
+	if (NULL == m_pShaderVariants)
+	{
+		return(-1);
+	}
+
+	if (bTextured == true)
+	{
+		flags |= ShaderVariants::VARIANT_TEXTURED;
+	}
+	if (bVirtual == true)
+	{
+		flags |= ShaderVariants::VARIANT_VIRTUAL;
+	}
+	if ((m_bUseLighting == true) && (lod == ShadingLod::SHADING_LOD_BAKED))
+	{
+		flags |= ShaderVariants::VARIANT_BAKED;
+	}
+	else if (m_bUseLighting == true)
+	{
+		flags |= ShaderVariants::VARIANT_LIT;
+	}
+
+	// only a fixed light loop stops before the uploaded count
+	if (lod == ShadingLod::SHADING_LOD_REDUCED)
+	{
+		lightCount = std::min(lightCount,
+			std::min(m_shadingLod->GetReducedLightCount(), (int)ShaderVariants::MAX_SPECIALIZED_LIGHTS));
+	}
+
+	return(m_pShaderVariants->GetVariant(ShaderVariants::MakeKey(flags, lightCount)));
+}
+
+/***********************************************************
+ *  AttachProgram()
+ *
+ *  This method is used for connecting the light, material
+ *  and per-draw buffer blocks of a newly linked variant
+ *  program to their binding points, and resolving its
+ *  uniform handles.  A reloaded variant replaces the
+ *  handles of its previous program.  Programs built from
+ *  SPIR-V have their binding points in the modules.  The
+ *  draws are submitted again, since ones waiting for this
+ *  variant's shading level can now switch to it.
+ ***********************************************************/
+void SceneManager::AttachProgram(int variant, GLuint programID)
+{
+	if (m_pShaderVariants->UsesSpirv() == false)
+	{
+		m_lightList->AttachProgram(programID);
+		m_materialTable->AttachProgram(programID);
+		PrepareIndirectDraws(programID);
+	}
+
+	if (variant >= (int)m_variantUniforms.size())
+	{
+		m_variantUniforms.resize(variant + 1);
+	}
+	ResolveUniforms(programID, m_variantUniforms[variant]);
+	m_bReplayNeeded = true;
+}
+
+/***********************************************************
+ *  SubmitImmediate()
+ *
+ *  This method is used for passing the sorted draw commands
+ *  to the shader one draw call at a time.  Uniforms are only
+ *  sent when they differ from the values already in the
+ *  shader, and each change is counted by the queue.
+ ***********************************************************/
+void SceneManager::SubmitImmediate()
+{
+	RenderQueue::DRAW_COMMAND current;
+	bool bColorSet = false;
+	bool bUVScaleSet = false;
+
+	// no state has been sent yet for this frame
+	current.program = -1;
+	current.textureSlot = -2;
+	current.textureLayer = -1;
+	current.materialIndex = -1;
+	current.mesh = -1;
+
+	for (size_t i = 0; i < m_renderQueue->GetCommandCount(); i++)
+	{
+		const RenderQueue::DRAW_COMMAND& command = m_renderQueue->GetSortedCommand(i);
+
+		// the variant's program is still compiling
+		if (m_pShaderVariants->IsReady(command.program) == false)
+		{
+			continue;
+		}
+
+		if (command.program != current.program)
+		{
+			ApplyProgram(command.program);
+			current.program = command.program;
+			m_renderQueue->RecordStateChange(RenderQueue::STATE_PROGRAM);
+
+			// a new program has none of the values sent so far
+			current.textureSlot = -2;
+			current.textureLayer = -1;
+			current.materialIndex = -1;
+			bColorSet = false;
+			bUVScaleSet = false;
+		}
+
+		if (command.textureSlot != current.textureSlot)
+		{
+			ApplyTexture(command, false);
+			current.textureSlot = command.textureSlot;
+			m_renderQueue->RecordStateChange(RenderQueue::STATE_TEXTURE);
+		}
+
+		// the layer is only read by the shader for textured draws
+		if ((command.textureSlot >= 0) && (command.textureLayer != current.textureLayer))
+		{
+			m_pStateCache->SetUniform(m_uniforms.textureLayer, command.textureLayer);
+			current.textureLayer = command.textureLayer;
+			m_renderQueue->RecordStateChange(RenderQueue::STATE_TEXTURE);
+		}
+
+		// the color is only read by the shader for untextured draws
+		if ((command.textureSlot < 0) &&
+			((bColorSet == false) || (command.color != current.color)))
+		{
+			m_pStateCache->SetUniform(m_uniforms.objectColor, command.color);
+			current.color = command.color;
+			bColorSet = true;
+			m_renderQueue->RecordStateChange(RenderQueue::STATE_COLOR);
+		}
+
+		// the UV scale is only read by the shader for textured draws
+		if ((command.textureSlot >= 0) &&
+			((bUVScaleSet == false) || (command.uvScale != current.uvScale)))
+		{
+			m_pStateCache->SetUniform(m_uniforms.uvScale, command.uvScale);
+			current.uvScale = command.uvScale;
+			bUVScaleSet = true;
+			m_renderQueue->RecordStateChange(RenderQueue::STATE_UVSCALE);
+		}
+
+		if ((command.materialIndex >= 0) && (command.materialIndex != current.materialIndex))
+		{
+			m_pStateCache->SetUniform(m_uniforms.materialIndex, command.materialIndex);
+			current.materialIndex = command.materialIndex;
+			m_renderQueue->RecordStateChange(RenderQueue::STATE_MATERIAL);
+		}
+
+		if (command.mesh != current.mesh)
+		{
+			current.mesh = command.mesh;
+			m_renderQueue->RecordStateChange(RenderQueue::STATE_MESH);
+		}
+
+		// the model and normal matrices are unique to every draw
+		m_pStateCache->SetUniform(m_uniforms.model, command.model);
+		m_pStateCache->SetUniform(m_uniforms.normalMatrix, command.normalMatrix);
+
+		DrawBasicMesh(command.mesh);
+		m_renderQueue->RecordDrawCall();
+	}
+}
+
+/***********************************************************
+ *  DrawBasicMesh()
+ *
+ *  This method is used for issuing the draw call of the
+ *  passed in basic mesh with the state already sent.
+ ***********************************************************/
+void SceneManager::DrawBasicMesh(int mesh)
+{
+	switch (mesh)
+	{
+	case RenderQueue::MESH_BOX:
+		m_basicMeshes->DrawBoxMesh();
+		break;
+	case RenderQueue::MESH_CYLINDER:
+		m_basicMeshes->DrawCylinderMesh();
+		break;
+	case RenderQueue::MESH_TAPERED_CYLINDER:
+		m_basicMeshes->DrawTaperedCylinderMesh();
+		break;
+	case RenderQueue::MESH_PLANE:
+		m_basicMeshes->DrawPlaneMesh();
+		break;
+	}
+}
+
+/***********************************************************
+ *  FindBatchEnd()
+ *
+ *  This method is used for finding the end of the run of
+ *  sorted draw commands, starting at the passed in index,
+ *  that share the program and texture array - and the mesh
+ *  too when requested.  Texture layers and UV scales are
+ *  per-draw data, so they never split a batch.
+ ***********************************************************/
+size_t SceneManager::FindBatchEnd(size_t first, bool bSameMesh)
+{
+	const RenderQueue::DRAW_COMMAND& command = m_renderQueue->GetSortedCommand(first);
+	size_t count = m_renderQueue->GetCommandCount();
+	size_t last = first + 1;
+
+	while (last < count)
+	{
+		const RenderQueue::DRAW_COMMAND& next = m_renderQueue->GetSortedCommand(last);
+		if ((next.program != command.program) ||
+			(next.textureSlot != command.textureSlot) ||
+			((bSameMesh == true) && (next.mesh != command.mesh)))
+		{
+			break;
+		}
+		last++;
+	}
+
+	return(last);
+}
+
+/***********************************************************
+ *  ApplyBatchState()
+ *
+ *  This method is used for sending the program and texture
+ *  array of a batch to the shader, skipping any that
+ *  already match the current state.
+ ***********************************************************/
+void SceneManager::ApplyBatchState(
+	const RenderQueue::DRAW_COMMAND& command,
+	RenderQueue::DRAW_COMMAND& current)
+{
+	if (command.program != current.program)
+	{
+		ApplyProgram(command.program);
+		current.program = command.program;
+		m_renderQueue->RecordStateChange(RenderQueue::STATE_PROGRAM);
+
+		// a new program has none of the values sent so far
+		current.textureSlot = -2;
+	}
+
+	if (command.textureSlot != current.textureSlot)
+	{
+		ApplyTexture(command, false);
+		current.textureSlot = command.textureSlot;
+		m_renderQueue->RecordStateChange(RenderQueue::STATE_TEXTURE);
+	}
+}
+
+/***********************************************************
+ *  SubmitInstanced()
+ *
+ *  This method is used for passing the sorted draw commands
+ *  to the shader as instanced batches.  Neighbouring commands
+ *  that share the program, texture array and mesh are drawn
+ *  with one call, with their model matrices, colors,
+ *  materials, texture layers and UV scales read from the
+ *  instance buffer.
+ ***********************************************************/
+void SceneManager::SubmitInstanced()
+{
+	RenderQueue::DRAW_COMMAND current;
+	size_t first = 0;
+	size_t last = 0;
+	size_t count = m_renderQueue->GetCommandCount();
+
+	// no state has been sent yet for this frame
+	current.program = -1;
+	current.textureSlot = -2;
+	current.mesh = -1;
+
+	while (first < count)
+	{
+		const RenderQueue::DRAW_COMMAND& command = m_renderQueue->GetSortedCommand(first);
+
+		last = FindBatchEnd(first, true);
+		if (m_pShaderVariants->IsReady(command.program) == false)
+		{
+			first = last;
+			continue;
+		}
+		ApplyBatchState(command, current);
+
+		if (command.mesh != current.mesh)
+		{
+			current.mesh = command.mesh;
+			m_renderQueue->RecordStateChange(RenderQueue::STATE_MESH);
+		}
+
+		m_instanceData.resize(last - first);
+		for (size_t i = first; i < last; i++)
+		{
+			FillInstanceData(m_renderQueue->GetSortedCommand(i), m_instanceData[i - first]);
+		}
+
+		m_batchedMeshes->DrawMeshInstanced(
+			(RenderQueue::MESH_TYPE)command.mesh,
+			m_instanceData.data(),
+			(int)m_instanceData.size());
+		m_renderQueue->RecordDrawCall();
+
+		first = last;
+	}
+}
+
+/***********************************************************
+ *  SubmitIndirect()
+ *
+ *  This method is used for passing the sorted draw commands
+ *  to the GPU with multi-draw-indirect.  Every draw goes into
+ *  the per-draw storage buffer and the indirect command buffer
+ *  with one upload each, then one glMultiDrawElementsIndirect
+ *  call is made per run of draws sharing the texture array.
+ *  All meshes live in the same buffers, so mesh changes do
+ *  not split the runs.
+ ***********************************************************/
+void SceneManager::SubmitIndirect()
+{
+	RenderQueue::DRAW_COMMAND current;
+	BatchedMeshes::INSTANCE_DATA data;
+	size_t first = 0;
+	size_t last = 0;
+	size_t count = m_renderQueue->GetCommandCount();
+
+	// a replayed frame draws the same commands as the frame
+	// before, so the draws uploaded then are used again
+	if ((m_bRetainedMode == true) && (m_renderQueue->GetGeneration() == m_uploadedGeneration))
+	{
+		m_batchedMeshes->BindIndirectDraws(g_DrawDataBinding);
+	}
+	else
+	{
+		// collect every draw in sorted order
+		m_batchedMeshes->BeginIndirectDraws();
+		for (size_t i = 0; i < count; i++)
+		{
+			const RenderQueue::DRAW_COMMAND& command = m_renderQueue->GetSortedCommand(i);
+			FillInstanceData(command, data);
+			m_batchedMeshes->AddIndirectDraw((RenderQueue::MESH_TYPE)command.mesh, data);
+		}
+		m_batchedMeshes->UploadIndirectDraws(g_DrawDataBinding, m_bRetainedMode);
+		m_uploadedGeneration = m_bRetainedMode ? m_renderQueue->GetGeneration() : 0;
+	}
+
+	// no state has been sent yet for this frame
+	current.program = -1;
+	current.textureSlot = -2;
+
+	while (first < count)
+	{
+		const RenderQueue::DRAW_COMMAND& command = m_renderQueue->GetSortedCommand(first);
+
+		last = FindBatchEnd(first, false);
+		if (m_pShaderVariants->IsReady(command.program) == false)
+		{
+			first = last;
+			continue;
+		}
+		ApplyBatchState(command, current);
+
+		// gl_DrawID restarts at zero for every multi-draw call
+		m_pStateCache->SetUniform(m_uniforms.drawIndexBase, (int)first);
+		m_batchedMeshes->DrawIndirect((int)first, (int)(last - first));
+		m_renderQueue->RecordDrawCall();
+
+		first = last;
+	}
+}
+
+/***********************************************************
+ *  SubmitFeedback()
+ *
+ *  This method is used for drawing the sorted draws that
+ *  sample a virtual texture again into the feedback target,
+ *  with the variant that writes the page each pixel needs.
+ *  The draws are sent one at a time whatever the submit
+ *  mode, since there are few of them and the target is
+ *  small.  Other draws are left out, so a page hidden behind
+ *  them is still asked for, which only loads more than
+ *  needed.
+ ***********************************************************/
+void SceneManager::SubmitFeedback()
+{
+	RenderQueue::DRAW_COMMAND current;
+	int variant = -1;
+	bool bStarted = false;
+
+	if ((NULL == m_pShaderVariants) || (m_virtualTextures->GetTextureCount() == 0))
+	{
+		return;
+	}
+
+	variant = m_pShaderVariants->GetVariant(ShaderVariants::MakeKey(
+		ShaderVariants::VARIANT_VIRTUAL | ShaderVariants::VARIANT_FEEDBACK, 0));
+	if ((variant < 0) || (m_pShaderVariants->IsReady(variant) == false))
+	{
+		return;
+	}
+
+	current.textureSlot = -1;
+	for (size_t i = 0; i < m_renderQueue->GetCommandCount(); i++)
+	{
+		const RenderQueue::DRAW_COMMAND& command = m_renderQueue->GetSortedCommand(i);
+
+		if (command.virtualTexture < 0)
+		{
+			continue;
+		}
+
+		if (bStarted == false)
+		{
+			if (m_virtualTextures->BeginFeedback() == false)
+			{
+				return;
+			}
+			ApplyProgram(variant);
+			m_pStateCache->SetUniform(m_uniforms.useInstancing, false);
+			m_pStateCache->SetUniform(m_uniforms.useIndirect, false);
+			bStarted = true;
+		}
+
+		if (command.virtualTexture != current.textureSlot)
+		{
+			ApplyTexture(command, true);
+			current.textureSlot = command.virtualTexture;
+		}
+		m_pStateCache->SetUniform(m_uniforms.uvScale, command.uvScale);
+		m_pStateCache->SetUniform(m_uniforms.model, command.model);
+		m_pStateCache->SetUniform(m_uniforms.normalMatrix, command.normalMatrix);
+		DrawBasicMesh(command.mesh);
+	}
+
+	if (bStarted == true)
+	{
+		m_virtualTextures->EndFeedback();
+	}
+}
+
+/***********************************************************
+ *  PrepareIndirectDraws()
+ *
+ *  This method is used for connecting the per-draw storage
+ *  buffer block in the passed in program's vertex shader to
+ *  its binding point.
+ *  The block is compiled out when the driver is missing the
+ *  required extensions, in which case false is returned.
+ ***********************************************************/
+bool SceneManager::PrepareIndirectDraws(GLuint programID)
+{
+	GLuint blockIndex = GL_INVALID_INDEX;
+
+	if (BatchedMeshes::IsIndirectSupported() == false)
+	{
+		return(false);
+	}
+
+	blockIndex = glGetProgramResourceIndex(programID, GL_SHADER_STORAGE_BLOCK, g_DrawDataBlockName);
+	if (GL_INVALID_INDEX == blockIndex)
+	{
+		return(false);
+	}
+	glShaderStorageBlockBinding(programID, blockIndex, g_DrawDataBinding);
+
+	return(true);
+}
+
+/***********************************************************
+ *  ResolveUniforms()
+ *
+ *  This method is used for looking up the handles of the
+ *  uniforms that are set for every draw, so that the render
+ *  loop never passes a uniform name to the driver.  Handles
+ *  of uniforms the program does not use stay invalid and are
+ *  ignored when set.
+ ***********************************************************/
+void SceneManager::ResolveUniforms(GLuint programID, SCENE_UNIFORMS& uniforms)
+{
+	const UniformTable* pTable = m_pStateCache->GetUniformTable(programID);
+
+	uniforms.model = pTable->Get<glm::mat4>(g_ModelName);
+	uniforms.normalMatrix = pTable->Get<glm::mat3>(g_NormalMatrixName);
+	uniforms.objectColor = pTable->Get<glm::vec4>(g_ColorValueName);
+	uniforms.objectTexture = pTable->Get<int>(g_TextureValueName);
+	uniforms.uvScale = pTable->Get<glm::vec2>(g_UVScaleName);
+	uniforms.textureLayer = pTable->Get<int>(g_TextureLayerName);
+	uniforms.materialIndex = pTable->Get<int>(g_MaterialIndexName);
+	uniforms.useInstancing = pTable->Get<bool>(g_UseInstancingName);
+	uniforms.useIndirect = pTable->Get<bool>(g_UseIndirectName);
+	uniforms.drawIndexBase = pTable->Get<int>(g_DrawIndexBaseName);
+	uniforms.virtualPageTable = pTable->Get<int>(g_VirtualPageTableName);
+	uniforms.virtualPageCache = pTable->Get<int>(g_VirtualPageCacheName);
+	uniforms.virtualTextureInfo = pTable->Get<glm::vec3>(g_VirtualTextureInfoName);
+	uniforms.virtualCacheInfo = pTable->Get<glm::vec4>(g_VirtualCacheInfoName);
+}
+
+/***********************************************************
+ *  CompileMaterialTable()
+ *
+ *  This method is used for packing all of the defined
+ *  materials into the material table and sending it to the
+ *  shaders once.  Draws then only carry the material ID,
+ *  which is the material's position in the defined list,
+ *  and the ID is registered as the asset of its tag.
+ ***********************************************************/
+void SceneManager::CompileMaterialTable()
+{
+	int materialID = -1;
+
+	m_materialTable->Clear();
+	m_assets->Clear(ASSET_MATERIAL);
+	for (size_t i = 0; i < m_objectMaterials.size(); i++)
+	{
+		materialID = m_materialTable->AddMaterial(
+			m_objectMaterials[i].tag,
+			m_objectMaterials[i].diffuseColor,
+			m_objectMaterials[i].specularColor,
+			m_objectMaterials[i].shininess);
+		m_assets->Register(ASSET_MATERIAL, m_objectMaterials[i].tag, materialID);
+	}
+
+	m_materialTable->Upload();
+}
+
+/***********************************************************
+ *  SetSubmitMode()
+ *
+ *  This method is used for choosing how the recorded draws
+ *  are sent to the GPU.
+ ***********************************************************/
+void SceneManager::SetSubmitMode(SUBMIT_MODE mode)
+{
+	m_submitMode = mode;
+	m_renderQueue->SetPerInstanceState(mode != SUBMIT_IMMEDIATE);
+
+	// the sort keys depend on the submit mode
+	m_bReplayNeeded = true;
+}
+
+/***********************************************************
+ *  SetRetainedMode()
+ *
+ *  This method is used for choosing whether the scene is
+ *  recorded every frame, or recorded once into the command
+ *  list and replayed.  In retained mode only the objects
+ *  passed to InvalidateSceneObject() are recorded again.
+ ***********************************************************/
+void SceneManager::SetRetainedMode(bool bRetained)
+{
+	m_bRetainedMode = bRetained;
+	m_commandList->Clear();
+	m_bReplayNeeded = true;
+}
+
+/***********************************************************
+ *  InvalidateSceneObject()
+ *
+ *  This method is used for marking a scene object whose
+ *  draws have changed, so that only its draws are recorded
+ *  again on the next frame.
+ ***********************************************************/
+void SceneManager::InvalidateSceneObject(const std::string& name)
+{
+	m_commandList->Invalidate(name);
+}
+
+/***********************************************************
+ *  SetViewPosition()
+ *
+ *  This method is used for setting the camera position that
+ *  the recorded draws are depth sorted from.
+ ***********************************************************/
+void SceneManager::SetViewPosition(glm::vec3 viewPosition)
+{
+	m_viewPosition = viewPosition;
+}
+
+/***********************************************************
+ *  SetProjection()
+ *
+ *  This method is used for setting the projection that the
+ *  size of each draw on screen is measured with, which
+ *  chooses its shading level.
+ ***********************************************************/
+void SceneManager::SetProjection(const glm::mat4& projection)
+{
+	if (projection != m_shadingLod->GetProjection())
+	{
+		m_shadingLod->SetProjection(projection);
+		m_bReplayNeeded = true;
+	}
+}
+
+/***********************************************************
+ *  SetShadingLod()
+ *
+ *  This method is used for setting the fractions of the
+ *  viewport height below which draws are lit by only the
+ *  first reducedLightCount lights, and below which they
+ *  are shaded with the baked light.  Zero thresholds draw
+ *  everything at full detail.
+ ***********************************************************/
+void SceneManager::SetShadingLod(float reducedThreshold, float bakedThreshold, int reducedLightCount)
+{
+	m_shadingLod->SetThresholds(reducedThreshold, bakedThreshold);
+	m_shadingLod->SetReducedLightCount(reducedLightCount);
+	m_bReplayNeeded = true;
+}
+
+/***********************************************************
+ *  SetTextureBudget()
+ *
+ *  This method is used for setting the most bytes of
+ *  texture levels kept on the GPU, and the most bytes of
+ *  them uploaded in one frame.  Textures keep their
+ *  smallest levels whatever the budget.
+ ***********************************************************/
+void SceneManager::SetTextureBudget(size_t budgetBytes, size_t uploadBytesPerFrame)
+{
+	m_textureStreamer->SetBudget(budgetBytes, uploadBytesPerFrame);
+}
+
+/***********************************************************
+ * DefineObjectMaterials()
+ *
+ * This method is used for configuring the various material
+ * settings for all of the objects within the 3D scene.
+ ***********************************************************/
+void SceneManager::DefineObjectMaterials()
+{
+	/*** STUDENTS - add the code BELOW for defining object materials. ***/
+	/*** There is no limit to the number of object materials that can ***/
+	/*** be defined. Refer to the code in the OpenGL Sample for help ***/
+	OBJECT_MATERIAL plasticMaterial;
+	plasticMaterial.diffuseColor = glm::vec3(0.5f, 0.5f, 0.5f);
+	plasticMaterial.specularColor = glm::vec3(0.7f, 0.7f, 0.7f);
+	plasticMaterial.shininess = 5.0;
+	plasticMaterial.tag = "plastic";
+	m_objectMaterials.push_back(plasticMaterial);
+
+	OBJECT_MATERIAL woodMaterial;
+	woodMaterial.diffuseColor = glm::vec3(0.6f, 0.5f, 0.2f);
+	woodMaterial.specularColor = glm::vec3(0.5f, 0.2f, 0.5f);
+	woodMaterial.shininess = 1.0;
+	woodMaterial.tag = "wood";
+	m_objectMaterials.push_back(woodMaterial);
+
+	OBJECT_MATERIAL stoneMaterial;
+	stoneMaterial.diffuseColor = glm::vec3(0.5f, 0.5f, 0.5f);
+	stoneMaterial.specularColor = glm::vec3(0.73f, 0.3f, 0.3f);
+	stoneMaterial.shininess = 6.0;
+	stoneMaterial.tag = "stone";
+	m_objectMaterials.push_back(stoneMaterial);
+
+}
+
+void SceneManager::SetupSceneLights()
+{
+	// this line of code is NEEDED for telling the shaders to render 
+	// the 3D scene with custom lighting, if no light sources have
+	// been added then the display window will be black - to use the 
+	// default OpenGL lighting then comment out the following line
+	m_bUseLighting = true;
+
+	/*** STUDENTS - add the code BELOW for setting up light sources ***/
+	/*** Any number of light sources can be added to the light list ***/
+	/*** Refer to the code in the OpenGL Sample for help            ***/
+	int flashlight = -1;
+
+	m_lightList->Clear();
+
+	// point light 1
+	m_lightList->AddPointLight(
+		glm::vec3(4.0f, 6.0f, 2.0f),
+		glm::vec3(0.05f, 0.05f, 0.05f),
+		glm::vec3(1.0f, 1.0f, 1.0f),
+		glm::vec3(0.2f, 0.2f, 0.2f));
+
+	// point light 2
+	m_lightList->AddPointLight(
+		glm::vec3(-4.0f, -4.0f, -4.0f),
+		glm::vec3(0.05f, 0.05f, 0.05f),
+		glm::vec3(0.8f, 0.8f, 0.8f),
+		glm::vec3(0.2f, 0.2f, 0.2f));
+
+	// directional light 3
+	m_lightList->AddDirectionalLight(
+		glm::vec3(7.2f, 7.2f, 1.5f),
+		glm::vec3(0.05f, 0.05f, 0.01f),
+		glm::vec3(0.8f, 0.8f, 0.8f),
+		glm::vec3(0.2f, 0.2f, 0.2f));
+
+	// spotlight 4, a flashlight held by the camera
+	flashlight = m_lightList->AddSpotLight(
+		glm::vec3(0.0f, 0.0f, 0.0f),
+		glm::vec3(0.0f, 0.0f, -1.0f),
+		glm::vec3(0.0f, 0.0f, 0.0f),
+		glm::vec3(1.0f, 1.0f, 1.0f),
+		glm::vec3(1.0f, 1.0f, 1.0f),
+		1.0f, 0.014f, 0.0007f,
+		22.5f, 28.0f);
+	m_lightList->SetFollowCamera(flashlight, true);
+
+	// all of the lights are sent to the shaders at once
+	m_lightList->Upload();
+
+	// the light count is compiled into the shader variants, so
+	// draws recorded with another count are recorded again
+	m_commandList->InvalidateAll();
+}
+
+void SceneManager::LoadSceneTextures()
+{
+	/*** STUDENTS - add the code BELOW for loading the textures that ***/
+	/*** will be used for mapping to objects in the 3D scene. There  ***/
+	/*** is no limit to the number of textures. Refer to the code in ***/
+	/*** the OpenGL Sample for help.                                 ***/
+	CreateGLTexture("textures/marbletexture.jpg", "marble");
+	CreateGLTexture("textures/woodtexture.jpg", "wood");
+	// the table top is drawn large enough to page in the
+	// marble image at full detail, once it has been baked
+	// with BakeTextures --virtual
+	CreateGLVirtualTexture("textures/marbletexture.jpg", "tabletop");
+
+	// textures of the same size share a texture array, which
+	// is bound for each batch of draws, so nothing is bound here
+}
+
+
+/**************************************************************/
+/*** STUDENTS CAN MODIFY the code in the methods BELOW for  ***/
+/*** preparing and rendering their own 3D replicated scenes.***/
+/*** Please refer to the code in the OpenGL sample project  ***/
+/*** for assistance.                                        ***/
+/**************************************************************/
+
+
+/***********************************************************
+ *  PrepareScene()
+ *
+ *  This method is used for preparing the 3D scene by loading
+ *  the shapes, textures in memory to support the 3D scene 
+ *  rendering
+ ***********************************************************/
+void SceneManager::PrepareScene()
+{
+	// only one instance of a particular mesh needs to be
+	// loaded in memory no matter how many times it is drawn
+	// in the rendered 3D scene
+	SetTextureBudget(g_TextureBudgetBytes, g_TextureUploadBytesPerFrame);
+	LoadSceneTextures();
+	DefineObjectMaterials();
+	CompileMaterialTable();
+	SetupSceneLights();
+	m_basicMeshes->LoadPlaneMesh();
+	m_basicMeshes->LoadCylinderMesh();
+	m_basicMeshes->LoadTaperedCylinderMesh();
+	m_basicMeshes->LoadBoxMesh();
+
+	// the same shapes packed into shared buffers for instancing
+	m_batchedMeshes->LoadPlaneMesh();
+	m_batchedMeshes->LoadCylinderMesh();
+	m_batchedMeshes->LoadTaperedCylinderMesh();
+	m_batchedMeshes->LoadBoxMesh();
+	RegisterMeshes();
+
+	// tags are looked up once here, and every draw after
+	// resolves its handles without hashing a string
+	ResolveSceneAssets();
+
+	// the scene is static, so it is recorded once and replayed
+	SetRetainedMode(true);
+
+	// submit the whole scene with multi-draw-indirect when
+	// the driver supports it, each variant's per-draw block
+	// is connected as the variant links
+	if (BatchedMeshes::IsIndirectSupported() == true)
+	{
+		SetSubmitMode(SUBMIT_INDIRECT);
+		std::cout << "INFO: Scene draws submitted with multi-draw-indirect" << std::endl;
+	}
+	else
+	{
+		std::cout << "INFO: Scene draws submitted with instancing" << std::endl;
+	}
+}
+
+/***********************************************************
+ *  RenderScene()
+ *
+ *  This method is used for rendering the 3D scene.  In
+ *  retained mode the recorded draws are replayed, and only
+ *  invalidated objects are recorded again.  The queue keeps
+ *  its sorted order until the draws or the camera change.
+ ***********************************************************/
+void SceneManager::RenderScene()
+{
+	// textures decoded since the last frame replace their
+	// placeholders, and textures whose levels are streamed in
+	// or out move, which moves their draws to another array
+	if (m_textureLoader->Update() > 0)
+	{
+		m_bReplayNeeded = true;
+	}
+	if (m_textureStreamer->Update() > 0)
+	{
+		m_bReplayNeeded = true;
+	}
+	// virtual texture pages asked for by earlier frames enter
+	// the page cache, which the draws find through their page
+	// tables, so nothing is submitted again
+	m_virtualTextures->Update();
+
+	// an unlit scene has no cheaper shading to switch to
+	m_shadingLod->SetEnabled(m_bUseLighting);
+
+	if (m_bRetainedMode == true)
+	{
+		if (m_commandList->NeedsRecording() == true)
+		{
+			ResetPendingDraw();
+			m_commandList->BeginRecording(m_pendingDraw);
+			RecordScene();
+			m_commandList->EndRecording();
+		}
+
+		if ((m_commandList->HasChanged() == true) ||
+			(m_bReplayNeeded == true) ||
+			(m_viewPosition != m_replayViewPosition))
+		{
+			m_renderQueue->BeginFrame(m_viewPosition);
+			m_shadingLod->BeginFrame();
+			m_textureStreamer->BeginRequests();
+			m_commandList->Replay([this](const RenderQueue::DRAW_COMMAND& command) { SubmitDraw(command); });
+			m_replayViewPosition = m_viewPosition;
+			m_bReplayNeeded = false;
+		}
+		else
+		{
+			m_renderQueue->BeginReplay();
+		}
+	}
+	else
+	{
+		// start recording the draws for this frame with default state
+		m_renderQueue->BeginFrame(m_viewPosition);
+		m_shadingLod->BeginFrame();
+		m_textureStreamer->BeginRequests();
+		ResetPendingDraw();
+		RecordScene();
+	}
+
+	// sort and send the recorded draws to the shader, writing
+	// the per-draw data into this frame's ring buffer region
+	m_batchedMeshes->BeginFrame();
+	SubmitRenderQueue();
+	m_batchedMeshes->EndFrame();
+	// then record the virtual texture pages the frame sampled
+	SubmitFeedback();
+	m_renderQueue->EndFrame();
+	m_shadingLod->EndFrame();
+}
+
+/***********************************************************
+ *  RecordScene()
+ *
+ *  This method is used for recording the 3D scene by 
+ *  transforming and drawing the basic 3D shapes.  Each
+ *  object starts with BeginSceneObject() so that it can be
+ *  recorded again on its own in retained mode.
+ ***********************************************************/
+void SceneManager::RecordScene()
+{
+	// declare the variables for the transformations
+	glm::vec3 scaleXYZ;
+	float XrotationDegrees = 0.0f;
+	float YrotationDegrees = 0.0f;
+	float ZrotationDegrees = 0.0f;
+	glm::vec3 positionXYZ;
+
+	glm::vec3 scaleCylinderBody;
+	glm::vec3 scaleTaperedCylinder;
+	glm::vec3 positionCylinderBody;
+	glm::vec3 positionTaperedCylinder;
+
+	/*** Set needed transformations before drawing the basic mesh.  ***/
+	/*** This same ordering of code should be used for transforming ***/
+	/*** and drawing all the basic 3D shapes.						***/
+	/******************************************************************/
+	BeginSceneObject("table");
+
+	// set the XYZ scale for the mesh
+	scaleXYZ = glm::vec3(40.0f, 0.5f, 20.0f);
+
+	// set the XYZ rotation for the mesh
+	XrotationDegrees = 0.0f;
+	YrotationDegrees = 0.0f;
+	ZrotationDegrees = 0.0f;
+
+	// set the XYZ position for the mesh
+	positionXYZ = glm::vec3(0.0f, 0.0f, 0.0f);
+
+	// set the transformations into memory to be used on the drawn meshes
+	SetTransformations(
+		scaleXYZ,
+		XrotationDegrees,
+		YrotationDegrees,
+		ZrotationDegrees,
+		positionXYZ);
+
+	//SetShaderColor(0.8f, 0.6f, 0.4f, 1.0f);
+	SetShaderMaterial(m_sceneAssets.woodMaterial);
+	SetShaderTexture(m_sceneAssets.tabletopTexture);
+	// draw the mesh with transformation values
+	DrawMesh(m_sceneAssets.boxMesh);
+	// Table Legs 
+	float tableHeight = 3.0f; 
+	glm::vec3 scaleLeg = glm::vec3(0.3f, tableHeight, 0.3f);  
+
+	// Tabletop dimensions
+	float tableWidth = 40.0f;   
+	float tableDepth = 20.0f;   
+	float legOffsetX = scaleLeg.x * 2.0f; 
+	float legOffsetZ = scaleLeg.z * 1.5f; 
+
+	// Table leg positions
+	glm::vec3 legPositions[4] = {
+		glm::vec3(-tableWidth / 2.0f + legOffsetX, -tableHeight / 1.0f, -tableDepth / 2.0f + legOffsetZ), // Rear-left corner
+		glm::vec3(tableWidth / 2.0f - legOffsetX, -tableHeight / 1.0f, -tableDepth / 2.0f + legOffsetZ),  // Rear-right corner
+		glm::vec3(-tableWidth / 2.0f + legOffsetX, -tableHeight / 1.0f, tableDepth / 2.0f - legOffsetZ),  // Front-left corner
+		glm::vec3(tableWidth / 2.0f - legOffsetX, -tableHeight / 1.0f, tableDepth / 2.0f - legOffsetZ)    // Front-right corner
+	};
+	
+	// Render the four legs
+	for (int i = 0; i < 4; i++) {
+		SetTransformations(scaleLeg, 0.0f, 0.0f, 0.0f, legPositions[i]);
+		//SetShaderColor(0.5f, 0.5f, 0.5f, 1.0f);
+		SetShaderTexture(m_sceneAssets.woodTexture);
+		DrawMesh(m_sceneAssets.cylinderMesh);
+	}
+
+
+	/****************************************************************/
+	BeginSceneObject("bowl");
+
+	//Main Cylinder (body of the bowl)
+	scaleCylinderBody = glm::vec3(1.5f, 0.9f, 1.5f); 
+	positionCylinderBody = glm::vec3(0.0f, 0.0f, 0.0f);  
+
+	SetTransformations(scaleCylinderBody, 0.0f, 0.0f, 0.0f, positionCylinderBody);
+	SetShaderColor(1,1,1,1); 
+	SetShaderMaterial(m_sceneAssets.plasticMaterial);
+	//SetShaderTexture(m_sceneAssets.marbleTexture);
+	DrawMesh(m_sceneAssets.cylinderMesh);
+
+	//Tapered Cylinder (upper slope of the bowl)
+	scaleTaperedCylinder = glm::vec3(2.0f, 0.3f, 2.0f);  
+	positionTaperedCylinder = glm::vec3(0.0f, 1.0f, 0.0f);
+	float rotationDegrees = 180.0f;
+
+	SetTransformations(scaleTaperedCylinder, rotationDegrees, 0.0f, 0.0f, positionTaperedCylinder);
+	//SetShaderColor(1,1,1,1);  
+	SetShaderMaterial(m_sceneAssets.stoneMaterial);
+	SetShaderTexture(m_sceneAssets.marbleTexture);
+	DrawMesh(m_sceneAssets.taperedCylinderMesh);
+
+	//Microwave
+	BeginSceneObject("microwave");
+
+	// Set transformations for microwave body 
+	glm::vec3 scaleMicrowaveBody = glm::vec3(9.5f, 5.2f, 5.5f); 
+	glm::vec3 positionMicrowaveBody = glm::vec3(10.0f, 3.0f, 0.0f);
+
+	SetTransformations(scaleMicrowaveBody, 0.0f, 0.0f, 0.0f, positionMicrowaveBody);
+	SetShaderMaterial(m_sceneAssets.plasticMaterial);
+	SetShaderColor(0.5f, 0.5f, 0.5f, 1.0f);
+	DrawMesh(m_sceneAssets.boxMesh);
+
+	// Microwave front panel
+	glm::vec3 scaleMicrowaveFront = glm::vec3(9.5f, 5.2f, 0.1f); 
+	glm::vec3 positionMicrowaveFront = glm::vec3(10.0f, 3.0f, 2.8f); 
+
+	SetTransformations(scaleMicrowaveFront, 0.0f, 0.0f, 0.0f, positionMicrowaveFront);
+	SetShaderMaterial(m_sceneAssets.plasticMaterial);
+	SetShaderTexture(m_sceneAssets.marbleTexture); 
+	DrawMesh(m_sceneAssets.boxMesh);
+
+	// Microwave control panel 
+	glm::vec3 scaleMicrowavePanel = glm::vec3(0.3f, 0.7f, 1.5f); 
+	glm::vec3 positionMicrowavePanel = glm::vec3(13.2f, 1.3f, 2.85f); 
+
+	SetTransformations(scaleMicrowavePanel, 0.0f, 90.0f, 0.0f, positionMicrowavePanel);
+	SetShaderMaterial(m_sceneAssets.plasticMaterial);
+	SetShaderTexture(m_sceneAssets.woodTexture); 
+	DrawMesh(m_sceneAssets.boxMesh); 
+
+	// Ice maker 
+	BeginSceneObject("ice maker");
+
+	glm::vec3 scaleIceMakerBody = glm::vec3(4.5f, 5.0f, 4.2f); 
+	glm::vec3 positionIceMakerBody = glm::vec3(-5.0f, 2.7f, 0.0f); 
+
+	SetTransformations(scaleIceMakerBody, 0.0f, 0.0f, 0.0f, positionIceMakerBody);
+	SetShaderMaterial(m_sceneAssets.plasticMaterial);
+	SetShaderColor(0.8f, 0.1f, 0.1f, 1.0f); 
+	DrawMesh(m_sceneAssets.boxMesh);
+
+	// Ice maker front 
+	glm::vec3 scaleIceMakerFrontCylinder = glm::vec3(2.27f, 5.0f, 1.8f); 
+	glm::vec3 positionIceMakerFrontCylinder = glm::vec3(-5.0f, 0.2f, 1.96f);
+
+	SetTransformations(scaleIceMakerFrontCylinder, 0.0f, 0.0f, 0.0f, positionIceMakerFrontCylinder); 
+	SetShaderMaterial(m_sceneAssets.plasticMaterial);
+	SetShaderColor(0.8f, 0.1f, 0.1f, 1.0f); 
+	DrawMesh(m_sceneAssets.cylinderMesh); 
+
+	// Pitcher
+	BeginSceneObject("pitcher");
+
+	// Main body of the pitcher 
+	glm::vec3 scalePitcherBody = glm::vec3(1.0f, 2.5f, 1.0f); 
+	glm::vec3 positionPitcherBody = glm::vec3(1.5f, 0.0f, -4.0f);
+
+	SetTransformations(scalePitcherBody, 0.0f, 0.0f, 0.0f, positionPitcherBody);
+	SetShaderMaterial(m_sceneAssets.plasticMaterial); 
+	SetShaderColor(0.4f, 0.9f, 0.9f, 4.0f); 
+	DrawMesh(m_sceneAssets.cylinderMesh); 
+
+	// Pitcher spout 
+	glm::vec3 scalePitcherSpout = glm::vec3(0.2f, 0.3f, 0.3f); 
+	glm::vec3 positionPitcherSpout = glm::vec3(1.5f, 1.9f, -3.2f); 
+
+	SetTransformations(scalePitcherSpout, 45.0f, 0.0f, 0.0f, positionPitcherSpout); 
+	SetShaderMaterial(m_sceneAssets.plasticMaterial);
+	SetShaderColor(0.4f, 0.9f, 0.9f, 4.0f);
+	DrawMesh(m_sceneAssets.cylinderMesh);
+}
@@ -1,110 +1,270 @@
-///////////////////////////////////////////////////////////////////////////////
-// scenemanager.h
-// ============
-// manage the preparing and rendering of 3D scenes - textures, materials, lighting
-//
-//  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
-//	Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
-///////////////////////////////////////////////////////////////////////////////
-
-#pragma once
-
-#include "ShaderManager.h"
-#include "ShapeMeshes.h"
-
-#include <string>
-#include <vector>
-
-/***********************************************************
- *  SceneManager
- *
- *  This class contains the code for preparing and rendering
- *  3D scenes, including the shader settings.
- ***********************************************************/
-class SceneManager
-{
-public:
-	// constructor
-	SceneManager(ShaderManager *pShaderManager);
-	// destructor
-	~SceneManager();
-
-	struct TEXTURE_INFO
-	{
-		std::string tag;
-		uint32_t ID;
-	};
-
-	struct OBJECT_MATERIAL
-	{
-		glm::vec3 diffuseColor;
-		glm::vec3 specularColor;
-		float shininess;
-		std::string tag;
-	};
-
-private:
-	// pointer to shader manager object
-	ShaderManager* m_pShaderManager;
-	// pointer to basic shapes object
-	ShapeMeshes* m_basicMeshes;
-	// total number of loaded textures
-	int m_loadedTextures;
-	// loaded textures info
-	TEXTURE_INFO m_textureIDs[16];
-	// defined object materials
-	std::vector<OBJECT_MATERIAL> m_objectMaterials;
-
-	// load texture images and convert to OpenGL texture data
-	bool CreateGLTexture(const char* filename, std::string tag);
-	// bind loaded OpenGL textures to slots in memory
-	void BindGLTextures();
-	// free the loaded OpenGL textures
-	void DestroyGLTextures();
-	// find a loaded texture by tag
-	int FindTextureID(std::string tag);
-	int FindTextureSlot(std::string tag);
-	// find a defined material by tag
-	bool FindMaterial(std::string tag, OBJECT_MATERIAL& material);
-
-	// set the transformation values 
-	// into the transform buffer
-	void SetTransformations(
-		glm::vec3 scaleXYZ,
-		float XrotationDegrees,
-		float YrotationDegrees,
-		float ZrotationDegrees,
-		glm::vec3 positionXYZ);
-
-	// set the color values into the shader
-	void SetShaderColor(
-		float redColorValue,
-		float greenColorValue,
-		float blueColorValue,
-		float alphaValue);
-
-	// set the texture data into the shader
-	void SetShaderTexture(
-		std::string textureTag);
-
-	// set the UV scale for the texture mapping
-	void SetTextureUVScale(
-		float u, float v);
-
-	// set the object material into the shader
-	void SetShaderMaterial(
-		std::string materialTag);
-
-public:
-
-	// The following methods are for the students to 
-	// customize for their own 3D scene
-	void PrepareScene();
-	void RenderScene();
-	// loads textures from image files
-	void LoadSceneTextures();
-	// pre-set light sources for 3D scene
-	void SetupSceneLights();
-	// pre-define the object materials for lighting
-	void DefineObjectMaterials();
+///////////////////////////////////////////////////////////////////////////////
+// scenemanager.h
+// ============
+// manage the preparing and rendering of 3D scenes - textures, materials, lighting
+//
+//  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
+//	Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "AssetRegistry.h"
+#include "ShapeMeshes.h"
+#include "RenderQueue.h"
+#include "BatchedMeshes.h"
+#include "GLStateCache.h"
+#include "LightList.h"
+#include "MaterialTable.h"
+#include "CommandList.h"
+#include "ShaderVariants.h"
+#include "ShadingLod.h"
+#include "TextureArrays.h"
+#include "TextureLoader.h"
+#include "TextureStreamer.h"
+#include "VirtualTextures.h"
+
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  SceneManager
+ *
+ *  This class contains the code for preparing and rendering
+ *  3D scenes, including the shader settings.
+ ***********************************************************/
+class SceneManager
+{
+public:
+	// constructor
+	SceneManager(GLStateCache* pStateCache, ShaderVariants* pShaderVariants);
+	// destructor
+	~SceneManager();
+
+	struct OBJECT_MATERIAL
+	{
+		glm::vec3 diffuseColor;
+		glm::vec3 specularColor;
+		float shininess;
+		std::string tag;
+	};
+
+	// uniforms set for every draw, resolved once from each program
+	struct SCENE_UNIFORMS
+	{
+		UniformHandle<glm::mat4> model;
+		UniformHandle<glm::mat3> normalMatrix;
+		UniformHandle<glm::vec4> objectColor;
+		UniformHandle<int> objectTexture;
+		UniformHandle<glm::vec2> uvScale;
+		UniformHandle<int> textureLayer;
+		UniformHandle<int> materialIndex;
+		UniformHandle<bool> useInstancing;
+		UniformHandle<bool> useIndirect;
+		UniformHandle<int> drawIndexBase;
+		UniformHandle<int> virtualPageTable;
+		UniformHandle<int> virtualPageCache;
+		UniformHandle<glm::vec3> virtualTextureInfo;
+		UniformHandle<glm::vec4> virtualCacheInfo;
+	};
+
+	// handles of the assets the scene draws with, looked up by
+	// tag once the scene is loaded so draws never hash a tag
+	struct SCENE_ASSETS
+	{
+		ASSET_HANDLE marbleTexture;
+		ASSET_HANDLE woodTexture;
+		// the virtual texture of the table top, or the marble
+		// texture when it has not been baked
+		ASSET_HANDLE tabletopTexture;
+		ASSET_HANDLE plasticMaterial;
+		ASSET_HANDLE woodMaterial;
+		ASSET_HANDLE stoneMaterial;
+		ASSET_HANDLE boxMesh;
+		ASSET_HANDLE cylinderMesh;
+		ASSET_HANDLE taperedCylinderMesh;
+		ASSET_HANDLE planeMesh;
+	};
+
+	// ways the recorded draws can be sent to the GPU
+	enum SUBMIT_MODE
+	{
+		SUBMIT_IMMEDIATE = 0,
+		SUBMIT_INSTANCED,
+		SUBMIT_INDIRECT
+	};
+
+private:
+	// pointer to the cache that drops redundant state changes
+	GLStateCache* m_pStateCache;
+	// pointer to the programs built for each feature combination
+	ShaderVariants* m_pShaderVariants;
+	// pointer to basic shapes object
+	ShapeMeshes* m_basicMeshes;
+	// pointer to basic shapes packed for instanced drawing
+	BatchedMeshes* m_batchedMeshes;
+	// how the recorded draws are sent to the GPU
+	SUBMIT_MODE m_submitMode;
+	// instance data of the batch being submitted
+	std::vector<BatchedMeshes::INSTANCE_DATA> m_instanceData;
+	// texture arrays holding every loaded texture
+	TextureArrays* m_textureArrays;
+	// decodes texture files in the background
+	TextureLoader* m_textureLoader;
+	// keeps the texture levels the draws need on the GPU
+	TextureStreamer* m_textureStreamer;
+	// keeps the pages of virtual textures the frame samples
+	VirtualTextures* m_virtualTextures;
+	// handles of the textures, materials and meshes by tag
+	AssetRegistry* m_assets;
+	// handles the scene draws with, resolved once loaded
+	SCENE_ASSETS m_sceneAssets;
+	// defined object materials
+	std::vector<OBJECT_MATERIAL> m_objectMaterials;
+	// defined object materials packed for the shaders
+	MaterialTable* m_materialTable;
+	// light sources of the scene
+	LightList* m_lightList;
+	// queue of draw commands recorded for the current frame
+	RenderQueue* m_renderQueue;
+	// draw command that collects the state set before each draw
+	RenderQueue::DRAW_COMMAND m_pendingDraw;
+	// position of the camera used for sorting draws by depth
+	glm::vec3 m_viewPosition;
+	// cheaper lighting for draws that are small on screen
+	ShadingLod* m_shadingLod;
+	// handles of the uniforms set for every draw, for the bound variant
+	SCENE_UNIFORMS m_uniforms;
+	// handles of the uniforms of each shader variant
+	std::vector<SCENE_UNIFORMS> m_variantUniforms;
+	// true when the scene is drawn with the light list
+	bool m_bUseLighting;
+	// draws of the scene kept between frames in retained mode
+	CommandList* m_commandList;
+	// true when the scene is recorded once and replayed
+	bool m_bRetainedMode;
+	// true when the retained draws must be submitted to the queue again
+	bool m_bReplayNeeded;
+	// camera position the retained draws were last sorted from
+	glm::vec3 m_replayViewPosition;
+	// render queue generation whose draws were uploaded as static
+	uint32_t m_uploadedGeneration;
+
+	// load texture images and convert to OpenGL texture data
+	bool CreateGLTexture(const char* filename, const std::string& tag);
+	// map the virtual texture baked from a texture image
+	bool CreateGLVirtualTexture(const char* filename, const std::string& tag);
+	// free the loaded OpenGL textures
+	void DestroyGLTextures();
+	// register the basic meshes under their tags
+	void RegisterMeshes();
+	// look up the handles of the assets the scene draws with
+	void ResolveSceneAssets();
+
+	// set the transformation values 
+	// into the transform buffer
+	void SetTransformations(
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ);
+
+	// set the color values into the shader
+	void SetShaderColor(
+		float redColorValue,
+		float greenColorValue,
+		float blueColorValue,
+		float alphaValue);
+
+	// set the texture data into the shader
+	void SetShaderTexture(
+		const std::string& textureTag);
+	void SetShaderTexture(
+		ASSET_HANDLE texture);
+
+	// set the UV scale for the texture mapping
+	void SetTextureUVScale(
+		float u, float v);
+
+	// set the object material into the shader
+	void SetShaderMaterial(
+		const std::string& materialTag);
+	void SetShaderMaterial(
+		ASSET_HANDLE material);
+
+	// record a draw of a basic mesh with the current state
+	void DrawMesh(RenderQueue::MESH_TYPE mesh);
+	void DrawMesh(ASSET_HANDLE mesh);
+	// pass a draw to the render queue at its shading level
+	void SubmitDraw(const RenderQueue::DRAW_COMMAND& command);
+	// reset the state used by the next recorded draw
+	void ResetPendingDraw();
+	// start the draws of a named scene object
+	void BeginSceneObject(const std::string& name);
+	// check whether the current draws are being recorded
+	bool IsRecordingDraws() const;
+	// record every draw of the scene
+	void RecordScene();
+	// sort the recorded draws and send them to the shader
+	void SubmitRenderQueue();
+	// send the sorted draws one draw call at a time
+	void SubmitImmediate();
+	// send the sorted draws as instanced batches
+	void SubmitInstanced();
+	// send the sorted draws with multi-draw-indirect calls
+	void SubmitIndirect();
+	// draw the virtual texture draws into the feedback target
+	void SubmitFeedback();
+	// issue the draw call of a basic mesh
+	void DrawBasicMesh(int mesh);
+	// set the program and texture array shared by a batch
+	void ApplyBatchState(
+		const RenderQueue::DRAW_COMMAND& command,
+		RenderQueue::DRAW_COMMAND& current);
+	// find the end of the batch starting at the passed in index
+	size_t FindBatchEnd(size_t first, bool bSameMesh);
+	// connect the shader's per-draw storage buffer for indirect draws
+	bool PrepareIndirectDraws(GLuint programID);
+	// connect the scene's buffers to a newly linked variant program
+	void AttachProgram(int variant, GLuint programID);
+	// get the shader variant for a draw with the current scene
+	// features at a shading level of detail
+	int GetSceneVariant(bool bTextured, bool bVirtual, ShadingLod::SHADING_LOD lod);
+	// bind a shader variant and its uniform handles
+	void ApplyProgram(int variant);
+	// bind the texture array or virtual texture of a draw, or
+	// no texture, for the shader
+	void ApplyTexture(const RenderQueue::DRAW_COMMAND& command, bool bFeedback);
+	// pack the defined materials into the shaders' material table
+	void CompileMaterialTable();
+	// look up the handles of the uniforms set for every draw
+	void ResolveUniforms(GLuint programID, SCENE_UNIFORMS& uniforms);
+
+public:
+
+	// The following methods are for the students to 
+	// customize for their own 3D scene
+	void PrepareScene();
+	void RenderScene();
+	// set the camera position used for depth sorting
+	void SetViewPosition(glm::vec3 viewPosition);
+	// set the projection used for measuring draws on screen
+	void SetProjection(const glm::mat4& projection);
+	// set when draws switch to cheaper lighting
+	void SetShadingLod(float reducedThreshold, float bakedThreshold, int reducedLightCount);
+	// set the texture memory and per-frame upload budgets
+	void SetTextureBudget(size_t budgetBytes, size_t uploadBytesPerFrame);
+	// set how the recorded draws are sent to the GPU
+	void SetSubmitMode(SUBMIT_MODE mode);
+	// record the scene once and replay it every frame
+	void SetRetainedMode(bool bRetained);
+	// record the draws of a named scene object again
+	void InvalidateSceneObject(const std::string& name);
+	// loads textures from image files
+	void LoadSceneTextures();
+	// pre-set light sources for 3D scene
+	void SetupSceneLights();
+	// pre-define the object materials for lighting
+	void DefineObjectMaterials();
 };
\ No newline at end of file
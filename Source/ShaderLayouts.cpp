@@ -0,0 +1,133 @@
+///////////////////////////////////////////////////////////////////////////////
+// shaderlayouts.cpp
+// ============
+// single description of the structs and blocks shared between the C++ code
+// and the shaders, from which both sides' declarations are generated
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShaderLayouts.h"
+
+// the GLSL text of a layout list, built by the preprocessor
+#define GLSL_LAYOUT_FIELD(cppType, glslType, name) "    " #glslType " " #name ";\n"
+#define GLSL_LAYOUT_CONSTANT(name, value) "#define " #name " " #value "\n"
+#define GLSL_LAYOUT_UNIFORM(name, location) "#define UNIFORM_LOCATION_" #name " " #location "\n"
+#define LAYOUT_UNIFORM_ENTRY(name, location) { #name, location },
+
+// declaration of global variables
+namespace
+{
+	// lines around the generated part of a shader source
+	const char* g_SectionBegin = "// BEGIN SHARED LAYOUTS";
+	const char* g_SectionEnd = "// END SHARED LAYOUTS";
+
+	const char* g_SectionComment =
+		"// generated from Source/ShaderLayouts.h, edit the layouts there\n";
+
+	const char* g_Constants =
+		SHADER_LAYOUT_CONSTANTS(GLSL_LAYOUT_CONSTANT)
+		SHADER_UNIFORM_LOCATIONS(GLSL_LAYOUT_UNIFORM);
+
+	struct LAYOUT_UNIFORM
+	{
+		const char* name;
+		int location;
+	};
+
+	const LAYOUT_UNIFORM g_Uniforms[] =
+	{
+		SHADER_UNIFORM_LOCATIONS(LAYOUT_UNIFORM_ENTRY)
+	};
+
+	const char* g_LightStruct =
+		"struct Light {\n"
+		LIGHT_DATA_LAYOUT(GLSL_LAYOUT_FIELD, SHADER_LAYOUT_SKIP)
+		"};\n";
+
+	const char* g_MaterialStruct =
+		"struct MaterialData {\n"
+		MATERIAL_DATA_LAYOUT(GLSL_LAYOUT_FIELD, SHADER_LAYOUT_SKIP)
+		"};\n";
+
+	const char* g_DrawStruct =
+		"struct DrawData {\n"
+		DRAW_DATA_LAYOUT(GLSL_LAYOUT_FIELD, SHADER_LAYOUT_SKIP)
+		"};\n";
+
+	// SPIRV_BINDING is defined by the shaders, and only adds
+	// the binding when they are compiled to SPIR-V
+	const char* g_FrameBlock =
+		"layout (std140 SPIRV_BINDING(FRAME_DATA_BINDING)) uniform FrameData {\n"
+		FRAME_DATA_LAYOUT(GLSL_LAYOUT_FIELD, SHADER_LAYOUT_SKIP)
+		"};\n";
+}
+
+/***********************************************************
+ *  GetLayoutDeclarations()
+ *
+ *  This function is used for getting the GLSL declarations
+ *  of the shared layouts that a shader stage reads.
+ ***********************************************************/
+std::string GetLayoutDeclarations(LAYOUT_STAGE stage)
+{
+	std::string declarations = g_SectionComment;
+
+	declarations += g_Constants;
+	if (stage == LAYOUT_VERTEX_STAGE)
+	{
+		declarations += g_DrawStruct;
+	}
+	else
+	{
+		declarations += g_LightStruct;
+		declarations += g_MaterialStruct;
+	}
+	declarations += g_FrameBlock;
+	return(declarations);
+}
+
+/***********************************************************
+ *  FindLayoutUniform()
+ *
+ *  This function is used for getting the name of the
+ *  uniform that has a fixed location in the shaders.
+ ***********************************************************/
+const char* FindLayoutUniform(int location)
+{
+	for (size_t i = 0; i < sizeof(g_Uniforms) / sizeof(g_Uniforms[0]); i++)
+	{
+		if (g_Uniforms[i].location == location)
+		{
+			return(g_Uniforms[i].name);
+		}
+	}
+	return(NULL);
+}
+
+/***********************************************************
+ *  ReplaceLayoutSection()
+ *
+ *  This function is used for replacing the lines between
+ *  the BEGIN and END SHARED LAYOUTS comments of a shader
+ *  source with the generated declarations, so the shaders
+ *  that are built always match the C++ structs.  False is
+ *  returned when the source has no such section.
+ ***********************************************************/
+bool ReplaceLayoutSection(const std::string& source, LAYOUT_STAGE stage, std::string& result)
+{
+	size_t begin = source.find(g_SectionBegin);
+	size_t end = std::string::npos;
+
+	if (begin != std::string::npos)
+	{
+		begin = source.find('\n', begin);
+		end = source.find(g_SectionEnd, begin);
+	}
+	if ((begin == std::string::npos) || (end == std::string::npos))
+	{
+		result = source;
+		return(false);
+	}
+
+	result = source.substr(0, begin + 1) + GetLayoutDeclarations(stage) + source.substr(end);
+	return(true);
+}
@@ -0,0 +1,245 @@
+///////////////////////////////////////////////////////////////////////////////
+// shaderlayouts.h
+// ============
+// single description of the structs and blocks shared between the C++ code
+// and the shaders, from which both sides' declarations are generated
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <string>
+
+// a mat3 member of a std140 or std430 block, whose three
+// columns are each padded to a vec4
+typedef glm::vec4 LAYOUT_MAT3[3];
+
+/***********************************************************
+ *  Shared layout lists
+ *
+ *  Each list names the members of one struct in order.
+ *  FIELD(C++ type, GLSL type, name) is a member on both
+ *  sides, PAD(C++ type, name) only pads the C++ struct out
+ *  to the size the GLSL rules give it.  The C++ structs are
+ *  declared by expanding a list with SHADER_LAYOUT_MEMBER
+ *  and SHADER_LAYOUT_MEMBER_PAD, the GLSL declarations are
+ *  generated by GetLayoutDeclarations, and
+ *  SHADER_LAYOUT_ASSERT checks every member offset against
+ *  the std140 or std430 rules at compile time.
+ ***********************************************************/
+
+// one light, LightList::LIGHT_DATA and Light in the shaders
+#define LIGHT_DATA_LAYOUT(FIELD, PAD) \
+	/* xyz is the position, w is the light type */ \
+	FIELD(glm::vec4, vec4, position) \
+	/* xyz is the direction, w is 1 when the light follows the camera */ \
+	FIELD(glm::vec4, vec4, direction) \
+	FIELD(glm::vec4, vec4, ambient) \
+	FIELD(glm::vec4, vec4, diffuse) \
+	FIELD(glm::vec4, vec4, specular) \
+	/* x is constant, y is linear and z is quadratic falloff */ \
+	FIELD(glm::vec4, vec4, attenuation) \
+	/* x is the cosine of the inner cone, y of the outer cone */ \
+	FIELD(glm::vec4, vec4, cone)
+
+// one material, MaterialTable::MATERIAL_DATA and MaterialData
+// in the shaders
+#define MATERIAL_DATA_LAYOUT(FIELD, PAD) \
+	/* rgb is the diffuse color, w is unused */ \
+	FIELD(glm::vec4, vec4, diffuseColor) \
+	/* rgb is the specular color, w is the shininess */ \
+	FIELD(glm::vec4, vec4, specularColor)
+
+// per-frame values, FrameUniformBuffer::FRAME_DATA and the
+// FrameData block in the shaders
+#define FRAME_DATA_LAYOUT(FIELD, PAD) \
+	FIELD(glm::mat4, mat4, view) \
+	FIELD(glm::mat4, mat4, projection) \
+	FIELD(glm::mat4, mat4, viewProjection) \
+	/* xyz is the camera position, w is unused */ \
+	FIELD(glm::vec4, vec4, cameraPosition) \
+	/* xyz is the camera front vector, w is unused */ \
+	FIELD(glm::vec4, vec4, cameraDirection) \
+	/* seconds since the window was created */ \
+	FIELD(float, float, time) \
+	PAD(float, padding[3])
+
+// per-draw values, BatchedMeshes::INSTANCE_DATA and DrawData
+// in the vertex shader
+#define DRAW_DATA_LAYOUT(FIELD, PAD) \
+	FIELD(glm::mat4, mat4, model) \
+	/* inverse transpose of the model's upper 3x3 */ \
+	FIELD(LAYOUT_MAT3, mat3, normalMatrix) \
+	FIELD(glm::vec4, vec4, color) \
+	FIELD(int, int, materialIndex) \
+	/* layer of the bound texture array the draw samples */ \
+	FIELD(int, int, textureLayer) \
+	FIELD(glm::vec2, vec2, uvScale)
+
+// integer constants shared with the shaders, where each one
+// becomes a #define of the same name
+#define SHADER_LAYOUT_CONSTANTS(CONSTANT) \
+	CONSTANT(LIGHT_DIRECTIONAL, 0) \
+	CONSTANT(LIGHT_POINT, 1) \
+	CONSTANT(LIGHT_SPOT, 2) \
+	CONSTANT(MAX_UNIFORM_LIGHTS, 64) \
+	CONSTANT(MAX_UNIFORM_MATERIALS, 256) \
+	/* uniform buffer binding point */ \
+	CONSTANT(FRAME_DATA_BINDING, 0) \
+	/* storage buffer binding points, lights and materials use */ \
+	/* the same points when they fall back to uniform buffers */ \
+	CONSTANT(DRAW_DATA_BINDING, 0) \
+	CONSTANT(LIGHT_BINDING, 1) \
+	CONSTANT(MATERIAL_BINDING, 2) \
+	/* SPIR-V specialization constant holding the light count */ \
+	CONSTANT(LIGHT_COUNT_CONSTANT_ID, 0)
+
+// locations of the uniforms outside blocks, which become
+// UNIFORM_LOCATION_ defines.  SPIR-V programs are built with
+// these fixed locations since they need not report names.
+#define SHADER_UNIFORM_LOCATIONS(UNIFORM) \
+	UNIFORM(model, 0) \
+	UNIFORM(normalMatrix, 1) \
+	UNIFORM(bUseInstancing, 2) \
+	UNIFORM(bUseIndirect, 3) \
+	UNIFORM(drawIndexBase, 4) \
+	UNIFORM(objectColor, 5) \
+	UNIFORM(materialIndex, 6) \
+	UNIFORM(objectTexture, 7) \
+	UNIFORM(UVscale, 8) \
+	UNIFORM(textureLayer, 9) \
+	UNIFORM(virtualPageTable, 10) \
+	UNIFORM(virtualPageCache, 11) \
+	UNIFORM(virtualTextureInfo, 12) \
+	UNIFORM(virtualCacheInfo, 13)
+
+// declare the members of a C++ struct from a layout list
+#define SHADER_LAYOUT_MEMBER(cppType, glslType, name) cppType name;
+#define SHADER_LAYOUT_MEMBER_PAD(cppType, name) cppType name;
+
+#define SHADER_LAYOUT_ENUM(name, value) LAYOUT_##name = value,
+// the shared constants, prefixed with LAYOUT_ on the C++ side
+enum LAYOUT_CONSTANT
+{
+	SHADER_LAYOUT_CONSTANTS(SHADER_LAYOUT_ENUM)
+};
+#undef SHADER_LAYOUT_ENUM
+
+// GLSL types allowed in the layout lists, named after the
+// GLSL keywords so that the lists can paste them
+enum LAYOUT_TYPE
+{
+	LAYOUT_int,
+	LAYOUT_float,
+	LAYOUT_vec2,
+	LAYOUT_vec3,
+	LAYOUT_vec4,
+	LAYOUT_mat3,
+	LAYOUT_mat4
+};
+
+// packing rules of a block
+enum LAYOUT_RULES
+{
+	LAYOUT_STD140,
+	LAYOUT_STD430
+};
+
+// shader stages that include the generated declarations
+enum LAYOUT_STAGE
+{
+	LAYOUT_VERTEX_STAGE,
+	LAYOUT_FRAGMENT_STAGE
+};
+
+/***********************************************************
+ *  LayoutAlignment()
+ *
+ *  This function is used for getting the base alignment of
+ *  a GLSL type, which is the same under std140 and std430
+ *  for everything but arrays and structs.
+ ***********************************************************/
+constexpr size_t LayoutAlignment(LAYOUT_TYPE type)
+{
+	return((type == LAYOUT_int) || (type == LAYOUT_float) ? 4 :
+		(type == LAYOUT_vec2) ? 8 : 16);
+}
+
+/***********************************************************
+ *  LayoutSize()
+ *
+ *  This function is used for getting the number of bytes a
+ *  GLSL type takes up in a block.
+ ***********************************************************/
+constexpr size_t LayoutSize(LAYOUT_TYPE type)
+{
+	return((type == LAYOUT_int) || (type == LAYOUT_float) ? 4 :
+		(type == LAYOUT_vec2) ? 8 :
+		(type == LAYOUT_vec3) ? 12 :
+		(type == LAYOUT_vec4) ? 16 :
+		(type == LAYOUT_mat3) ? 48 : 64);
+}
+
+/***********************************************************
+ *  LayoutMatches()
+ *
+ *  This function is used for checking a C++ struct against
+ *  the GLSL packing rules.  Every member must start at the
+ *  offset the rules give it, and the struct must be as big
+ *  as one element of an array of it, whose alignment is
+ *  rounded up to a vec4 under std140.
+ ***********************************************************/
+constexpr bool LayoutMatches(
+	const LAYOUT_TYPE* types,
+	const size_t* offsets,
+	size_t count,
+	size_t structSize,
+	LAYOUT_RULES rules)
+{
+	size_t offset = 0;
+	size_t alignment = (rules == LAYOUT_STD140) ? 16 : 4;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		size_t memberAlignment = LayoutAlignment(types[i]);
+
+		offset = (offset + memberAlignment - 1) / memberAlignment * memberAlignment;
+		if (offsets[i] != offset)
+		{
+			return(false);
+		}
+		offset += LayoutSize(types[i]);
+		alignment = (memberAlignment > alignment) ? memberAlignment : alignment;
+	}
+	return((offset + alignment - 1) / alignment * alignment == structSize);
+}
+
+#define SHADER_LAYOUT_TYPE(cppType, glslType, name) LAYOUT_##glslType,
+#define SHADER_LAYOUT_OFFSET(cppType, glslType, name) offsetof(CHECKED, name),
+#define SHADER_LAYOUT_SKIP(cppType, name)
+
+// check a C++ struct declared from a layout list against
+// the packing rules of the blocks that hold it
+#define SHADER_LAYOUT_ASSERT(STRUCT, LAYOUT, RULES) \
+	namespace \
+	{ \
+		struct LAYOUT##_CHECK_##RULES \
+		{ \
+			typedef STRUCT CHECKED; \
+			static constexpr LAYOUT_TYPE types[] = { LAYOUT(SHADER_LAYOUT_TYPE, SHADER_LAYOUT_SKIP) }; \
+			static constexpr size_t offsets[] = { LAYOUT(SHADER_LAYOUT_OFFSET, SHADER_LAYOUT_SKIP) }; \
+		}; \
+	} \
+	static_assert(LayoutMatches(LAYOUT##_CHECK_##RULES::types, LAYOUT##_CHECK_##RULES::offsets, \
+		sizeof(LAYOUT##_CHECK_##RULES::types) / sizeof(LAYOUT_TYPE), sizeof(STRUCT), RULES), \
+		#STRUCT " does not match the " #RULES " layout in the shaders")
+
+// get the generated declarations used by a shader stage
+std::string GetLayoutDeclarations(LAYOUT_STAGE stage);
+// get the name of the uniform with a fixed location, or NULL
+const char* FindLayoutUniform(int location);
+// replace the generated section of a shader source with the
+// current declarations, returning false when it has none
+bool ReplaceLayoutSection(const std::string& source, LAYOUT_STAGE stage, std::string& result);
@@ -0,0 +1,917 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadervariants.cpp
+// ============
+// compile one program per combination of scene features, so that features
+// a draw does not use are removed by the preprocessor instead of being
+// skipped by a uniform branch in every fragment
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShaderVariants.h"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+// declaration of global variables
+namespace
+{
+	// directory of the program binary cache files
+	const char* g_BinaryCacheDirectory = "shaders/";
+}
+
+/***********************************************************
+ *  ShaderVariants()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ShaderVariants::ShaderVariants()
+{
+	m_binaryCache = new ProgramBinaryCache(g_BinaryCacheDirectory);
+	m_bUseSpirv = false;
+	m_bAllowSpirv = false;
+	m_bParallelCompile = false;
+}
+
+/***********************************************************
+ *  ~ShaderVariants()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ShaderVariants::~ShaderVariants()
+{
+	// the owners of the callbacks may already be gone
+	m_programCallbacks.clear();
+	m_releaseCallbacks.clear();
+	Clear();
+	delete m_binaryCache;
+	m_binaryCache = NULL;
+}
+
+/***********************************************************
+ *  MakeKey()
+ *
+ *  This method is used for packing the feature flags into
+ *  the low byte of a key and the light count into the next
+ *  byte.  Light counts above MAX_SPECIALIZED_LIGHTS, and any
+ *  count of an unlit variant, collapse to one value so that
+ *  they share a program.
+ ***********************************************************/
+uint32_t ShaderVariants::MakeKey(uint32_t flags, int lightCount)
+{
+	uint32_t keyLights = DYNAMIC_LIGHT_COUNT;
+
+	if (((flags & VARIANT_LIT) != 0) &&
+		(lightCount >= 0) && (lightCount <= MAX_SPECIALIZED_LIGHTS))
+	{
+		keyLights = (uint32_t)lightCount;
+	}
+	return((flags & 0xFF) | (keyLights << 8));
+}
+
+/***********************************************************
+ *  ReadFile()
+ *
+ *  This method is used for reading a whole text file into
+ *  the passed in string.
+ ***********************************************************/
+bool ShaderVariants::ReadFile(const char* filePath, std::string& contents)
+{
+	std::ifstream file(filePath);
+	std::stringstream stream;
+
+	if (!file.is_open())
+	{
+		std::cout << "ERROR: Could not open shader file " << filePath << std::endl;
+		return(false);
+	}
+
+	stream << file.rdbuf();
+	contents = stream.str();
+	return(true);
+}
+
+/***********************************************************
+ *  ApplySharedLayouts()
+ *
+ *  This method is used for replacing the shared layouts
+ *  section of a scene shader source with the declarations
+ *  generated from ShaderLayouts.h, so that the programs
+ *  always read the buffers the way the C++ code writes
+ *  them.  A section that differs from the generated text is
+ *  reported, since the file is still what other tools read,
+ *  and false is returned.
+ ***********************************************************/
+bool ShaderVariants::ApplySharedLayouts(const std::string& source, LAYOUT_STAGE stage, const char* name, std::string& result) const
+{
+	std::string previous = source;
+
+	if (ReplaceLayoutSection(source, stage, result) == false)
+	{
+		std::cout << "INFO: The " << name << " shader has no shared layouts section" << std::endl;
+		return(false);
+	}
+
+	// line endings depend on how the file was checked out
+	previous.erase(std::remove(previous.begin(), previous.end(), '\r'), previous.end());
+	result.erase(std::remove(result.begin(), result.end(), '\r'), result.end());
+	if (previous != result)
+	{
+		std::cout << "INFO: The shared layouts in the " << name
+			<< " shader are out of date, the generated declarations are used" << std::endl;
+		return(false);
+	}
+	return(true);
+}
+
+/***********************************************************
+ *  GetModulePath()
+ *
+ *  This method is used for getting the name of the SPIR-V
+ *  module compiled from a shader file, which replaces the
+ *  .glsl extension.  Fragment modules add the feature flags
+ *  they were compiled with.  Tools/CompileSpirv.cpp writes
+ *  the modules under the same names.
+ ***********************************************************/
+std::string ShaderVariants::GetModulePath(const char* sourcePath, int featureSet)
+{
+	std::string path = sourcePath;
+	size_t extension = path.rfind(".glsl");
+
+	if (extension != std::string::npos)
+	{
+		path.erase(extension);
+	}
+	if (featureSet >= 0)
+	{
+		path += "." + std::to_string(featureSet);
+	}
+	return(path + ".spv");
+}
+
+/***********************************************************
+ *  ReadModule()
+ *
+ *  This method is used for reading a SPIR-V module.  A
+ *  module that is missing, or older than the shader file it
+ *  was compiled from, is not read.
+ ***********************************************************/
+bool ShaderVariants::ReadModule(const std::string& modulePath, const char* sourcePath, std::string& module)
+{
+	struct stat moduleStatus;
+	struct stat sourceStatus;
+
+	if (stat(modulePath.c_str(), &moduleStatus) != 0)
+	{
+		return(false);
+	}
+	if ((stat(sourcePath, &sourceStatus) == 0) && (sourceStatus.st_mtime > moduleStatus.st_mtime))
+	{
+		std::cout << "INFO: " << modulePath << " is older than " << sourcePath
+			<< ", the shaders are compiled from GLSL" << std::endl;
+		return(false);
+	}
+
+	std::ifstream file(modulePath, std::ios::binary);
+	std::stringstream stream;
+
+	stream << file.rdbuf();
+	module = stream.str();
+	return(module.empty() == false);
+}
+
+/***********************************************************
+ *  LoadSpirvModules()
+ *
+ *  This method is used for reading the vertex module and
+ *  the fragment module of every feature set.  They are only
+ *  used when the driver takes SPIR-V and all of them are
+ *  up to date.
+ ***********************************************************/
+bool ShaderVariants::LoadSpirvModules(const char* vertexShaderPath, const char* fragmentShaderPath)
+{
+	if (GLEW_VERSION_4_6 == false)
+	{
+		return(false);
+	}
+
+	if (ReadModule(GetModulePath(vertexShaderPath, -1), vertexShaderPath, m_vertexModule) == false)
+	{
+		return(false);
+	}
+	for (int i = 0; i < FEATURE_SETS; i++)
+	{
+		if (ReadModule(GetModulePath(fragmentShaderPath, i), fragmentShaderPath, m_fragmentModules[i]) == false)
+		{
+			return(false);
+		}
+	}
+
+	std::cout << "INFO: Building the shader variants from SPIR-V modules" << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  Load()
+ *
+ *  This method is used for reading the scene shader sources,
+ *  and the SPIR-V modules compiled from them when they are
+ *  allowed and up to date.  Programs built from earlier
+ *  sources are deleted.
+ ***********************************************************/
+bool ShaderVariants::Load(const char* vertexShaderPath, const char* fragmentShaderPath)
+{
+	std::string vertexSource;
+	std::string fragmentSource;
+	bool bLayoutsCurrent = false;
+
+	if ((ReadFile(vertexShaderPath, vertexSource) == false) ||
+		(ReadFile(fragmentShaderPath, fragmentSource) == false))
+	{
+		return(false);
+	}
+
+	Clear();
+	bLayoutsCurrent = ApplySharedLayouts(vertexSource, LAYOUT_VERTEX_STAGE, "vertex", m_vertexSource);
+	bLayoutsCurrent = ApplySharedLayouts(fragmentSource, LAYOUT_FRAGMENT_STAGE, "fragment", m_fragmentSource) &&
+		bLayoutsCurrent;
+
+	// modules compiled from stale layouts would not match the
+	// C++ structs
+	m_bUseSpirv = (m_bAllowSpirv == true) && (bLayoutsCurrent == true) &&
+		(LoadSpirvModules(vertexShaderPath, fragmentShaderPath) == true);
+
+	// let the driver use as many compiler threads as it likes
+	if (GLEW_KHR_parallel_shader_compile)
+	{
+		glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+		m_bParallelCompile = true;
+	}
+	else if (GLEW_ARB_parallel_shader_compile)
+	{
+		glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+		m_bParallelCompile = true;
+	}
+	if (m_bParallelCompile == true)
+	{
+		std::cout << "INFO: Shader variants are compiled in the background" << std::endl;
+	}
+	return(true);
+}
+
+/***********************************************************
+ *  Reload()
+ *
+ *  This method is used for starting to build every variant
+ *  again from the passed in sources.  Nothing is waited on,
+ *  and Update() swaps the new programs in together once all
+ *  of them have linked, so a shader error leaves the last
+ *  good programs in use.  The variant numbers stay the same.
+ *  A reload still in progress is dropped for the newer
+ *  sources.
+ ***********************************************************/
+bool ShaderVariants::Reload(const std::string& vertexSource, const std::string& fragmentSource)
+{
+	CancelReload();
+
+	ApplySharedLayouts(vertexSource, LAYOUT_VERTEX_STAGE, "vertex", m_reloadVertexSource);
+	ApplySharedLayouts(fragmentSource, LAYOUT_FRAGMENT_STAGE, "fragment", m_reloadFragmentSource);
+	m_reloadStart = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < m_variants.size(); i++)
+	{
+		StartReloadBuild((int)i);
+	}
+
+	// with no variant built yet, the sources are swapped at once
+	if (IsReloading() == false)
+	{
+		UpdateReload();
+		return(true);
+	}
+
+	std::cout << "INFO: Shader reload started for " << m_reloadBuilds.size() << " variants" << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  StartReloadBuild()
+ *
+ *  This method is used for starting the build of a variant
+ *  from the reloaded sources.  The reloaded sources are
+ *  always compiled from GLSL, since the SPIR-V modules were
+ *  compiled from the sources being replaced.
+ ***********************************************************/
+void ShaderVariants::StartReloadBuild(int variant)
+{
+	PENDING_BUILD build;
+
+	StartBuild(m_variants[variant].key, build, true);
+	build.variant = variant;
+	m_reloadBuilds.push_back(build);
+}
+
+/***********************************************************
+ *  UpdateReload()
+ *
+ *  This method is used for checking the reload builds that
+ *  have finished since the last call.  When every one has
+ *  linked, the variants are swapped to the new programs at
+ *  once, so that one frame never mixes old and new programs,
+ *  and builds of the old sources still running are dropped.
+ *  When one fails, the whole reload is dropped.
+ ***********************************************************/
+void ShaderVariants::UpdateReload()
+{
+	bool bComplete = true;
+	double milliseconds = 0.0;
+
+	for (size_t i = 0; i < m_reloadBuilds.size(); i++)
+	{
+		PENDING_BUILD& build = m_reloadBuilds[i];
+
+		// loaded from the binary cache, or already checked
+		if (0 == build.vertexShader)
+		{
+			continue;
+		}
+		if (IsBuildComplete(build) == false)
+		{
+			bComplete = false;
+			continue;
+		}
+		if (0 == FinishBuild(build))
+		{
+			milliseconds = std::chrono::duration<double, std::milli>(
+				std::chrono::steady_clock::now() - m_reloadStart).count();
+			std::cout << "ERROR: Shader reload failed after " << milliseconds
+				<< " ms, keeping the previous programs" << std::endl;
+			CancelReload();
+			return;
+		}
+	}
+	if (bComplete == false)
+	{
+		return;
+	}
+
+	for (size_t i = 0; i < m_pendingBuilds.size(); i++)
+	{
+		DiscardBuild(m_pendingBuilds[i]);
+	}
+	m_pendingBuilds.clear();
+
+	for (size_t i = 0; i < m_reloadBuilds.size(); i++)
+	{
+		int variant = m_reloadBuilds[i].variant;
+		GLuint programID = m_reloadBuilds[i].programID;
+
+		ReleaseProgram(m_variants[variant].programID);
+		m_variants[variant].programID = programID;
+		for (size_t j = 0; j < m_programCallbacks.size(); j++)
+		{
+			m_programCallbacks[j](variant, programID);
+		}
+	}
+	m_vertexSource.swap(m_reloadVertexSource);
+	m_fragmentSource.swap(m_reloadFragmentSource);
+	m_bUseSpirv = false;
+	m_failedKeys.clear();
+
+	milliseconds = std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - m_reloadStart).count();
+	std::cout << "INFO: Shader reload rebuilt " << m_reloadBuilds.size()
+		<< " variants in " << milliseconds << " ms" << std::endl;
+	m_reloadBuilds.clear();
+	m_reloadVertexSource.clear();
+	m_reloadFragmentSource.clear();
+}
+
+/***********************************************************
+ *  CancelReload()
+ *
+ *  This method is used for deleting the programs of the
+ *  reload in progress, finished or not, and forgetting its
+ *  sources.
+ ***********************************************************/
+void ShaderVariants::CancelReload()
+{
+	for (size_t i = 0; i < m_reloadBuilds.size(); i++)
+	{
+		DiscardBuild(m_reloadBuilds[i]);
+	}
+	m_reloadBuilds.clear();
+	m_reloadVertexSource.clear();
+	m_reloadFragmentSource.clear();
+}
+
+/***********************************************************
+ *  AddProgramCallback()
+ *
+ *  This method is used for adding a function that is called
+ *  with each program right after it is linked.
+ ***********************************************************/
+void ShaderVariants::AddProgramCallback(const PROGRAM_CALLBACK& callback)
+{
+	m_programCallbacks.push_back(callback);
+}
+
+/***********************************************************
+ *  AddReleaseCallback()
+ *
+ *  This method is used for adding a function that is called
+ *  with each program right before it is deleted, so that
+ *  nothing keeps state for a deleted program object.
+ ***********************************************************/
+void ShaderVariants::AddReleaseCallback(const RELEASE_CALLBACK& callback)
+{
+	m_releaseCallbacks.push_back(callback);
+}
+
+/***********************************************************
+ *  ReleaseProgram()
+ *
+ *  This method is used for calling the release callbacks
+ *  with a program and then deleting it.
+ ***********************************************************/
+void ShaderVariants::ReleaseProgram(GLuint programID)
+{
+	if (0 == programID)
+	{
+		return;
+	}
+
+	for (size_t i = 0; i < m_releaseCallbacks.size(); i++)
+	{
+		m_releaseCallbacks[i](programID);
+	}
+	glDeleteProgram(programID);
+}
+
+/***********************************************************
+ *  BuildDefines()
+ *
+ *  This method is used for writing the #define lines that
+ *  select the features of a variant key.
+ ***********************************************************/
+std::string ShaderVariants::BuildDefines(uint32_t key) const
+{
+	std::string defines;
+	uint32_t keyLights = (key >> 8) & 0xFF;
+
+	if ((key & VARIANT_TEXTURED) != 0)
+	{
+		defines += "#define USE_TEXTURE\n";
+	}
+	if ((key & VARIANT_LIT) != 0)
+	{
+		defines += "#define USE_LIGHTING\n";
+		if (keyLights != DYNAMIC_LIGHT_COUNT)
+		{
+			defines += "#define LIGHT_COUNT " + std::to_string(keyLights) + "\n";
+		}
+	}
+	else if ((key & VARIANT_BAKED) != 0)
+	{
+		defines += "#define USE_BAKED_LIGHTING\n";
+	}
+	if ((key & VARIANT_VIRTUAL) != 0)
+	{
+		defines += "#define USE_VIRTUAL_TEXTURE\n";
+	}
+	if ((key & VARIANT_FEEDBACK) != 0)
+	{
+		defines += "#define WRITE_FEEDBACK\n";
+	}
+	return(defines);
+}
+
+/***********************************************************
+ *  InjectDefines()
+ *
+ *  This method is used for placing the #define lines after
+ *  the #version line, which must stay the first line of the
+ *  source.  Extension directives may follow the defines.
+ ***********************************************************/
+std::string ShaderVariants::InjectDefines(const std::string& source, const std::string& defines) const
+{
+	size_t version = source.find("#version");
+	size_t lineEnd = std::string::npos;
+
+	if (version != std::string::npos)
+	{
+		lineEnd = source.find('\n', version);
+	}
+	if (lineEnd == std::string::npos)
+	{
+		return(defines + source);
+	}
+	return(source.substr(0, lineEnd + 1) + defines + source.substr(lineEnd + 1));
+}
+
+/***********************************************************
+ *  CompileShader()
+ *
+ *  This method is used for starting the compile of one
+ *  stage of a variant.  The status is not asked for here,
+ *  since that would wait for a background compile, and is
+ *  only checked when the program fails to link.
+ ***********************************************************/
+GLuint ShaderVariants::CompileShader(GLenum type, const std::string& source)
+{
+	GLuint shaderID = glCreateShader(type);
+	const GLchar* sourceText = source.c_str();
+
+	glShaderSource(shaderID, 1, &sourceText, NULL);
+	glCompileShader(shaderID);
+	return(shaderID);
+}
+
+/***********************************************************
+ *  SpecializeShader()
+ *
+ *  This method is used for creating one stage of a variant
+ *  from its SPIR-V module.  The lit fragment modules get the
+ *  light count of the key, where zero loops over lightCount
+ *  as the dynamic variants do.
+ ***********************************************************/
+GLuint ShaderVariants::SpecializeShader(GLenum type, const std::string& module, uint32_t key)
+{
+	GLuint shaderID = glCreateShader(type);
+	GLuint constantIndex = LAYOUT_LIGHT_COUNT_CONSTANT_ID;
+	GLuint constantValue = 0;
+	GLuint constantCount = 0;
+	uint32_t keyLights = (key >> 8) & 0xFF;
+
+	if ((type == GL_FRAGMENT_SHADER) && ((key & VARIANT_LIT) != 0))
+	{
+		constantCount = 1;
+		constantValue = (keyLights != DYNAMIC_LIGHT_COUNT) ? keyLights : 0;
+	}
+
+	glShaderBinary(1, &shaderID, GL_SHADER_BINARY_FORMAT_SPIR_V, module.data(), (GLsizei)module.size());
+	glSpecializeShader(shaderID, "main", constantCount, &constantIndex, &constantValue);
+	return(shaderID);
+}
+
+/***********************************************************
+ *  ReportShaderErrors()
+ *
+ *  This method is used for writing the info log of a stage
+ *  to the console when it failed to compile.
+ ***********************************************************/
+void ShaderVariants::ReportShaderErrors(GLuint shaderID, uint32_t key) const
+{
+	GLint status = GL_FALSE;
+	GLint logLength = 0;
+
+	glGetShaderiv(shaderID, GL_COMPILE_STATUS, &status);
+	if (status == GL_TRUE)
+	{
+		return;
+	}
+
+	glGetShaderiv(shaderID, GL_INFO_LOG_LENGTH, &logLength);
+	std::vector<GLchar> log(logLength + 1, 0);
+	glGetShaderInfoLog(shaderID, (GLsizei)log.size(), NULL, log.data());
+
+	std::cout << "ERROR: Shader variant 0x" << std::hex << key << std::dec
+		<< " failed to compile" << std::endl << log.data() << std::endl;
+}
+
+/***********************************************************
+ *  StartBuild()
+ *
+ *  This method is used for loading the program of a variant
+ *  key from the binary cache, or issuing the compile of its
+ *  stages and the link of its program.  Nothing is waited
+ *  on, so with KHR_parallel_shader_compile the work carries
+ *  on in the driver's threads.  A program loaded from the
+ *  cache has no shaders in the build.  A reload build uses
+ *  the reloaded sources, as GLSL.
+ ***********************************************************/
+void ShaderVariants::StartBuild(uint32_t key, PENDING_BUILD& build, bool bReload)
+{
+	std::string defines = BuildDefines(key);
+	std::string vertexSource;
+	std::string fragmentSource;
+	bool bUseSpirv = (m_bUseSpirv == true) && (bReload == false);
+
+	build.variant = -1;
+	build.key = key;
+	build.vertexShader = 0;
+	build.fragmentShader = 0;
+	build.start = std::chrono::steady_clock::now();
+
+	if (bUseSpirv == true)
+	{
+		// the defines hold the light count, which is not part
+		// of the module
+		vertexSource = m_vertexModule;
+		fragmentSource = m_fragmentModules[key & (FEATURE_SETS - 1)] + defines;
+	}
+	else if (bReload == true)
+	{
+		vertexSource = InjectDefines(m_reloadVertexSource, defines);
+		fragmentSource = InjectDefines(m_reloadFragmentSource, defines);
+	}
+	else
+	{
+		vertexSource = InjectDefines(m_vertexSource, defines);
+		fragmentSource = InjectDefines(m_fragmentSource, defines);
+	}
+
+	build.binaryKey = m_binaryCache->MakeKey(vertexSource, fragmentSource);
+	build.programID = m_binaryCache->Load(build.binaryKey);
+	if (0 != build.programID)
+	{
+		return;
+	}
+
+	if (bUseSpirv == true)
+	{
+		build.vertexShader = SpecializeShader(GL_VERTEX_SHADER, m_vertexModule, key);
+		build.fragmentShader = SpecializeShader(GL_FRAGMENT_SHADER, m_fragmentModules[key & (FEATURE_SETS - 1)], key);
+	}
+	else
+	{
+		build.vertexShader = CompileShader(GL_VERTEX_SHADER, vertexSource);
+		build.fragmentShader = CompileShader(GL_FRAGMENT_SHADER, fragmentSource);
+	}
+
+	// a stage that fails to compile makes the link fail, and
+	// its log is written then
+	build.programID = glCreateProgram();
+	m_binaryCache->PrepareProgram(build.programID);
+	glAttachShader(build.programID, build.vertexShader);
+	glAttachShader(build.programID, build.fragmentShader);
+	glLinkProgram(build.programID);
+}
+
+/***********************************************************
+ *  IsBuildComplete()
+ *
+ *  This method is used for asking the driver whether the
+ *  compile and link of a build have finished, without
+ *  waiting for them.  Without parallel compiling, every
+ *  build is complete once issued.
+ ***********************************************************/
+bool ShaderVariants::IsBuildComplete(const PENDING_BUILD& build) const
+{
+	GLint status = GL_TRUE;
+
+	if ((m_bParallelCompile == true) && (0 != build.vertexShader))
+	{
+		glGetProgramiv(build.programID, GL_COMPLETION_STATUS_KHR, &status);
+	}
+	return(status == GL_TRUE);
+}
+
+/***********************************************************
+ *  FinishBuild()
+ *
+ *  This method is used for checking the link of a build,
+ *  which waits for it when it is still running, and adding
+ *  a linked program to the binary cache.  The shaders of
+ *  the build are deleted, and zero is returned on failure.
+ ***********************************************************/
+GLuint ShaderVariants::FinishBuild(PENDING_BUILD& build)
+{
+	GLuint programID = build.programID;
+	GLint status = GL_FALSE;
+
+	// loaded from the binary cache
+	if (0 == build.vertexShader)
+	{
+		return(programID);
+	}
+
+	glGetProgramiv(programID, GL_LINK_STATUS, &status);
+	if (status != GL_TRUE)
+	{
+		GLint logLength = 0;
+		glGetProgramiv(programID, GL_INFO_LOG_LENGTH, &logLength);
+		std::vector<GLchar> log(logLength + 1, 0);
+		glGetProgramInfoLog(programID, (GLsizei)log.size(), NULL, log.data());
+
+		ReportShaderErrors(build.vertexShader, build.key);
+		ReportShaderErrors(build.fragmentShader, build.key);
+		std::cout << "ERROR: Shader variant 0x" << std::hex << build.key << std::dec
+			<< " failed to link" << std::endl << log.data() << std::endl;
+		glDeleteProgram(programID);
+		programID = 0;
+	}
+	else
+	{
+		glDetachShader(programID, build.vertexShader);
+		glDetachShader(programID, build.fragmentShader);
+		m_binaryCache->Save(build.binaryKey, programID, std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - build.start).count());
+	}
+
+	glDeleteShader(build.vertexShader);
+	glDeleteShader(build.fragmentShader);
+	build.vertexShader = 0;
+	build.fragmentShader = 0;
+	build.programID = programID;
+	return(programID);
+}
+
+/***********************************************************
+ *  BuildProgram()
+ *
+ *  This method is used for loading the program of a variant
+ *  key from the binary cache, or compiling and linking it
+ *  and adding it to the cache, waiting for the result.
+ *  Zero is returned on failure.
+ ***********************************************************/
+GLuint ShaderVariants::BuildProgram(uint32_t key)
+{
+	PENDING_BUILD build;
+
+	StartBuild(key, build);
+	return(FinishBuild(build));
+}
+
+/***********************************************************
+ *  AddProgram()
+ *
+ *  This method is used for storing the linked program of a
+ *  variant and calling the program callbacks with it.
+ ***********************************************************/
+void ShaderVariants::AddProgram(int variant, GLuint programID)
+{
+	m_variants[variant].programID = programID;
+
+	const ProgramBinaryCache::CACHE_STATS& stats = m_binaryCache->GetStats();
+	std::cout << "INFO: Shader variant 0x" << std::hex << m_variants[variant].key << std::dec
+		<< " ready (" << m_variants.size() << " variants) - loaded from binaries:" << stats.loadedPrograms
+		<< ", compiled:" << stats.builtPrograms << ", startup time saved:" << stats.savedMilliseconds << " ms" << std::endl;
+
+	for (size_t i = 0; i < m_programCallbacks.size(); i++)
+	{
+		m_programCallbacks[i](variant, programID);
+	}
+}
+
+/***********************************************************
+ *  GetVariant()
+ *
+ *  This method is used for getting the index of the variant
+ *  with the passed in key.  A variant's build is started
+ *  the first time it is asked for.  When the driver compiles
+ *  in the background, the index is returned right away and
+ *  the program callbacks are called from Update() once it
+ *  has linked.  Otherwise the program is ready on return.
+ *  A key that fails to build returns -1 and is not built
+ *  again.
+ ***********************************************************/
+int ShaderVariants::GetVariant(uint32_t key)
+{
+	std::unordered_map<uint32_t, int>::iterator found = m_variantIndices.find(key);
+	PENDING_BUILD build;
+	VARIANT variant;
+	int index = (int)m_variants.size();
+
+	if (found != m_variantIndices.end())
+	{
+		return(found->second);
+	}
+	if (m_failedKeys.find(key) != m_failedKeys.end())
+	{
+		return(-1);
+	}
+
+	StartBuild(key, build);
+	if ((IsBuildComplete(build) == true) && (0 == FinishBuild(build)))
+	{
+		m_failedKeys[key] = true;
+		return(-1);
+	}
+
+	// the variant is added before the program callbacks are
+	// called, since they may ask for it
+	variant.key = key;
+	variant.programID = 0;
+	m_variants.push_back(variant);
+	m_variantIndices[key] = index;
+
+	if (0 != build.vertexShader)
+	{
+		build.variant = index;
+		m_pendingBuilds.push_back(build);
+	}
+	else
+	{
+		AddProgram(index, build.programID);
+	}
+
+	// a reload in progress swaps every variant, so a new one
+	// is built from the reloaded sources as well
+	if (IsReloading() == true)
+	{
+		StartReloadBuild(index);
+	}
+	return(index);
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used for picking up the builds that have
+ *  finished since the last call.  Their programs are handed
+ *  to the callbacks and drawn with from then on.  A build
+ *  that failed leaves its variant without a program, so its
+ *  draws keep being skipped until the shaders are reloaded.
+ *  A reload whose builds have all linked is swapped in.
+ ***********************************************************/
+void ShaderVariants::Update()
+{
+	size_t i = 0;
+
+	while (i < m_pendingBuilds.size())
+	{
+		if (IsBuildComplete(m_pendingBuilds[i]) == false)
+		{
+			i++;
+			continue;
+		}
+
+		PENDING_BUILD build = m_pendingBuilds[i];
+		m_pendingBuilds.erase(m_pendingBuilds.begin() + i);
+		if (0 == FinishBuild(build))
+		{
+			m_failedKeys[build.key] = true;
+		}
+		else
+		{
+			AddProgram(build.variant, build.programID);
+		}
+	}
+
+	if (IsReloading() == true)
+	{
+		UpdateReload();
+	}
+}
+
+/***********************************************************
+ *  DiscardBuild()
+ *
+ *  This method is used for deleting the shaders and program
+ *  of a build that will not be used, whether or not it has
+ *  finished.
+ ***********************************************************/
+void ShaderVariants::DiscardBuild(PENDING_BUILD& build)
+{
+	glDeleteShader(build.vertexShader);
+	glDeleteShader(build.fragmentShader);
+	glDeleteProgram(build.programID);
+	build.vertexShader = 0;
+	build.fragmentShader = 0;
+	build.programID = 0;
+}
+
+/***********************************************************
+ *  GetProgram()
+ *
+ *  This method is used for getting the program of a built
+ *  variant, or zero for an unknown index or a variant that
+ *  is still being built.
+ ***********************************************************/
+GLuint ShaderVariants::GetProgram(int variant) const
+{
+	if ((variant < 0) || (variant >= (int)m_variants.size()))
+	{
+		return(0);
+	}
+	return(m_variants[variant].programID);
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for deleting every built program,
+ *  and dropping the builds that have not finished and the
+ *  reload in progress.
+ ***********************************************************/
+void ShaderVariants::Clear()
+{
+	CancelReload();
+	for (size_t i = 0; i < m_pendingBuilds.size(); i++)
+	{
+		DiscardBuild(m_pendingBuilds[i]);
+	}
+	m_pendingBuilds.clear();
+
+	for (size_t i = 0; i < m_variants.size(); i++)
+	{
+		ReleaseProgram(m_variants[i].programID);
+	}
+	m_variants.clear();
+	m_variantIndices.clear();
+	m_failedKeys.clear();
+}
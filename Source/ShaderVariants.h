@@ -0,0 +1,233 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadervariants.h
+// ============
+// compile one program per combination of scene features, so that features
+// a draw does not use are removed by the preprocessor instead of being
+// skipped by a uniform branch in every fragment
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ProgramBinaryCache.h"
+#include "ShaderLayouts.h"
+
+#include <GL/glew.h>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/***********************************************************
+ *  ShaderVariants
+ *
+ *  This class keeps the source of the scene shaders and
+ *  builds a program for each variant key the first time it
+ *  is asked for.  A key holds the feature flags and the
+ *  number of lights, which are turned into #defines placed
+ *  after the #version line.  Variants are numbered in the
+ *  order they were built, so the number fits in the program
+ *  field of a render queue sort key.  Linked programs are
+ *  kept in a binary cache, so only the first launch on a
+ *  driver compiles them.  Reloading rebuilds every variant
+ *  from new sources in the background and swaps them in
+ *  together between frames, keeping the variant numbers, or
+ *  keeps the old programs on failure.
+ *
+ *  On OpenGL 4.6, SPIR-V modules compiled ahead of time by
+ *  Tools/CompileSpirv.cpp can be used instead of the sources
+ *  when they are newer.  This path has not been run on a
+ *  driver yet, so it is only taken when asked for with
+ *  AllowSpirv().  There is one fragment module per
+ *  set of feature flags, and the light count is set as a
+ *  specialization constant.  Reloaded sources are always
+ *  compiled from GLSL.
+ *
+ *  With KHR_parallel_shader_compile, a variant that is not
+ *  in the binary cache is compiled and linked on the
+ *  driver's threads.  Its number is handed out at once, but
+ *  its program stays zero until Update() sees the link
+ *  finish, and the draws using it are skipped until then.
+ ***********************************************************/
+class ShaderVariants
+{
+public:
+	// constructor
+	ShaderVariants();
+	// destructor
+	~ShaderVariants();
+
+	// features that are compiled into a variant, and into the
+	// fragment modules written by Tools/CompileSpirv.cpp
+	enum VARIANT_FLAGS
+	{
+		VARIANT_TEXTURED = 1 << 0,
+		VARIANT_LIT = 1 << 1,
+		// the surface color is scaled by the baked scene light,
+		// for far objects whose lighting is not worth computing
+		VARIANT_BAKED = 1 << 2,
+		// the texture is sampled through a virtual texture's
+		// page table and the shared page cache
+		VARIANT_VIRTUAL = 1 << 3,
+		// the fragment writes the virtual texture page it
+		// samples instead of its color, for the feedback pass
+		VARIANT_FEEDBACK = 1 << 4
+	};
+
+	// largest light count that gets its own fixed loop, more
+	// lights than this share the loop bounded by lightCount
+	static const int MAX_SPECIALIZED_LIGHTS = 8;
+
+	// called with each newly linked program so that its blocks
+	// can be connected to their binding points
+	typedef std::function<void(int variant, GLuint programID)> PROGRAM_CALLBACK;
+	// called with each program just before it is deleted
+	typedef std::function<void(GLuint programID)> RELEASE_CALLBACK;
+
+private:
+	// light count stored in a key that uses the dynamic loop
+	static const uint32_t DYNAMIC_LIGHT_COUNT = 0xFF;
+	// combinations of feature flags, each with its own
+	// fragment module
+	static const int FEATURE_SETS = 32;
+
+	struct VARIANT
+	{
+		uint32_t key;
+		// zero until the program has finished linking
+		GLuint programID;
+	};
+
+	// a program whose compile and link were issued but not
+	// yet checked
+	struct PENDING_BUILD
+	{
+		int variant;
+		uint32_t key;
+		uint64_t binaryKey;
+		GLuint vertexShader;
+		GLuint fragmentShader;
+		GLuint programID;
+		std::chrono::steady_clock::time_point start;
+	};
+
+	// scene shader sources without any variant defines
+	std::string m_vertexSource;
+	std::string m_fragmentSource;
+	// SPIR-V modules, the fragment modules indexed by flags
+	std::string m_vertexModule;
+	std::string m_fragmentModules[FEATURE_SETS];
+	// true when variants are built from the SPIR-V modules
+	bool m_bUseSpirv;
+	// true when up to date SPIR-V modules may be used
+	bool m_bAllowSpirv;
+	// built variants in build order
+	std::vector<VARIANT> m_variants;
+	// index of each built variant keyed by variant key
+	std::unordered_map<uint32_t, int> m_variantIndices;
+	// keys that failed to build and are not tried again
+	std::unordered_map<uint32_t, bool> m_failedKeys;
+	// programs still compiling on the driver's threads
+	std::vector<PENDING_BUILD> m_pendingBuilds;
+	// reloaded sources and the build of every variant from
+	// them, empty when no reload is in progress
+	std::string m_reloadVertexSource;
+	std::string m_reloadFragmentSource;
+	std::vector<PENDING_BUILD> m_reloadBuilds;
+	std::chrono::steady_clock::time_point m_reloadStart;
+	// true when the driver compiles programs in the background
+	bool m_bParallelCompile;
+	// functions called with each newly linked program
+	std::vector<PROGRAM_CALLBACK> m_programCallbacks;
+	// functions called with each program before it is deleted
+	std::vector<RELEASE_CALLBACK> m_releaseCallbacks;
+	// driver binaries of programs linked by earlier launches
+	ProgramBinaryCache* m_binaryCache;
+
+	// read a whole text file
+	bool ReadFile(const char* filePath, std::string& contents);
+	// replace the shared layouts section of a scene shader
+	// source, returning false when the file's copy was stale
+	bool ApplySharedLayouts(const std::string& source, LAYOUT_STAGE stage, const char* name, std::string& result) const;
+	// read the SPIR-V modules compiled from the shader files
+	bool LoadSpirvModules(const char* vertexShaderPath, const char* fragmentShaderPath);
+	// read a SPIR-V module that is newer than its source file
+	bool ReadModule(const std::string& modulePath, const char* sourcePath, std::string& module);
+	// get the #define lines of a variant key
+	std::string BuildDefines(uint32_t key) const;
+	// place the #define lines after the #version line
+	std::string InjectDefines(const std::string& source, const std::string& defines) const;
+	// start compiling one stage of a variant
+	GLuint CompileShader(GLenum type, const std::string& source);
+	// start specializing one stage of a variant from its
+	// SPIR-V module
+	GLuint SpecializeShader(GLenum type, const std::string& module, uint32_t key);
+	// write the info log of a stage that failed to compile
+	void ReportShaderErrors(GLuint shaderID, uint32_t key) const;
+	// load the program of a variant from the binary cache, or
+	// issue its compile and link without waiting for them,
+	// from the reloaded sources when asked to
+	void StartBuild(uint32_t key, PENDING_BUILD& build, bool bReload = false);
+	// true when the compile and link of a build have finished
+	bool IsBuildComplete(const PENDING_BUILD& build) const;
+	// check the link of a build and cache its program,
+	// returning zero on failure
+	GLuint FinishBuild(PENDING_BUILD& build);
+	// compile and link the program of a variant, waiting for it
+	GLuint BuildProgram(uint32_t key);
+	// hand a linked program to its variant and the callbacks
+	void AddProgram(int variant, GLuint programID);
+	// delete the shaders and program of an unused build
+	void DiscardBuild(PENDING_BUILD& build);
+	// start building a variant from the reloaded sources
+	void StartReloadBuild(int variant);
+	// check the reload builds, swapping them in once all have
+	// linked or dropping them when one fails
+	void UpdateReload();
+	// drop the reload in progress, if any
+	void CancelReload();
+	// tell the release callbacks about a program and delete it
+	void ReleaseProgram(GLuint programID);
+
+public:
+	// make the key of a feature combination
+	static uint32_t MakeKey(uint32_t flags, int lightCount);
+	// get the SPIR-V module file compiled from a shader file,
+	// for a set of feature flags or -1 for the vertex shader
+	static std::string GetModulePath(const char* sourcePath, int featureSet);
+
+	// let Load() build the variants from SPIR-V modules
+	void AllowSpirv(bool bAllow) { m_bAllowSpirv = bAllow; }
+	// read the scene shader sources
+	bool Load(const char* vertexShaderPath, const char* fragmentShaderPath);
+	// start rebuilding every variant from new sources
+	bool Reload(const std::string& vertexSource, const std::string& fragmentSource);
+	// add a function that is called with each newly linked program
+	void AddProgramCallback(const PROGRAM_CALLBACK& callback);
+	// add a function that is called before a program is deleted
+	void AddReleaseCallback(const RELEASE_CALLBACK& callback);
+	// get the index of a variant, starting its build on first
+	// use, or -1 when it could not be built
+	int GetVariant(uint32_t key);
+	// pick up the programs that finished linking since the
+	// last call, and swap in a finished reload, once per frame
+	void Update();
+	// true when the program of a variant can be drawn with
+	bool IsReady(int variant) const { return(0 != GetProgram(variant)); }
+	// get the number of variants still being built
+	int GetPendingCount() const { return((int)m_pendingBuilds.size()); }
+	// true while reloaded sources are being built
+	bool IsReloading() const { return(m_reloadBuilds.empty() == false); }
+	// get the program of a built variant, or zero while it is
+	// still being built
+	GLuint GetProgram(int variant) const;
+	// get the number of built variants
+	int GetVariantCount() const { return((int)m_variants.size()); }
+	// true when the programs are built from SPIR-V modules, whose
+	// blocks already have their binding points
+	bool UsesSpirv() const { return(m_bUseSpirv); }
+	// delete every built program
+	void Clear();
+};
@@ -0,0 +1,295 @@
+///////////////////////////////////////////////////////////////////////////////
+// shaderwatcher.cpp
+// ============
+// watch the shader source files on a background thread and hand their new
+// contents to the render loop when they are saved
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShaderWatcher.h"
+
+#include <sys/stat.h>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+/***********************************************************
+ *  ShaderWatcher()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ShaderWatcher::ShaderWatcher()
+{
+	m_bPending = false;
+	m_bRunning = false;
+	m_notifyDescriptor = -1;
+}
+
+/***********************************************************
+ *  ~ShaderWatcher()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ShaderWatcher::~ShaderWatcher()
+{
+	Stop();
+	m_files.clear();
+	m_pendingSources.clear();
+}
+
+/***********************************************************
+ *  AddFile()
+ *
+ *  This method is used for adding a file to the watched
+ *  list.  Files must be added before the watcher starts.
+ ***********************************************************/
+void ShaderWatcher::AddFile(const std::string& filePath)
+{
+	WATCHED_FILE file;
+	size_t separator = filePath.find_last_of("/\\");
+
+	file.path = filePath;
+	if (separator == std::string::npos)
+	{
+		file.directory = ".";
+		file.name = filePath;
+	}
+	else
+	{
+		file.directory = filePath.substr(0, separator);
+		file.name = filePath.substr(separator + 1);
+	}
+	file.modifiedTime = GetModifiedTime(filePath);
+	m_files.push_back(file);
+}
+
+/***********************************************************
+ *  GetModifiedTime()
+ *
+ *  This method is used for getting the last modification
+ *  time of a file, or zero when it cannot be read.
+ ***********************************************************/
+long long ShaderWatcher::GetModifiedTime(const std::string& filePath)
+{
+	struct stat fileStatus;
+
+	if (stat(filePath.c_str(), &fileStatus) != 0)
+	{
+		return(0);
+	}
+	return((long long)fileStatus.st_mtime);
+}
+
+/***********************************************************
+ *  Start()
+ *
+ *  This method is used for starting the watching thread.
+ *  On Linux the directory of each file is watched with
+ *  inotify, since editors often save by replacing the file.
+ ***********************************************************/
+bool ShaderWatcher::Start()
+{
+	if ((m_bRunning == true) || (m_files.empty() == true))
+	{
+		return(false);
+	}
+
+#ifdef __linux__
+	m_notifyDescriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (m_notifyDescriptor < 0)
+	{
+		std::cout << "ERROR: Could not start watching the shader files" << std::endl;
+		return(false);
+	}
+	for (size_t i = 0; i < m_files.size(); i++)
+	{
+		bool bWatched = false;
+		for (size_t j = 0; j < m_watchDirectories.size(); j++)
+		{
+			bWatched = bWatched || (m_watchDirectories[j] == m_files[i].directory);
+		}
+		if (bWatched == false)
+		{
+			int watch = inotify_add_watch(m_notifyDescriptor, m_files[i].directory.c_str(),
+				IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+			if (watch >= 0)
+			{
+				m_watchDescriptors.push_back(watch);
+				m_watchDirectories.push_back(m_files[i].directory);
+			}
+		}
+	}
+#endif
+
+	m_bRunning = true;
+	m_thread = std::thread(&ShaderWatcher::WatchThread, this);
+	std::cout << "INFO: Watching " << m_files.size() << " shader files for changes" << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  Stop()
+ *
+ *  This method is used for stopping the watching thread and
+ *  waiting for it to finish.
+ ***********************************************************/
+void ShaderWatcher::Stop()
+{
+	m_bRunning = false;
+	if (m_thread.joinable() == true)
+	{
+		m_thread.join();
+	}
+
+#ifdef __linux__
+	if (m_notifyDescriptor >= 0)
+	{
+		close(m_notifyDescriptor);
+	}
+#endif
+	m_notifyDescriptor = -1;
+	m_watchDescriptors.clear();
+	m_watchDirectories.clear();
+}
+
+/***********************************************************
+ *  WatchThread()
+ *
+ *  This method is the body of the watching thread.
+ ***********************************************************/
+void ShaderWatcher::WatchThread()
+{
+	while (m_bRunning == true)
+	{
+		if (WaitForChange() == true)
+		{
+			ReadSources();
+		}
+	}
+}
+
+/***********************************************************
+ *  WaitForChange()
+ *
+ *  This method is used for waiting up to POLL_MILLISECONDS
+ *  for a watched file to change.  True is returned when one
+ *  did.
+ ***********************************************************/
+bool ShaderWatcher::WaitForChange()
+{
+	bool bChanged = false;
+
+#ifdef __linux__
+	struct pollfd descriptor;
+	alignas(struct inotify_event) char buffer[4096];
+	ssize_t length = 0;
+
+	descriptor.fd = m_notifyDescriptor;
+	descriptor.events = POLLIN;
+	descriptor.revents = 0;
+	if (poll(&descriptor, 1, POLL_MILLISECONDS) <= 0)
+	{
+		return(false);
+	}
+
+	while ((length = read(m_notifyDescriptor, buffer, sizeof(buffer))) > 0)
+	{
+		for (char* next = buffer; next < buffer + length;
+			next += sizeof(struct inotify_event) + ((struct inotify_event*)next)->len)
+		{
+			const struct inotify_event* event = (const struct inotify_event*)next;
+			std::string directory;
+
+			if (event->len == 0)
+			{
+				continue;
+			}
+			for (size_t i = 0; i < m_watchDescriptors.size(); i++)
+			{
+				if (m_watchDescriptors[i] == event->wd)
+				{
+					directory = m_watchDirectories[i];
+				}
+			}
+			for (size_t i = 0; i < m_files.size(); i++)
+			{
+				if ((m_files[i].directory == directory) && (m_files[i].name == event->name))
+				{
+					bChanged = true;
+				}
+			}
+		}
+	}
+#else
+	std::this_thread::sleep_for(std::chrono::milliseconds(POLL_MILLISECONDS));
+	for (size_t i = 0; i < m_files.size(); i++)
+	{
+		long long modifiedTime = GetModifiedTime(m_files[i].path);
+		if ((modifiedTime != 0) && (modifiedTime != m_files[i].modifiedTime))
+		{
+			m_files[i].modifiedTime = modifiedTime;
+			bChanged = true;
+		}
+	}
+#endif
+
+	return(bChanged);
+}
+
+/***********************************************************
+ *  ReadSources()
+ *
+ *  This method is used for reading every watched file and
+ *  storing the contents for the render loop.  Nothing is
+ *  stored when a file cannot be read, as happens while an
+ *  editor is replacing it.
+ ***********************************************************/
+void ShaderWatcher::ReadSources()
+{
+	std::vector<std::string> sources(m_files.size());
+
+	for (size_t i = 0; i < m_files.size(); i++)
+	{
+		std::ifstream file(m_files[i].path);
+		std::stringstream stream;
+
+		if (!file.is_open())
+		{
+			return;
+		}
+		stream << file.rdbuf();
+		sources[i] = stream.str();
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_pendingSources.swap(sources);
+	m_bPending = true;
+}
+
+/***********************************************************
+ *  TakeSources()
+ *
+ *  This method is used for taking the contents of every
+ *  watched file, in the order the files were added, when a
+ *  change has been read since the last call.
+ ***********************************************************/
+bool ShaderWatcher::TakeSources(std::vector<std::string>& sources)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (m_bPending == false)
+	{
+		return(false);
+	}
+	sources.swap(m_pendingSources);
+	m_pendingSources.clear();
+	m_bPending = false;
+	return(true);
+}
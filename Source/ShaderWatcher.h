@@ -0,0 +1,83 @@
+///////////////////////////////////////////////////////////////////////////////
+// shaderwatcher.h
+// ============
+// watch the shader source files on a background thread and hand their new
+// contents to the render loop when they are saved
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  ShaderWatcher
+ *
+ *  This class waits for the watched files to change on a
+ *  thread of its own, using inotify on Linux and by polling
+ *  the modification times elsewhere.  When a file is saved,
+ *  every watched file is read again on that thread, so the
+ *  render loop only picks up finished sources between
+ *  frames and compiles them on the thread that owns the
+ *  OpenGL context.
+ ***********************************************************/
+class ShaderWatcher
+{
+public:
+	// constructor
+	ShaderWatcher();
+	// destructor
+	~ShaderWatcher();
+
+private:
+	// time between checks for a change, and the longest wait
+	// before the thread notices it has been stopped
+	static const int POLL_MILLISECONDS = 250;
+
+	struct WATCHED_FILE
+	{
+		std::string path;
+		std::string directory;
+		std::string name;
+		long long modifiedTime;
+	};
+
+	// files that are watched, in the order they were added
+	std::vector<WATCHED_FILE> m_files;
+	// contents read after the last change, not yet taken
+	std::vector<std::string> m_pendingSources;
+	bool m_bPending;
+	// guards the pending contents
+	std::mutex m_mutex;
+	// thread waiting for changes
+	std::thread m_thread;
+	// cleared to stop the thread
+	std::atomic<bool> m_bRunning;
+	// inotify descriptor and the directory of each watch
+	int m_notifyDescriptor;
+	std::vector<int> m_watchDescriptors;
+	std::vector<std::string> m_watchDirectories;
+
+	// body of the watching thread
+	void WatchThread();
+	// block until a watched file changes or the poll time ends
+	bool WaitForChange();
+	// read every watched file into the pending contents
+	void ReadSources();
+	// get the modification time of a file, or zero
+	static long long GetModifiedTime(const std::string& filePath);
+
+public:
+	// add a file to watch, before the watcher is started
+	void AddFile(const std::string& filePath);
+	// start watching on the background thread
+	bool Start();
+	// stop the background thread
+	void Stop();
+	// take the contents of every watched file when any of
+	// them changed since the last call
+	bool TakeSources(std::vector<std::string>& sources);
+};
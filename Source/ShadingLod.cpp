@@ -0,0 +1,183 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadinglod.cpp
+// ============
+// choose cheaper lighting for objects that cover little of the screen, and
+// count how many draws used each level of detail
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShadingLod.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// screen height fractions where the cheaper levels start
+	const float g_DefaultReducedThreshold = 0.05f;
+	const float g_DefaultBakedThreshold = 0.01f;
+	// the reduced level keeps the lights that reach the whole
+	// scene, which the light list uploads first
+	const int g_DefaultReducedLightCount = 1;
+
+	// names used when reporting the counts
+	const char* g_LodNames[ShadingLod::SHADING_LOD_COUNT] =
+	{
+		"full", "reduced", "baked"
+	};
+}
+
+/***********************************************************
+ *  ShadingLod()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ShadingLod::ShadingLod()
+{
+	m_projection = glm::mat4(1.0f);
+	m_reducedThreshold = g_DefaultReducedThreshold;
+	m_bakedThreshold = g_DefaultBakedThreshold;
+	m_reducedLightCount = g_DefaultReducedLightCount;
+	m_bEnabled = true;
+	memset(m_counts, 0, sizeof(m_counts));
+	memset(m_reportedCounts, 0, sizeof(m_reportedCounts));
+}
+
+/***********************************************************
+ *  ~ShadingLod()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ShadingLod::~ShadingLod()
+{
+}
+
+/***********************************************************
+ *  SetThresholds()
+ *
+ *  This method is used for setting the screen height
+ *  fractions below which the reduced and the baked levels
+ *  are used.  The baked threshold is kept at or below the
+ *  reduced one.
+ ***********************************************************/
+void ShadingLod::SetThresholds(float reducedThreshold, float bakedThreshold)
+{
+	m_reducedThreshold = std::max(reducedThreshold, 0.0f);
+	m_bakedThreshold = std::min(std::max(bakedThreshold, 0.0f), m_reducedThreshold);
+}
+
+/***********************************************************
+ *  SetReducedLightCount()
+ *
+ *  This method is used for setting how many lights, from
+ *  the start of the light list, the reduced level keeps.
+ ***********************************************************/
+void ShadingLod::SetReducedLightCount(int lightCount)
+{
+	m_reducedLightCount = std::max(lightCount, 0);
+}
+
+/***********************************************************
+ *  GetScreenSize()
+ *
+ *  This method is used for getting the height a bounding
+ *  sphere covers on screen, as a fraction of the viewport
+ *  height.  Under a perspective projection the size falls
+ *  off with the distance from the camera, and a camera
+ *  inside the sphere always sees it at full size.
+ ***********************************************************/
+float ShadingLod::GetScreenSize(glm::vec3 center, float radius, glm::vec3 viewPosition) const
+{
+	// projection[1][1] maps a view space height to half the
+	// viewport, and projection[2][3] is -1 for perspective
+	float size = radius * m_projection[1][1];
+
+	if (m_projection[2][3] != 0.0f)
+	{
+		float distance = glm::length(center - viewPosition);
+		if (distance <= radius)
+		{
+			return(1.0f);
+		}
+		size /= distance;
+	}
+	return(size);
+}
+
+/***********************************************************
+ *  GetDrawSize()
+ *
+ *  This method is used for getting the height on screen of
+ *  a draw of a mesh whose bounding sphere around its origin
+ *  has the passed in radius.  The sphere is scaled by the
+ *  largest scale of the model matrix.
+ ***********************************************************/
+float ShadingLod::GetDrawSize(const glm::mat4& model, float meshRadius, glm::vec3 viewPosition) const
+{
+	float scale = std::max(glm::length(glm::vec3(model[0])),
+		std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+
+	return(GetScreenSize(glm::vec3(model[3]), meshRadius * scale, viewPosition));
+}
+
+/***********************************************************
+ *  Select()
+ *
+ *  This method is used for choosing the level of a draw
+ *  from its height on screen.  The draw is not counted,
+ *  since it may be submitted at another level when the
+ *  variant of this one is not built yet.
+ ***********************************************************/
+ShadingLod::SHADING_LOD ShadingLod::Select(float screenSize) const
+{
+	if (m_bEnabled == false)
+	{
+		return(SHADING_LOD_FULL);
+	}
+	if (screenSize < m_bakedThreshold)
+	{
+		return(SHADING_LOD_BAKED);
+	}
+	if (screenSize < m_reducedThreshold)
+	{
+		return(SHADING_LOD_REDUCED);
+	}
+	return(SHADING_LOD_FULL);
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for clearing the counts before the
+ *  draws of a frame are chosen.  Frames that reuse the
+ *  previous frame's draws keep their counts.
+ ***********************************************************/
+void ShadingLod::BeginFrame()
+{
+	memset(m_counts, 0, sizeof(m_counts));
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for writing the number of draws at
+ *  each level to the console.  They are only written when
+ *  they differ from the previously written counts.
+ ***********************************************************/
+void ShadingLod::EndFrame()
+{
+	if (memcmp(m_counts, m_reportedCounts, sizeof(m_counts)) == 0)
+	{
+		return;
+	}
+
+	std::cout << "INFO: ShadingLod - draws";
+	for (int i = 0; i < SHADING_LOD_COUNT; i++)
+	{
+		std::cout << ", " << g_LodNames[i] << ":" << m_counts[i];
+	}
+	std::cout << std::endl;
+
+	memcpy(m_reportedCounts, m_counts, sizeof(m_counts));
+}
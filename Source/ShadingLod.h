@@ -0,0 +1,92 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadinglod.h
+// ============
+// choose cheaper lighting for objects that cover little of the screen, and
+// count how many draws used each level of detail
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  ShadingLod
+ *
+ *  This class picks the shading level of detail of a draw
+ *  from the height of its bounding sphere on screen, as a
+ *  fraction of the viewport height.  Draws at or above the
+ *  reduced threshold get every light, draws below it only
+ *  the first lights of the light list, and draws below the
+ *  baked threshold no per-light work at all.  The number of
+ *  draws submitted at each level is counted for every frame
+ *  whose draws were chosen again, and reported when it
+ *  changes.
+ ***********************************************************/
+class ShadingLod
+{
+public:
+	// constructor
+	ShadingLod();
+	// destructor
+	~ShadingLod();
+
+	// levels of detail, from the most expensive
+	enum SHADING_LOD
+	{
+		// per-fragment lighting from every light
+		SHADING_LOD_FULL = 0,
+		// per-fragment lighting from the first lights only
+		SHADING_LOD_REDUCED,
+		// surface color scaled by the scene's baked light
+		SHADING_LOD_BAKED,
+		SHADING_LOD_COUNT
+	};
+
+private:
+	// projection of the current frame
+	glm::mat4 m_projection;
+	// screen height fractions below which the cheaper levels
+	// are used
+	float m_reducedThreshold;
+	float m_bakedThreshold;
+	// number of lights kept by the reduced level
+	int m_reducedLightCount;
+	// false to draw everything at full detail
+	bool m_bEnabled;
+	// draws at each level in the current frame
+	int m_counts[SHADING_LOD_COUNT];
+	// counts that were last written to the console
+	int m_reportedCounts[SHADING_LOD_COUNT];
+
+public:
+	// set the projection that objects are measured with
+	void SetProjection(const glm::mat4& projection) { m_projection = projection; }
+	// get the projection that objects are measured with
+	const glm::mat4& GetProjection() const { return(m_projection); }
+	// set the screen height fractions below which the reduced
+	// and baked levels are used
+	void SetThresholds(float reducedThreshold, float bakedThreshold);
+	// set the number of lights kept by the reduced level
+	void SetReducedLightCount(int lightCount);
+	// get the number of lights kept by the reduced level
+	int GetReducedLightCount() const { return(m_reducedLightCount); }
+	// switch the cheaper levels on or off
+	void SetEnabled(bool bEnabled) { m_bEnabled = bEnabled; }
+
+	// get the height of a bounding sphere on screen, as a
+	// fraction of the viewport height
+	float GetScreenSize(glm::vec3 center, float radius, glm::vec3 viewPosition) const;
+	// get the height on screen of a draw of a mesh
+	float GetDrawSize(const glm::mat4& model, float meshRadius, glm::vec3 viewPosition) const;
+	// choose the level of a draw from its height on screen
+	SHADING_LOD Select(float screenSize) const;
+	// count a draw at the level it was submitted with
+	void Count(SHADING_LOD lod) { m_counts[lod]++; }
+
+	// clear the counts before the draws of a frame are chosen
+	void BeginFrame();
+	// report the counts when they have changed
+	void EndFrame();
+	// get the number of draws at a level in the current frame
+	int GetCount(SHADING_LOD lod) const { return(m_counts[lod]); }
+};
@@ -0,0 +1,487 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturearrays.cpp
+// ============
+// scene textures stored as layers of 2D texture arrays, one array for every
+// size and format, so that draws pick a texture by layer instead of binding
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureArrays.h"
+#include "TextureContainer.h"
+
+#include <algorithm>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// color shown until a texture's image has been placed
+	const unsigned char g_PlaceholderPixel[4] = { 128, 128, 128, 255 };
+
+	// unit the arrays are bound to while they are filled
+	const int g_UploadUnit = 0;
+
+	/***********************************************************
+	 *  GetLevelSize()
+	 *
+	 *  This function is used for getting the number of bytes
+	 *  of one layer of one level of an array.
+	 ***********************************************************/
+	GLsizei GetLevelSize(const TextureArrays::LAYER_FORMAT& format, int level)
+	{
+		uint32_t width = std::max(format.width >> level, 1u);
+		uint32_t height = std::max(format.height >> level, 1u);
+
+		if (format.internalFormat == GL_COMPRESSED_RGB_S3TC_DXT1_EXT)
+		{
+			return((GLsizei)GetTextureLevelSize(TEXTURE_FORMAT_BC1, width, height));
+		}
+		if (format.internalFormat == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT)
+		{
+			return((GLsizei)GetTextureLevelSize(TEXTURE_FORMAT_BC3, width, height));
+		}
+		return((GLsizei)GetTextureLevelSize(TEXTURE_FORMAT_RGBA8, width, height));
+	}
+
+	/***********************************************************
+	 *  IsSameFormat()
+	 *
+	 *  This function is used for checking whether two textures
+	 *  can share an array.
+	 ***********************************************************/
+	bool IsSameFormat(const TextureArrays::LAYER_FORMAT& a, const TextureArrays::LAYER_FORMAT& b)
+	{
+		return((a.internalFormat == b.internalFormat) && (a.width == b.width) &&
+			(a.height == b.height) && (a.levelCount == b.levelCount));
+	}
+}
+
+/***********************************************************
+ *  TextureArrays()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureArrays::TextureArrays(GLStateCache* pStateCache)
+{
+	m_pStateCache = pStateCache;
+	m_copyBuffer = 0;
+}
+
+/***********************************************************
+ *  ~TextureArrays()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TextureArrays::~TextureArrays()
+{
+	Clear();
+	m_pStateCache = NULL;
+}
+
+/***********************************************************
+ *  CreateArrayTexture()
+ *
+ *  This method is used for creating an array texture with
+ *  room for the passed in number of layers, every level
+ *  allocated and left undefined, and the scene's wrapping
+ *  and filtering parameters.  Minified draws filter between
+ *  the levels, which every placed texture fills.  The
+ *  texture is left bound to the upload unit.
+ ***********************************************************/
+GLuint TextureArrays::CreateArrayTexture(const LAYER_FORMAT& format, int layerCapacity)
+{
+	GLuint textureID = 0;
+
+	glGenTextures(1, &textureID);
+	if (0 == textureID)
+	{
+		return(0);
+	}
+
+	m_pStateCache->BindTexture(g_UploadUnit, textureID, GL_TEXTURE_2D_ARRAY);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, format.levelCount - 1);
+	for (int level = 0; level < format.levelCount; level++)
+	{
+		GLsizei width = (GLsizei)std::max(format.width >> level, 1u);
+		GLsizei height = (GLsizei)std::max(format.height >> level, 1u);
+
+		if (format.internalFormat == GL_RGBA8)
+		{
+			glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, width, height, layerCapacity, 0,
+				GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		}
+		else
+		{
+			glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, format.internalFormat, width, height,
+				layerCapacity, 0, GetLevelSize(format, level) * layerCapacity, NULL);
+		}
+	}
+	return(textureID);
+}
+
+/***********************************************************
+ *  FindFreeArray()
+ *
+ *  This method is used for getting the array that holds
+ *  textures of the passed in format and has a free layer,
+ *  growing or creating one when needed.  -1 is returned
+ *  when no texture could be created.
+ ***********************************************************/
+int TextureArrays::FindFreeArray(const LAYER_FORMAT& format)
+{
+	ARRAY_INFO info;
+
+	// array 0 only ever holds the placeholder
+	for (size_t i = 1; i < m_arrays.size(); i++)
+	{
+		ARRAY_INFO& array = m_arrays[i];
+
+		if (IsSameFormat(array.format, format) == false)
+		{
+			continue;
+		}
+		if (0 == array.textureID)
+		{
+			// the array was emptied and deleted, so it is made again
+			array.layerCount = 0;
+			array.layerCapacity = INITIAL_LAYERS;
+			array.freeLayers.clear();
+			array.textureID = CreateArrayTexture(format, array.layerCapacity);
+			return((0 == array.textureID) ? -1 : (int)i);
+		}
+		if ((array.freeLayers.empty() == false) ||
+			(array.layerCount < array.layerCapacity) ||
+			(GrowArray((int)i) == true))
+		{
+			return((int)i);
+		}
+		return(-1);
+	}
+
+	info.format = format;
+	info.layerCount = 0;
+	info.layerCapacity = INITIAL_LAYERS;
+	info.textureID = CreateArrayTexture(format, info.layerCapacity);
+	if (0 == info.textureID)
+	{
+		return(-1);
+	}
+	m_arrays.push_back(info);
+	return((int)m_arrays.size() - 1);
+}
+
+/***********************************************************
+ *  GrowArray()
+ *
+ *  This method is used for doubling the layers of a full
+ *  array.  Each level of the filled layers is read back
+ *  into a pixel buffer and written into the new texture
+ *  from it, so the texels never leave the GPU.  Texture
+ *  indices stay the same, since only the texture object of
+ *  the array changes.
+ ***********************************************************/
+bool TextureArrays::GrowArray(int array)
+{
+	ARRAY_INFO& info = m_arrays[array];
+	int layerCapacity = info.layerCapacity * 2;
+	GLuint textureID = 0;
+
+	textureID = CreateArrayTexture(info.format, layerCapacity);
+	if (0 == textureID)
+	{
+		std::cout << "ERROR: Could not grow the " << info.format.width << "x" << info.format.height
+			<< " texture array to " << layerCapacity << " layers" << std::endl;
+		return(false);
+	}
+
+	if (0 == m_copyBuffer)
+	{
+		glGenBuffers(1, &m_copyBuffer);
+	}
+	for (int level = 0; level < info.format.levelCount; level++)
+	{
+		GLsizei width = (GLsizei)std::max(info.format.width >> level, 1u);
+		GLsizei height = (GLsizei)std::max(info.format.height >> level, 1u);
+		GLsizei levelSize = GetLevelSize(info.format, level);
+
+		// every layer of the old level is read back at once
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, m_copyBuffer);
+		glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)levelSize * info.layerCapacity, NULL, GL_STREAM_COPY);
+		m_pStateCache->BindTexture(g_UploadUnit, info.textureID, GL_TEXTURE_2D_ARRAY);
+		if (info.format.internalFormat == GL_RGBA8)
+		{
+			glGetTexImage(GL_TEXTURE_2D_ARRAY, level, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		}
+		else
+		{
+			glGetCompressedTexImage(GL_TEXTURE_2D_ARRAY, level, NULL);
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_copyBuffer);
+		m_pStateCache->BindTexture(g_UploadUnit, textureID, GL_TEXTURE_2D_ARRAY);
+		if (info.format.internalFormat == GL_RGBA8)
+		{
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, 0, width, height, info.layerCount,
+				GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		}
+		else
+		{
+			glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, 0, width, height, info.layerCount,
+				info.format.internalFormat, levelSize * info.layerCount, NULL);
+		}
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+
+	m_pStateCache->ForgetTexture(info.textureID);
+	glDeleteTextures(1, &info.textureID);
+	info.textureID = textureID;
+	info.layerCapacity = layerCapacity;
+
+	std::cout << "INFO: The " << info.format.width << "x" << info.format.height
+		<< " texture array grew to " << layerCapacity << " layers" << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  ReleaseLayer()
+ *
+ *  This method is used for giving the layer of a placed
+ *  texture back to its array, to be handed out again.  An
+ *  array left holding no texture is deleted, so that the
+ *  memory of its levels is freed, and made again by the
+ *  next texture of its format.
+ ***********************************************************/
+void TextureArrays::ReleaseLayer(int texture)
+{
+	TEXTURE_ENTRY& entry = m_textures[texture];
+
+	if (entry.array <= 0)
+	{
+		return;
+	}
+
+	ARRAY_INFO& info = m_arrays[entry.array];
+	info.freeLayers.push_back(entry.layer);
+	if ((int)info.freeLayers.size() == info.layerCount)
+	{
+		m_pStateCache->ForgetTexture(info.textureID);
+		glDeleteTextures(1, &info.textureID);
+		info.textureID = 0;
+		info.layerCount = 0;
+		info.layerCapacity = 0;
+		info.freeLayers.clear();
+	}
+
+	entry.array = 0;
+	entry.layer = 0;
+}
+
+/***********************************************************
+ *  AddTexture()
+ *
+ *  This method is used for handing out the index of a new
+ *  texture, which reads the placeholder until its image is
+ *  placed.  The placeholder array is made with the first
+ *  texture.  -1 is returned when it cannot be made.
+ ***********************************************************/
+int TextureArrays::AddTexture()
+{
+	TEXTURE_ENTRY entry;
+
+	if (m_arrays.empty() == true)
+	{
+		ARRAY_INFO placeholder;
+
+		placeholder.format.internalFormat = GL_RGBA8;
+		placeholder.format.width = 1;
+		placeholder.format.height = 1;
+		placeholder.format.levelCount = 1;
+		placeholder.layerCount = 1;
+		placeholder.layerCapacity = 1;
+		placeholder.textureID = CreateArrayTexture(placeholder.format, placeholder.layerCapacity);
+		if (0 == placeholder.textureID)
+		{
+			return(-1);
+		}
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, 1, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, g_PlaceholderPixel);
+		m_arrays.push_back(placeholder);
+	}
+
+	entry.array = 0;
+	entry.layer = 0;
+	m_textures.push_back(entry);
+	return((int)m_textures.size() - 1);
+}
+
+/***********************************************************
+ *  PlaceTexture()
+ *
+ *  This method is used for giving a texture a layer of the
+ *  array for its format, which its levels are then filled
+ *  into with UploadLevel().  A texture that is already
+ *  placed moves, giving its old layer back, so its old
+ *  levels are gone and all of them must be filled again.
+ *  When no layer can be found the texture stays where it
+ *  is.  The array is left bound to the upload unit.
+ ***********************************************************/
+bool TextureArrays::PlaceTexture(int texture, const LAYER_FORMAT& format)
+{
+	int array = -1;
+	int layer = 0;
+
+	if ((texture < 0) || (texture >= (int)m_textures.size()))
+	{
+		return(false);
+	}
+
+	array = FindFreeArray(format);
+	if (array < 0)
+	{
+		return(false);
+	}
+
+	ARRAY_INFO& info = m_arrays[array];
+	if (info.freeLayers.empty() == false)
+	{
+		layer = info.freeLayers.back();
+		info.freeLayers.pop_back();
+	}
+	else
+	{
+		layer = info.layerCount;
+		info.layerCount++;
+	}
+
+	// the old layer is only given back once the new one is
+	// taken, so that it cannot empty and delete the array
+	// the texture moves into
+	ReleaseLayer(texture);
+	m_textures[texture].array = array;
+	m_textures[texture].layer = layer;
+	m_pStateCache->BindTexture(g_UploadUnit, info.textureID, GL_TEXTURE_2D_ARRAY);
+	return(true);
+}
+
+/***********************************************************
+ *  UploadLevel()
+ *
+ *  This method is used for filling one level of a placed
+ *  texture's layer.  When a pixel unpack buffer is bound,
+ *  the data pointer is an offset into it.
+ ***********************************************************/
+void TextureArrays::UploadLevel(int texture, int level, const void* data, GLsizei dataSize)
+{
+	const TEXTURE_ENTRY& entry = m_textures[texture];
+	const ARRAY_INFO& info = m_arrays[entry.array];
+	GLsizei width = (GLsizei)std::max(info.format.width >> level, 1u);
+	GLsizei height = (GLsizei)std::max(info.format.height >> level, 1u);
+
+	m_pStateCache->BindTexture(g_UploadUnit, info.textureID, GL_TEXTURE_2D_ARRAY);
+	if (info.format.internalFormat == GL_RGBA8)
+	{
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, entry.layer, width, height, 1,
+			GL_RGBA, GL_UNSIGNED_BYTE, data);
+	}
+	else
+	{
+		glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, entry.layer, width, height, 1,
+			info.format.internalFormat, dataSize, data);
+	}
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for deleting every array, which
+ *  leaves the handed out texture indices unused.
+ ***********************************************************/
+void TextureArrays::Clear()
+{
+	for (size_t i = 0; i < m_arrays.size(); i++)
+	{
+		if (0 != m_arrays[i].textureID)
+		{
+			m_pStateCache->ForgetTexture(m_arrays[i].textureID);
+			glDeleteTextures(1, &m_arrays[i].textureID);
+		}
+	}
+	m_arrays.clear();
+	m_textures.clear();
+
+	if (0 != m_copyBuffer)
+	{
+		glDeleteBuffers(1, &m_copyBuffer);
+		m_copyBuffer = 0;
+	}
+}
+
+/***********************************************************
+ *  GetArray()
+ *
+ *  This method is used for getting the array that holds a
+ *  texture, which is the placeholder array until the
+ *  texture is placed.
+ ***********************************************************/
+int TextureArrays::GetArray(int texture) const
+{
+	if ((texture < 0) || (texture >= (int)m_textures.size()))
+	{
+		return(-1);
+	}
+	return(m_textures[texture].array);
+}
+
+/***********************************************************
+ *  GetLayer()
+ *
+ *  This method is used for getting the layer of its array
+ *  that holds a texture.
+ ***********************************************************/
+int TextureArrays::GetLayer(int texture) const
+{
+	if ((texture < 0) || (texture >= (int)m_textures.size()))
+	{
+		return(0);
+	}
+	return(m_textures[texture].layer);
+}
+
+/***********************************************************
+ *  GetAllocatedBytes()
+ *
+ *  This method is used for getting the bytes of every level
+ *  of every layer the arrays have allocated, the free and
+ *  not yet handed out layers included.
+ ***********************************************************/
+size_t TextureArrays::GetAllocatedBytes() const
+{
+	size_t bytes = 0;
+
+	for (size_t i = 0; i < m_arrays.size(); i++)
+	{
+		for (int level = 0; level < m_arrays[i].format.levelCount; level++)
+		{
+			bytes += (size_t)GetLevelSize(m_arrays[i].format, level) * m_arrays[i].layerCapacity;
+		}
+	}
+	return(bytes);
+}
+
+/***********************************************************
+ *  BindArray()
+ *
+ *  This method is used for binding the texture object of an
+ *  array to a texture unit.  An array's texture object
+ *  changes when it grows, so it is looked up every time.
+ ***********************************************************/
+void TextureArrays::BindArray(int array, int unit)
+{
+	if ((array >= 0) && (array < (int)m_arrays.size()))
+	{
+		m_pStateCache->BindTexture(unit, m_arrays[array].textureID, GL_TEXTURE_2D_ARRAY);
+	}
+}
@@ -0,0 +1,115 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturearrays.h
+// ============
+// scene textures stored as layers of 2D texture arrays, one array for every
+// size and format, so that draws pick a texture by layer instead of binding
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "GLStateCache.h"
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  TextureArrays
+ *
+ *  This class hands out a texture index for every scene
+ *  texture, with no limit on their number.  Textures of the
+ *  same size, format and level count share one
+ *  GL_TEXTURE_2D_ARRAY, each in its own layer, so draws
+ *  sampling any of them can share a draw call and only the
+ *  layer travels with each draw.  A texture reads a 1x1
+ *  placeholder, the only layer of array 0, until its image
+ *  is placed, and an array that runs out of layers is grown
+ *  by copying its levels on the GPU.  A texture placed
+ *  again, at another size, gives its old layer back, and an
+ *  array left with no textures is deleted.
+ ***********************************************************/
+class TextureArrays
+{
+public:
+	// constructor
+	TextureArrays(GLStateCache* pStateCache);
+	// destructor
+	~TextureArrays();
+
+	// what every layer of an array has in common
+	struct LAYER_FORMAT
+	{
+		// GL_RGBA8 or a block compressed format
+		GLenum internalFormat;
+		uint32_t width;
+		uint32_t height;
+		int levelCount;
+	};
+
+private:
+	// layers allocated for a new array, doubled when it is full
+	static const int INITIAL_LAYERS = 4;
+
+	struct ARRAY_INFO
+	{
+		// 0 once the array's last texture has left it
+		GLuint textureID;
+		LAYER_FORMAT format;
+		// layers ever handed out, free ones included
+		int layerCount;
+		int layerCapacity;
+		// layers given back, handed out before new ones
+		std::vector<int> freeLayers;
+	};
+
+	// array and layer holding a texture
+	struct TEXTURE_ENTRY
+	{
+		int array;
+		int layer;
+	};
+
+	// pointer to the cache that drops redundant state changes
+	GLStateCache* m_pStateCache;
+	// every array, the placeholder first
+	std::vector<ARRAY_INFO> m_arrays;
+	// every texture handed out, in index order
+	std::vector<TEXTURE_ENTRY> m_textures;
+	// buffer the levels of a growing array are copied through
+	GLuint m_copyBuffer;
+
+	// allocate the levels of an array's texture
+	GLuint CreateArrayTexture(const LAYER_FORMAT& format, int layerCapacity);
+	// find the array for a format with a free layer, or make one
+	int FindFreeArray(const LAYER_FORMAT& format);
+	// double the layers of an array, keeping the filled ones
+	bool GrowArray(int array);
+	// give a texture's layer back to its array
+	void ReleaseLayer(int texture);
+
+public:
+	// add a texture that reads the placeholder, returning its index
+	int AddTexture();
+	// move a texture into a layer of the array for its format
+	bool PlaceTexture(int texture, const LAYER_FORMAT& format);
+	// fill one level of a placed texture, from the bound pixel
+	// unpack buffer when there is one
+	void UploadLevel(int texture, int level, const void* data, GLsizei dataSize);
+	// delete every array and texture
+	void Clear();
+
+	// get the array holding a texture, or -1 for no texture
+	int GetArray(int texture) const;
+	// get the layer of its array holding a texture
+	int GetLayer(int texture) const;
+	// bind the texture object of an array to a texture unit
+	void BindArray(int array, int unit);
+
+	// get the number of textures handed out
+	int GetTextureCount() const { return((int)m_textures.size()); }
+	// get the number of arrays, the placeholder included
+	int GetArrayCount() const { return((int)m_arrays.size()); }
+	// get the bytes of texture memory the arrays allocate
+	size_t GetAllocatedBytes() const;
+};
@@ -0,0 +1,188 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturecontainer.h
+// ============
+// layout of the baked texture files written by Tools/BakeTextures.cpp, which
+// hold every mip level ready to be handed to OpenGL as it is, and of the
+// virtual texture files it writes, which hold every level cut into pages
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/***********************************************************
+ *  Baked texture container
+ *
+ *  A header, followed by the data of each mip level from
+ *  the largest down to 1x1, each starting on a 16 byte
+ *  boundary.  The image is already flipped the way the
+ *  scene's texture coordinates expect.  Block compressed
+ *  levels are made of 4x4 blocks, so a level smaller than
+ *  a block still takes a whole one.  All values are little
+ *  endian.
+ ***********************************************************/
+
+// "STEX" read as a little endian integer
+const uint32_t TEXTURE_CONTAINER_MAGIC = 0x58455453;
+// incremented whenever the layout changes
+const uint32_t TEXTURE_CONTAINER_VERSION = 1;
+// enough levels for a 32768 texel wide image
+const int TEXTURE_CONTAINER_MAX_LEVELS = 16;
+// alignment of the data of each level
+const uint64_t TEXTURE_CONTAINER_ALIGNMENT = 16;
+
+// texel formats of the level data
+enum TEXTURE_CONTAINER_FORMAT
+{
+	// 4 bytes per texel
+	TEXTURE_FORMAT_RGBA8 = 0,
+	// 8 bytes per 4x4 block, opaque, 1/8 the size of RGBA8
+	TEXTURE_FORMAT_BC1,
+	// 16 bytes per 4x4 block with alpha, 1/4 the size of RGBA8
+	TEXTURE_FORMAT_BC3,
+	TEXTURE_FORMAT_COUNT
+};
+
+struct TEXTURE_CONTAINER_LEVEL
+{
+	uint32_t width;
+	uint32_t height;
+	// position of the level data from the start of the file
+	uint64_t offset;
+	uint64_t size;
+};
+
+struct TEXTURE_CONTAINER_HEADER
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t format;
+	uint32_t levelCount;
+	TEXTURE_CONTAINER_LEVEL levels[TEXTURE_CONTAINER_MAX_LEVELS];
+};
+
+// the header is read straight from the mapped file
+static_assert(sizeof(TEXTURE_CONTAINER_HEADER) == 16 + (TEXTURE_CONTAINER_MAX_LEVELS * 24),
+	"TEXTURE_CONTAINER_HEADER must not be padded");
+
+/***********************************************************
+ *  GetBakedTexturePath()
+ *
+ *  This function is used for getting the name of the baked
+ *  file of an image file, which replaces its extension.
+ ***********************************************************/
+inline std::string GetBakedTexturePath(const std::string& imagePath)
+{
+	size_t extension = imagePath.rfind('.');
+	size_t directory = imagePath.find_last_of("/\\");
+
+	if ((extension == std::string::npos) ||
+		((directory != std::string::npos) && (extension < directory)))
+	{
+		return(imagePath + ".stex");
+	}
+	return(imagePath.substr(0, extension) + ".stex");
+}
+
+/***********************************************************
+ *  GetTextureLevelSize()
+ *
+ *  This function is used for getting the number of bytes
+ *  of one level of a texture in a container format.
+ ***********************************************************/
+inline uint64_t GetTextureLevelSize(TEXTURE_CONTAINER_FORMAT format, uint32_t width, uint32_t height)
+{
+	uint64_t blocks = (uint64_t)((width + 3) / 4) * ((height + 3) / 4);
+
+	if (format == TEXTURE_FORMAT_BC1)
+	{
+		return(blocks * 8);
+	}
+	if (format == TEXTURE_FORMAT_BC3)
+	{
+		return(blocks * 16);
+	}
+	return((uint64_t)width * height * 4);
+}
+
+/***********************************************************
+ *  Virtual texture file
+ *
+ *  A header, followed by square pages of RGBA8 texels for
+ *  every level from the largest down to the level that is
+ *  a single page, level by level and row by row.  Level 0
+ *  is a square power of two, so level L has (size >> L) /
+ *  VIRTUAL_PAGE_SIZE pages across and down.  Every page
+ *  carries a border of VIRTUAL_PAGE_BORDER texels copied
+ *  from its neighbours, wrapping around the edges, so that
+ *  filtering inside a page never needs another page.  Pages
+ *  all have the same size, so a page is found from its
+ *  level and position without an index.  Written by
+ *  Tools/BakeTextures.cpp with --virtual.
+ ***********************************************************/
+
+// "SVTX" read as a little endian integer
+const uint32_t VIRTUAL_TEXTURE_MAGIC = 0x58545653;
+// incremented whenever the layout changes
+const uint32_t VIRTUAL_TEXTURE_VERSION = 1;
+// texels across a page, inside its border
+const uint32_t VIRTUAL_PAGE_SIZE = 128;
+// texels around a page copied from its neighbours
+const uint32_t VIRTUAL_PAGE_BORDER = 4;
+// texels across a page with its border
+const uint32_t VIRTUAL_PAGE_STRIDE = VIRTUAL_PAGE_SIZE + 2 * VIRTUAL_PAGE_BORDER;
+// bytes of one page, a multiple of TEXTURE_CONTAINER_ALIGNMENT
+const uint64_t VIRTUAL_PAGE_BYTES = (uint64_t)VIRTUAL_PAGE_STRIDE * VIRTUAL_PAGE_STRIDE * 4;
+// most pages across level 0, since a page table entry
+// stores page positions in bytes
+const uint32_t VIRTUAL_TEXTURE_MAX_PAGES = 256;
+
+struct VIRTUAL_TEXTURE_HEADER
+{
+	uint32_t magic;
+	uint32_t version;
+	// texels across and down level 0
+	uint32_t size;
+	uint32_t pageSize;
+	uint32_t pageBorder;
+	uint32_t levelCount;
+	// position of the first page from the start of the file
+	uint64_t dataOffset;
+};
+
+// the header is read straight from the mapped file
+static_assert(sizeof(VIRTUAL_TEXTURE_HEADER) == 32, "VIRTUAL_TEXTURE_HEADER must not be padded");
+static_assert((VIRTUAL_PAGE_BYTES % TEXTURE_CONTAINER_ALIGNMENT) == 0, "pages must stay aligned");
+
+/***********************************************************
+ *  GetVirtualTexturePath()
+ *
+ *  This function is used for getting the name of the
+ *  virtual texture file of an image file.
+ ***********************************************************/
+inline std::string GetVirtualTexturePath(const std::string& imagePath)
+{
+	std::string bakedPath = GetBakedTexturePath(imagePath);
+
+	return(bakedPath.substr(0, bakedPath.size() - 5) + ".svt");
+}
+
+/***********************************************************
+ *  GetVirtualPageIndex()
+ *
+ *  This function is used for getting the position of a
+ *  page among every page of a virtual texture, counting
+ *  the pages of the larger levels first.
+ ***********************************************************/
+inline uint64_t GetVirtualPageIndex(uint32_t size, uint32_t level, uint32_t x, uint32_t y)
+{
+	uint64_t index = 0;
+
+	for (uint32_t i = 0; i < level; i++)
+	{
+		uint64_t pages = (size >> i) / VIRTUAL_PAGE_SIZE;
+		index += pages * pages;
+	}
+	return(index + (uint64_t)y * ((size >> level) / VIRTUAL_PAGE_SIZE) + x);
+}
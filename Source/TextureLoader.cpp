@@ -0,0 +1,419 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureloader.cpp
+// ============
+// decode texture image files on a pool of worker threads and hand their
+// levels to the texture streamer on the thread that owns the OpenGL context
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureLoader.h"
+#include "MappedFile.h"
+#include "TextureContainer.h"
+
+#ifndef STB_IMAGE_IMPLEMENTATION
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#endif
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// OpenGL formats of the container formats
+	const GLenum g_ContainerFormats[TEXTURE_FORMAT_COUNT] =
+	{
+		GL_RGBA8,
+		GL_COMPRESSED_RGB_S3TC_DXT1_EXT,
+		GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+	};
+	const char* g_ContainerFormatNames[TEXTURE_FORMAT_COUNT] =
+	{
+		"RGBA8", "BC1", "BC3"
+	};
+
+	/***********************************************************
+	 *  IsContainerValid()
+	 *
+	 *  This function is used for checking that a mapped file
+	 *  is a baked texture of the current version, and that
+	 *  every level it lists lies inside the file and has the
+	 *  size its format gives it.
+	 ***********************************************************/
+	bool IsContainerValid(const MappedFile& file)
+	{
+		const TEXTURE_CONTAINER_HEADER* pHeader = (const TEXTURE_CONTAINER_HEADER*)file.GetData();
+
+		if ((file.GetSize() < sizeof(TEXTURE_CONTAINER_HEADER)) ||
+			(pHeader->magic != TEXTURE_CONTAINER_MAGIC) ||
+			(pHeader->version != TEXTURE_CONTAINER_VERSION) ||
+			(pHeader->format >= TEXTURE_FORMAT_COUNT) ||
+			(pHeader->levelCount == 0) ||
+			(pHeader->levelCount > (uint32_t)TEXTURE_CONTAINER_MAX_LEVELS))
+		{
+			return(false);
+		}
+		for (uint32_t i = 0; i < pHeader->levelCount; i++)
+		{
+			const TEXTURE_CONTAINER_LEVEL& level = pHeader->levels[i];
+			if ((level.size != GetTextureLevelSize((TEXTURE_CONTAINER_FORMAT)pHeader->format, level.width, level.height)) ||
+				(level.offset > file.GetSize()) ||
+				(level.size > file.GetSize() - level.offset))
+			{
+				return(false);
+			}
+		}
+		return(true);
+	}
+
+	/***********************************************************
+	 *  BuildMipChain()
+	 *
+	 *  This function is used for appending every mip level of
+	 *  an RGBA image to its texels, each half the size of the
+	 *  one before down to 1x1, with a box filter.  An odd edge
+	 *  repeats its last row or column.  The number of levels,
+	 *  the image included, is returned.
+	 ***********************************************************/
+	int BuildMipChain(std::vector<unsigned char>& pixels, int width, int height)
+	{
+		size_t sourceOffset = 0;
+		int levelCount = 1;
+
+		while ((width > 1) || (height > 1))
+		{
+			int levelWidth = std::max(width / 2, 1);
+			int levelHeight = std::max(height / 2, 1);
+			size_t levelOffset = pixels.size();
+
+			pixels.resize(levelOffset + (size_t)levelWidth * levelHeight * 4);
+			for (int y = 0; y < levelHeight; y++)
+			{
+				int y0 = std::min(2 * y, height - 1);
+				int y1 = std::min(2 * y + 1, height - 1);
+
+				for (int x = 0; x < levelWidth; x++)
+				{
+					int x0 = std::min(2 * x, width - 1);
+					int x1 = std::min(2 * x + 1, width - 1);
+
+					for (int c = 0; c < 4; c++)
+					{
+						int sum = pixels[sourceOffset + ((size_t)y0 * width + x0) * 4 + c] +
+							pixels[sourceOffset + ((size_t)y0 * width + x1) * 4 + c] +
+							pixels[sourceOffset + ((size_t)y1 * width + x0) * 4 + c] +
+							pixels[sourceOffset + ((size_t)y1 * width + x1) * 4 + c];
+						pixels[levelOffset + ((size_t)y * levelWidth + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+					}
+				}
+			}
+
+			sourceOffset = levelOffset;
+			width = levelWidth;
+			height = levelHeight;
+			levelCount++;
+		}
+		return(levelCount);
+	}
+}
+
+/***********************************************************
+ *  TextureLoader()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureLoader::TextureLoader(TextureArrays* pTextureArrays, TextureStreamer* pTextureStreamer)
+{
+	m_pTextureArrays = pTextureArrays;
+	m_pTextureStreamer = pTextureStreamer;
+	m_bStopping = false;
+	m_pendingCount = 0;
+}
+
+/***********************************************************
+ *  ~TextureLoader()
+ *
+ *  The destructor for the class.  Queued files that no
+ *  worker has started are dropped.
+ ***********************************************************/
+TextureLoader::~TextureLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_bStopping = true;
+		m_jobs.clear();
+	}
+	m_jobQueued.notify_all();
+	for (size_t i = 0; i < m_threads.size(); i++)
+	{
+		m_threads[i].join();
+	}
+	m_threads.clear();
+	m_decoded.clear();
+	m_pTextureArrays = NULL;
+	m_pTextureStreamer = NULL;
+}
+
+/***********************************************************
+ *  StartWorkers()
+ *
+ *  This method is used for starting one worker thread per
+ *  core, leaving one core to the render thread, up to
+ *  MAX_WORKER_THREADS.  The images are flipped vertically
+ *  on load, which is set here since stb_image keeps the
+ *  setting in a global that the workers only read.
+ ***********************************************************/
+void TextureLoader::StartWorkers()
+{
+	int threadCount = (int)std::thread::hardware_concurrency() - 1;
+
+	threadCount = std::min(std::max(threadCount, 1), (int)MAX_WORKER_THREADS);
+	stbi_set_flip_vertically_on_load(true);
+	for (int i = 0; i < threadCount; i++)
+	{
+		m_threads.push_back(std::thread(&TextureLoader::WorkerThread, this));
+	}
+}
+
+/***********************************************************
+ *  WorkerThread()
+ *
+ *  This method is used for decoding queued image files
+ *  until the loader is destroyed.  Every image is expanded
+ *  to RGBA, so that all of them can share texture arrays,
+ *  and its mipmaps are built here rather than on the render
+ *  thread.
+ ***********************************************************/
+void TextureLoader::WorkerThread()
+{
+	while (true)
+	{
+		DECODED_IMAGE image;
+		std::chrono::steady_clock::time_point start;
+		unsigned char* pixels = NULL;
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_jobQueued.wait(lock, [this]() { return((m_bStopping == true) || (m_jobs.empty() == false)); });
+			if (m_bStopping == true)
+			{
+				return;
+			}
+			image.job = m_jobs.front();
+			m_jobs.pop_front();
+		}
+
+		start = std::chrono::steady_clock::now();
+		image.width = 0;
+		image.height = 0;
+		image.levelCount = 0;
+		image.channels = 0;
+		pixels = stbi_load(image.job.filePath.c_str(), &image.width, &image.height, &image.channels, 4);
+		if (NULL != pixels)
+		{
+			image.pixels.assign(pixels, pixels + (size_t)image.width * image.height * 4);
+			stbi_image_free(pixels);
+			image.levelCount = BuildMipChain(image.pixels, image.width, image.height);
+		}
+		image.decodeMilliseconds = std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - start).count();
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_decoded.push_back(std::move(image));
+	}
+}
+
+/***********************************************************
+ *  Load()
+ *
+ *  This method is used for adding a texture that reads the
+ *  placeholder and queueing its image file to be decoded.
+ *  The returned index can be drawn with at once.  A baked
+ *  file is filled in here and nothing is queued.
+ ***********************************************************/
+int TextureLoader::Load(const char* filePath)
+{
+	int texture = m_pTextureArrays->AddTexture();
+	DECODE_JOB job;
+
+	if (texture < 0)
+	{
+		return(-1);
+	}
+	if (LoadBaked(filePath, texture) == true)
+	{
+		return(texture);
+	}
+
+	if (m_threads.empty() == true)
+	{
+		StartWorkers();
+	}
+
+	job.texture = texture;
+	job.filePath = filePath;
+	job.queuedTime = std::chrono::steady_clock::now();
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_jobs.push_back(job);
+	}
+	m_jobQueued.notify_one();
+	m_pendingCount++;
+	return(texture);
+}
+
+/***********************************************************
+ *  LoadBaked()
+ *
+ *  This method is used for handing the baked file of an
+ *  image file to the streamer, which keeps it mapped and
+ *  copies the levels it uploads straight from the mapping.
+ *  A baked file older than its image, one that fails the
+ *  checks, or one the driver cannot read is passed over.
+ ***********************************************************/
+bool TextureLoader::LoadBaked(const char* filePath, int texture)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::string bakedPath = GetBakedTexturePath(filePath);
+	const TEXTURE_CONTAINER_HEADER* pHeader = NULL;
+	TextureStreamer::TEXTURE_SOURCE source;
+	struct stat bakedStatus;
+	struct stat imageStatus;
+	double milliseconds = 0.0;
+
+	if (stat(bakedPath.c_str(), &bakedStatus) != 0)
+	{
+		return(false);
+	}
+	if ((stat(filePath, &imageStatus) == 0) && (imageStatus.st_mtime > bakedStatus.st_mtime))
+	{
+		std::cout << "INFO: " << bakedPath << " is older than " << filePath
+			<< ", the image is decoded instead" << std::endl;
+		return(false);
+	}
+	source.file.reset(new MappedFile());
+	if ((source.file->Open(bakedPath) == false) || (IsContainerValid(*source.file) == false))
+	{
+		std::cout << "ERROR: " << bakedPath << " is not a baked texture of version "
+			<< TEXTURE_CONTAINER_VERSION << ", the image is decoded instead" << std::endl;
+		return(false);
+	}
+
+	pHeader = (const TEXTURE_CONTAINER_HEADER*)source.file->GetData();
+	if ((pHeader->format != TEXTURE_FORMAT_RGBA8) && (!GLEW_EXT_texture_compression_s3tc))
+	{
+		std::cout << "INFO: The driver cannot read " << g_ContainerFormatNames[pHeader->format]
+			<< " textures, " << filePath << " is decoded instead" << std::endl;
+		return(false);
+	}
+
+	source.internalFormat = g_ContainerFormats[pHeader->format];
+	source.width = pHeader->levels[0].width;
+	source.height = pHeader->levels[0].height;
+	for (uint32_t i = 0; i < pHeader->levelCount; i++)
+	{
+		TextureStreamer::SOURCE_LEVEL level;
+		level.offset = (size_t)pHeader->levels[i].offset;
+		level.size = (size_t)pHeader->levels[i].size;
+		source.levels.push_back(level);
+	}
+
+	// the header stays mapped, since the streamer only takes
+	// over the owner of the mapping
+	if (m_pTextureStreamer->AddTexture(texture, source) == false)
+	{
+		return(false);
+	}
+
+	milliseconds = std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - start).count();
+	std::cout << "INFO: Texture " << filePath << " loaded from " << bakedPath << " - "
+		<< pHeader->levels[0].width << "x" << pHeader->levels[0].height
+		<< ", " << g_ContainerFormatNames[pHeader->format] << ", levels:" << pHeader->levelCount
+		<< ", " << milliseconds << " ms" << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used for handing every image the
+ *  workers have finished since the last call to the
+ *  streamer.  The number
+ *  of textures that stopped reading the placeholder is
+ *  returned.
+ ***********************************************************/
+int TextureLoader::Update()
+{
+	std::vector<DECODED_IMAGE> decoded;
+	int uploaded = 0;
+
+	if (m_pendingCount == 0)
+	{
+		return(0);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		decoded.swap(m_decoded);
+	}
+	for (size_t i = 0; i < decoded.size(); i++)
+	{
+		if (decoded[i].pixels.empty() == false)
+		{
+			Upload(decoded[i]);
+			uploaded++;
+		}
+		else
+		{
+			std::cout << "ERROR: Could not load image:" << decoded[i].job.filePath << std::endl;
+		}
+		m_pendingCount--;
+	}
+	return(uploaded);
+}
+
+/***********************************************************
+ *  Upload()
+ *
+ *  This method is used for handing the levels of a decoded
+ *  image to the streamer, which takes over the texels and
+ *  places the texture with its smallest levels at once.
+ ***********************************************************/
+void TextureLoader::Upload(DECODED_IMAGE& image)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	TextureStreamer::TEXTURE_SOURCE source;
+	size_t levelOffset = 0;
+	double uploadMilliseconds = 0.0;
+	double readyMilliseconds = 0.0;
+
+	source.internalFormat = GL_RGBA8;
+	source.width = (uint32_t)image.width;
+	source.height = (uint32_t)image.height;
+	for (int i = 0; i < image.levelCount; i++)
+	{
+		TextureStreamer::SOURCE_LEVEL level;
+		level.offset = levelOffset;
+		level.size = (size_t)std::max(image.width >> i, 1) * std::max(image.height >> i, 1) * 4;
+		source.levels.push_back(level);
+		levelOffset += level.size;
+	}
+	source.pixels.swap(image.pixels);
+
+	if (m_pTextureStreamer->AddTexture(image.job.texture, source) == false)
+	{
+		std::cout << "ERROR: No texture array layer is left for " << image.job.filePath << std::endl;
+		return;
+	}
+
+	uploadMilliseconds = std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - start).count();
+	readyMilliseconds = std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - image.job.queuedTime).count();
+	std::cout << "INFO: Texture " << image.job.filePath << " ready - " << image.width << "x" << image.height
+		<< ", channels:" << image.channels << ", levels:" << image.levelCount << ", decode:" << image.decodeMilliseconds
+		<< " ms, upload:" << uploadMilliseconds << " ms, " << readyMilliseconds << " ms after it was queued" << std::endl;
+}
@@ -0,0 +1,113 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureloader.h
+// ============
+// decode texture image files on a pool of worker threads and hand their
+// levels to the texture streamer on the thread that owns the OpenGL context
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "TextureArrays.h"
+#include "TextureStreamer.h"
+
+#include <GL/glew.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  TextureLoader
+ *
+ *  This class hands out a texture index for an image file
+ *  at once, reading a 1x1 placeholder, and queues the file
+ *  to be decoded by a worker thread, which also builds its
+ *  mipmaps.  Update() takes the finished images on the
+ *  render thread and hands their levels to the texture
+ *  streamer, which uploads the levels the draws need, so
+ *  the texture index never changes while the scene draws
+ *  with the placeholder.
+ *
+ *  An image baked by Tools/BakeTextures.cpp that is newer
+ *  than the image file is used instead.  The baked file is
+ *  mapped into memory and its levels, already flipped,
+ *  mipmapped and possibly block compressed, are streamed
+ *  from the mapping as they are, so nothing is queued for
+ *  it and only the levels read are paged in from disk.
+ ***********************************************************/
+class TextureLoader
+{
+public:
+	// constructor
+	TextureLoader(TextureArrays* pTextureArrays, TextureStreamer* pTextureStreamer);
+	// destructor
+	~TextureLoader();
+
+private:
+	// most worker threads started, whatever the core count
+	static const int MAX_WORKER_THREADS = 4;
+
+	struct DECODE_JOB
+	{
+		int texture;
+		std::string filePath;
+		std::chrono::steady_clock::time_point queuedTime;
+	};
+
+	struct DECODED_IMAGE
+	{
+		DECODE_JOB job;
+		// RGBA texels of every level, largest first, empty
+		// when the file could not be decoded
+		std::vector<unsigned char> pixels;
+		int width;
+		int height;
+		int levelCount;
+		// channels of the image file
+		int channels;
+		double decodeMilliseconds;
+	};
+
+	// pointer to the arrays the textures are added to
+	TextureArrays* m_pTextureArrays;
+	// pointer to the streamer that uploads their levels
+	TextureStreamer* m_pTextureStreamer;
+	// files waiting for a worker, oldest first
+	std::deque<DECODE_JOB> m_jobs;
+	// images decoded by the workers, not yet uploaded
+	std::vector<DECODED_IMAGE> m_decoded;
+	// guards the jobs, the decoded images and m_bStopping
+	std::mutex m_mutex;
+	// signalled when a job is queued or the workers must stop
+	std::condition_variable m_jobQueued;
+	// worker threads, started with the first job
+	std::vector<std::thread> m_threads;
+	// set to make the workers return
+	bool m_bStopping;
+	// textures handed out that have not been uploaded yet
+	int m_pendingCount;
+
+	// body of each worker thread
+	void WorkerThread();
+	// start the worker threads
+	void StartWorkers();
+	// hand the levels of a decoded image to the streamer
+	void Upload(DECODED_IMAGE& image);
+	// fill a texture from the baked file of an image file,
+	// returning false when there is no usable one
+	bool LoadBaked(const char* filePath, int texture);
+
+public:
+	// add a texture reading the placeholder and queue its
+	// image file to be decoded, returning -1 on failure
+	int Load(const char* filePath);
+	// hand over the images decoded since the last call, once
+	// per frame on the render thread, returning how many
+	int Update();
+	// get the number of textures still showing a placeholder
+	int GetPendingCount() const { return(m_pendingCount); }
+};
@@ -0,0 +1,429 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturestreamer.cpp
+// ============
+// keep only the mip levels of each texture that its draws need on the GPU,
+// streaming larger levels in and out under a texture memory budget
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureStreamer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// resident bytes and bytes uploaded per frame until the
+	// budget is set
+	const size_t g_DefaultBudgetBytes = 256 * 1024 * 1024;
+	const size_t g_DefaultUploadBytesPerFrame = 8 * 1024 * 1024;
+
+	const double g_BytesPerMegabyte = 1024.0 * 1024.0;
+}
+
+/***********************************************************
+ *  TextureStreamer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureStreamer::TextureStreamer(TextureArrays* pTextureArrays)
+{
+	m_pTextureArrays = pTextureArrays;
+	m_residentBytes = 0;
+	m_budgetBytes = g_DefaultBudgetBytes;
+	m_uploadBytesPerFrame = g_DefaultUploadBytesPerFrame;
+	m_viewportHeight = 1.0f;
+	m_uploadBuffer = 0;
+}
+
+/***********************************************************
+ *  ~TextureStreamer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TextureStreamer::~TextureStreamer()
+{
+	Clear();
+	if (0 != m_uploadBuffer)
+	{
+		glDeleteBuffers(1, &m_uploadBuffer);
+		m_uploadBuffer = 0;
+	}
+	m_pTextureArrays = NULL;
+}
+
+/***********************************************************
+ *  GetSourceData()
+ *
+ *  This method is used for getting the start of the data
+ *  that the level offsets of a texture source refer to.
+ ***********************************************************/
+const unsigned char* TextureStreamer::GetSourceData(const TEXTURE_SOURCE& source) const
+{
+	if (NULL != source.file)
+	{
+		return(source.file->GetData());
+	}
+	return(source.pixels.data());
+}
+
+/***********************************************************
+ *  MoveTexture()
+ *
+ *  This method is used for placing a texture in the array
+ *  whose largest level is the passed in level of the
+ *  texture, and filling it with that level and every one
+ *  after it.  The levels are copied into the pixel buffer,
+ *  whose storage is orphaned every time so the driver can
+ *  keep reading the last texture's levels, and the layer is
+ *  filled from it.  Moving to a smaller array uploads the
+ *  levels that are kept again, since the old layer goes
+ *  away with the levels that are dropped.  The number of
+ *  bytes uploaded is returned, 0 when no layer was found.
+ ***********************************************************/
+size_t TextureStreamer::MoveTexture(int texture, int level)
+{
+	STREAMED_TEXTURE& entry = m_textures[texture];
+	const TEXTURE_SOURCE& source = entry.source;
+	const unsigned char* data = GetSourceData(source);
+	size_t bytes = entry.chainBytes[level];
+	TextureArrays::LAYER_FORMAT format;
+	bool bFromBuffer = false;
+	void* mapped = NULL;
+	size_t offset = 0;
+
+	format.internalFormat = source.internalFormat;
+	format.width = std::max(source.width >> level, 1u);
+	format.height = std::max(source.height >> level, 1u);
+	format.levelCount = (int)source.levels.size() - level;
+	if (m_pTextureArrays->PlaceTexture(texture, format) == false)
+	{
+		std::cout << "ERROR: No texture array layer is left for a " << format.width << "x"
+			<< format.height << " texture" << std::endl;
+		return(0);
+	}
+
+	if (0 == m_uploadBuffer)
+	{
+		glGenBuffers(1, &m_uploadBuffer);
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_uploadBuffer);
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, NULL, GL_STREAM_DRAW);
+	mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	if (NULL != mapped)
+	{
+		for (size_t i = level; i < source.levels.size(); i++)
+		{
+			memcpy((unsigned char*)mapped + offset, data + source.levels[i].offset, source.levels[i].size);
+			offset += source.levels[i].size;
+		}
+		if (glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE)
+		{
+			// the levels are read from offsets into the buffer
+			bFromBuffer = true;
+			data = NULL;
+		}
+	}
+	if (bFromBuffer == false)
+	{
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+
+	offset = 0;
+	for (size_t i = level; i < source.levels.size(); i++)
+	{
+		size_t levelOffset = (bFromBuffer == true) ? offset : source.levels[i].offset;
+		m_pTextureArrays->UploadLevel(texture, (int)i - level, data + levelOffset, (GLsizei)source.levels[i].size);
+		offset += source.levels[i].size;
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	m_residentBytes = m_residentBytes - entry.chainBytes[entry.residentLevel] + bytes;
+	entry.residentLevel = level;
+	return(bytes);
+}
+
+/***********************************************************
+ *  Evict()
+ *
+ *  This method is used for dropping resident levels, from
+ *  the textures smallest on screen first, until the passed
+ *  in number of bytes are freed.  Textures first drop the
+ *  levels their draws do not sample.  When bBelowWanted is
+ *  true, which only a lowered budget needs, textures go on
+ *  dropping one level at a time down to the smallest ones
+ *  that are always kept.  The number of moves is returned.
+ ***********************************************************/
+int TextureStreamer::Evict(size_t bytes, bool bBelowWanted, size_t& uploadedBytes)
+{
+	std::vector<int> victims;
+	size_t freed = 0;
+	int moved = 0;
+	bool bProgress = true;
+
+	while ((freed < bytes) && (bProgress == true))
+	{
+		victims.clear();
+		for (size_t i = 0; i < m_textures.size(); i++)
+		{
+			const STREAMED_TEXTURE& entry = m_textures[i];
+			int floorLevel = (bBelowWanted == true) ? entry.minimumLevel : entry.wantedLevel;
+
+			if ((entry.bStreamed == true) && (entry.residentLevel < floorLevel))
+			{
+				victims.push_back((int)i);
+			}
+		}
+		std::sort(victims.begin(), victims.end(), [this](int a, int b)
+		{
+			return(m_textures[a].screenSize < m_textures[b].screenSize);
+		});
+
+		bProgress = false;
+		for (size_t i = 0; (i < victims.size()) && (freed < bytes); i++)
+		{
+			STREAMED_TEXTURE& entry = m_textures[victims[i]];
+			size_t residentBytes = entry.chainBytes[entry.residentLevel];
+			int level = (bBelowWanted == true) ? entry.residentLevel + 1 : entry.wantedLevel;
+			size_t moveBytes = MoveTexture(victims[i], level);
+
+			if (moveBytes > 0)
+			{
+				freed += residentBytes - moveBytes;
+				uploadedBytes += moveBytes;
+				moved++;
+				bProgress = true;
+			}
+		}
+
+		// the wanted levels are reached in one pass
+		if (bBelowWanted == false)
+		{
+			break;
+		}
+	}
+	return(moved);
+}
+
+/***********************************************************
+ *  AddTexture()
+ *
+ *  This method is used for taking over the level chain of
+ *  a loaded texture, leaving the passed in source empty,
+ *  and placing the texture with its levels of
+ *  MINIMUM_RESIDENT_SIZE texels and below, which it keeps
+ *  whatever the budget.  The larger levels are only
+ *  uploaded once a draw wants them.
+ ***********************************************************/
+bool TextureStreamer::AddTexture(int texture, TEXTURE_SOURCE& source)
+{
+	int levelCount = (int)source.levels.size();
+
+	if ((texture < 0) || (levelCount == 0))
+	{
+		return(false);
+	}
+	if (texture >= (int)m_textures.size())
+	{
+		m_textures.resize(texture + 1);
+	}
+
+	STREAMED_TEXTURE& entry = m_textures[texture];
+	if (entry.bStreamed == true)
+	{
+		m_residentBytes -= entry.chainBytes[entry.residentLevel];
+	}
+
+	entry.source = std::move(source);
+	entry.chainBytes.assign(levelCount + 1, 0);
+	for (int level = levelCount - 1; level >= 0; level--)
+	{
+		entry.chainBytes[level] = entry.chainBytes[level + 1] + entry.source.levels[level].size;
+	}
+
+	entry.minimumLevel = 0;
+	while ((entry.minimumLevel < levelCount - 1) &&
+		(std::max(entry.source.width >> entry.minimumLevel, entry.source.height >> entry.minimumLevel) > MINIMUM_RESIDENT_SIZE))
+	{
+		entry.minimumLevel++;
+	}
+
+	// nothing is resident yet, which the empty chain past the
+	// last level stands for
+	entry.residentLevel = levelCount;
+	entry.wantedLevel = entry.minimumLevel;
+	entry.screenSize = 0.0f;
+	entry.bStreamed = true;
+	if (MoveTexture(texture, entry.minimumLevel) == 0)
+	{
+		entry.bStreamed = false;
+		return(false);
+	}
+	return(true);
+}
+
+/***********************************************************
+ *  SetBudget()
+ *
+ *  This method is used for setting the most bytes of
+ *  texture levels kept on the GPU, and the most bytes
+ *  uploaded in a frame.  A texture larger than the upload
+ *  cap is still uploaded whole when it is the first in its
+ *  frame.
+ ***********************************************************/
+void TextureStreamer::SetBudget(size_t budgetBytes, size_t uploadBytesPerFrame)
+{
+	m_budgetBytes = budgetBytes;
+	m_uploadBytesPerFrame = uploadBytesPerFrame;
+}
+
+/***********************************************************
+ *  BeginRequests()
+ *
+ *  This method is used for setting every texture back to
+ *  wanting only its smallest levels, before the draws that
+ *  sample them are submitted again.  Textures no draw asks
+ *  for keep their levels until the room is needed.
+ ***********************************************************/
+void TextureStreamer::BeginRequests()
+{
+	GLint viewport[4] = { 0, 0, 0, 0 };
+
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	if (viewport[3] > 0)
+	{
+		m_viewportHeight = (float)viewport[3];
+	}
+
+	for (size_t i = 0; i < m_textures.size(); i++)
+	{
+		m_textures[i].wantedLevel = m_textures[i].minimumLevel;
+		m_textures[i].screenSize = 0.0f;
+	}
+}
+
+/***********************************************************
+ *  Request()
+ *
+ *  This method is used for wanting the levels a draw of a
+ *  texture samples.  The screen size is the height of the
+ *  draw's bounding sphere as a fraction of the viewport
+ *  height, across which the texture repeats by the larger
+ *  UV scale.  The wanted level is the largest one with no
+ *  fewer texels across than the draw covers pixels.
+ ***********************************************************/
+void TextureStreamer::Request(int texture, float screenSize, glm::vec2 uvScale)
+{
+	if ((texture < 0) || (texture >= (int)m_textures.size()) || (m_textures[texture].bStreamed == false))
+	{
+		return;
+	}
+
+	STREAMED_TEXTURE& entry = m_textures[texture];
+	float texels = (float)std::max(entry.source.width, entry.source.height) *
+		std::max(std::fabs(uvScale.x), std::fabs(uvScale.y));
+	float pixels = std::max(screenSize * m_viewportHeight, 1.0f);
+	int level = 0;
+
+	while ((level < entry.minimumLevel) && (texels * 0.5f >= pixels))
+	{
+		texels *= 0.5f;
+		level++;
+	}
+
+	entry.wantedLevel = std::min(entry.wantedLevel, level);
+	entry.screenSize = std::max(entry.screenSize, screenSize);
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used for streaming in the levels that
+ *  draws want, the textures largest on screen first, until
+ *  the frame's upload cap is reached.  A texture that does
+ *  not fit the budget first makes room from textures
+ *  holding levels no draw samples, and then streams in as
+ *  many levels as fit.  A budget that was lowered is met
+ *  first.  The number of textures that moved is returned,
+ *  since their draws must look up their layers again.
+ ***********************************************************/
+int TextureStreamer::Update()
+{
+	size_t uploadedBytes = 0;
+	int moved = 0;
+
+	if (m_residentBytes > m_budgetBytes)
+	{
+		moved += Evict(m_residentBytes - m_budgetBytes, false, uploadedBytes);
+	}
+	if (m_residentBytes > m_budgetBytes)
+	{
+		moved += Evict(m_residentBytes - m_budgetBytes, true, uploadedBytes);
+	}
+
+	m_candidates.clear();
+	for (size_t i = 0; i < m_textures.size(); i++)
+	{
+		if ((m_textures[i].bStreamed == true) && (m_textures[i].wantedLevel < m_textures[i].residentLevel))
+		{
+			m_candidates.push_back((int)i);
+		}
+	}
+	std::sort(m_candidates.begin(), m_candidates.end(), [this](int a, int b)
+	{
+		return(m_textures[a].screenSize > m_textures[b].screenSize);
+	});
+
+	for (size_t i = 0; (i < m_candidates.size()) && (uploadedBytes < m_uploadBytesPerFrame); i++)
+	{
+		STREAMED_TEXTURE& entry = m_textures[m_candidates[i]];
+		size_t otherBytes = m_residentBytes - entry.chainBytes[entry.residentLevel];
+		int level = entry.wantedLevel;
+		size_t moveBytes = 0;
+
+		if (otherBytes + entry.chainBytes[level] > m_budgetBytes)
+		{
+			moved += Evict(otherBytes + entry.chainBytes[level] - m_budgetBytes, false, uploadedBytes);
+			otherBytes = m_residentBytes - entry.chainBytes[entry.residentLevel];
+		}
+		while ((level < entry.residentLevel) && (otherBytes + entry.chainBytes[level] > m_budgetBytes))
+		{
+			level++;
+		}
+		if (level < entry.residentLevel)
+		{
+			moveBytes = MoveTexture(m_candidates[i], level);
+			if (moveBytes > 0)
+			{
+				uploadedBytes += moveBytes;
+				moved++;
+			}
+		}
+	}
+
+	if (moved > 0)
+	{
+		std::cout << "INFO: Texture streaming moved " << moved << " textures, uploading "
+			<< (uploadedBytes / g_BytesPerMegabyte) << " MB - resident "
+			<< (m_residentBytes / g_BytesPerMegabyte) << " MB of a "
+			<< (m_budgetBytes / g_BytesPerMegabyte) << " MB budget, arrays allocate "
+			<< (m_pTextureArrays->GetAllocatedBytes() / g_BytesPerMegabyte) << " MB" << std::endl;
+	}
+	return(moved);
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for dropping every texture and its
+ *  level chain.  The arrays the textures were placed in
+ *  are cleared by their owner.
+ ***********************************************************/
+void TextureStreamer::Clear()
+{
+	m_textures.clear();
+	m_candidates.clear();
+	m_residentBytes = 0;
+}
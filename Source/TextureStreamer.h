@@ -0,0 +1,133 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturestreamer.h
+// ============
+// keep only the mip levels of each texture that its draws need on the GPU,
+// streaming larger levels in and out under a texture memory budget
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MappedFile.h"
+#include "TextureArrays.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/***********************************************************
+ *  TextureStreamer
+ *
+ *  This class keeps the whole level chain of every loaded
+ *  texture in system memory, either in a mapped baked file
+ *  or in the decoded texels, and only the levels its draws
+ *  need in its texture array layer.  A texture starts with
+ *  the levels of MINIMUM_RESIDENT_SIZE texels and below.
+ *
+ *  Every draw that samples a texture passes its size on
+ *  screen, and the texture's wanted level is the largest
+ *  whose texels are no smaller than a pixel.  Update()
+ *  moves textures that want more levels into the layer of
+ *  a larger array, the ones largest on screen first, within
+ *  a budget of resident bytes and a cap on the bytes
+ *  uploaded in one frame, so loading spreads over frames.
+ *  Room is made by dropping textures that hold more levels
+ *  than they are drawn with, the smallest on screen first,
+ *  and those extra levels are kept until it is needed.
+ ***********************************************************/
+class TextureStreamer
+{
+public:
+	// constructor
+	TextureStreamer(TextureArrays* pTextureArrays);
+	// destructor
+	~TextureStreamer();
+
+	// position of one level in the data of a texture source
+	struct SOURCE_LEVEL
+	{
+		size_t offset;
+		size_t size;
+	};
+
+	// every level of a texture, largest first, held in the
+	// texels or in the file
+	struct TEXTURE_SOURCE
+	{
+		GLenum internalFormat;
+		uint32_t width;
+		uint32_t height;
+		std::vector<SOURCE_LEVEL> levels;
+		// decoded texels, empty for a mapped file
+		std::vector<unsigned char> pixels;
+		// mapped baked file, NULL for decoded texels
+		std::unique_ptr<MappedFile> file;
+	};
+
+	// largest level kept resident whatever the texture's draws
+	static const uint32_t MINIMUM_RESIDENT_SIZE = 64;
+
+private:
+	struct STREAMED_TEXTURE
+	{
+		TEXTURE_SOURCE source;
+		// false for a texture index with no source
+		bool bStreamed;
+		// largest level resident and the one the draws want
+		int residentLevel;
+		int wantedLevel;
+		// smallest largest level ever kept resident
+		int minimumLevel;
+		// largest screen size of the texture's draws
+		float screenSize;
+		// bytes of each level and every level after it
+		std::vector<size_t> chainBytes;
+	};
+
+	// pointer to the arrays the textures are placed in
+	TextureArrays* m_pTextureArrays;
+	// streamed textures by texture index
+	std::vector<STREAMED_TEXTURE> m_textures;
+	// texture indices being streamed in or out this update
+	std::vector<int> m_candidates;
+	// bytes of the levels resident on the GPU
+	size_t m_residentBytes;
+	// most resident bytes and most bytes uploaded in a frame
+	size_t m_budgetBytes;
+	size_t m_uploadBytesPerFrame;
+	// viewport height the screen sizes are measured against
+	float m_viewportHeight;
+	// pixel buffer the levels are uploaded through
+	GLuint m_uploadBuffer;
+
+	// get the data a texture's levels are read from
+	const unsigned char* GetSourceData(const TEXTURE_SOURCE& source) const;
+	// place a texture with its levels from the passed in one
+	// down, returning the number of bytes uploaded
+	size_t MoveTexture(int texture, int level);
+	// drop resident levels until the passed in number of
+	// bytes are freed, returning the number of textures moved
+	int Evict(size_t bytes, bool bBelowWanted, size_t& uploadedBytes);
+
+public:
+	// take over the level chain of a loaded texture and place
+	// its smallest levels
+	bool AddTexture(int texture, TEXTURE_SOURCE& source);
+	// set the most resident bytes and the most bytes uploaded
+	// in a frame
+	void SetBudget(size_t budgetBytes, size_t uploadBytesPerFrame);
+	// forget the wanted levels before the draws are submitted
+	void BeginRequests();
+	// want the levels a draw of a texture needs
+	void Request(int texture, float screenSize, glm::vec2 uvScale);
+	// stream levels in and out, once per frame, returning the
+	// number of textures that moved to another layer
+	int Update();
+	// drop every texture
+	void Clear();
+
+	// get the bytes of the levels resident on the GPU
+	size_t GetResidentBytes() const { return(m_residentBytes); }
+};
@@ -0,0 +1,204 @@
+///////////////////////////////////////////////////////////////////////////////
+// uniformtable.cpp
+// ============
+// resolve the uniform locations of a linked program once, keyed by names
+// that are hashed at compile time, and hand out typed uniform handles
+///////////////////////////////////////////////////////////////////////////////
+
+#include "UniformTable.h"
+#include "ShaderLayouts.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <iostream>
+#include <vector>
+
+/***********************************************************
+ *  UniformTable()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+UniformTable::UniformTable()
+{
+	m_programID = 0;
+}
+
+/***********************************************************
+ *  ~UniformTable()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+UniformTable::~UniformTable()
+{
+	m_entries.clear();
+}
+
+/***********************************************************
+ *  AddEntry()
+ *
+ *  This method is used for adding a uniform to the table
+ *  under the hash of its name.  Two names with the same
+ *  hash would make one of them unreachable, so that case
+ *  is reported.
+ ***********************************************************/
+void UniformTable::AddEntry(const std::string& name, GLint location)
+{
+	uint32_t nameHash = UniformHash(name.c_str());
+	UNIFORM_ENTRY entry;
+
+	if (m_entries.find(nameHash) != m_entries.end())
+	{
+		std::cout << "ERROR: Uniform name hash collision for " << name << std::endl;
+		return;
+	}
+
+	entry.location = location;
+	entry.slot = (int)m_entries.size();
+	m_entries[nameHash] = entry;
+}
+
+/***********************************************************
+ *  Build()
+ *
+ *  This method is used for querying every active uniform of
+ *  the passed in linked program.  Array uniforms are added
+ *  both by their base name and by each indexed element name.
+ *  Programs linked from SPIR-V need not report names or find
+ *  locations by name, so their uniforms are looked up by
+ *  index and named from the fixed locations in
+ *  ShaderLayouts.h.
+ ***********************************************************/
+void UniformTable::Build(GLuint programID)
+{
+	GLint uniformCount = 0;
+	GLint maxNameLength = 0;
+	bool bQueryByIndex = GLEW_VERSION_4_3 || GLEW_ARB_program_interface_query;
+
+	m_programID = programID;
+	m_entries.clear();
+
+	glGetProgramiv(programID, GL_ACTIVE_UNIFORMS, &uniformCount);
+	glGetProgramiv(programID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+	std::vector<GLchar> nameBuffer(maxNameLength + 1);
+
+	for (GLint i = 0; i < uniformCount; i++)
+	{
+		GLsizei nameLength = 0;
+		GLint arraySize = 0;
+		GLenum type = 0;
+		GLint location = -1;
+
+		glGetActiveUniform(programID, (GLuint)i, (GLsizei)nameBuffer.size(), &nameLength, &arraySize, &type, nameBuffer.data());
+		std::string name(nameBuffer.data(), nameLength);
+
+		// uniforms inside blocks have no location of their own
+		location = glGetUniformLocation(programID, name.c_str());
+		if ((location < 0) && (bQueryByIndex == true))
+		{
+			GLenum property = GL_LOCATION;
+			glGetProgramResourceiv(programID, GL_UNIFORM, (GLuint)i, 1, &property, 1, NULL, &location);
+		}
+		if (location < 0)
+		{
+			continue;
+		}
+		if (name.empty() == true)
+		{
+			const char* layoutName = FindLayoutUniform(location);
+			if (NULL == layoutName)
+			{
+				continue;
+			}
+			name = layoutName;
+		}
+
+		// arrays of basic types are reported once as "name[0]"
+		size_t bracket = name.rfind("[0]");
+		if ((arraySize > 1) && (bracket != std::string::npos) && (bracket + 3 == name.size()))
+		{
+			std::string baseName = name.substr(0, bracket);
+			AddEntry(baseName, location);
+			for (GLint element = 0; element < arraySize; element++)
+			{
+				std::string elementName = baseName + "[" + std::to_string(element) + "]";
+				AddEntry(elementName, glGetUniformLocation(programID, elementName.c_str()));
+			}
+		}
+		else
+		{
+			AddEntry(name, location);
+		}
+	}
+}
+
+/***********************************************************
+ *  SetUniform()
+ *
+ *  These functions are used for sending a value through a
+ *  resolved handle to the currently bound program.  Handles
+ *  for uniforms the program does not use are ignored.
+ ***********************************************************/
+void SetUniform(const UniformHandle<bool>& handle, bool value)
+{
+	if (handle.IsValid())
+	{
+		glUniform1i(handle.location, (int)value);
+	}
+}
+
+void SetUniform(const UniformHandle<int>& handle, int value)
+{
+	if (handle.IsValid())
+	{
+		glUniform1i(handle.location, value);
+	}
+}
+
+void SetUniform(const UniformHandle<float>& handle, float value)
+{
+	if (handle.IsValid())
+	{
+		glUniform1f(handle.location, value);
+	}
+}
+
+void SetUniform(const UniformHandle<glm::vec2>& handle, const glm::vec2& value)
+{
+	if (handle.IsValid())
+	{
+		glUniform2fv(handle.location, 1, glm::value_ptr(value));
+	}
+}
+
+void SetUniform(const UniformHandle<glm::vec3>& handle, const glm::vec3& value)
+{
+	if (handle.IsValid())
+	{
+		glUniform3fv(handle.location, 1, glm::value_ptr(value));
+	}
+}
+
+void SetUniform(const UniformHandle<glm::vec4>& handle, const glm::vec4& value)
+{
+	if (handle.IsValid())
+	{
+		glUniform4fv(handle.location, 1, glm::value_ptr(value));
+	}
+}
+
+void SetUniform(const UniformHandle<glm::mat3>& handle, const glm::mat3& value)
+{
+	if (handle.IsValid())
+	{
+		glUniformMatrix3fv(handle.location, 1, GL_FALSE, glm::value_ptr(value));
+	}
+}
+
+void SetUniform(const UniformHandle<glm::mat4>& handle, const glm::mat4& value)
+{
+	if (handle.IsValid())
+	{
+		glUniformMatrix4fv(handle.location, 1, GL_FALSE, glm::value_ptr(value));
+	}
+}
@@ -0,0 +1,109 @@
+///////////////////////////////////////////////////////////////////////////////
+// uniformtable.h
+// ============
+// resolve the uniform locations of a linked program once, keyed by names
+// that are hashed at compile time, and hand out typed uniform handles
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+/***********************************************************
+ *  UniformHash()
+ *
+ *  This function is used for hashing a uniform name with
+ *  32-bit FNV-1a.  It is constexpr so that names written in
+ *  the source are hashed by the compiler.
+ ***********************************************************/
+constexpr uint32_t UniformHash(const char* name, uint32_t hash = 2166136261u)
+{
+	return((*name == '\0') ? hash : UniformHash(name + 1, (hash ^ (uint8_t)*name) * 16777619u));
+}
+
+/***********************************************************
+ *  UniformHandle
+ *
+ *  A resolved uniform of type T.  The location is what is
+ *  passed to glUniform*, and the slot is a dense index that
+ *  the state cache uses to remember the last sent value.
+ ***********************************************************/
+template <typename T>
+struct UniformHandle
+{
+	GLint location;
+	int slot;
+
+	UniformHandle() : location(-1), slot(-1) {}
+	bool IsValid() const { return(location >= 0); }
+};
+
+/***********************************************************
+ *  UniformTable
+ *
+ *  This class holds the location of every active uniform of
+ *  one linked program.  The table is built once after the
+ *  program is linked, so setting a uniform through a handle
+ *  never touches a string or asks the driver for a location.
+ ***********************************************************/
+class UniformTable
+{
+public:
+	// constructor
+	UniformTable();
+	// destructor
+	~UniformTable();
+
+private:
+	struct UNIFORM_ENTRY
+	{
+		GLint location;
+		int slot;
+	};
+
+	// program the table was built from
+	GLuint m_programID;
+	// uniform locations keyed by the hash of the uniform name
+	std::unordered_map<uint32_t, UNIFORM_ENTRY> m_entries;
+
+	// add a uniform name and location to the table
+	void AddEntry(const std::string& name, GLint location);
+
+public:
+	// query the active uniforms of a linked program
+	void Build(GLuint programID);
+	// get the program the table was built from
+	GLuint GetProgramID() const { return(m_programID); }
+	// get the number of slots handed out to the uniforms
+	int GetSlotCount() const { return((int)m_entries.size()); }
+
+	// get a typed handle for the uniform with the hashed name
+	template <typename T>
+	UniformHandle<T> Get(uint32_t nameHash) const
+	{
+		UniformHandle<T> handle;
+		std::unordered_map<uint32_t, UNIFORM_ENTRY>::const_iterator found = m_entries.find(nameHash);
+
+		if (found != m_entries.end())
+		{
+			handle.location = found->second.location;
+			handle.slot = found->second.slot;
+		}
+		return(handle);
+	}
+};
+
+// send a value through a uniform handle to the bound program
+void SetUniform(const UniformHandle<bool>& handle, bool value);
+void SetUniform(const UniformHandle<int>& handle, int value);
+void SetUniform(const UniformHandle<float>& handle, float value);
+void SetUniform(const UniformHandle<glm::vec2>& handle, const glm::vec2& value);
+void SetUniform(const UniformHandle<glm::vec3>& handle, const glm::vec3& value);
+void SetUniform(const UniformHandle<glm::vec4>& handle, const glm::vec4& value);
+void SetUniform(const UniformHandle<glm::mat3>& handle, const glm::mat3& value);
+void SetUniform(const UniformHandle<glm::mat4>& handle, const glm::mat4& value);
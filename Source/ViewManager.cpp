@@ -1,258 +1,284 @@
-///////////////////////////////////////////////////////////////////////////////
-// viewmanager.cpp
-// ============
-// manage the viewing of 3D objects within the viewport - camera, projection
-//
-//  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
-//	Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
-///////////////////////////////////////////////////////////////////////////////
-
-#include "ViewManager.h"
-
-// GLM Math Header inclusions
-#include <glm/glm.hpp>
-#include <glm/gtx/transform.hpp>
-#include <glm/gtc/type_ptr.hpp>    
-
-
-float ViewManager::gLastX = 0.0f;
-float ViewManager::gLastY = 0.0f;
-bool ViewManager::gFirstMouse = true;
-float ViewManager::gDeltaTime = 0.0f;
-float ViewManager::gLastFrame = 0.0f;
-
-void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
-{
-	// Retrieve the ViewManager instance from the window
-	ViewManager* viewManager = static_cast<ViewManager*>(glfwGetWindowUserPointer(window));
-
-	// Adjust movement speed with scroll
-	viewManager->g_pCamera->ProcessMouseScroll(static_cast<float>(yoffset));
-}
-
-// declaration of the global variables and defines
-namespace
-{
-	// Variables for window width and height
-	const int WINDOW_WIDTH = 1000;
-	const int WINDOW_HEIGHT = 800;
-	const char* g_ViewName = "view";
-	const char* g_ProjectionName = "projection";
-
-	// the following variable is false when orthographic projection
-	// is off and true when it is on
-	bool bOrthographicProjection = false;
-}
-
-/***********************************************************
- *  ViewManager()
- *
- *  The constructor for the class
- ***********************************************************/
-ViewManager::ViewManager(
-	ShaderManager *pShaderManager)
-{
-	// initialize the member variables
-	m_pShaderManager = pShaderManager;
-	m_pWindow = NULL;
-	g_pCamera = new Camera();
-	// default camera view parameters
-	g_pCamera->Position = glm::vec3(0.0f, 5.0f, 20.0f);
-	g_pCamera->Front = glm::vec3(0.0f, 0.0f, -1.0f);
-	g_pCamera->Up = glm::vec3(0.0f, 1.0f, 0.0f);
-	g_pCamera->Zoom = 80;
-	g_pCamera->MovementSpeed = 20;
-}
-
-/***********************************************************
- *  ~ViewManager()
- *
- *  The destructor for the class
- ***********************************************************/
-ViewManager::~ViewManager()
-{
-	// free up allocated memory
-	m_pShaderManager = NULL;
-	m_pWindow = NULL;
-	if (NULL != g_pCamera)
-	{
-		delete g_pCamera;
-		g_pCamera = NULL;
-	}
-}
-
-/***********************************************************
- *  CreateDisplayWindow()
- *
- *  This method is used to create the main display window.
- ***********************************************************/
-GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
-{
-	GLFWwindow* window = nullptr;
-
-	// try to create the displayed OpenGL window
-	window = glfwCreateWindow(
-		WINDOW_WIDTH,
-		WINDOW_HEIGHT,
-		windowTitle,
-		NULL, NULL);
-	if (window == NULL)
-	{
-		std::cout << "Failed to create GLFW window" << std::endl;
-		glfwTerminate();
-		return NULL;
-	}
-	glfwMakeContextCurrent(window);
-	glfwSetWindowUserPointer(window, this);
-
-
-	// tell GLFW to capture all mouse events
-	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-
-	// this callback is used to receive mouse moving events
-	glfwSetCursorPosCallback(window, &ViewManager::Mouse_Position_Callback);
-	glfwSetScrollCallback(window, scroll_callback);
-
-	// enable blending for supporting tranparent rendering
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-	m_pWindow = window;
-
-	return(window);
-}
-
-/***********************************************************
- *  Mouse_Position_Callback()
- *
- *  This method is automatically called from GLFW whenever
- *  the mouse is moved within the active GLFW display window.
- ***********************************************************/
-void ViewManager::Mouse_Position_Callback(GLFWwindow* window, double xMousePos, double yMousePos)
-{
-	// Retrieve the ViewManager instance from the window
-	ViewManager* viewManager = static_cast<ViewManager*>(glfwGetWindowUserPointer(window));
-
-	// When the first mouse move event is received, this needs to be recorded so that
-	// all subsequent mouse moves can correctly calculate the X position offset and Y
-	// position offset for proper operation
-	if (viewManager->gFirstMouse)
-	{
-		viewManager->gLastX = static_cast<float>(xMousePos);
-		viewManager->gLastY = static_cast<float>(yMousePos);
-		viewManager->gFirstMouse = false;
-	}
-
-	// Calculate the X offset and Y offset values for moving the 3D camera accordingly
-	float xOffset = static_cast<float>(xMousePos) - viewManager->gLastX;
-	float yOffset = viewManager->gLastY - static_cast<float>(yMousePos); // reversed since y-coordinates go from bottom to top
-
-	// Update the last position variables
-	viewManager->gLastX = static_cast<float>(xMousePos);
-	viewManager->gLastY = static_cast<float>(yMousePos);
-
-	// Move the 3D camera according to the calculated offsets
-	viewManager->g_pCamera->ProcessMouseMovement(xOffset, yOffset);
-}
-
-/***********************************************************
- *  ProcessKeyboardEvents()
- *
- *  This method is called to process any keyboard events
- *  that may be waiting in the event queue.
- ***********************************************************/
-void ViewManager::ProcessKeyboardEvents()
-{
-	// close the window if the escape key has been pressed
-	if (glfwGetKey(m_pWindow, GLFW_KEY_ESCAPE) == GLFW_PRESS)
-	{
-		glfwSetWindowShouldClose(m_pWindow, true);
-	}
-
-	// process camera zooming in and out
-	if (glfwGetKey(m_pWindow, GLFW_KEY_W) == GLFW_PRESS)
-	{
-		g_pCamera->ProcessKeyboard(FORWARD, gDeltaTime);
-	}
-	if (glfwGetKey(m_pWindow, GLFW_KEY_S) == GLFW_PRESS)
-	{
-		g_pCamera->ProcessKeyboard(BACKWARD, gDeltaTime);
-	}
-
-	// process camera panning left and right and up and down
-	if (glfwGetKey(m_pWindow, GLFW_KEY_A) == GLFW_PRESS)
-	{
-		g_pCamera->ProcessKeyboard(LEFT, gDeltaTime);
-	}
-	if (glfwGetKey(m_pWindow, GLFW_KEY_D) == GLFW_PRESS)
-	{
-		g_pCamera->ProcessKeyboard(RIGHT, gDeltaTime);
-	}
-	if (glfwGetKey(m_pWindow, GLFW_KEY_Q) == GLFW_PRESS)
-	{
-		g_pCamera->ProcessKeyboard(UP, gDeltaTime);
-	}
-	if (glfwGetKey(m_pWindow, GLFW_KEY_E) == GLFW_PRESS)
-	{
-		g_pCamera->ProcessKeyboard(DOWN, gDeltaTime);
-	}
-
-	//Perpective and Orthographic
-	if (glfwGetKey(m_pWindow, GLFW_KEY_P) == GLFW_PRESS)
-	{
-		bOrthographicProjection = false;
-	}
-	if (glfwGetKey(m_pWindow, GLFW_KEY_O) == GLFW_PRESS)
-	{
-		bOrthographicProjection = true;
-	}
-}
-
-/***********************************************************
- *  PrepareSceneView()
- *
- *  This method is used for preparing the 3D scene by loading
- *  the shapes, textures in memory to support the 3D scene 
- *  rendering
- ***********************************************************/
-void ViewManager::PrepareSceneView()
-{
-	glm::mat4 view;
-	glm::mat4 projection;
-
-	// per-frame timing
-	float currentFrame = glfwGetTime();
-	gDeltaTime = currentFrame - gLastFrame;
-	gLastFrame = currentFrame;
-
-	// process any keyboard events that may be waiting in the 
-	// event queue
-	ProcessKeyboardEvents();
-
-	// get the current view matrix from the camera
-	view = g_pCamera->GetViewMatrix();
-
-	// Set projection matrix based on current mode
-	if (bOrthographicProjection)
-	{
-		// Orthographic projection
-		float orthoScale = 10.0f;  // Adjust this scale as needed
-		projection = glm::ortho(-orthoScale, orthoScale, -orthoScale, orthoScale, 0.1f, 100.0f);
-	}
-	else
-	{
-		// Perspective projection
-		projection = glm::perspective(glm::radians(g_pCamera->Zoom), (float)WINDOW_WIDTH / (float)WINDOW_HEIGHT, 0.1f, 100.0f);
-	}
-	// if the shader manager object is valid
-	if (NULL != m_pShaderManager)
-	{
-		// set the view matrix into the shader for proper rendering
-		m_pShaderManager->setMat4Value(g_ViewName, view);
-		// set the view matrix into the shader for proper rendering
-		m_pShaderManager->setMat4Value(g_ProjectionName, projection);
-		// set the view position of the camera into the shader for proper rendering
-		m_pShaderManager->setVec3Value("spotLight.position", g_pCamera->Position);
-		m_pShaderManager->setVec3Value("spotLight.direction", g_pCamera->Front);
-	}
+///////////////////////////////////////////////////////////////////////////////
+// viewmanager.cpp
+// ============
+// manage the viewing of 3D objects within the viewport - camera, projection
+//
+//  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
+//	Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ViewManager.h"
+
+// GLM Math Header inclusions
+#include <glm/glm.hpp>
+#include <glm/gtx/transform.hpp>
+#include <glm/gtc/type_ptr.hpp>    
+
+#include <iostream>
+
+
+float ViewManager::gLastX = 0.0f;
+float ViewManager::gLastY = 0.0f;
+bool ViewManager::gFirstMouse = true;
+float ViewManager::gDeltaTime = 0.0f;
+float ViewManager::gLastFrame = 0.0f;
+
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
+{
+	// Retrieve the ViewManager instance from the window
+	ViewManager* viewManager = static_cast<ViewManager*>(glfwGetWindowUserPointer(window));
+
+	// Adjust movement speed with scroll
+	viewManager->g_pCamera->ProcessMouseScroll(static_cast<float>(yoffset));
+}
+
+// declaration of the global variables and defines
+namespace
+{
+	// Variables for window width and height
+	const int WINDOW_WIDTH = 1000;
+	const int WINDOW_HEIGHT = 800;
+
+	// the following variable is false when orthographic projection
+	// is off and true when it is on
+	bool bOrthographicProjection = false;
+}
+
+/***********************************************************
+ *  ViewManager()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ViewManager::ViewManager(
+	GLStateCache* pStateCache)
+{
+	// initialize the member variables
+	m_pStateCache = pStateCache;
+	m_pWindow = NULL;
+	m_frameUniforms = new FrameUniformBuffer();
+	m_projection = glm::mat4(1.0f);
+	g_pCamera = new Camera();
+	// default camera view parameters
+	g_pCamera->Position = glm::vec3(0.0f, 5.0f, 20.0f);
+	g_pCamera->Front = glm::vec3(0.0f, 0.0f, -1.0f);
+	g_pCamera->Up = glm::vec3(0.0f, 1.0f, 0.0f);
+	g_pCamera->Zoom = 80;
+	g_pCamera->MovementSpeed = 20;
+}
+
+/***********************************************************
+ *  ~ViewManager()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ViewManager::~ViewManager()
+{
+	// free up allocated memory
+	m_pStateCache = NULL;
+	m_pWindow = NULL;
+	if (NULL != m_frameUniforms)
+	{
+		delete m_frameUniforms;
+		m_frameUniforms = NULL;
+	}
+	if (NULL != g_pCamera)
+	{
+		delete g_pCamera;
+		g_pCamera = NULL;
+	}
+}
+
+/***********************************************************
+ *  CreateDisplayWindow()
+ *
+ *  This method is used to create the main display window.
+ ***********************************************************/
+GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
+{
+	GLFWwindow* window = nullptr;
+
+	// try to create the displayed OpenGL window
+	window = glfwCreateWindow(
+		WINDOW_WIDTH,
+		WINDOW_HEIGHT,
+		windowTitle,
+		NULL, NULL);
+	if (window == NULL)
+	{
+		std::cout << "Failed to create GLFW window" << std::endl;
+		glfwTerminate();
+		return NULL;
+	}
+	glfwMakeContextCurrent(window);
+	glfwSetWindowUserPointer(window, this);
+
+
+	// tell GLFW to capture all mouse events
+	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+	// this callback is used to receive mouse moving events
+	glfwSetCursorPosCallback(window, &ViewManager::Mouse_Position_Callback);
+	glfwSetScrollCallback(window, scroll_callback);
+
+	// enable blending for supporting tranparent rendering
+	m_pStateCache->Enable(GL_BLEND);
+	m_pStateCache->BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	m_pWindow = window;
+
+	return(window);
+}
+
+/***********************************************************
+ *  Mouse_Position_Callback()
+ *
+ *  This method is automatically called from GLFW whenever
+ *  the mouse is moved within the active GLFW display window.
+ ***********************************************************/
+void ViewManager::Mouse_Position_Callback(GLFWwindow* window, double xMousePos, double yMousePos)
+{
+	// Retrieve the ViewManager instance from the window
+	ViewManager* viewManager = static_cast<ViewManager*>(glfwGetWindowUserPointer(window));
+
+	// When the first mouse move event is received, this needs to be recorded so that
+	// all subsequent mouse moves can correctly calculate the X position offset and Y
+	// position offset for proper operation
+	if (viewManager->gFirstMouse)
+	{
+		viewManager->gLastX = static_cast<float>(xMousePos);
+		viewManager->gLastY = static_cast<float>(yMousePos);
+		viewManager->gFirstMouse = false;
+	}
+
+	// Calculate the X offset and Y offset values for moving the 3D camera accordingly
+	float xOffset = static_cast<float>(xMousePos) - viewManager->gLastX;
+	float yOffset = viewManager->gLastY - static_cast<float>(yMousePos); // reversed since y-coordinates go from bottom to top
+
+	// Update the last position variables
+	viewManager->gLastX = static_cast<float>(xMousePos);
+	viewManager->gLastY = static_cast<float>(yMousePos);
+
+	// Move the 3D camera according to the calculated offsets
+	viewManager->g_pCamera->ProcessMouseMovement(xOffset, yOffset);
+}
+
+/***********************************************************
+ *  ProcessKeyboardEvents()
+ *
+ *  This method is called to process any keyboard events
+ *  that may be waiting in the event queue.
+ ***********************************************************/
+void ViewManager::ProcessKeyboardEvents()
+{
+	// close the window if the escape key has been pressed
+	if (glfwGetKey(m_pWindow, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+	{
+		glfwSetWindowShouldClose(m_pWindow, true);
+	}
+
+	// process camera zooming in and out
+	if (glfwGetKey(m_pWindow, GLFW_KEY_W) == GLFW_PRESS)
+	{
+		g_pCamera->ProcessKeyboard(FORWARD, gDeltaTime);
+	}
+	if (glfwGetKey(m_pWindow, GLFW_KEY_S) == GLFW_PRESS)
+	{
+		g_pCamera->ProcessKeyboard(BACKWARD, gDeltaTime);
+	}
+
+	// process camera panning left and right and up and down
+	if (glfwGetKey(m_pWindow, GLFW_KEY_A) == GLFW_PRESS)
+	{
+		g_pCamera->ProcessKeyboard(LEFT, gDeltaTime);
+	}
+	if (glfwGetKey(m_pWindow, GLFW_KEY_D) == GLFW_PRESS)
+	{
+		g_pCamera->ProcessKeyboard(RIGHT, gDeltaTime);
+	}
+	if (glfwGetKey(m_pWindow, GLFW_KEY_Q) == GLFW_PRESS)
+	{
+		g_pCamera->ProcessKeyboard(UP, gDeltaTime);
+	}
+	if (glfwGetKey(m_pWindow, GLFW_KEY_E) == GLFW_PRESS)
+	{
+		g_pCamera->ProcessKeyboard(DOWN, gDeltaTime);
+	}
+
+	//Perpective and Orthographic
+	if (glfwGetKey(m_pWindow, GLFW_KEY_P) == GLFW_PRESS)
+	{
+		bOrthographicProjection = false;
+	}
+	if (glfwGetKey(m_pWindow, GLFW_KEY_O) == GLFW_PRESS)
+	{
+		bOrthographicProjection = true;
+	}
+}
+
+/***********************************************************
+ *  AttachProgram()
+ *
+ *  This method is used for connecting the passed in shader
+ *  program to the per-frame camera values.  It must be
+ *  called for every program after its shaders are loaded.
+ ***********************************************************/
+void ViewManager::AttachProgram(GLuint programID)
+{
+	m_frameUniforms->AttachProgram(programID);
+}
+
+/***********************************************************
+ *  PrepareSceneView()
+ *
+ *  This method is used for preparing the 3D scene by loading
+ *  the shapes, textures in memory to support the 3D scene 
+ *  rendering
+ ***********************************************************/
+void ViewManager::PrepareSceneView()
+{
+	glm::mat4 view;
+	glm::mat4 projection;
+
+	// per-frame timing
+	float currentFrame = glfwGetTime();
+	gDeltaTime = currentFrame - gLastFrame;
+	gLastFrame = currentFrame;
+
+	// process any keyboard events that may be waiting in the 
+	// event queue
+	ProcessKeyboardEvents();
+
+	// get the current view matrix from the camera
+	view = g_pCamera->GetViewMatrix();
+
+	// Set projection matrix based on current mode
+	if (bOrthographicProjection)
+	{
+		// Orthographic projection
+		float orthoScale = 10.0f;  // Adjust this scale as needed
+		projection = glm::ortho(-orthoScale, orthoScale, -orthoScale, orthoScale, 0.1f, 100.0f);
+	}
+	else
+	{
+		// Perspective projection
+		projection = glm::perspective(glm::radians(g_pCamera->Zoom), (float)WINDOW_WIDTH / (float)WINDOW_HEIGHT, 0.1f, 100.0f);
+	}
+	m_projection = projection;
+
+	// if the per-frame buffer object is valid
+	if (NULL != m_frameUniforms)
+	{
+		FrameUniformBuffer::FRAME_DATA frameData;
+
+		// the camera values are shared by every program, so
+		// they are written once into the per-frame buffer
+		frameData.view = view;
+		frameData.projection = projection;
+		frameData.viewProjection = projection * view;
+		frameData.cameraPosition = glm::vec4(g_pCamera->Position, 1.0f);
+		frameData.cameraDirection = glm::vec4(g_pCamera->Front, 0.0f);
+		frameData.time = currentFrame;
+		frameData.padding[0] = frameData.padding[1] = frameData.padding[2] = 0.0f;
+		m_frameUniforms->Update(frameData);
+	}
 }
\ No newline at end of file
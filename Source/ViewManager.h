@@ -1,51 +1,60 @@
-///////////////////////////////////////////////////////////////////////////////
-// viewmanager.h
-// ============
-// manage the viewing of 3D objects within the viewport - camera, projection
-//
-//  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
-//	Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
-///////////////////////////////////////////////////////////////////////////////
-
-#pragma once
-
-#include "ShaderManager.h"
-#include "camera.h"
-
-// GLFW library
-#include "GLFW/glfw3.h" 
-
-class ViewManager
-{
-public:
-	// constructor
-	ViewManager(
-		ShaderManager* pShaderManager);
-	// destructor
-	~ViewManager();
-
-	// mouse position callback for mouse interaction with the 3D scene
-	static void Mouse_Position_Callback(GLFWwindow* window, double xMousePos, double yMousePos);
-	Camera* g_pCamera;
-
-private:
-	// pointer to shader manager object
-	ShaderManager* m_pShaderManager;
-	// active OpenGL display window
-	GLFWwindow* m_pWindow;
-
-	// process keyboard events for interaction with the 3D scene
-	void ProcessKeyboardEvents();
-	static float gLastX;
-	static float gLastY;
-	static bool gFirstMouse;
-	static float gDeltaTime;
-	static float gLastFrame;
-
-public:
-	// create the initial OpenGL display window
-	GLFWwindow* CreateDisplayWindow(const char* windowTitle);
-	
-	// prepare the conversion from 3D object display to 2D scene display
-	void PrepareSceneView();
+///////////////////////////////////////////////////////////////////////////////
+// viewmanager.h
+// ============
+// manage the viewing of 3D objects within the viewport - camera, projection
+//
+//  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
+//	Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "GLStateCache.h"
+#include "FrameUniformBuffer.h"
+#include "camera.h"
+
+// GLFW library
+#include "GLFW/glfw3.h" 
+
+class ViewManager
+{
+public:
+	// constructor
+	ViewManager(
+		GLStateCache* pStateCache);
+	// destructor
+	~ViewManager();
+
+	// mouse position callback for mouse interaction with the 3D scene
+	static void Mouse_Position_Callback(GLFWwindow* window, double xMousePos, double yMousePos);
+	Camera* g_pCamera;
+
+private:
+	// pointer to the cache that drops redundant state changes
+	GLStateCache* m_pStateCache;
+	// active OpenGL display window
+	GLFWwindow* m_pWindow;
+	// camera values shared by every program
+	FrameUniformBuffer* m_frameUniforms;
+	// projection of the last prepared frame
+	glm::mat4 m_projection;
+
+	// process keyboard events for interaction with the 3D scene
+	void ProcessKeyboardEvents();
+	static float gLastX;
+	static float gLastY;
+	static bool gFirstMouse;
+	static float gDeltaTime;
+	static float gLastFrame;
+
+public:
+	// create the initial OpenGL display window
+	GLFWwindow* CreateDisplayWindow(const char* windowTitle);
+	
+	// connect a shader program to the per-frame camera values
+	void AttachProgram(GLuint programID);
+	// prepare the conversion from 3D object display to 2D scene display
+	void PrepareSceneView();
+	// get the projection of the last prepared frame
+	const glm::mat4& GetProjection() const { return(m_projection); }
 };
\ No newline at end of file
@@ -0,0 +1,930 @@
+///////////////////////////////////////////////////////////////////////////////
+// virtualtextures.cpp
+// ============
+// draw textures larger than video memory by keeping only the pages the
+// frame samples in a shared page cache, loading them from the tiled files
+// written by Tools/BakeTextures.cpp as a feedback pass asks for them
+///////////////////////////////////////////////////////////////////////////////
+
+#include "VirtualTextures.h"
+#include "TextureContainer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// texture unit the page cache and page tables are bound
+	// to while they are written
+	const int g_UploadUnit = 0;
+
+	/***********************************************************
+	 *  IsVirtualTextureValid()
+	 *
+	 *  This function is used for checking that a mapped file
+	 *  is a virtual texture of the current version, with the
+	 *  page layout this build reads, and that all of its pages
+	 *  lie inside the file.
+	 ***********************************************************/
+	bool IsVirtualTextureValid(const MappedFile& file)
+	{
+		const VIRTUAL_TEXTURE_HEADER* pHeader = (const VIRTUAL_TEXTURE_HEADER*)file.GetData();
+		uint32_t levelCount = 1;
+		uint64_t pageCount = 0;
+
+		if ((file.GetSize() < sizeof(VIRTUAL_TEXTURE_HEADER)) ||
+			(pHeader->magic != VIRTUAL_TEXTURE_MAGIC) ||
+			(pHeader->version != VIRTUAL_TEXTURE_VERSION) ||
+			(pHeader->pageSize != VIRTUAL_PAGE_SIZE) ||
+			(pHeader->pageBorder != VIRTUAL_PAGE_BORDER) ||
+			(pHeader->size < VIRTUAL_PAGE_SIZE) ||
+			(pHeader->size > VIRTUAL_PAGE_SIZE * VIRTUAL_TEXTURE_MAX_PAGES) ||
+			((pHeader->size & (pHeader->size - 1)) != 0))
+		{
+			return(false);
+		}
+
+		while ((pHeader->size >> levelCount) >= VIRTUAL_PAGE_SIZE)
+		{
+			levelCount++;
+		}
+		if (pHeader->levelCount != levelCount)
+		{
+			return(false);
+		}
+
+		pageCount = GetVirtualPageIndex(pHeader->size, levelCount, 0, 0);
+		return((pHeader->dataOffset <= file.GetSize()) &&
+			(pageCount * VIRTUAL_PAGE_BYTES <= file.GetSize() - pHeader->dataOffset));
+	}
+}
+
+/***********************************************************
+ *  VirtualTextures()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+VirtualTextures::VirtualTextures(GLStateCache* pStateCache)
+{
+	m_pStateCache = pStateCache;
+	m_cacheTextureID = 0;
+	m_generation = 0;
+	m_frame = 0;
+	m_feedbackFramebuffer = 0;
+	m_feedbackColor = 0;
+	m_feedbackDepth = 0;
+	m_feedbackWidth = 0;
+	m_feedbackHeight = 0;
+	for (int i = 0; i < READBACK_COUNT; i++)
+	{
+		m_readbacks[i].bufferID = 0;
+		m_readbacks[i].fence = 0;
+		m_readbacks[i].width = 0;
+		m_readbacks[i].height = 0;
+	}
+	m_nextReadback = 0;
+	m_savedFramebuffer = 0;
+	memset(m_savedViewport, 0, sizeof(m_savedViewport));
+	m_bSavedBlend = false;
+	m_bFeedbackSupported = true;
+	m_bStopping = false;
+}
+
+/***********************************************************
+ *  ~VirtualTextures()
+ *
+ *  The destructor for the class.  The worker is stopped
+ *  before the files it copies from are released.
+ ***********************************************************/
+VirtualTextures::~VirtualTextures()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_bStopping = true;
+		m_requests.clear();
+	}
+	m_pageQueued.notify_all();
+	if (m_thread.joinable() == true)
+	{
+		m_thread.join();
+	}
+	Clear();
+	m_pStateCache = NULL;
+}
+
+/***********************************************************
+ *  MakePageKey()
+ *
+ *  This method is used for packing the virtual texture ID,
+ *  level and page position of a page into one key.
+ ***********************************************************/
+VirtualTextures::PAGE_KEY VirtualTextures::MakePageKey(int texture, uint32_t level, uint32_t x, uint32_t y)
+{
+	return(((PAGE_KEY)texture << 40) | ((PAGE_KEY)level << 32) | ((PAGE_KEY)y << 16) | (PAGE_KEY)x);
+}
+
+/***********************************************************
+ *  SplitPageKey()
+ *
+ *  This method is used for getting the parts of a page key.
+ ***********************************************************/
+void VirtualTextures::SplitPageKey(PAGE_KEY key, int& texture, uint32_t& level, uint32_t& x, uint32_t& y)
+{
+	texture = (int)(key >> 40);
+	level = (uint32_t)(key >> 32) & 0xFF;
+	y = (uint32_t)(key >> 16) & 0xFFFF;
+	x = (uint32_t)key & 0xFFFF;
+}
+
+/***********************************************************
+ *  WorkerThread()
+ *
+ *  This method is used for copying queued pages out of
+ *  their mapped files until the class is destroyed.  The
+ *  copy is what reads the page from disk, so the render
+ *  thread only ever touches pages already in memory.
+ ***********************************************************/
+void VirtualTextures::WorkerThread()
+{
+	while (true)
+	{
+		PAGE_REQUEST request;
+		LOADED_PAGE page;
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_pageQueued.wait(lock, [this]() { return((m_bStopping == true) || (m_requests.empty() == false)); });
+			if (m_bStopping == true)
+			{
+				return;
+			}
+			request = m_requests.front();
+			m_requests.pop_front();
+		}
+
+		page.key = request.key;
+		page.generation = request.generation;
+		page.texels.assign(request.file->GetData() + request.offset,
+			request.file->GetData() + request.offset + VIRTUAL_PAGE_BYTES);
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_loaded.push_back(std::move(page));
+	}
+}
+
+/***********************************************************
+ *  CreateCache()
+ *
+ *  This method is used for creating the page cache texture,
+ *  CACHE_PAGES pages across and down with their borders,
+ *  and putting every slot in the least recently used list.
+ *  Pages are sampled from one level with bilinear
+ *  filtering, and the borders keep the filter inside the
+ *  page.
+ ***********************************************************/
+bool VirtualTextures::CreateCache()
+{
+	GLsizei cacheSize = CACHE_PAGES * VIRTUAL_PAGE_STRIDE;
+
+	glGenTextures(1, &m_cacheTextureID);
+	if (0 == m_cacheTextureID)
+	{
+		return(false);
+	}
+
+	m_pStateCache->BindTexture(g_UploadUnit, m_cacheTextureID, GL_TEXTURE_2D);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, cacheSize, cacheSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+	m_slots.resize(CACHE_PAGES * CACHE_PAGES);
+	m_lru.clear();
+	for (size_t i = 0; i < m_slots.size(); i++)
+	{
+		m_slots[i].key = INVALID_PAGE_KEY;
+		m_slots[i].bLocked = false;
+		m_slots[i].usedFrame = 0;
+		m_slots[i].lruEntry = m_lru.insert(m_lru.end(), (int)i);
+	}
+
+	std::cout << "INFO: Virtual texture page cache - " << cacheSize << "x" << cacheSize
+		<< ", pages:" << m_slots.size() << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  EvictSlot()
+ *
+ *  This method is used for removing the page held by the
+ *  passed in slot from its page table, which falls back to
+ *  the finest page above it once it is written again.
+ ***********************************************************/
+void VirtualTextures::EvictSlot(int slot)
+{
+	CACHE_SLOT& cacheSlot = m_slots[slot];
+	int textureIndex = -1;
+	uint32_t level = 0;
+	uint32_t x = 0;
+	uint32_t y = 0;
+
+	if (cacheSlot.key == INVALID_PAGE_KEY)
+	{
+		return;
+	}
+
+	SplitPageKey(cacheSlot.key, textureIndex, level, x, y);
+	if (textureIndex < (int)m_textures.size())
+	{
+		VIRTUAL_TEXTURE& texture = m_textures[textureIndex];
+		texture.pageSlots[GetVirtualPageIndex(texture.size, level, x, y)] = -1;
+		texture.bTableDirty = true;
+	}
+	cacheSlot.key = INVALID_PAGE_KEY;
+}
+
+/***********************************************************
+ *  AcquireSlot()
+ *
+ *  This method is used for getting the least recently used
+ *  slot for a new page.  When that slot holds a page the
+ *  last feedback asked for, every slot does, and -1 is
+ *  returned rather than replacing a page still in view.
+ ***********************************************************/
+int VirtualTextures::AcquireSlot()
+{
+	int slot = -1;
+
+	if (m_lru.empty() == true)
+	{
+		return(-1);
+	}
+
+	slot = m_lru.back();
+	if ((m_slots[slot].key != INVALID_PAGE_KEY) && (m_slots[slot].usedFrame == m_frame))
+	{
+		return(-1);
+	}
+	EvictSlot(slot);
+	return(slot);
+}
+
+/***********************************************************
+ *  TouchSlot()
+ *
+ *  This method is used for marking the page in a slot as
+ *  sampled this frame, moving it to the front of the least
+ *  recently used list.  Locked slots are not in the list.
+ ***********************************************************/
+void VirtualTextures::TouchSlot(int slot)
+{
+	CACHE_SLOT& cacheSlot = m_slots[slot];
+
+	if (cacheSlot.bLocked == true)
+	{
+		return;
+	}
+	cacheSlot.usedFrame = m_frame;
+	m_lru.splice(m_lru.begin(), m_lru, cacheSlot.lruEntry);
+}
+
+/***********************************************************
+ *  StorePage()
+ *
+ *  This method is used for copying the texels of a page,
+ *  border included, into a cache slot and recording the
+ *  slot in the page's texture, whose page table is written
+ *  again at the end of the update.
+ ***********************************************************/
+void VirtualTextures::StorePage(PAGE_KEY key, int slot, const unsigned char* pTexels)
+{
+	int textureIndex = -1;
+	uint32_t level = 0;
+	uint32_t x = 0;
+	uint32_t y = 0;
+
+	SplitPageKey(key, textureIndex, level, x, y);
+	VIRTUAL_TEXTURE& texture = m_textures[textureIndex];
+
+	m_pStateCache->BindTexture(g_UploadUnit, m_cacheTextureID, GL_TEXTURE_2D);
+	glTexSubImage2D(GL_TEXTURE_2D, 0,
+		(slot % CACHE_PAGES) * VIRTUAL_PAGE_STRIDE, (slot / CACHE_PAGES) * VIRTUAL_PAGE_STRIDE,
+		VIRTUAL_PAGE_STRIDE, VIRTUAL_PAGE_STRIDE, GL_RGBA, GL_UNSIGNED_BYTE, pTexels);
+
+	m_slots[slot].key = key;
+	m_slots[slot].usedFrame = m_frame;
+	texture.pageSlots[GetVirtualPageIndex(texture.size, level, x, y)] = slot;
+	texture.bTableDirty = true;
+}
+
+/***********************************************************
+ *  WritePageTable()
+ *
+ *  This method is used for writing every level of a page
+ *  table, coarsest first.  A page in the cache points at
+ *  its slot, and a page that is not points at whatever its
+ *  parent page points at, so a texel always finds the
+ *  finest loaded page that covers it.
+ ***********************************************************/
+void VirtualTextures::WritePageTable(VIRTUAL_TEXTURE& texture)
+{
+	std::vector<std::vector<unsigned char> > levels(texture.levelCount);
+
+	m_pStateCache->BindTexture(g_UploadUnit, texture.pageTableID, GL_TEXTURE_2D);
+	for (int level = (int)texture.levelCount - 1; level >= 0; level--)
+	{
+		uint32_t pages = texture.pages >> level;
+		uint64_t firstPage = GetVirtualPageIndex(texture.size, level, 0, 0);
+		std::vector<unsigned char>& entries = levels[level];
+
+		entries.assign((size_t)pages * pages * 4, 0);
+		for (uint32_t y = 0; y < pages; y++)
+		{
+			for (uint32_t x = 0; x < pages; x++)
+			{
+				int slot = texture.pageSlots[firstPage + (uint64_t)y * pages + x];
+				unsigned char* pEntry = &entries[((size_t)y * pages + x) * 4];
+
+				if (slot >= 0)
+				{
+					pEntry[0] = (unsigned char)(slot % CACHE_PAGES);
+					pEntry[1] = (unsigned char)(slot / CACHE_PAGES);
+					pEntry[2] = (unsigned char)level;
+					pEntry[3] = 255;
+				}
+				else if (level + 1 < (int)texture.levelCount)
+				{
+					uint32_t parentPages = pages / 2;
+					memcpy(pEntry, &levels[level + 1][((size_t)(y / 2) * parentPages + (x / 2)) * 4], 4);
+				}
+			}
+		}
+		glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, pages, pages, GL_RGBA, GL_UNSIGNED_BYTE, entries.data());
+	}
+	texture.bTableDirty = false;
+}
+
+/***********************************************************
+ *  Load()
+ *
+ *  This method is used for mapping the virtual texture file
+ *  of an image file, creating its page table and loading
+ *  its coarsest page, which covers the whole texture and is
+ *  never replaced, so the texture can be drawn at once.
+ *  The file is written by Tools/BakeTextures.cpp with
+ *  --virtual, and -1 is returned when there is none.
+ ***********************************************************/
+int VirtualTextures::Load(const char* imagePath)
+{
+	std::string virtualPath = GetVirtualTexturePath(imagePath);
+	std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+	const VIRTUAL_TEXTURE_HEADER* pHeader = NULL;
+	VIRTUAL_TEXTURE texture;
+	int id = (int)m_textures.size();
+	int slot = -1;
+	uint32_t coarsestLevel = 0;
+
+	if (file->Open(virtualPath) == false)
+	{
+		std::cout << "INFO: No virtual texture for " << imagePath
+			<< ", bake one with BakeTextures --virtual" << std::endl;
+		return(-1);
+	}
+	if (IsVirtualTextureValid(*file) == false)
+	{
+		std::cout << "ERROR: " << virtualPath << " is not a virtual texture of the current version" << std::endl;
+		return(-1);
+	}
+	if (id >= MAX_VIRTUAL_TEXTURES)
+	{
+		std::cout << "ERROR: Too many virtual textures to load " << imagePath << std::endl;
+		return(-1);
+	}
+	if ((0 == m_cacheTextureID) && (CreateCache() == false))
+	{
+		std::cout << "ERROR: Could not create the virtual texture page cache" << std::endl;
+		return(-1);
+	}
+	if (m_lru.empty() == true)
+	{
+		std::cout << "ERROR: No room in the page cache for " << imagePath << std::endl;
+		return(-1);
+	}
+
+	pHeader = (const VIRTUAL_TEXTURE_HEADER*)file->GetData();
+	texture.file = file;
+	texture.size = pHeader->size;
+	texture.pages = pHeader->size / VIRTUAL_PAGE_SIZE;
+	texture.levelCount = pHeader->levelCount;
+	texture.dataOffset = pHeader->dataOffset;
+	texture.pageSlots.assign((size_t)GetVirtualPageIndex(texture.size, texture.levelCount, 0, 0), -1);
+	texture.bTableDirty = true;
+
+	// one texel per page, read without filtering
+	glGenTextures(1, &texture.pageTableID);
+	m_pStateCache->BindTexture(g_UploadUnit, texture.pageTableID, GL_TEXTURE_2D);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, texture.levelCount - 1);
+	for (uint32_t level = 0; level < texture.levelCount; level++)
+	{
+		GLsizei pages = (GLsizei)(texture.pages >> level);
+		glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, pages, pages, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	}
+	m_textures.push_back(std::move(texture));
+
+	// the coarsest page is taken out of the least recently
+	// used list so that it is never replaced
+	coarsestLevel = m_textures[id].levelCount - 1;
+	slot = m_lru.back();
+	EvictSlot(slot);
+	m_lru.erase(m_slots[slot].lruEntry);
+	m_slots[slot].bLocked = true;
+	StorePage(MakePageKey(id, coarsestLevel, 0, 0), slot, file->GetData() + m_textures[id].dataOffset +
+		GetVirtualPageIndex(m_textures[id].size, coarsestLevel, 0, 0) * VIRTUAL_PAGE_BYTES);
+	WritePageTable(m_textures[id]);
+
+	if (m_thread.joinable() == false)
+	{
+		m_thread = std::thread(&VirtualTextures::WorkerThread, this);
+	}
+
+	std::cout << "INFO: Virtual texture " << imagePath << " mapped from " << virtualPath << " - "
+		<< m_textures[id].size << "x" << m_textures[id].size << ", levels:" << m_textures[id].levelCount
+		<< ", pages:" << m_textures[id].pageSlots.size() << std::endl;
+	return(id);
+}
+
+/***********************************************************
+ *  ReadFeedback()
+ *
+ *  This method is used for reading the feedback of every
+ *  frame whose read back has finished, without waiting for
+ *  one that has not.  Each texel holds the page position,
+ *  the level and the texture ID plus one, and neighbouring
+ *  texels mostly ask for the same page, so repeats are
+ *  skipped before the set is searched.
+ ***********************************************************/
+bool VirtualTextures::ReadFeedback()
+{
+	bool bRead = false;
+
+	for (int i = 0; i < READBACK_COUNT; i++)
+	{
+		FEEDBACK_READBACK& readback = m_readbacks[i];
+		const unsigned char* pTexels = NULL;
+		size_t texelCount = (size_t)readback.width * readback.height;
+		GLenum result = GL_TIMEOUT_EXPIRED;
+
+		if (0 == readback.fence)
+		{
+			continue;
+		}
+		result = glClientWaitSync(readback.fence, 0, 0);
+		if ((result != GL_ALREADY_SIGNALED) && (result != GL_CONDITION_SATISFIED))
+		{
+			continue;
+		}
+		glDeleteSync(readback.fence);
+		readback.fence = 0;
+
+		// the newest feedback replaces the pages asked for before
+		if (bRead == false)
+		{
+			m_requestedPages.clear();
+			bRead = true;
+		}
+
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.bufferID);
+		pTexels = (const unsigned char*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, texelCount * 4, GL_MAP_READ_BIT);
+		if (NULL != pTexels)
+		{
+			const unsigned char* pPrevious = NULL;
+
+			for (size_t t = 0; t < texelCount; t++)
+			{
+				const unsigned char* pTexel = pTexels + t * 4;
+				int texture = (int)pTexel[3] - 1;
+
+				if ((texture < 0) || ((NULL != pPrevious) && (memcmp(pTexel, pPrevious, 4) == 0)))
+				{
+					continue;
+				}
+				pPrevious = pTexel;
+
+				if ((texture < (int)m_textures.size()) &&
+					(pTexel[2] < m_textures[texture].levelCount) &&
+					(pTexel[0] < (m_textures[texture].pages >> pTexel[2])) &&
+					(pTexel[1] < (m_textures[texture].pages >> pTexel[2])))
+				{
+					m_requestedPages.insert(MakePageKey(texture, pTexel[2], pTexel[0], pTexel[1]));
+				}
+			}
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	}
+	return(bRead);
+}
+
+/***********************************************************
+ *  RequestPages()
+ *
+ *  This method is used for marking the cached pages the
+ *  feedback asked for, and every page above them, as used,
+ *  and queueing the ones that are missing for the worker.
+ *  Coarser pages are queued first, since each one fills in
+ *  the most texels while the finer pages load, and the
+ *  queue is kept short so it follows the camera.
+ ***********************************************************/
+void VirtualTextures::RequestPages()
+{
+	std::vector<PAGE_KEY> missing;
+	int available = MAX_PENDING_PAGES - (int)m_pendingPages.size();
+
+	for (std::unordered_set<PAGE_KEY>::const_iterator requested = m_requestedPages.begin();
+		requested != m_requestedPages.end(); ++requested)
+	{
+		int textureIndex = -1;
+		uint32_t level = 0;
+		uint32_t x = 0;
+		uint32_t y = 0;
+
+		SplitPageKey(*requested, textureIndex, level, x, y);
+		const VIRTUAL_TEXTURE& texture = m_textures[textureIndex];
+		for (uint32_t parent = level; parent < texture.levelCount; parent++)
+		{
+			uint32_t parentX = x >> (parent - level);
+			uint32_t parentY = y >> (parent - level);
+			int slot = texture.pageSlots[GetVirtualPageIndex(texture.size, parent, parentX, parentY)];
+			PAGE_KEY key = MakePageKey(textureIndex, parent, parentX, parentY);
+
+			if (slot >= 0)
+			{
+				TouchSlot(slot);
+			}
+			else if (m_pendingPages.find(key) == m_pendingPages.end())
+			{
+				missing.push_back(key);
+			}
+		}
+	}
+
+	if ((missing.empty() == true) || (available <= 0))
+	{
+		return;
+	}
+
+	// coarsest level first, the level being bits 32 to 39
+	std::sort(missing.begin(), missing.end(), [](PAGE_KEY a, PAGE_KEY b)
+	{
+		uint32_t levelA = (uint32_t)(a >> 32) & 0xFF;
+		uint32_t levelB = (uint32_t)(b >> 32) & 0xFF;
+		return((levelA > levelB) || ((levelA == levelB) && (a < b)));
+	});
+	missing.erase(std::unique(missing.begin(), missing.end()), missing.end());
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (size_t i = 0; (i < missing.size()) && ((int)i < available); i++)
+		{
+			PAGE_REQUEST request;
+			int textureIndex = -1;
+			uint32_t level = 0;
+			uint32_t x = 0;
+			uint32_t y = 0;
+
+			SplitPageKey(missing[i], textureIndex, level, x, y);
+			const VIRTUAL_TEXTURE& texture = m_textures[textureIndex];
+			request.key = missing[i];
+			request.generation = m_generation;
+			request.file = texture.file;
+			request.offset = texture.dataOffset + GetVirtualPageIndex(texture.size, level, x, y) * VIRTUAL_PAGE_BYTES;
+			m_requests.push_back(request);
+			m_pendingPages.insert(missing[i]);
+		}
+	}
+	m_pageQueued.notify_one();
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used for reading the finished feedback,
+ *  queueing the pages it asks for, and copying up to
+ *  MAX_UPLOADS_PER_FRAME loaded pages into the cache, once
+ *  per frame on the render thread.  Pages loaded for a
+ *  texture dropped since are thrown away.  A page that finds
+ *  every slot in use this frame waits for the view to
+ *  change, and its texels are drawn from a coarser page.
+ ***********************************************************/
+int VirtualTextures::Update()
+{
+	int uploaded = 0;
+
+	if (m_textures.empty() == true)
+	{
+		return(0);
+	}
+
+	m_frame++;
+	if (ReadFeedback() == true)
+	{
+		RequestPages();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (size_t i = 0; i < m_loaded.size(); i++)
+		{
+			m_uploads.push_back(std::move(m_loaded[i]));
+		}
+		m_loaded.clear();
+	}
+
+	while ((m_uploads.empty() == false) && (uploaded < MAX_UPLOADS_PER_FRAME))
+	{
+		LOADED_PAGE& page = m_uploads.front();
+
+		if (page.generation == m_generation)
+		{
+			int slot = AcquireSlot();
+			if (slot < 0)
+			{
+				break;
+			}
+			StorePage(page.key, slot, page.texels.data());
+			TouchSlot(slot);
+			m_pendingPages.erase(page.key);
+			uploaded++;
+		}
+		m_uploads.pop_front();
+	}
+
+	for (size_t i = 0; i < m_textures.size(); i++)
+	{
+		if (m_textures[i].bTableDirty == true)
+		{
+			WritePageTable(m_textures[i]);
+		}
+	}
+	return(uploaded);
+}
+
+/***********************************************************
+ *  CreateFeedbackTarget()
+ *
+ *  This method is used for creating the framebuffer the
+ *  feedback pass is drawn into, at the passed in size, with
+ *  a depth buffer of its own so that only the nearest
+ *  surface of each pixel asks for pages.  The framebuffer
+ *  is left bound.
+ ***********************************************************/
+bool VirtualTextures::CreateFeedbackTarget(int width, int height)
+{
+	if (0 == m_feedbackFramebuffer)
+	{
+		glGenFramebuffers(1, &m_feedbackFramebuffer);
+		glGenRenderbuffers(1, &m_feedbackColor);
+		glGenRenderbuffers(1, &m_feedbackDepth);
+	}
+
+	glBindRenderbuffer(GL_RENDERBUFFER, m_feedbackColor);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_feedbackDepth);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_feedbackFramebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_feedbackColor);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_feedbackDepth);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "ERROR: Could not create the virtual texture feedback target, pages stay at their coarsest level" << std::endl;
+		return(false);
+	}
+
+	m_feedbackWidth = width;
+	m_feedbackHeight = height;
+	return(true);
+}
+
+/***********************************************************
+ *  DestroyFeedbackTarget()
+ *
+ *  This method is used for deleting the feedback target and
+ *  the buffers it is read back into, dropping any read back
+ *  still in flight.
+ ***********************************************************/
+void VirtualTextures::DestroyFeedbackTarget()
+{
+	for (int i = 0; i < READBACK_COUNT; i++)
+	{
+		if (0 != m_readbacks[i].fence)
+		{
+			glDeleteSync(m_readbacks[i].fence);
+			m_readbacks[i].fence = 0;
+		}
+		if (0 != m_readbacks[i].bufferID)
+		{
+			glDeleteBuffers(1, &m_readbacks[i].bufferID);
+			m_readbacks[i].bufferID = 0;
+		}
+	}
+	if (0 != m_feedbackFramebuffer)
+	{
+		glDeleteFramebuffers(1, &m_feedbackFramebuffer);
+		glDeleteRenderbuffers(1, &m_feedbackColor);
+		glDeleteRenderbuffers(1, &m_feedbackDepth);
+		m_feedbackFramebuffer = 0;
+		m_feedbackColor = 0;
+		m_feedbackDepth = 0;
+	}
+	m_feedbackWidth = 0;
+	m_feedbackHeight = 0;
+}
+
+/***********************************************************
+ *  BeginFeedback()
+ *
+ *  This method is used for binding and clearing the
+ *  feedback target, FEEDBACK_DIVISOR times smaller than the
+ *  viewport, after the frame has been drawn.  The pass is
+ *  skipped while both read back buffers are still waiting
+ *  for the GPU.  Blending is turned off, since the feedback
+ *  stores the texture ID in alpha.
+ ***********************************************************/
+bool VirtualTextures::BeginFeedback()
+{
+	const GLfloat noRequest[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	const GLfloat farDepth = 1.0f;
+	int width = 0;
+	int height = 0;
+
+	if ((m_textures.empty() == true) ||
+		(m_bFeedbackSupported == false) ||
+		(0 != m_readbacks[m_nextReadback].fence))
+	{
+		return(false);
+	}
+
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &m_savedFramebuffer);
+	glGetIntegerv(GL_VIEWPORT, m_savedViewport);
+	width = std::max((int)m_savedViewport[2] / FEEDBACK_DIVISOR, 1);
+	height = std::max((int)m_savedViewport[3] / FEEDBACK_DIVISOR, 1);
+
+	if ((width != m_feedbackWidth) || (height != m_feedbackHeight))
+	{
+		if (CreateFeedbackTarget(width, height) == false)
+		{
+			m_bFeedbackSupported = false;
+			glBindFramebuffer(GL_FRAMEBUFFER, m_savedFramebuffer);
+			return(false);
+		}
+	}
+	else
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, m_feedbackFramebuffer);
+	}
+
+	glViewport(0, 0, width, height);
+	m_bSavedBlend = (glIsEnabled(GL_BLEND) == GL_TRUE);
+	m_pStateCache->Disable(GL_BLEND);
+	glClearBufferfv(GL_COLOR, 0, noRequest);
+	glClearBufferfv(GL_DEPTH, 0, &farDepth);
+	return(true);
+}
+
+/***********************************************************
+ *  EndFeedback()
+ *
+ *  This method is used for reading the feedback target into
+ *  the next read back buffer, fenced so that Update() maps
+ *  it only once the copy has finished, and drawing to the
+ *  view again.
+ ***********************************************************/
+void VirtualTextures::EndFeedback()
+{
+	FEEDBACK_READBACK& readback = m_readbacks[m_nextReadback];
+
+	if (0 == readback.bufferID)
+	{
+		glGenBuffers(1, &readback.bufferID);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.bufferID);
+	glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)m_feedbackWidth * m_feedbackHeight * 4, NULL, GL_STREAM_READ);
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	glReadPixels(0, 0, m_feedbackWidth, m_feedbackHeight, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	readback.width = m_feedbackWidth;
+	readback.height = m_feedbackHeight;
+	m_nextReadback = (m_nextReadback + 1) % READBACK_COUNT;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_savedFramebuffer);
+	glViewport(m_savedViewport[0], m_savedViewport[1], m_savedViewport[2], m_savedViewport[3]);
+	if (m_bSavedBlend == true)
+	{
+		m_pStateCache->Enable(GL_BLEND);
+	}
+}
+
+/***********************************************************
+ *  Bind()
+ *
+ *  This method is used for binding the page table of the
+ *  passed in virtual texture and the page cache to the
+ *  passed in texture units.
+ ***********************************************************/
+void VirtualTextures::Bind(int texture, int tableUnit, int cacheUnit)
+{
+	if ((texture >= 0) && (texture < (int)m_textures.size()))
+	{
+		m_pStateCache->BindTexture(tableUnit, m_textures[texture].pageTableID, GL_TEXTURE_2D);
+		m_pStateCache->BindTexture(cacheUnit, m_cacheTextureID, GL_TEXTURE_2D);
+	}
+}
+
+/***********************************************************
+ *  GetTextureInfo()
+ *
+ *  This method is used for getting the values the shader
+ *  needs to find the pages of a virtual texture - its pages
+ *  across level 0, its coarsest level and its ID.
+ ***********************************************************/
+glm::vec3 VirtualTextures::GetTextureInfo(int texture) const
+{
+	if ((texture < 0) || (texture >= (int)m_textures.size()))
+	{
+		return(glm::vec3(1.0f, 0.0f, 0.0f));
+	}
+	return(glm::vec3((float)m_textures[texture].pages,
+		(float)(m_textures[texture].levelCount - 1),
+		(float)texture));
+}
+
+/***********************************************************
+ *  GetCacheInfo()
+ *
+ *  This method is used for getting the page size, border
+ *  and stride in cache texels, and the level bias of the
+ *  pass.  The feedback pass is drawn FEEDBACK_DIVISOR times
+ *  smaller, so its derivatives are that many times larger,
+ *  and the bias brings its levels back to the frame's.
+ ***********************************************************/
+glm::vec4 VirtualTextures::GetCacheInfo(bool bFeedback) const
+{
+	float levelBias = 0.0f;
+
+	if (bFeedback == true)
+	{
+		levelBias = -std::log2((float)FEEDBACK_DIVISOR);
+	}
+	return(glm::vec4((float)VIRTUAL_PAGE_SIZE, (float)VIRTUAL_PAGE_BORDER,
+		(float)VIRTUAL_PAGE_STRIDE, levelBias));
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for dropping every virtual texture,
+ *  the page cache and the feedback target.  Pages the
+ *  worker is still copying keep their file mapped until
+ *  they are done, and are thrown away when they come back.
+ ***********************************************************/
+void VirtualTextures::Clear()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_requests.clear();
+		m_loaded.clear();
+	}
+	m_generation++;
+	m_uploads.clear();
+	m_pendingPages.clear();
+	m_requestedPages.clear();
+
+	for (size_t i = 0; i < m_textures.size(); i++)
+	{
+		m_pStateCache->ForgetTexture(m_textures[i].pageTableID);
+		glDeleteTextures(1, &m_textures[i].pageTableID);
+	}
+	m_textures.clear();
+
+	if (0 != m_cacheTextureID)
+	{
+		m_pStateCache->ForgetTexture(m_cacheTextureID);
+		glDeleteTextures(1, &m_cacheTextureID);
+		m_cacheTextureID = 0;
+	}
+	m_slots.clear();
+	m_lru.clear();
+	DestroyFeedbackTarget();
+}
@@ -0,0 +1,240 @@
+///////////////////////////////////////////////////////////////////////////////
+// virtualtextures.h
+// ============
+// draw textures larger than video memory by keeping only the pages the
+// frame samples in a shared page cache, loading them from the tiled files
+// written by Tools/BakeTextures.cpp as a feedback pass asks for them
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "GLStateCache.h"
+#include "MappedFile.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+/***********************************************************
+ *  VirtualTextures
+ *
+ *  This class maps the virtual texture file of an image,
+ *  cut into pages of every level, and keeps the pages the
+ *  scene samples in one page cache texture shared by every
+ *  virtual texture.  Each virtual texture has a page table
+ *  with one texel per page of each level, giving the cache
+ *  slot of the page, or of the finest loaded page above it
+ *  until the page itself is loaded.  The coarsest page is
+ *  loaded when the texture is, and never leaves the cache.
+ *
+ *  The draws of virtual textures are drawn again into a
+ *  small feedback target, writing the page each pixel
+ *  needs, and the target is read back through a pixel
+ *  buffer without waiting for the GPU.  Update() reads the
+ *  finished feedback, queues the missing pages, coarsest
+ *  first, for a worker thread that copies them from the
+ *  mapped file, and copies a few loaded pages per frame
+ *  into the slots least recently sampled.
+ ***********************************************************/
+class VirtualTextures
+{
+public:
+	// constructor
+	VirtualTextures(GLStateCache* pStateCache);
+	// destructor
+	~VirtualTextures();
+
+	// pages across and down the page cache
+	static const int CACHE_PAGES = 16;
+	// most virtual textures, since the feedback stores the
+	// texture ID plus one in a byte
+	static const int MAX_VIRTUAL_TEXTURES = 255;
+	// most pages queued or loaded and not yet in the cache
+	static const int MAX_PENDING_PAGES = 32;
+	// most pages copied into the cache in one frame
+	static const int MAX_UPLOADS_PER_FRAME = 8;
+	// the feedback target is this many times smaller than
+	// the viewport across and down
+	static const int FEEDBACK_DIVISOR = 8;
+
+private:
+	// virtual texture, level and position of a page
+	typedef uint64_t PAGE_KEY;
+
+	struct VIRTUAL_TEXTURE
+	{
+		// mapped pages, shared with the worker while it copies
+		std::shared_ptr<MappedFile> file;
+		// texels across level 0, pages across level 0 and
+		// levels down to a single page
+		uint32_t size;
+		uint32_t pages;
+		uint32_t levelCount;
+		uint64_t dataOffset;
+		GLuint pageTableID;
+		// cache slot of every page, by GetVirtualPageIndex(),
+		// -1 for a page that is not in the cache
+		std::vector<int> pageSlots;
+		// true when the page table must be written again
+		bool bTableDirty;
+	};
+
+	struct CACHE_SLOT
+	{
+		// page held by the slot, or INVALID_PAGE_KEY
+		PAGE_KEY key;
+		// true for a coarsest page, which is never replaced
+		bool bLocked;
+		// frame the page was last asked for by the feedback
+		uint32_t usedFrame;
+		// position in the least recently used list
+		std::list<int>::iterator lruEntry;
+	};
+
+	// a page for the worker to copy out of its file
+	struct PAGE_REQUEST
+	{
+		PAGE_KEY key;
+		uint32_t generation;
+		std::shared_ptr<MappedFile> file;
+		uint64_t offset;
+	};
+
+	// a page copied by the worker, waiting for a cache slot
+	struct LOADED_PAGE
+	{
+		PAGE_KEY key;
+		uint32_t generation;
+		std::vector<unsigned char> texels;
+	};
+
+	// pixel buffer a frame's feedback is read back into
+	struct FEEDBACK_READBACK
+	{
+		GLuint bufferID;
+		// signalled once the read has finished, 0 when free
+		GLsync fence;
+		int width;
+		int height;
+	};
+
+	static const PAGE_KEY INVALID_PAGE_KEY = ~0ull;
+	static const int READBACK_COUNT = 2;
+
+	// pointer to the cache the textures are bound through
+	GLStateCache* m_pStateCache;
+	// loaded virtual textures by ID
+	std::vector<VIRTUAL_TEXTURE> m_textures;
+	// page cache texture and its slots
+	GLuint m_cacheTextureID;
+	std::vector<CACHE_SLOT> m_slots;
+	// unlocked slots, the most recently used first
+	std::list<int> m_lru;
+	// pages queued for the worker or loaded by it
+	std::unordered_set<PAGE_KEY> m_pendingPages;
+	// loaded pages waiting for a cache slot, oldest first
+	std::deque<LOADED_PAGE> m_uploads;
+	// pages the last read feedback asked for
+	std::unordered_set<PAGE_KEY> m_requestedPages;
+	// raised by Clear() so that pages of dropped textures
+	// coming back from the worker are ignored
+	uint32_t m_generation;
+	// counts the updates, for the least recently used slots
+	uint32_t m_frame;
+
+	// feedback target and the buffers it is read back into
+	GLuint m_feedbackFramebuffer;
+	GLuint m_feedbackColor;
+	GLuint m_feedbackDepth;
+	int m_feedbackWidth;
+	int m_feedbackHeight;
+	FEEDBACK_READBACK m_readbacks[READBACK_COUNT];
+	int m_nextReadback;
+	// state put back once the feedback is drawn
+	GLint m_savedFramebuffer;
+	GLint m_savedViewport[4];
+	bool m_bSavedBlend;
+	// false once the feedback target could not be created
+	bool m_bFeedbackSupported;
+
+	// pages for the worker, oldest first, and the pages it
+	// has copied
+	std::deque<PAGE_REQUEST> m_requests;
+	std::vector<LOADED_PAGE> m_loaded;
+	// guards the requests, the loaded pages and m_bStopping
+	std::mutex m_mutex;
+	// signalled when a page is queued or the worker must stop
+	std::condition_variable m_pageQueued;
+	// worker thread, started with the first virtual texture
+	std::thread m_thread;
+	// set to make the worker return
+	bool m_bStopping;
+
+	// pack and unpack the parts of a page key
+	static PAGE_KEY MakePageKey(int texture, uint32_t level, uint32_t x, uint32_t y);
+	static void SplitPageKey(PAGE_KEY key, int& texture, uint32_t& level, uint32_t& x, uint32_t& y);
+	// body of the worker thread
+	void WorkerThread();
+	// create the page cache texture and its slots
+	bool CreateCache();
+	// get a slot for a new page, replacing the least recently
+	// used page, or -1 when every slot is in use this frame
+	int AcquireSlot();
+	// drop the page held by a slot from its page table
+	void EvictSlot(int slot);
+	// copy a page's texels into a slot and point the page
+	// table at it
+	void StorePage(PAGE_KEY key, int slot, const unsigned char* pTexels);
+	// move a slot to the front of the least recently used list
+	void TouchSlot(int slot);
+	// write the page table of a texture from its page slots
+	void WritePageTable(VIRTUAL_TEXTURE& texture);
+	// read the feedback of finished frames into the requested
+	// pages, returning false when none has finished
+	bool ReadFeedback();
+	// queue the requested pages that are not in the cache
+	void RequestPages();
+	// create the feedback target at the passed in size
+	bool CreateFeedbackTarget(int width, int height);
+	// delete the feedback target and its read back buffers
+	void DestroyFeedbackTarget();
+
+public:
+	// map the virtual texture file of an image file and load
+	// its coarsest page, returning its ID or -1 on failure
+	int Load(const char* imagePath);
+	// read the feedback, queue missing pages and copy loaded
+	// ones into the cache, once per frame, returning the
+	// number of pages copied
+	int Update();
+	// start drawing the virtual texture draws into the
+	// feedback target, returning false to skip the pass
+	bool BeginFeedback();
+	// read back the feedback target and draw to the view again
+	void EndFeedback();
+	// bind a texture's page table and the page cache
+	void Bind(int texture, int tableUnit, int cacheUnit);
+	// get the pages across level 0, the coarsest level and the
+	// ID of a texture, for the shader
+	glm::vec3 GetTextureInfo(int texture) const;
+	// get the page size, border and stride in cache texels and
+	// the level bias of the pass, for the shader
+	glm::vec4 GetCacheInfo(bool bFeedback) const;
+	// drop every virtual texture and empty the cache
+	void Clear();
+
+	// get the number of loaded virtual textures
+	int GetTextureCount() const { return((int)m_textures.size()); }
+	// get the number of pages waiting to enter the cache
+	int GetPendingCount() const { return((int)m_pendingPages.size()); }
+};
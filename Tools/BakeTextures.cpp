@@ -0,0 +1,655 @@
+///////////////////////////////////////////////////////////////////////////////
+// baketextures.cpp
+// ============
+// bake the scene's texture images into files that the runtime maps and hands
+// to OpenGL as they are, flipped, with every mip level and block compressed,
+// or into virtual texture files cut into pages that are loaded as they are seen
+//
+// needs stb_image.h from the Utilities folder.  build from the repository
+// root, for example:
+//     cl /EHsc /O2 /I..\..\Utilities Tools\BakeTextures.cpp
+//     g++ -std=c++11 -O2 -I../../Utilities -o baketextures Tools/BakeTextures.cpp
+// and run it from the repository root after changing a texture:
+//     baketextures [--uncompressed] [image.jpg ...]
+// with no files, every .jpg and .png in the textures folder is baked.
+//     baketextures --virtual [size] image.jpg ...
+// writes virtual texture files instead, resampled to a square power of two
+// size, by default the image's larger side rounded up.
+///////////////////////////////////////////////////////////////////////////////
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include "../Source/TextureContainer.h"
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <dirent.h>
+#endif
+
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// declaration of global variables
+namespace
+{
+	const char* g_DefaultDirectory = "textures";
+
+	// one mip level of an RGBA8 image
+	struct IMAGE_LEVEL
+	{
+		uint32_t width;
+		uint32_t height;
+		std::vector<unsigned char> pixels;
+	};
+}
+
+/***********************************************************
+ *  HasExtension()
+ *
+ *  This function is used for checking, ignoring case, that
+ *  a file name ends with an extension.
+ ***********************************************************/
+bool HasExtension(const std::string& fileName, const char* extension)
+{
+	size_t length = strlen(extension);
+
+	if (fileName.size() < length)
+	{
+		return(false);
+	}
+	for (size_t i = 0; i < length; i++)
+	{
+		if (tolower((unsigned char)fileName[fileName.size() - length + i]) != extension[i])
+		{
+			return(false);
+		}
+	}
+	return(true);
+}
+
+/***********************************************************
+ *  ListImages()
+ *
+ *  This function is used for getting the path of every
+ *  .jpg and .png file in a directory.
+ ***********************************************************/
+std::vector<std::string> ListImages(const std::string& directory)
+{
+	std::vector<std::string> filePaths;
+	std::vector<std::string> fileNames;
+
+#ifdef _WIN32
+	struct _finddata_t fileData;
+	intptr_t search = _findfirst((directory + "/*").c_str(), &fileData);
+
+	if (search != -1)
+	{
+		do
+		{
+			fileNames.push_back(fileData.name);
+		} while (_findnext(search, &fileData) == 0);
+		_findclose(search);
+	}
+#else
+	DIR* pDirectory = opendir(directory.c_str());
+	struct dirent* pEntry = NULL;
+
+	if (NULL != pDirectory)
+	{
+		while (NULL != (pEntry = readdir(pDirectory)))
+		{
+			fileNames.push_back(pEntry->d_name);
+		}
+		closedir(pDirectory);
+	}
+#endif
+
+	for (size_t i = 0; i < fileNames.size(); i++)
+	{
+		if ((HasExtension(fileNames[i], ".jpg") == true) || (HasExtension(fileNames[i], ".png") == true))
+		{
+			filePaths.push_back(directory + "/" + fileNames[i]);
+		}
+	}
+	return(filePaths);
+}
+
+/***********************************************************
+ *  BuildMipChain()
+ *
+ *  This function is used for halving an image with a box
+ *  filter until it is 1x1.  An odd edge repeats its last
+ *  row or column, the way glGenerateMipmap sizes levels.
+ ***********************************************************/
+void BuildMipChain(std::vector<IMAGE_LEVEL>& levels)
+{
+	while (((levels.back().width > 1) || (levels.back().height > 1)) &&
+		(levels.size() < (size_t)TEXTURE_CONTAINER_MAX_LEVELS))
+	{
+		const IMAGE_LEVEL& source = levels.back();
+		IMAGE_LEVEL level;
+
+		level.width = (source.width > 1) ? source.width / 2 : 1;
+		level.height = (source.height > 1) ? source.height / 2 : 1;
+		level.pixels.resize((size_t)level.width * level.height * 4);
+		for (uint32_t y = 0; y < level.height; y++)
+		{
+			uint32_t y0 = (2 * y < source.height) ? 2 * y : source.height - 1;
+			uint32_t y1 = (2 * y + 1 < source.height) ? 2 * y + 1 : y0;
+
+			for (uint32_t x = 0; x < level.width; x++)
+			{
+				uint32_t x0 = (2 * x < source.width) ? 2 * x : source.width - 1;
+				uint32_t x1 = (2 * x + 1 < source.width) ? 2 * x + 1 : x0;
+
+				for (int c = 0; c < 4; c++)
+				{
+					int sum = source.pixels[((size_t)y0 * source.width + x0) * 4 + c] +
+						source.pixels[((size_t)y0 * source.width + x1) * 4 + c] +
+						source.pixels[((size_t)y1 * source.width + x0) * 4 + c] +
+						source.pixels[((size_t)y1 * source.width + x1) * 4 + c];
+					level.pixels[((size_t)y * level.width + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+				}
+			}
+		}
+		levels.push_back(level);
+	}
+}
+
+/***********************************************************
+ *  PackColor565()
+ *
+ *  This function is used for rounding a color to the 5:6:5
+ *  bits of a BC1 endpoint.
+ ***********************************************************/
+uint16_t PackColor565(const unsigned char* color)
+{
+	return((uint16_t)((((color[0] * 31 + 127) / 255) << 11) |
+		(((color[1] * 63 + 127) / 255) << 5) |
+		((color[2] * 31 + 127) / 255)));
+}
+
+/***********************************************************
+ *  UnpackColor565()
+ *
+ *  This function is used for expanding a 5:6:5 endpoint to
+ *  8 bits per channel.
+ ***********************************************************/
+void UnpackColor565(uint16_t packed, int* color)
+{
+	color[0] = ((packed >> 11) & 31) * 255 / 31;
+	color[1] = ((packed >> 5) & 63) * 255 / 63;
+	color[2] = (packed & 31) * 255 / 31;
+}
+
+/***********************************************************
+ *  EncodeColorBlock()
+ *
+ *  This function is used for encoding the colors of a 4x4
+ *  block as BC1, with the corners of the block's bounding
+ *  box as endpoints and each texel given the closest of the
+ *  four palette colors.  The first endpoint is kept the
+ *  larger so the block never uses the 1 bit alpha mode.
+ ***********************************************************/
+void EncodeColorBlock(const unsigned char block[16][4], unsigned char* pOutput)
+{
+	unsigned char minColor[4] = { 255, 255, 255, 255 };
+	unsigned char maxColor[4] = { 0, 0, 0, 0 };
+	int palette[4][3];
+	uint16_t color0 = 0;
+	uint16_t color1 = 0;
+	uint32_t indices = 0;
+
+	for (int i = 0; i < 16; i++)
+	{
+		for (int c = 0; c < 3; c++)
+		{
+			minColor[c] = (block[i][c] < minColor[c]) ? block[i][c] : minColor[c];
+			maxColor[c] = (block[i][c] > maxColor[c]) ? block[i][c] : maxColor[c];
+		}
+	}
+	color0 = PackColor565(maxColor);
+	color1 = PackColor565(minColor);
+	if (color0 < color1)
+	{
+		uint16_t swap = color0;
+		color0 = color1;
+		color1 = swap;
+	}
+
+	if (color0 != color1)
+	{
+		UnpackColor565(color0, palette[0]);
+		UnpackColor565(color1, palette[1]);
+		for (int c = 0; c < 3; c++)
+		{
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+		for (int i = 0; i < 16; i++)
+		{
+			int bestIndex = 0;
+			int bestDistance = 0x7fffffff;
+
+			for (int p = 0; p < 4; p++)
+			{
+				int distance = 0;
+				for (int c = 0; c < 3; c++)
+				{
+					int difference = block[i][c] - palette[p][c];
+					distance += difference * difference;
+				}
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					bestIndex = p;
+				}
+			}
+			indices |= (uint32_t)bestIndex << (2 * i);
+		}
+	}
+
+	pOutput[0] = (unsigned char)(color0 & 0xff);
+	pOutput[1] = (unsigned char)(color0 >> 8);
+	pOutput[2] = (unsigned char)(color1 & 0xff);
+	pOutput[3] = (unsigned char)(color1 >> 8);
+	for (int i = 0; i < 4; i++)
+	{
+		pOutput[4 + i] = (unsigned char)(indices >> (8 * i));
+	}
+}
+
+/***********************************************************
+ *  EncodeAlphaBlock()
+ *
+ *  This function is used for encoding the alpha of a 4x4
+ *  block as the alpha half of BC3, with the block's alpha
+ *  range as endpoints and eight steps between them.
+ ***********************************************************/
+void EncodeAlphaBlock(const unsigned char block[16][4], unsigned char* pOutput)
+{
+	int alpha0 = 0;
+	int alpha1 = 255;
+	int palette[8];
+	uint64_t indices = 0;
+
+	for (int i = 0; i < 16; i++)
+	{
+		alpha0 = (block[i][3] > alpha0) ? block[i][3] : alpha0;
+		alpha1 = (block[i][3] < alpha1) ? block[i][3] : alpha1;
+	}
+	palette[0] = alpha0;
+	palette[1] = alpha1;
+	for (int p = 1; p < 7; p++)
+	{
+		palette[p + 1] = ((7 - p) * alpha0 + p * alpha1) / 7;
+	}
+	for (int i = 0; i < 16; i++)
+	{
+		int bestIndex = 0;
+		int bestDistance = 256;
+
+		for (int p = 0; p < 8; p++)
+		{
+			int distance = (block[i][3] > palette[p]) ? block[i][3] - palette[p] : palette[p] - block[i][3];
+			if (distance < bestDistance)
+			{
+				bestDistance = distance;
+				bestIndex = p;
+			}
+		}
+		indices |= (uint64_t)bestIndex << (3 * i);
+	}
+
+	pOutput[0] = (unsigned char)alpha0;
+	pOutput[1] = (unsigned char)alpha1;
+	for (int i = 0; i < 6; i++)
+	{
+		pOutput[2 + i] = (unsigned char)(indices >> (8 * i));
+	}
+}
+
+/***********************************************************
+ *  EncodeLevel()
+ *
+ *  This function is used for encoding one level in a
+ *  container format.  Texels of a block past the edge of
+ *  the level repeat the last row or column.
+ ***********************************************************/
+std::vector<unsigned char> EncodeLevel(const IMAGE_LEVEL& level, TEXTURE_CONTAINER_FORMAT format)
+{
+	std::vector<unsigned char> output;
+	unsigned char block[16][4];
+	size_t position = 0;
+
+	if (format == TEXTURE_FORMAT_RGBA8)
+	{
+		return(level.pixels);
+	}
+
+	output.resize((size_t)GetTextureLevelSize(format, level.width, level.height));
+	for (uint32_t blockY = 0; blockY < level.height; blockY += 4)
+	{
+		for (uint32_t blockX = 0; blockX < level.width; blockX += 4)
+		{
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				uint32_t x = (blockX + i % 4 < level.width) ? blockX + i % 4 : level.width - 1;
+				uint32_t y = (blockY + i / 4 < level.height) ? blockY + i / 4 : level.height - 1;
+				memcpy(block[i], &level.pixels[((size_t)y * level.width + x) * 4], 4);
+			}
+			if (format == TEXTURE_FORMAT_BC3)
+			{
+				EncodeAlphaBlock(block, &output[position]);
+				position += 8;
+			}
+			EncodeColorBlock(block, &output[position]);
+			position += 8;
+		}
+	}
+	return(output);
+}
+
+/***********************************************************
+ *  BakeTexture()
+ *
+ *  This function is used for decoding an image file and
+ *  writing its baked file next to it.  Images with any
+ *  texel that is not opaque are written as BC3, the others
+ *  as BC1, unless compression is turned off.
+ ***********************************************************/
+bool BakeTexture(const std::string& imagePath, bool bCompress)
+{
+	std::string bakedPath = GetBakedTexturePath(imagePath);
+	std::vector<IMAGE_LEVEL> levels(1);
+	TEXTURE_CONTAINER_HEADER header;
+	TEXTURE_CONTAINER_FORMAT format = TEXTURE_FORMAT_RGBA8;
+	std::vector<std::vector<unsigned char> > levelData;
+	uint64_t offset = 0;
+	bool bOpaque = true;
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+	FILE* pFile = NULL;
+
+	// flipped the same way TextureLoader::WorkerThread()
+	// flips images decoded at runtime
+	stbi_set_flip_vertically_on_load(true);
+	unsigned char* pixels = stbi_load(imagePath.c_str(), &width, &height, &channels, 4);
+	if (NULL == pixels)
+	{
+		std::cout << "ERROR: Could not decode " << imagePath << std::endl;
+		return(false);
+	}
+	levels[0].width = (uint32_t)width;
+	levels[0].height = (uint32_t)height;
+	levels[0].pixels.assign(pixels, pixels + (size_t)width * height * 4);
+	stbi_image_free(pixels);
+
+	for (size_t i = 3; i < levels[0].pixels.size(); i += 4)
+	{
+		bOpaque = bOpaque && (levels[0].pixels[i] == 255);
+	}
+	if (bCompress == true)
+	{
+		format = (bOpaque == true) ? TEXTURE_FORMAT_BC1 : TEXTURE_FORMAT_BC3;
+	}
+
+	BuildMipChain(levels);
+
+	memset(&header, 0, sizeof(header));
+	header.magic = TEXTURE_CONTAINER_MAGIC;
+	header.version = TEXTURE_CONTAINER_VERSION;
+	header.format = (uint32_t)format;
+	header.levelCount = (uint32_t)levels.size();
+	offset = sizeof(header);
+	for (size_t i = 0; i < levels.size(); i++)
+	{
+		offset = (offset + TEXTURE_CONTAINER_ALIGNMENT - 1) & ~(TEXTURE_CONTAINER_ALIGNMENT - 1);
+		levelData.push_back(EncodeLevel(levels[i], format));
+		header.levels[i].width = levels[i].width;
+		header.levels[i].height = levels[i].height;
+		header.levels[i].offset = offset;
+		header.levels[i].size = levelData.back().size();
+		offset += header.levels[i].size;
+	}
+
+	pFile = fopen(bakedPath.c_str(), "wb");
+	if (NULL == pFile)
+	{
+		std::cout << "ERROR: Could not write " << bakedPath << std::endl;
+		return(false);
+	}
+	fwrite(&header, sizeof(header), 1, pFile);
+	for (size_t i = 0; i < levelData.size(); i++)
+	{
+		static const unsigned char padding[TEXTURE_CONTAINER_ALIGNMENT] = { 0 };
+		long position = ftell(pFile);
+		fwrite(padding, 1, (size_t)(header.levels[i].offset - (uint64_t)position), pFile);
+		fwrite(levelData[i].data(), 1, levelData[i].size(), pFile);
+	}
+	fclose(pFile);
+
+	std::cout << "INFO: Baked " << imagePath << " into " << bakedPath << " - "
+		<< width << "x" << height << ", "
+		<< ((format == TEXTURE_FORMAT_BC1) ? "BC1" : (format == TEXTURE_FORMAT_BC3) ? "BC3" : "RGBA8")
+		<< ", levels:" << header.levelCount << ", " << offset << " bytes" << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  ResampleImage()
+ *
+ *  This function is used for resizing an image to a square
+ *  of the passed in size with a bilinear filter.  The
+ *  image wraps around its edges, the way the scene repeats
+ *  its textures.
+ ***********************************************************/
+IMAGE_LEVEL ResampleImage(const IMAGE_LEVEL& source, uint32_t size)
+{
+	IMAGE_LEVEL level;
+
+	level.width = size;
+	level.height = size;
+	level.pixels.resize((size_t)size * size * 4);
+	for (uint32_t y = 0; y < size; y++)
+	{
+		float sourceY = ((float)y + 0.5f) * source.height / size - 0.5f;
+		float rowY = sourceY - (float)floor(sourceY);
+		uint32_t y0 = (uint32_t)((int64_t)floor(sourceY) + source.height) % source.height;
+		uint32_t y1 = (y0 + 1) % source.height;
+
+		for (uint32_t x = 0; x < size; x++)
+		{
+			float sourceX = ((float)x + 0.5f) * source.width / size - 0.5f;
+			float columnX = sourceX - (float)floor(sourceX);
+			uint32_t x0 = (uint32_t)((int64_t)floor(sourceX) + source.width) % source.width;
+			uint32_t x1 = (x0 + 1) % source.width;
+
+			for (int c = 0; c < 4; c++)
+			{
+				float top = source.pixels[((size_t)y0 * source.width + x0) * 4 + c] * (1.0f - columnX) +
+					source.pixels[((size_t)y0 * source.width + x1) * 4 + c] * columnX;
+				float bottom = source.pixels[((size_t)y1 * source.width + x0) * 4 + c] * (1.0f - columnX) +
+					source.pixels[((size_t)y1 * source.width + x1) * 4 + c] * columnX;
+				level.pixels[((size_t)y * size + x) * 4 + c] = (unsigned char)(top * (1.0f - rowY) + bottom * rowY + 0.5f);
+			}
+		}
+	}
+	return(level);
+}
+
+/***********************************************************
+ *  BakeVirtualTexture()
+ *
+ *  This function is used for decoding an image file and
+ *  writing its virtual texture file next to it, resampled
+ *  to the passed in size, or to its larger side rounded up
+ *  to a power of two when the size is 0.  Every level down
+ *  to a single page is cut into pages with their borders.
+ ***********************************************************/
+bool BakeVirtualTexture(const std::string& imagePath, uint32_t size)
+{
+	std::string virtualPath = GetVirtualTexturePath(imagePath);
+	std::vector<IMAGE_LEVEL> levels(1);
+	std::vector<unsigned char> page((size_t)VIRTUAL_PAGE_BYTES);
+	VIRTUAL_TEXTURE_HEADER header;
+	uint64_t pageCount = 0;
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+	FILE* pFile = NULL;
+
+	stbi_set_flip_vertically_on_load(true);
+	unsigned char* pixels = stbi_load(imagePath.c_str(), &width, &height, &channels, 4);
+	if (NULL == pixels)
+	{
+		std::cout << "ERROR: Could not decode " << imagePath << std::endl;
+		return(false);
+	}
+	levels[0].width = (uint32_t)width;
+	levels[0].height = (uint32_t)height;
+	levels[0].pixels.assign(pixels, pixels + (size_t)width * height * 4);
+	stbi_image_free(pixels);
+
+	if (0 == size)
+	{
+		size = VIRTUAL_PAGE_SIZE;
+		while ((size < (uint32_t)width) || (size < (uint32_t)height))
+		{
+			size *= 2;
+		}
+	}
+	if ((size < VIRTUAL_PAGE_SIZE) || (size > VIRTUAL_PAGE_SIZE * VIRTUAL_TEXTURE_MAX_PAGES) || ((size & (size - 1)) != 0))
+	{
+		std::cout << "ERROR: A virtual texture must be a power of two from " << VIRTUAL_PAGE_SIZE
+			<< " to " << (VIRTUAL_PAGE_SIZE * VIRTUAL_TEXTURE_MAX_PAGES) << " texels across" << std::endl;
+		return(false);
+	}
+	if ((levels[0].width != size) || (levels[0].height != size))
+	{
+		levels[0] = ResampleImage(levels[0], size);
+	}
+	BuildMipChain(levels);
+
+	memset(&header, 0, sizeof(header));
+	header.magic = VIRTUAL_TEXTURE_MAGIC;
+	header.version = VIRTUAL_TEXTURE_VERSION;
+	header.size = size;
+	header.pageSize = VIRTUAL_PAGE_SIZE;
+	header.pageBorder = VIRTUAL_PAGE_BORDER;
+	header.levelCount = 1;
+	while ((size >> header.levelCount) >= VIRTUAL_PAGE_SIZE)
+	{
+		header.levelCount++;
+	}
+	header.dataOffset = (sizeof(header) + TEXTURE_CONTAINER_ALIGNMENT - 1) & ~(TEXTURE_CONTAINER_ALIGNMENT - 1);
+
+	pFile = fopen(virtualPath.c_str(), "wb");
+	if (NULL == pFile)
+	{
+		std::cout << "ERROR: Could not write " << virtualPath << std::endl;
+		return(false);
+	}
+	fwrite(&header, sizeof(header), 1, pFile);
+	for (uint64_t i = sizeof(header); i < header.dataOffset; i++)
+	{
+		fputc(0, pFile);
+	}
+
+	for (uint32_t level = 0; level < header.levelCount; level++)
+	{
+		const IMAGE_LEVEL& image = levels[level];
+		uint32_t pages = image.width / VIRTUAL_PAGE_SIZE;
+
+		for (uint32_t pageY = 0; pageY < pages; pageY++)
+		{
+			for (uint32_t pageX = 0; pageX < pages; pageX++)
+			{
+				for (uint32_t y = 0; y < VIRTUAL_PAGE_STRIDE; y++)
+				{
+					uint32_t sourceY = (pageY * VIRTUAL_PAGE_SIZE + y + image.height - VIRTUAL_PAGE_BORDER) % image.height;
+					for (uint32_t x = 0; x < VIRTUAL_PAGE_STRIDE; x++)
+					{
+						uint32_t sourceX = (pageX * VIRTUAL_PAGE_SIZE + x + image.width - VIRTUAL_PAGE_BORDER) % image.width;
+						memcpy(&page[((size_t)y * VIRTUAL_PAGE_STRIDE + x) * 4],
+							&image.pixels[((size_t)sourceY * image.width + sourceX) * 4], 4);
+					}
+				}
+				fwrite(page.data(), 1, page.size(), pFile);
+				pageCount++;
+			}
+		}
+	}
+	fclose(pFile);
+
+	std::cout << "INFO: Baked " << imagePath << " into " << virtualPath << " - "
+		<< size << "x" << size << ", levels:" << header.levelCount << ", pages:" << pageCount
+		<< ", " << (header.dataOffset + pageCount * VIRTUAL_PAGE_BYTES) << " bytes" << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  main()
+ *
+ *  This function bakes the image files given on the command
+ *  line, or every image in the textures folder.
+ ***********************************************************/
+int main(int argc, char* argv[])
+{
+	std::vector<std::string> imagePaths;
+	bool bCompress = true;
+	bool bVirtual = false;
+	uint32_t virtualSize = 0;
+	int failures = 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--uncompressed") == 0)
+		{
+			bCompress = false;
+		}
+		else if (strcmp(argv[i], "--virtual") == 0)
+		{
+			bVirtual = true;
+			if ((i + 1 < argc) && (isdigit((unsigned char)argv[i + 1][0]) != 0))
+			{
+				virtualSize = (uint32_t)strtoul(argv[++i], NULL, 10);
+			}
+		}
+		else
+		{
+			imagePaths.push_back(argv[i]);
+		}
+	}
+	if (imagePaths.empty() == true)
+	{
+		imagePaths = ListImages(g_DefaultDirectory);
+	}
+	if (imagePaths.empty() == true)
+	{
+		std::cout << "ERROR: No images to bake in " << g_DefaultDirectory << std::endl;
+		return(1);
+	}
+
+	for (size_t i = 0; i < imagePaths.size(); i++)
+	{
+		bool bBaked = (bVirtual == true) ?
+			BakeVirtualTexture(imagePaths[i], virtualSize) :
+			BakeTexture(imagePaths[i], bCompress);
+
+		if (bBaked == false)
+		{
+			failures++;
+		}
+	}
+	return((failures == 0) ? 0 : 1);
+}
@@ -0,0 +1,125 @@
+///////////////////////////////////////////////////////////////////////////////
+// compilespirv.cpp
+// ============
+// compile the scene shaders to SPIR-V modules ahead of time, so that the
+// driver never parses the GLSL sources at startup
+//
+// needs glslangValidator from the Vulkan SDK or the glslang package on the
+// PATH.  build from the repository root, for example:
+//     cl /EHsc /O2 Tools\CompileSpirv.cpp
+//     g++ -std=c++11 -O2 -o compilespirv Tools/CompileSpirv.cpp
+// and run it from the repository root after editing the shaders:
+//     compilespirv [vertexShader.glsl fragmentShader.glsl]
+// the scene only uses the modules when it is started with --spirv
+///////////////////////////////////////////////////////////////////////////////
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+// declaration of global variables
+namespace
+{
+	const char* g_DefaultVertexPath = "shaders/vertexShader.glsl";
+	const char* g_DefaultFragmentPath = "shaders/fragmentShader.glsl";
+
+	// must match ShaderVariants::VARIANT_FLAGS, one fragment
+	// module is compiled for every combination
+	const int VARIANT_TEXTURED = 1 << 0;
+	const int VARIANT_LIT = 1 << 1;
+	const int VARIANT_BAKED = 1 << 2;
+	const int VARIANT_VIRTUAL = 1 << 3;
+	const int VARIANT_FEEDBACK = 1 << 4;
+	const int FEATURE_SETS = 32;
+}
+
+/***********************************************************
+ *  GetModulePath()
+ *
+ *  This function is used for getting the name of the module
+ *  compiled from a shader file, the same way as
+ *  ShaderVariants::GetModulePath().
+ ***********************************************************/
+std::string GetModulePath(const std::string& sourcePath, int featureSet)
+{
+	std::string path = sourcePath;
+	size_t extension = path.rfind(".glsl");
+
+	if (extension != std::string::npos)
+	{
+		path.erase(extension);
+	}
+	if (featureSet >= 0)
+	{
+		path += "." + std::to_string(featureSet);
+	}
+	return(path + ".spv");
+}
+
+/***********************************************************
+ *  CompileModule()
+ *
+ *  This function is used for running glslangValidator on
+ *  one stage with the defines of a feature set.  -G makes
+ *  an OpenGL module, which defines GL_SPIRV for the source.
+ ***********************************************************/
+bool CompileModule(const std::string& sourcePath, const char* stage, const std::string& defines, int featureSet)
+{
+	std::string modulePath = GetModulePath(sourcePath, featureSet);
+	std::string command = "glslangValidator -G -S " + std::string(stage) + defines +
+		" -o \"" + modulePath + "\" \"" + sourcePath + "\"";
+
+	std::cout << modulePath << std::endl;
+	if (std::system(command.c_str()) != 0)
+	{
+		std::cout << "ERROR: Could not compile " << sourcePath << " to " << modulePath << std::endl;
+		return(false);
+	}
+	return(true);
+}
+
+int main(int argc, char* argv[])
+{
+	std::string vertexPath = g_DefaultVertexPath;
+	std::string fragmentPath = g_DefaultFragmentPath;
+	bool bSucceeded = true;
+
+	if (argc == 3)
+	{
+		vertexPath = argv[1];
+		fragmentPath = argv[2];
+	}
+
+	// the vertex shader reads no feature defines
+	bSucceeded = CompileModule(vertexPath, "vert", "", -1);
+
+	// the light count is left to a specialization constant
+	for (int featureSet = 0; featureSet < FEATURE_SETS; featureSet++)
+	{
+		std::string defines;
+
+		if ((featureSet & VARIANT_TEXTURED) != 0)
+		{
+			defines += " -DUSE_TEXTURE";
+		}
+		if ((featureSet & VARIANT_LIT) != 0)
+		{
+			defines += " -DUSE_LIGHTING";
+		}
+		if ((featureSet & VARIANT_BAKED) != 0)
+		{
+			defines += " -DUSE_BAKED_LIGHTING";
+		}
+		if ((featureSet & VARIANT_VIRTUAL) != 0)
+		{
+			defines += " -DUSE_VIRTUAL_TEXTURE";
+		}
+		if ((featureSet & VARIANT_FEEDBACK) != 0)
+		{
+			defines += " -DWRITE_FEEDBACK";
+		}
+		bSucceeded = CompileModule(fragmentPath, "frag", defines, featureSet) && bSucceeded;
+	}
+
+	return(bSucceeded ? EXIT_SUCCESS : EXIT_FAILURE);
+}
@@ -0,0 +1,801 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadercost.cpp
+// ============
+// report the texture fetches and arithmetic operations of every scene
+// shader variant, so that shading cost can be compared between changes
+//
+// build from the repository root, for example:
+//     cl /EHsc /O2 Tools\ShaderCost.cpp
+//     g++ -std=c++11 -O2 -o shadercost Tools/ShaderCost.cpp
+// and run it from the repository root:
+//     shadercost [vertexShader.glsl fragmentShader.glsl] [--lights N]
+///////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// declaration of global variables
+namespace
+{
+	const char* g_DefaultVertexPath = "shaders/vertexShader.glsl";
+	const char* g_DefaultFragmentPath = "shaders/fragmentShader.glsl";
+
+	// number of lights assumed for loops bounded by a uniform
+	int g_DefaultLightCount = 4;
+
+	// must match ShaderVariants::MAX_SPECIALIZED_LIGHTS
+	const int MAX_SPECIALIZED_LIGHTS = 8;
+
+	// built-in functions that sample a texture
+	const char* g_FetchFunctions[] = {
+		"texture", "texture2D", "textureLod", "textureGrad",
+		"textureProj", "textureOffset", "texelFetch", "textureGather"
+	};
+
+	// built-in functions counted as one arithmetic operation
+	const char* g_AluFunctions[] = {
+		"abs", "sign", "floor", "ceil", "fract", "mod", "min", "max",
+		"clamp", "mix", "step", "smoothstep", "length", "distance",
+		"dot", "cross", "normalize", "reflect", "refract", "pow", "exp",
+		"log", "exp2", "log2", "sqrt", "inversesqrt", "sin", "cos",
+		"tan", "asin", "acos", "atan", "radians", "degrees", "transpose",
+		"inverse", "determinant"
+	};
+
+	// operators counted as one arithmetic operation
+	const char* g_AluOperators[] = {
+		"+", "-", "*", "/", "+=", "-=", "*=", "/=",
+		"<", ">", "<=", ">=", "==", "!=", "&&", "||", "!"
+	};
+}
+
+/***********************************************************
+ *  SHADER_COST
+ *
+ *  The counts of one piece of shader code.  Vector and
+ *  matrix operations count once, as the shader compiler
+ *  sees them, not once per component.
+ ***********************************************************/
+struct SHADER_COST
+{
+	double textureFetches;
+	double aluOperations;
+
+	SHADER_COST() : textureFetches(0.0), aluOperations(0.0) {}
+
+	SHADER_COST& operator+=(const SHADER_COST& other)
+	{
+		textureFetches += other.textureFetches;
+		aluOperations += other.aluOperations;
+		return(*this);
+	}
+};
+
+/***********************************************************
+ *  ShaderCostCounter
+ *
+ *  This class runs a small GLSL preprocessor over a shader
+ *  source with the defines of one variant, splits the rest
+ *  into functions, and counts the work of main() with the
+ *  functions it calls inlined.  Only the longest branch of
+ *  an if/else is counted, and a loop counts its body once
+ *  per iteration, so the result is the worst case for one
+ *  fragment or vertex.
+ ***********************************************************/
+class ShaderCostCounter
+{
+public:
+	ShaderCostCounter(const std::map<std::string, std::string>& defines)
+	{
+		m_defines = defines;
+	}
+
+private:
+	// defines in effect, including ones the source adds
+	std::map<std::string, std::string> m_defines;
+	// tokens of the preprocessed source
+	std::vector<std::string> m_tokens;
+	// first and last token of each function body
+	std::map<std::string, std::pair<size_t, size_t> > m_functions;
+	// counted cost of each function
+	std::map<std::string, SHADER_COST> m_functionCosts;
+	// functions being counted, to stop recursion
+	std::set<std::string> m_counting;
+
+	// strip comments and evaluate the preprocessor directives
+	std::string Preprocess(const std::string& source);
+	// evaluate the expression of an #if directive
+	bool EvaluateCondition(const std::string& expression);
+	// split text into tokens, expanding simple defines
+	void Tokenize(const std::string& text, std::vector<std::string>& tokens, bool bExpand);
+	// find the body of every function definition
+	void FindFunctions();
+	// find the token that closes the bracket at the passed in index
+	size_t FindClose(size_t open) const;
+	// count one statement and move past it
+	SHADER_COST CountStatement(size_t& position, size_t end);
+	// count the tokens of an expression
+	SHADER_COST CountExpression(size_t first, size_t end);
+	// count a function and the functions it calls
+	SHADER_COST CountFunction(const std::string& name);
+	// get the number of iterations of a loop header
+	int GetLoopCount(size_t first, size_t end) const;
+
+public:
+	// count the cost of main() in the passed in source
+	bool Count(const std::string& source, SHADER_COST& cost);
+};
+
+/***********************************************************
+ *  EvaluateCondition()
+ *
+ *  This method is used for evaluating an #if expression
+ *  made of defined(), !, && and ||.  Grouping parentheses
+ *  are ignored, which is enough for the scene shaders.
+ ***********************************************************/
+bool ShaderCostCounter::EvaluateCondition(const std::string& expression)
+{
+	std::vector<std::string> tokens;
+	std::string rewritten;
+
+	// replace each defined(NAME) with 1 or 0, then evaluate
+	Tokenize(expression, tokens, false);
+	for (size_t i = 0; i < tokens.size(); i++)
+	{
+		if (tokens[i] == "defined")
+		{
+			size_t name = i + 1;
+			if ((name < tokens.size()) && (tokens[name] == "("))
+			{
+				name++;
+			}
+			bool bDefined = (name < tokens.size()) && (m_defines.find(tokens[name]) != m_defines.end());
+			rewritten += bDefined ? "1 " : "0 ";
+			i = ((name + 1 < tokens.size()) && (tokens[name + 1] == ")")) ? name + 1 : name;
+		}
+		else
+		{
+			rewritten += tokens[i] + " ";
+		}
+	}
+
+	// left to right with || binding looser than &&
+	std::vector<std::string> values;
+	Tokenize(rewritten, values, true);
+	bool bResult = false;
+	bool bTerm = true;
+	for (size_t i = 0; i < values.size(); i++)
+	{
+		if ((values[i] == "(") || (values[i] == ")"))
+		{
+			continue;
+		}
+		else if (values[i] == "||")
+		{
+			bResult = bResult || bTerm;
+			bTerm = true;
+		}
+		else if (values[i] == "!")
+		{
+			bool bValue = (i + 1 < values.size()) && (atoi(values[i + 1].c_str()) != 0);
+			bTerm = bTerm && !bValue;
+			i++;
+		}
+		else if (values[i] != "&&")
+		{
+			bTerm = bTerm && (atoi(values[i].c_str()) != 0);
+		}
+	}
+	return(bResult || bTerm);
+}
+
+/***********************************************************
+ *  Preprocess()
+ *
+ *  This method is used for removing comments, dropping the
+ *  lines of inactive #if blocks, and recording #defines.
+ ***********************************************************/
+std::string ShaderCostCounter::Preprocess(const std::string& source)
+{
+	std::string text;
+	std::string output;
+	std::vector<std::pair<bool, bool> > blocks;
+	bool bActive = true;
+
+	// remove both kinds of comment
+	for (size_t i = 0; i < source.size(); i++)
+	{
+		if ((source[i] == '/') && (i + 1 < source.size()) && (source[i + 1] == '/'))
+		{
+			while ((i < source.size()) && (source[i] != '\n'))
+			{
+				i++;
+			}
+		}
+		else if ((source[i] == '/') && (i + 1 < source.size()) && (source[i + 1] == '*'))
+		{
+			size_t close = source.find("*/", i + 2);
+			i = (close == std::string::npos) ? source.size() : close + 1;
+			continue;
+		}
+		if (i < source.size())
+		{
+			text += source[i];
+		}
+	}
+
+	std::istringstream lines(text);
+	std::string line;
+	while (std::getline(lines, line))
+	{
+		std::istringstream words(line);
+		std::string directive;
+		std::string name;
+		words >> directive;
+
+		if ((directive.empty() == true) || (directive[0] != '#'))
+		{
+			if (bActive == true)
+			{
+				output += line + "\n";
+			}
+			continue;
+		}
+
+		if ((directive == "#ifdef") || (directive == "#ifndef") || (directive == "#if"))
+		{
+			bool bCondition = false;
+			if (directive == "#if")
+			{
+				bCondition = EvaluateCondition(line.substr(line.find("#if") + 3));
+			}
+			else
+			{
+				words >> name;
+				bCondition = (m_defines.find(name) != m_defines.end()) == (directive == "#ifdef");
+			}
+			blocks.push_back(std::make_pair(bActive, bCondition));
+			bActive = bActive && bCondition;
+		}
+		else if ((directive == "#elif") && (blocks.empty() == false))
+		{
+			// only the first branch whose condition holds is kept
+			bool bCondition = (blocks.back().second == false) &&
+				EvaluateCondition(line.substr(line.find("#elif") + 5));
+			bActive = blocks.back().first && bCondition;
+			blocks.back().second = blocks.back().second || bCondition;
+		}
+		else if ((directive == "#else") && (blocks.empty() == false))
+		{
+			bActive = blocks.back().first && !blocks.back().second;
+		}
+		else if ((directive == "#endif") && (blocks.empty() == false))
+		{
+			bActive = blocks.back().first;
+			blocks.pop_back();
+		}
+		else if ((directive == "#define") && (bActive == true))
+		{
+			std::string value;
+			words >> name;
+			std::getline(words, value);
+			m_defines[name] = value;
+		}
+	}
+	return(output);
+}
+
+/***********************************************************
+ *  Tokenize()
+ *
+ *  This method is used for splitting text into identifiers,
+ *  numbers and operators.  Identifiers with a defined value
+ *  are replaced by the tokens of the value when requested.
+ ***********************************************************/
+void ShaderCostCounter::Tokenize(const std::string& text, std::vector<std::string>& tokens, bool bExpand)
+{
+	static const char* twoCharacterOperators[] = {
+		"+=", "-=", "*=", "/=", "==", "!=", "<=", ">=", "&&", "||", "++", "--"
+	};
+	size_t i = 0;
+
+	while (i < text.size())
+	{
+		unsigned char character = (unsigned char)text[i];
+
+		if (isspace(character))
+		{
+			i++;
+		}
+		else if (isalpha(character) || (character == '_'))
+		{
+			size_t start = i;
+			while ((i < text.size()) && (isalnum((unsigned char)text[i]) || (text[i] == '_')))
+			{
+				i++;
+			}
+			std::string word = text.substr(start, i - start);
+			std::map<std::string, std::string>::const_iterator found = m_defines.find(word);
+			if ((bExpand == true) && (found != m_defines.end()) && (found->second.empty() == false))
+			{
+				Tokenize(found->second, tokens, false);
+			}
+			else
+			{
+				tokens.push_back(word);
+			}
+		}
+		else if (isdigit(character) || ((character == '.') && (i + 1 < text.size()) && isdigit((unsigned char)text[i + 1])))
+		{
+			size_t start = i;
+			while ((i < text.size()) && (isalnum((unsigned char)text[i]) || (text[i] == '.')))
+			{
+				i++;
+			}
+			tokens.push_back(text.substr(start, i - start));
+		}
+		else
+		{
+			std::string symbol(1, text[i]);
+			for (size_t j = 0; j < sizeof(twoCharacterOperators) / sizeof(twoCharacterOperators[0]); j++)
+			{
+				if (text.compare(i, 2, twoCharacterOperators[j]) == 0)
+				{
+					symbol = twoCharacterOperators[j];
+				}
+			}
+			tokens.push_back(symbol);
+			i += symbol.size();
+		}
+	}
+}
+
+/***********************************************************
+ *  FindClose()
+ *
+ *  This method is used for finding the token that closes
+ *  the bracket at the passed in index.
+ ***********************************************************/
+size_t ShaderCostCounter::FindClose(size_t open) const
+{
+	const std::string& opening = m_tokens[open];
+	std::string closing = (opening == "(") ? ")" : ((opening == "[") ? "]" : "}");
+	int depth = 0;
+
+	for (size_t i = open; i < m_tokens.size(); i++)
+	{
+		if (m_tokens[i] == opening)
+		{
+			depth++;
+		}
+		else if (m_tokens[i] == closing)
+		{
+			depth--;
+			if (depth == 0)
+			{
+				return(i);
+			}
+		}
+	}
+	return(m_tokens.size());
+}
+
+/***********************************************************
+ *  FindFunctions()
+ *
+ *  This method is used for finding every function body.  A
+ *  body is a top level brace that directly follows the
+ *  closing parenthesis of "type name(...)".
+ ***********************************************************/
+void ShaderCostCounter::FindFunctions()
+{
+	size_t i = 0;
+
+	m_functions.clear();
+	while (i < m_tokens.size())
+	{
+		if ((m_tokens[i] == "(") && (i >= 2) &&
+			isalpha((unsigned char)m_tokens[i - 1][0]) && isalpha((unsigned char)m_tokens[i - 2][0]))
+		{
+			size_t close = FindClose(i);
+			if ((close + 1 < m_tokens.size()) && (m_tokens[close + 1] == "{"))
+			{
+				size_t end = FindClose(close + 1);
+				m_functions[m_tokens[i - 1]] = std::make_pair(close + 1, end);
+				i = end + 1;
+				continue;
+			}
+		}
+		if (m_tokens[i] == "{")
+		{
+			i = FindClose(i) + 1;
+			continue;
+		}
+		i++;
+	}
+}
+
+/***********************************************************
+ *  GetLoopCount()
+ *
+ *  This method is used for reading the bound of a loop of
+ *  the form "for (...; i < bound; ...)".  A bound that is
+ *  not a number is taken as the assumed light count.
+ ***********************************************************/
+int ShaderCostCounter::GetLoopCount(size_t first, size_t end) const
+{
+	int semicolons = 0;
+
+	for (size_t i = first; i < end; i++)
+	{
+		if (m_tokens[i] == ";")
+		{
+			semicolons++;
+		}
+		else if ((semicolons == 1) && ((m_tokens[i] == "<") || (m_tokens[i] == "<=")) && (i + 1 < end))
+		{
+			const std::string& bound = m_tokens[i + 1];
+			int count = isdigit((unsigned char)bound[0]) ? atoi(bound.c_str()) : g_DefaultLightCount;
+			return((m_tokens[i] == "<=") ? count + 1 : count);
+		}
+	}
+	return(1);
+}
+
+/***********************************************************
+ *  CountExpression()
+ *
+ *  This method is used for counting the operators, built-in
+ *  calls and texture fetches of a run of tokens.  Calls to
+ *  functions of the shader add that function's cost.
+ ***********************************************************/
+SHADER_COST ShaderCostCounter::CountExpression(size_t first, size_t end)
+{
+	SHADER_COST cost;
+
+	for (size_t i = first; i < end; i++)
+	{
+		const std::string& token = m_tokens[i];
+		bool bCall = (i + 1 < end) && (m_tokens[i + 1] == "(");
+
+		for (size_t j = 0; j < sizeof(g_AluOperators) / sizeof(g_AluOperators[0]); j++)
+		{
+			if (token == g_AluOperators[j])
+			{
+				cost.aluOperations += 1.0;
+			}
+		}
+		if (bCall == false)
+		{
+			continue;
+		}
+		for (size_t j = 0; j < sizeof(g_FetchFunctions) / sizeof(g_FetchFunctions[0]); j++)
+		{
+			if (token == g_FetchFunctions[j])
+			{
+				cost.textureFetches += 1.0;
+			}
+		}
+		for (size_t j = 0; j < sizeof(g_AluFunctions) / sizeof(g_AluFunctions[0]); j++)
+		{
+			if (token == g_AluFunctions[j])
+			{
+				cost.aluOperations += 1.0;
+			}
+		}
+		if (m_functions.find(token) != m_functions.end())
+		{
+			cost += CountFunction(token);
+		}
+	}
+	return(cost);
+}
+
+/***********************************************************
+ *  CountStatement()
+ *
+ *  This method is used for counting one statement starting
+ *  at the passed in position, and moving the position past
+ *  it.  Only the dearer branch of an if/else is counted,
+ *  loop bodies are counted once per iteration, and a block
+ *  is counted up to its first return.
+ ***********************************************************/
+SHADER_COST ShaderCostCounter::CountStatement(size_t& position, size_t end)
+{
+	SHADER_COST cost;
+
+	if (position >= end)
+	{
+		return(cost);
+	}
+
+	if (m_tokens[position] == "{")
+	{
+		size_t close = FindClose(position);
+		position++;
+		while (position < close)
+		{
+			// nothing after a return in the block runs
+			bool bReturn = (m_tokens[position] == "return");
+			cost += CountStatement(position, close);
+			if (bReturn)
+			{
+				break;
+			}
+		}
+		position = close + 1;
+	}
+	else if (m_tokens[position] == "if")
+	{
+		size_t close = FindClose(position + 1);
+		SHADER_COST branch;
+		SHADER_COST otherBranch;
+
+		cost = CountExpression(position + 1, close);
+		position = close + 1;
+		branch = CountStatement(position, end);
+		if ((position < end) && (m_tokens[position] == "else"))
+		{
+			position++;
+			otherBranch = CountStatement(position, end);
+		}
+		cost.textureFetches += std::max(branch.textureFetches, otherBranch.textureFetches);
+		cost.aluOperations += std::max(branch.aluOperations, otherBranch.aluOperations);
+	}
+	else if ((m_tokens[position] == "for") || (m_tokens[position] == "while"))
+	{
+		size_t close = FindClose(position + 1);
+		int iterations = (m_tokens[position] == "for") ? GetLoopCount(position + 2, close) : g_DefaultLightCount;
+		SHADER_COST body;
+
+		position = close + 1;
+		body = CountStatement(position, end);
+		cost.textureFetches = body.textureFetches * iterations;
+		cost.aluOperations = body.aluOperations * iterations;
+	}
+	else
+	{
+		size_t first = position;
+		while ((position < end) && (m_tokens[position] != ";"))
+		{
+			if ((m_tokens[position] == "(") || (m_tokens[position] == "["))
+			{
+				position = FindClose(position);
+			}
+			position++;
+		}
+		cost = CountExpression(first, position);
+		position++;
+	}
+	return(cost);
+}
+
+/***********************************************************
+ *  CountFunction()
+ *
+ *  This method is used for counting the body of a function
+ *  of the shader, once per function.
+ ***********************************************************/
+SHADER_COST ShaderCostCounter::CountFunction(const std::string& name)
+{
+	std::map<std::string, SHADER_COST>::iterator counted = m_functionCosts.find(name);
+	SHADER_COST cost;
+
+	if (counted != m_functionCosts.end())
+	{
+		return(counted->second);
+	}
+	if (m_counting.find(name) != m_counting.end())
+	{
+		return(cost);
+	}
+
+	m_counting.insert(name);
+	size_t position = m_functions[name].first;
+	cost = CountStatement(position, m_functions[name].second + 1);
+	m_counting.erase(name);
+
+	m_functionCosts[name] = cost;
+	return(cost);
+}
+
+/***********************************************************
+ *  Count()
+ *
+ *  This method is used for counting the cost of main() in
+ *  the passed in source.
+ ***********************************************************/
+bool ShaderCostCounter::Count(const std::string& source, SHADER_COST& cost)
+{
+	std::string code = Preprocess(source);
+
+	m_tokens.clear();
+	Tokenize(code, m_tokens, true);
+	FindFunctions();
+	if (m_functions.find("main") == m_functions.end())
+	{
+		return(false);
+	}
+	cost = CountFunction("main");
+	return(true);
+}
+
+/***********************************************************
+ *  ReadFile()
+ *
+ *  This function is used for reading a whole text file.
+ ***********************************************************/
+bool ReadFile(const char* filePath, std::string& contents)
+{
+	std::ifstream file(filePath);
+	std::stringstream stream;
+
+	if (!file.is_open())
+	{
+		std::cout << "ERROR: Could not open shader file " << filePath << std::endl;
+		return(false);
+	}
+	stream << file.rdbuf();
+	contents = stream.str();
+	return(true);
+}
+
+/***********************************************************
+ *  ReportVariant()
+ *
+ *  This function is used for counting the scene shaders with
+ *  the passed in defines and writing the line of the variant.
+ ***********************************************************/
+bool ReportVariant(const std::string& name, const std::map<std::string, std::string>& defines,
+	const std::string& vertexSource, const std::string& fragmentSource)
+{
+	ShaderCostCounter vertexCounter(defines);
+	ShaderCostCounter fragmentCounter(defines);
+	SHADER_COST vertexCost;
+	SHADER_COST fragmentCost;
+
+	if ((vertexCounter.Count(vertexSource, vertexCost) == false) ||
+		(fragmentCounter.Count(fragmentSource, fragmentCost) == false))
+	{
+		std::cout << "ERROR: No main() found for variant " << name << std::endl;
+		return(false);
+	}
+
+	std::cout << std::left << std::setw(40) << name << std::right
+		<< std::setw(10) << vertexCost.textureFetches << std::setw(8) << vertexCost.aluOperations
+		<< std::setw(10) << fragmentCost.textureFetches << std::setw(8) << fragmentCost.aluOperations
+		<< std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  main(int, char*)
+ *
+ *  This function reads the scene shaders and writes one line
+ *  per variant with the cost of a vertex and a fragment.
+ *  The variants use the defines that ShaderVariants adds.
+ ***********************************************************/
+int main(int argc, char* argv[])
+{
+	const char* vertexPath = g_DefaultVertexPath;
+	const char* fragmentPath = g_DefaultFragmentPath;
+	std::vector<const char*> paths;
+	std::string vertexSource;
+	std::string fragmentSource;
+	std::map<std::string, std::string> feedbackDefines;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if ((strcmp(argv[i], "--lights") == 0) && (i + 1 < argc))
+		{
+			g_DefaultLightCount = atoi(argv[++i]);
+		}
+		else
+		{
+			paths.push_back(argv[i]);
+		}
+	}
+	if (paths.size() == 2)
+	{
+		vertexPath = paths[0];
+		fragmentPath = paths[1];
+	}
+
+	if ((ReadFile(vertexPath, vertexSource) == false) ||
+		(ReadFile(fragmentPath, fragmentSource) == false))
+	{
+		return(EXIT_FAILURE);
+	}
+
+	std::cout << std::left << std::setw(40) << "variant"
+		<< std::right << std::setw(10) << "vs fetch" << std::setw(8) << "vs alu"
+		<< std::setw(10) << "fs fetch" << std::setw(8) << "fs alu" << std::endl;
+
+	// untextured, textured, and textured through the pages of
+	// a virtual texture
+	for (int textured = 0; textured < 3; textured++)
+	{
+		// unlit, lit, and the baked lighting of far objects
+		for (int lit = 0; lit < 3; lit++)
+		{
+			// a lit variant has a fixed light loop up to
+			// MAX_SPECIALIZED_LIGHTS, and a dynamic one above
+			int specializations = ((lit == 1) && (g_DefaultLightCount <= MAX_SPECIALIZED_LIGHTS)) ? 2 : 1;
+			for (int specialized = 0; specialized < specializations; specialized++)
+			{
+				std::map<std::string, std::string> defines;
+				std::string name;
+
+				// the common driver path, with storage buffers
+				defines["GL_ARB_shader_storage_buffer_object"] = "1";
+				defines["GL_ARB_shader_draw_parameters"] = "1";
+
+				if (textured == 2)
+				{
+					defines["USE_TEXTURE"] = "";
+					defines["USE_VIRTUAL_TEXTURE"] = "";
+					name = "virtual textured";
+				}
+				else if (textured == 1)
+				{
+					defines["USE_TEXTURE"] = "";
+					name = "textured";
+				}
+				else
+				{
+					name = "untextured";
+				}
+				if (lit == 1)
+				{
+					defines["USE_LIGHTING"] = "";
+					if (specialized == 1)
+					{
+						defines["LIGHT_COUNT"] = std::to_string(g_DefaultLightCount);
+						name += ", " + std::to_string(g_DefaultLightCount) + " lights fixed";
+					}
+					else
+					{
+						name += ", " + std::to_string(g_DefaultLightCount) + " lights dynamic";
+					}
+				}
+				else if (lit == 2)
+				{
+					defines["USE_BAKED_LIGHTING"] = "";
+					name += ", baked";
+				}
+				else
+				{
+					name += ", unlit";
+				}
+
+				if (ReportVariant(name, defines, vertexSource, fragmentSource) == false)
+				{
+					return(EXIT_FAILURE);
+				}
+			}
+		}
+	}
+
+	// the feedback pass draws every virtual texture draw again
+	// each frame, unlit, writing only the page it samples
+	feedbackDefines["GL_ARB_shader_storage_buffer_object"] = "1";
+	feedbackDefines["GL_ARB_shader_draw_parameters"] = "1";
+	feedbackDefines["USE_VIRTUAL_TEXTURE"] = "";
+	feedbackDefines["WRITE_FEEDBACK"] = "";
+	if (ReportVariant("virtual feedback", feedbackDefines, vertexSource, fragmentSource) == false)
+	{
+		return(EXIT_FAILURE);
+	}
+
+	return(EXIT_SUCCESS);
+}
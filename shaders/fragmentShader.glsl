@@ -1,225 +1,373 @@
-#version 330 core
-out vec4 fragmentColor;
-
-in vec3 fragmentPosition;
-in vec3 fragmentVertexNormal;
-in vec2 fragmentTextureCoordinate;
-
-struct Material {
-    vec3 diffuseColor;
-    vec3 specularColor;
-    float shininess;
-}; 
-
-struct DirectionalLight {
-    vec3 direction;
-	
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-
-    bool bActive;
-};
-
-struct PointLight {
-    vec3 position;
-    
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-
-    bool bActive;
-};
-
-struct SpotLight {
-    vec3 position;
-    vec3 direction;
-    float cutOff;
-    float outerCutOff;
-  
-    float constant;
-    float linear;
-    float quadratic;
-  
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;       
-
-    bool bActive;
-};
-
-#define TOTAL_POINT_LIGHTS 5
-
-uniform bool bUseTexture=false;
-uniform bool bUseLighting=false;
-uniform vec4 objectColor = vec4(1.0f);
-uniform vec3 viewPosition;
-uniform DirectionalLight directionalLight;
-uniform PointLight pointLights[TOTAL_POINT_LIGHTS];
-uniform SpotLight spotLight;
-uniform Material material;
-uniform sampler2D objectTexture;
-uniform vec2 UVscale = vec2(1.0f, 1.0f);
-
-// function prototypes
-vec3 CalcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir);
-vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
-vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
-
-void main()
-{    
-    if(bUseLighting == true)
-    {
-        vec3 phongResult = vec3(0.0f);
-        // properties
-        vec3 norm = normalize(fragmentVertexNormal);
-        vec3 viewDir = normalize(viewPosition - fragmentPosition);
-    
-        // == =====================================================
-        // Our lighting is set up in 3 phases: directional, point lights and an optional flashlight
-        // For each phase, a calculate function is defined that calculates the corresponding color
-        // per light source. In the main() function we take all the calculated colors and sum them 
-        // up for this fragment's final color.
-        // == =====================================================
-        // phase 1: directional lighting
-        if(directionalLight.bActive == true)
-        {
-            phongResult += CalcDirectionalLight(directionalLight, norm, viewDir);
-        }
-        // phase 2: point lights
-        for(int i = 0; i < TOTAL_POINT_LIGHTS; i++)
-        {
-	    if(pointLights[i].bActive == true)
-            {
-                phongResult += CalcPointLight(pointLights[i], norm, fragmentPosition, viewDir);   
-            }
-        } 
-        // phase 3: spot light
-        if(spotLight.bActive == true)
-        {
-            phongResult += CalcSpotLight(spotLight, norm, fragmentPosition, viewDir);    
-        }
-    
-        if(bUseTexture == true)
-        {
-            fragmentColor = vec4(phongResult, (texture(objectTexture, fragmentTextureCoordinate)).a);
-        }
-        else
-        {
-            fragmentColor = vec4(phongResult, objectColor.a);
-        }
-    }
-    else
-    {
-        if(bUseTexture == true)
-        {
-            fragmentColor = texture(objectTexture, fragmentTextureCoordinate * UVscale);
-        }
-        else
-        {
-            fragmentColor = objectColor;
-        }
-    }
-}
-
-// calculates the color when using a directional light.
-vec3 CalcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir)
-{
-    vec3 ambient = vec3(0.0f);
-    vec3 diffuse = vec3(0.0f);
-    vec3 specular = vec3(0.0f);
-
-    vec3 lightDirection = normalize(-light.direction);
-    // diffuse shading
-    float diff = max(dot(normal, lightDirection), 0.0);
-    // specular shading
-    vec3 reflectDir = reflect(-lightDirection, normal);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
-    // combine results
-    if(bUseTexture == true)
-    {
-        ambient = light.ambient * vec3(texture(objectTexture, fragmentTextureCoordinate));
-        diffuse = light.diffuse * diff * material.diffuseColor * vec3(texture(objectTexture, fragmentTextureCoordinate));
-        specular = light.specular * spec * material.specularColor * vec3(texture(objectTexture, fragmentTextureCoordinate));
-    }
-    else
-    {
-        ambient = light.ambient * vec3(objectColor);
-        diffuse = light.diffuse * diff * material.diffuseColor * vec3(objectColor);
-        specular = light.specular * spec * material.specularColor * vec3(objectColor);
-    }
-    
-    return (ambient + diffuse + specular);
-}
-
-// calculates the color when using a point light.
-vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
-{
-    vec3 ambient = vec3(0.0f);
-    vec3 diffuse = vec3(0.0f);
-    vec3 specular= vec3(0.0f);
-
-    vec3 lightDir = normalize(light.position - fragPos);
-    // diffuse shading
-    float diff = max(dot(normal, lightDir), 0.0);
-    // specular shading
-    vec3 reflectDir = reflect(-lightDir, normal);
-    // Calculate specular component
-    float specularComponent = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
-   
-    // combine results
-    if(bUseTexture == true)
-    {
-        ambient = light.ambient * vec3(texture(objectTexture, fragmentTextureCoordinate));
-        diffuse = light.diffuse * diff * material.diffuseColor * vec3(texture(objectTexture, fragmentTextureCoordinate));
-        specular = light.specular * specularComponent * material.specularColor;
-    }
-    else
-    {
-        ambient = light.ambient * vec3(objectColor);
-        diffuse = light.diffuse * diff * material.diffuseColor * vec3(objectColor);
-        specular = light.specular * specularComponent * material.specularColor;
-    }
-    
-    return (ambient + diffuse + specular);
-}
-
-// calculates the color when using a spot light.
-vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
-{
-    vec3 ambient = vec3(0.0f);
-    vec3 diffuse = vec3(0.0f);
-    vec3 specular = vec3(0.0f);
-
-    vec3 lightDir = normalize(light.position - fragPos);
-    // diffuse shading
-    float diff = max(dot(normal, lightDir), 0.0);
-    // specular shading
-    vec3 reflectDir = reflect(-lightDir, normal);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
-    // attenuation
-    float distance = length(light.position - fragPos);
-    float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));    
-    // spotlight intensity
-    float theta = dot(lightDir, normalize(-light.direction)); 
-    float epsilon = light.cutOff - light.outerCutOff;
-    float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
-    // combine results
-    if(bUseTexture == true)
-    {
-        ambient = light.ambient * vec3(texture(objectTexture, fragmentTextureCoordinate));
-        diffuse = light.diffuse * diff * material.diffuseColor * vec3(texture(objectTexture, fragmentTextureCoordinate));
-        specular = light.specular * spec * material.specularColor * vec3(texture(objectTexture, fragmentTextureCoordinate));
-    }
-    else
-    {
-        ambient = light.ambient * vec3(objectColor);
-        diffuse = light.diffuse * diff * material.diffuseColor * vec3(objectColor);
-        specular = light.specular * spec * material.specularColor * vec3(objectColor);
-    }
-    
-    ambient *= attenuation * intensity;
-    diffuse *= attenuation * intensity;
-    specular *= attenuation * intensity;
-    return (ambient + diffuse + specular);
-}
+#version 330 core
+// the light list and material table are read from storage buffers when the
+// driver has them, otherwise from uniform buffers with a fixed size
+#extension GL_ARB_shader_storage_buffer_object : enable
+// compiled to SPIR-V by Tools/CompileSpirv.cpp, where every input, output,
+// uniform and block needs an explicit location or binding
+#ifdef GL_SPIRV
+#extension GL_ARB_separate_shader_objects : require
+#extension GL_ARB_explicit_uniform_location : require
+#extension GL_ARB_shading_language_420pack : require
+#define SPIRV_LOCATION(n) layout (location = n)
+#define SPIRV_BINDING(n) , binding = n
+#else
+#define SPIRV_LOCATION(n)
+#define SPIRV_BINDING(n)
+#endif
+// ShaderVariants inserts the permutation defines below the version line:
+//   USE_TEXTURE   the surface color is sampled from a layer of objectTexture
+//   USE_LIGHTING  the surface is lit by the light list
+//   LIGHT_COUNT   fixed number of lights, the loop reads lightCount when unset
+//   USE_BAKED_LIGHTING  an unlit surface is scaled by the baked scene light,
+//                       used for objects too small on screen to light
+//   USE_VIRTUAL_TEXTURE the surface color is sampled from the pages of a
+//                       virtual texture held in the shared page cache
+//   WRITE_FEEDBACK      the fragment writes the virtual texture page it
+//                       needs instead of its color, for the feedback pass,
+//                       and is ignored without USE_VIRTUAL_TEXTURE
+// SPIR-V modules are compiled once per feature set, and the light count is
+// a specialization constant instead
+
+SPIRV_LOCATION(0) out vec4 fragmentColor;
+
+// locations must match the outputs of the vertex shader
+SPIRV_LOCATION(0) in vec3 fragmentPosition;
+SPIRV_LOCATION(1) in vec3 fragmentVertexNormal;
+SPIRV_LOCATION(2) in vec2 fragmentTextureCoordinate;
+SPIRV_LOCATION(3) flat in vec4 fragmentInstanceColor;
+SPIRV_LOCATION(4) flat in int fragmentMaterialIndex;
+SPIRV_LOCATION(5) flat in int fragmentTextureLayer;
+
+struct Material {
+    vec3 diffuseColor;
+    vec3 specularColor;
+    float shininess;
+}; 
+
+// Light is one light source, MaterialData one entry of the material
+// table and FrameData the per-frame values
+// BEGIN SHARED LAYOUTS
+// generated from Source/ShaderLayouts.h, edit the layouts there
+#define LIGHT_DIRECTIONAL 0
+#define LIGHT_POINT 1
+#define LIGHT_SPOT 2
+#define MAX_UNIFORM_LIGHTS 64
+#define MAX_UNIFORM_MATERIALS 256
+#define FRAME_DATA_BINDING 0
+#define DRAW_DATA_BINDING 0
+#define LIGHT_BINDING 1
+#define MATERIAL_BINDING 2
+#define LIGHT_COUNT_CONSTANT_ID 0
+#define UNIFORM_LOCATION_model 0
+#define UNIFORM_LOCATION_normalMatrix 1
+#define UNIFORM_LOCATION_bUseInstancing 2
+#define UNIFORM_LOCATION_bUseIndirect 3
+#define UNIFORM_LOCATION_drawIndexBase 4
+#define UNIFORM_LOCATION_objectColor 5
+#define UNIFORM_LOCATION_materialIndex 6
+#define UNIFORM_LOCATION_objectTexture 7
+#define UNIFORM_LOCATION_UVscale 8
+#define UNIFORM_LOCATION_textureLayer 9
+#define UNIFORM_LOCATION_virtualPageTable 10
+#define UNIFORM_LOCATION_virtualPageCache 11
+#define UNIFORM_LOCATION_virtualTextureInfo 12
+#define UNIFORM_LOCATION_virtualCacheInfo 13
+struct Light {
+    vec4 position;
+    vec4 direction;
+    vec4 ambient;
+    vec4 diffuse;
+    vec4 specular;
+    vec4 attenuation;
+    vec4 cone;
+};
+struct MaterialData {
+    vec4 diffuseColor;
+    vec4 specularColor;
+};
+layout (std140 SPIRV_BINDING(FRAME_DATA_BINDING)) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPosition;
+    vec4 cameraDirection;
+    float time;
+};
+// END SHARED LAYOUTS
+
+// only the active lights are uploaded, so every entry is used, with the
+// lights that reach the whole scene first.  The baked light is the
+// ambient of every light and the diffuse of those reaching everywhere.
+#ifdef GL_ARB_shader_storage_buffer_object
+layout (std430 SPIRV_BINDING(LIGHT_BINDING)) readonly buffer LightBuffer {
+    int lightCount;
+    vec4 bakedAmbient;
+    vec4 bakedDiffuse;
+    Light lights[];
+};
+#else
+layout (std140 SPIRV_BINDING(LIGHT_BINDING)) uniform LightBuffer {
+    int lightCount;
+    vec4 bakedAmbient;
+    vec4 bakedDiffuse;
+    Light lights[MAX_UNIFORM_LIGHTS];
+};
+#endif
+
+// every defined material, indexed by material ID
+#ifdef GL_ARB_shader_storage_buffer_object
+layout (std430 SPIRV_BINDING(MATERIAL_BINDING)) readonly buffer MaterialBuffer {
+    MaterialData materials[];
+};
+#else
+layout (std140 SPIRV_BINDING(MATERIAL_BINDING)) uniform MaterialBuffer {
+    MaterialData materials[MAX_UNIFORM_MATERIALS];
+};
+#endif
+
+// every uniform is set before the draws that read it
+SPIRV_LOCATION(UNIFORM_LOCATION_bUseInstancing) uniform bool bUseInstancing;
+SPIRV_LOCATION(UNIFORM_LOCATION_objectColor) uniform vec4 objectColor;
+SPIRV_LOCATION(UNIFORM_LOCATION_materialIndex) uniform int materialIndex;
+// the texture array holding the draw's texture, which every draw of a
+// batch shares, with the layer and UV scale set by the vertex shader
+SPIRV_LOCATION(UNIFORM_LOCATION_objectTexture) uniform sampler2DArray objectTexture;
+
+#ifdef USE_VIRTUAL_TEXTURE
+// one texel per page of every level of the virtual texture, holding the
+// cache slot in red and green and the level of the page found there in
+// blue, which is coarser than the texel's level until its page is loaded
+SPIRV_LOCATION(UNIFORM_LOCATION_virtualPageTable) uniform sampler2D virtualPageTable;
+// pages of every virtual texture, each with a border of its neighbors
+SPIRV_LOCATION(UNIFORM_LOCATION_virtualPageCache) uniform sampler2D virtualPageCache;
+// pages across level 0, the coarsest level and the virtual texture ID
+SPIRV_LOCATION(UNIFORM_LOCATION_virtualTextureInfo) uniform vec3 virtualTextureInfo;
+// page size, border and stride in cache texels, and the level bias of
+// the feedback pass, which is drawn at a fraction of the resolution
+SPIRV_LOCATION(UNIFORM_LOCATION_virtualCacheInfo) uniform vec4 virtualCacheInfo;
+#endif
+
+#ifdef GL_SPIRV
+// light count set by glSpecializeShader, zero loops over lightCount
+layout (constant_id = LIGHT_COUNT_CONSTANT_ID) const int SPECIALIZED_LIGHT_COUNT = 0;
+#endif
+
+// function prototypes
+vec3 CalcDirectionalLight(Light light, vec3 normal, vec3 viewDir);
+vec3 CalcPointLight(Light light, vec3 normal, vec3 fragPos, vec3 viewDir);
+vec3 CalcSpotLight(Light light, vec3 normal, vec3 fragPos, vec3 viewDir);
+#ifdef USE_VIRTUAL_TEXTURE
+int VirtualTextureLevel(vec2 uv);
+vec4 SampleVirtualTexture(vec2 uv);
+vec4 VirtualTextureFeedback(vec2 uv);
+#endif
+
+// material and color of the object, taken from the uniforms or
+// from the instance data when drawing instanced
+Material objectMaterial;
+vec4 surfaceColor;
+// color of the surface at this fragment, fetched once and shared
+// by every light
+vec4 baseColor;
+
+void main()
+{    
+#if defined(WRITE_FEEDBACK) && defined(USE_VIRTUAL_TEXTURE)
+    fragmentColor = VirtualTextureFeedback(fragmentTextureCoordinate);
+    return;
+#endif
+
+    int objectMaterialIndex = materialIndex;
+    if(bUseInstancing == true)
+    {
+        objectMaterialIndex = fragmentMaterialIndex;
+        surfaceColor = fragmentInstanceColor;
+    }
+    else
+    {
+        surfaceColor = objectColor;
+    }
+    MaterialData materialData = materials[objectMaterialIndex];
+    objectMaterial.diffuseColor = materialData.diffuseColor.rgb;
+    objectMaterial.specularColor = materialData.specularColor.rgb;
+    objectMaterial.shininess = materialData.specularColor.w;
+
+#if defined(USE_VIRTUAL_TEXTURE)
+    baseColor = SampleVirtualTexture(fragmentTextureCoordinate);
+#elif defined(USE_TEXTURE)
+    baseColor = texture(objectTexture, vec3(fragmentTextureCoordinate, float(fragmentTextureLayer)));
+#else
+    baseColor = surfaceColor;
+#endif
+
+#ifdef USE_LIGHTING
+    {
+        vec3 phongResult = vec3(0.0f);
+        // properties
+        vec3 norm = normalize(fragmentVertexNormal);
+        vec3 viewDir = normalize(cameraPosition.xyz - fragmentPosition);
+    
+        // == =====================================================
+        // Our lighting supports directional, point and spot lights.
+        // For each type, a calculate function is defined that calculates the corresponding color
+        // per light source. In the main() function we take all the calculated colors and sum them 
+        // up for this fragment's final color.
+        // == =====================================================
+#if defined(GL_SPIRV)
+        for(int i = 0; i < ((SPECIALIZED_LIGHT_COUNT > 0) ? SPECIALIZED_LIGHT_COUNT : lightCount); i++)
+#elif defined(LIGHT_COUNT)
+        for(int i = 0; i < LIGHT_COUNT; i++)
+#else
+        for(int i = 0; i < lightCount; i++)
+#endif
+        {
+            Light light = lights[i];
+            int lightType = int(light.position.w);
+
+            // a light that follows the camera acts as a flashlight
+            if(light.direction.w > 0.5f)
+            {
+                light.position.xyz = cameraPosition.xyz;
+                light.direction.xyz = cameraDirection.xyz;
+            }
+
+            if(lightType == LIGHT_DIRECTIONAL)
+            {
+                phongResult += CalcDirectionalLight(light, norm, viewDir);
+            }
+            else if(lightType == LIGHT_POINT)
+            {
+                phongResult += CalcPointLight(light, norm, fragmentPosition, viewDir);
+            }
+            else
+            {
+                phongResult += CalcSpotLight(light, norm, fragmentPosition, viewDir);
+            }
+        }
+    
+        fragmentColor = vec4(phongResult, baseColor.a);
+    }
+#elif defined(USE_BAKED_LIGHTING)
+    fragmentColor = vec4(baseColor.rgb * (bakedAmbient.rgb + bakedDiffuse.rgb * objectMaterial.diffuseColor), baseColor.a);
+#else
+    fragmentColor = baseColor;
+#endif
+}
+
+// calculates the color when using a directional light.
+vec3 CalcDirectionalLight(Light light, vec3 normal, vec3 viewDir)
+{
+    vec3 ambient = vec3(0.0f);
+    vec3 diffuse = vec3(0.0f);
+    vec3 specular = vec3(0.0f);
+
+    vec3 lightDirection = normalize(-light.direction.xyz);
+    // diffuse shading
+    float diff = max(dot(normal, lightDirection), 0.0);
+    // specular shading
+    vec3 reflectDir = reflect(-lightDirection, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), objectMaterial.shininess);
+    // combine results
+    ambient = light.ambient.rgb * baseColor.rgb;
+    diffuse = light.diffuse.rgb * diff * objectMaterial.diffuseColor * baseColor.rgb;
+    specular = light.specular.rgb * spec * objectMaterial.specularColor * baseColor.rgb;
+    
+    return (ambient + diffuse + specular);
+}
+
+// calculates the color when using a point light.
+vec3 CalcPointLight(Light light, vec3 normal, vec3 fragPos, vec3 viewDir)
+{
+    vec3 ambient = vec3(0.0f);
+    vec3 diffuse = vec3(0.0f);
+    vec3 specular= vec3(0.0f);
+
+    vec3 lightDir = normalize(light.position.xyz - fragPos);
+    // diffuse shading
+    float diff = max(dot(normal, lightDir), 0.0);
+    // specular shading
+    vec3 reflectDir = reflect(-lightDir, normal);
+    // attenuation
+    float distance = length(light.position.xyz - fragPos);
+    float attenuation = 1.0 / (light.attenuation.x + light.attenuation.y * distance + light.attenuation.z * (distance * distance));
+    // Calculate specular component
+    float specularComponent = pow(max(dot(viewDir, reflectDir), 0.0), objectMaterial.shininess);
+   
+    // combine results
+    ambient = light.ambient.rgb * baseColor.rgb;
+    diffuse = light.diffuse.rgb * diff * objectMaterial.diffuseColor * baseColor.rgb;
+    specular = light.specular.rgb * specularComponent * objectMaterial.specularColor;
+    
+    return ((ambient + diffuse + specular) * attenuation);
+}
+
+// calculates the color when using a spot light.
+vec3 CalcSpotLight(Light light, vec3 normal, vec3 fragPos, vec3 viewDir)
+{
+    vec3 ambient = vec3(0.0f);
+    vec3 diffuse = vec3(0.0f);
+    vec3 specular = vec3(0.0f);
+
+    vec3 lightDir = normalize(light.position.xyz - fragPos);
+    // diffuse shading
+    float diff = max(dot(normal, lightDir), 0.0);
+    // specular shading
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), objectMaterial.shininess);
+    // attenuation
+    float distance = length(light.position.xyz - fragPos);
+    float attenuation = 1.0 / (light.attenuation.x + light.attenuation.y * distance + light.attenuation.z * (distance * distance));    
+    // spotlight intensity
+    float theta = dot(lightDir, normalize(-light.direction.xyz)); 
+    float epsilon = light.cone.x - light.cone.y;
+    float intensity = clamp((theta - light.cone.y) / epsilon, 0.0, 1.0);
+    // combine results
+    ambient = light.ambient.rgb * baseColor.rgb;
+    diffuse = light.diffuse.rgb * diff * objectMaterial.diffuseColor * baseColor.rgb;
+    specular = light.specular.rgb * spec * objectMaterial.specularColor * baseColor.rgb;
+    
+    ambient *= attenuation * intensity;
+    diffuse *= attenuation * intensity;
+    specular *= attenuation * intensity;
+    return (ambient + diffuse + specular);
+}
+
+#ifdef USE_VIRTUAL_TEXTURE
+// finds the level of the virtual texture whose texels are closest to
+// a pixel, taking the finer one
+int VirtualTextureLevel(vec2 uv)
+{
+    vec2 texels = uv * (virtualTextureInfo.x * virtualCacheInfo.x);
+    vec2 dx = dFdx(texels);
+    vec2 dy = dFdy(texels);
+    float level = 0.5 * log2(max(max(dot(dx, dx), dot(dy, dy)), 1e-8)) + virtualCacheInfo.w;
+    return int(clamp(floor(level), 0.0, virtualTextureInfo.y));
+}
+
+// samples the virtual texture through its page table, from the finest
+// resident page covering the texel
+vec4 SampleVirtualTexture(vec2 uv)
+{
+    int level = VirtualTextureLevel(uv);
+    vec2 wrapped = fract(uv);
+    int pages = max(int(virtualTextureInfo.x) >> level, 1);
+    ivec2 page = min(ivec2(wrapped * float(pages)), ivec2(pages - 1));
+    vec3 entry = floor(texelFetch(virtualPageTable, page, level).rgb * 255.0 + 0.5);
+
+    // position inside the resident page, past its border
+    float residentPages = max(virtualTextureInfo.x / exp2(entry.z), 1.0);
+    vec2 inPage = fract(wrapped * residentPages);
+    vec2 texel = entry.xy * virtualCacheInfo.z + virtualCacheInfo.y + inPage * virtualCacheInfo.x;
+    return textureLod(virtualPageCache, texel / vec2(textureSize(virtualPageCache, 0)), 0.0);
+}
+
+// writes the page and level the fragment needs, and the virtual texture
+// ID plus one, so that cleared texels read as no request
+vec4 VirtualTextureFeedback(vec2 uv)
+{
+    int level = VirtualTextureLevel(uv);
+    int pages = max(int(virtualTextureInfo.x) >> level, 1);
+    ivec2 page = min(ivec2(fract(uv) * float(pages)), ivec2(pages - 1));
+    return vec4(vec2(page), float(level), virtualTextureInfo.z + 1.0) / 255.0;
+}
+#endif
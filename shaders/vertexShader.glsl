@@ -1,20 +1,140 @@
-#version 330 core
-layout (location = 0) in vec3 inVertexPosition;
-layout (location = 1) in vec3 inVertexNormal;
-layout (location = 2) in vec2 inTextureCoordinate;
-
-out vec3 fragmentPosition;
-out vec3 fragmentVertexNormal;
-out vec2 fragmentTextureCoordinate;
-
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-
-void main()
-{
-   fragmentPosition = vec3(model * vec4(inVertexPosition, 1.0));
-   gl_Position = projection * view * model * vec4(inVertexPosition, 1.0f);
-   fragmentVertexNormal = inVertexNormal;
-   fragmentTextureCoordinate = inTextureCoordinate;
+#version 330 core
+// storage buffers and gl_DrawIDARB are only used by the indirect draw path,
+// when the driver does not expose them the path is compiled out
+#extension GL_ARB_shader_storage_buffer_object : enable
+#extension GL_ARB_shader_draw_parameters : enable
+#if defined(GL_ARB_shader_storage_buffer_object) && defined(GL_ARB_shader_draw_parameters)
+#define INDIRECT_DRAWS_SUPPORTED
+#endif
+// compiled to SPIR-V by Tools/CompileSpirv.cpp, where every input, output,
+// uniform and block needs an explicit location or binding
+#ifdef GL_SPIRV
+#extension GL_ARB_separate_shader_objects : require
+#extension GL_ARB_explicit_uniform_location : require
+#extension GL_ARB_shading_language_420pack : require
+#define SPIRV_LOCATION(n) layout (location = n)
+#define SPIRV_BINDING(n) , binding = n
+#else
+#define SPIRV_LOCATION(n)
+#define SPIRV_BINDING(n)
+#endif
+
+layout (location = 0) in vec3 inVertexPosition;
+layout (location = 1) in vec3 inVertexNormal;
+layout (location = 2) in vec2 inTextureCoordinate;
+// per-instance attributes, only read when bUseInstancing is set
+layout (location = 3) in mat4 inInstanceModel;
+layout (location = 7) in vec4 inInstanceColor;
+layout (location = 8) in int inInstanceMaterial;
+layout (location = 9) in mat3 inInstanceNormalMatrix;
+layout (location = 12) in int inInstanceTextureLayer;
+layout (location = 13) in vec2 inInstanceUVScale;
+
+// locations must match the inputs of the fragment shader
+SPIRV_LOCATION(0) out vec3 fragmentPosition;
+SPIRV_LOCATION(1) out vec3 fragmentVertexNormal;
+SPIRV_LOCATION(2) out vec2 fragmentTextureCoordinate;
+SPIRV_LOCATION(3) flat out vec4 fragmentInstanceColor;
+SPIRV_LOCATION(4) flat out int fragmentMaterialIndex;
+SPIRV_LOCATION(5) flat out int fragmentTextureLayer;
+
+// DrawData is the per-draw data and FrameData the per-frame values
+// BEGIN SHARED LAYOUTS
+// generated from Source/ShaderLayouts.h, edit the layouts there
+#define LIGHT_DIRECTIONAL 0
+#define LIGHT_POINT 1
+#define LIGHT_SPOT 2
+#define MAX_UNIFORM_LIGHTS 64
+#define MAX_UNIFORM_MATERIALS 256
+#define FRAME_DATA_BINDING 0
+#define DRAW_DATA_BINDING 0
+#define LIGHT_BINDING 1
+#define MATERIAL_BINDING 2
+#define LIGHT_COUNT_CONSTANT_ID 0
+#define UNIFORM_LOCATION_model 0
+#define UNIFORM_LOCATION_normalMatrix 1
+#define UNIFORM_LOCATION_bUseInstancing 2
+#define UNIFORM_LOCATION_bUseIndirect 3
+#define UNIFORM_LOCATION_drawIndexBase 4
+#define UNIFORM_LOCATION_objectColor 5
+#define UNIFORM_LOCATION_materialIndex 6
+#define UNIFORM_LOCATION_objectTexture 7
+#define UNIFORM_LOCATION_UVscale 8
+#define UNIFORM_LOCATION_textureLayer 9
+#define UNIFORM_LOCATION_virtualPageTable 10
+#define UNIFORM_LOCATION_virtualPageCache 11
+#define UNIFORM_LOCATION_virtualTextureInfo 12
+#define UNIFORM_LOCATION_virtualCacheInfo 13
+struct DrawData {
+    mat4 model;
+    mat3 normalMatrix;
+    vec4 color;
+    int materialIndex;
+    int textureLayer;
+    vec2 uvScale;
+};
+layout (std140 SPIRV_BINDING(FRAME_DATA_BINDING)) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPosition;
+    vec4 cameraDirection;
+    float time;
+};
+// END SHARED LAYOUTS
+
+#ifdef INDIRECT_DRAWS_SUPPORTED
+layout (std430 SPIRV_BINDING(DRAW_DATA_BINDING)) readonly buffer DrawDataBuffer {
+    DrawData draws[];
+};
+#endif
+
+SPIRV_LOCATION(UNIFORM_LOCATION_bUseInstancing) uniform bool bUseInstancing;
+SPIRV_LOCATION(UNIFORM_LOCATION_bUseIndirect) uniform bool bUseIndirect;
+SPIRV_LOCATION(UNIFORM_LOCATION_drawIndexBase) uniform int drawIndexBase;
+SPIRV_LOCATION(UNIFORM_LOCATION_model) uniform mat4 model;
+// inverse transpose of the model's upper 3x3, computed on the CPU
+SPIRV_LOCATION(UNIFORM_LOCATION_normalMatrix) uniform mat3 normalMatrix;
+// texture array layer and UV scale of a draw that is not instanced
+SPIRV_LOCATION(UNIFORM_LOCATION_textureLayer) uniform int textureLayer;
+SPIRV_LOCATION(UNIFORM_LOCATION_UVscale) uniform vec2 UVscale;
+
+void main()
+{
+   mat4 modelMatrix = model;
+   mat3 objectNormalMatrix = normalMatrix;
+   vec2 objectUVScale = UVscale;
+   fragmentInstanceColor = vec4(1.0f);
+   fragmentMaterialIndex = 0;
+   fragmentTextureLayer = textureLayer;
+   if(bUseIndirect == true)
+   {
+#ifdef INDIRECT_DRAWS_SUPPORTED
+      DrawData draw = draws[drawIndexBase + gl_DrawIDARB];
+      modelMatrix = draw.model;
+      objectNormalMatrix = draw.normalMatrix;
+      fragmentInstanceColor = draw.color;
+      fragmentMaterialIndex = draw.materialIndex;
+      fragmentTextureLayer = draw.textureLayer;
+      objectUVScale = draw.uvScale;
+#endif
+   }
+   else if(bUseInstancing == true)
+   {
+      modelMatrix = inInstanceModel;
+      objectNormalMatrix = inInstanceNormalMatrix;
+      fragmentInstanceColor = inInstanceColor;
+      fragmentMaterialIndex = inInstanceMaterial;
+      fragmentTextureLayer = inInstanceTextureLayer;
+      objectUVScale = inInstanceUVScale;
+   }
+
+   // the world position is transformed once and reused for the
+   // clip position, rather than multiplying the matrices per vertex
+   vec4 worldPosition = modelMatrix * vec4(inVertexPosition, 1.0f);
+   fragmentPosition = vec3(worldPosition);
+   gl_Position = viewProjection * worldPosition;
+   fragmentVertexNormal = objectNormalMatrix * inVertexNormal;
+   // the scale is linear, so it is applied once per vertex
+   fragmentTextureCoordinate = inTextureCoordinate * objectUVScale;
 }
\ No newline at end of file